@@ -0,0 +1,228 @@
+#include "binary_mesh_file.h"
+
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+BinaryMeshFile::BinaryMeshFile() {
+	file_descriptor = -1;
+	mapped_data = NULL;
+	mapped_size = 0;
+
+	header = NULL;
+}
+
+BinaryMeshFile::~BinaryMeshFile() {
+	Close();
+}
+
+//////////////
+// File i/o //
+//////////////
+
+int BinaryMeshFile::Open(const char* filename) {
+	Close();
+
+	file_descriptor = open(filename, O_RDONLY);
+	if(file_descriptor < 0) {
+		printf("Error opening the binary mesh file %s\n", filename);
+		return false;
+	}
+
+	struct stat file_stat;
+	if(fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size < (off_t) sizeof(BinaryMeshHeader)) {
+		printf("Error: %s is too small to be a binary mesh file\n", filename);
+
+		Close();
+		return false;
+	}
+
+	mapped_size = (size_t) file_stat.st_size;
+	mapped_data = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	if(mapped_data == MAP_FAILED) {
+		printf("Error mapping the binary mesh file %s\n", filename);
+
+		mapped_data = NULL;
+		Close();
+		return false;
+	}
+
+	//The blocks are read front to back
+	madvise(mapped_data, mapped_size, MADV_SEQUENTIAL);
+
+	header = (BinaryMeshHeader*) mapped_data;
+	if(validate_header() == false) {
+		printf("Error: %s is not a valid binary mesh file\n", filename);
+
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+int BinaryMeshFile::Close() {
+	if(mapped_data != NULL)
+		munmap(mapped_data, mapped_size);
+
+	if(file_descriptor >= 0)
+		close(file_descriptor);
+
+	file_descriptor = -1;
+	mapped_data = NULL;
+	mapped_size = 0;
+
+	header = NULL;
+
+	return true;
+}
+
+int BinaryMeshFile::IsOpen() {
+	return (header != NULL);
+}
+
+//Fill in a header for a mesh of the given size
+// + returns the total file size
+uint64_t BinaryMeshFile::ComputeLayout(BinaryMeshHeader& header, uint32_t vertex_count, uint32_t triangle_count) {
+	memset(&header, 0, sizeof(BinaryMeshHeader));
+
+	strncpy(header.magic, BINARY_MESH_MAGIC, sizeof(header.magic));
+	header.version = BINARY_MESH_VERSION;
+	header.byte_order = BINARY_MESH_BYTE_ORDER;
+
+	header.vertex_count = vertex_count;
+	header.triangle_count = triangle_count;
+
+	header.coordinate_offset = sizeof(BinaryMeshHeader);
+	header.vertex_index_offset = header.coordinate_offset + uint64_t(2) * vertex_count * sizeof(double);
+	header.neighbour_offset = header.vertex_index_offset + uint64_t(3) * triangle_count * sizeof(uint32_t);
+	header.file_size = header.neighbour_offset + uint64_t(3) * triangle_count * sizeof(uint32_t);
+
+	//Keep the file size a multiple of 8 so blocks appended later stay aligned
+	header.file_size = (header.file_size + 7) & ~uint64_t(7);
+
+	return header.file_size;
+}
+
+//Returns true if the file starts with the binary mesh magic
+int BinaryMeshFile::TestFile(const char* filename) {
+	FILE* handle = fopen(filename, "rb");
+	if(handle == NULL)
+		return false;
+
+	char magic[8];
+	size_t count = fread(magic, 1, sizeof(magic), handle);
+	fclose(handle);
+
+	if(count != sizeof(magic))
+		return false;
+
+	return (memcmp(magic, BINARY_MESH_MAGIC, sizeof(magic)) == 0);
+}
+
+/////////////////////
+// Data management //
+/////////////////////
+
+unsigned int BinaryMeshFile::GetVertexCount() {
+	if(header == NULL)
+		return 0;
+
+	return header->vertex_count;
+}
+
+unsigned int BinaryMeshFile::GetTriangleCount() {
+	if(header == NULL)
+		return 0;
+
+	return header->triangle_count;
+}
+
+const double* BinaryMeshFile::GetCoordinates() {
+	if(header == NULL)
+		return NULL;
+
+	return (const double*) ((const char*) mapped_data + header->coordinate_offset);
+}
+
+const uint32_t* BinaryMeshFile::GetVertexIndices() {
+	if(header == NULL)
+		return NULL;
+
+	return (const uint32_t*) ((const char*) mapped_data + header->vertex_index_offset);
+}
+
+const uint32_t* BinaryMeshFile::GetNeighbours() {
+	if(header == NULL)
+		return NULL;
+
+	return (const uint32_t*) ((const char*) mapped_data + header->neighbour_offset);
+}
+
+//Returns true if the vertex slot holds a vertex
+int BinaryMeshFile::HasVertex(unsigned int vindex) {
+	if(vindex == 0 || vindex >= GetVertexCount())
+		return false;
+
+	const double* coordinates = GetCoordinates();
+	return (isnan(coordinates[2*vindex]) == false);
+}
+
+//Returns true if the triangle slot holds a triangle
+int BinaryMeshFile::HasTriangle(unsigned int tindex) {
+	if(tindex == 0 || tindex >= GetTriangleCount())
+		return false;
+
+	const uint32_t* vertex_indices = GetVertexIndices();
+	return (vertex_indices[3*tindex] != 0);
+}
+
+//Any data stored after the mesh, the size is set to the number of bytes
+const char* BinaryMeshFile::GetTrailingData(size_t& size) {
+	size = 0;
+	if(header == NULL)
+		return NULL;
+
+	size = mapped_size - size_t(header->file_size);
+	return (const char*) mapped_data + header->file_size;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+int BinaryMeshFile::validate_header() {
+	if(memcmp(header->magic, BINARY_MESH_MAGIC, sizeof(header->magic)) != 0)
+		return false;
+
+	if(header->version != BINARY_MESH_VERSION) {
+		printf("Unsupported binary mesh version %u\n", header->version);
+		return false;
+	}
+
+	//Files are written in native byte order
+	if(header->byte_order != BINARY_MESH_BYTE_ORDER) {
+		printf("The binary mesh file was written with a different byte order\n");
+		return false;
+	}
+
+	//Recompute the layout and make sure it matches what is stored
+	BinaryMeshHeader expected;
+	ComputeLayout(expected, header->vertex_count, header->triangle_count);
+
+	if(header->coordinate_offset != expected.coordinate_offset)
+		return false;
+
+	if(header->vertex_index_offset != expected.vertex_index_offset)
+		return false;
+
+	if(header->neighbour_offset != expected.neighbour_offset)
+		return false;
+
+	if(header->file_size > mapped_size)
+		return false;
+
+	return true;
+}
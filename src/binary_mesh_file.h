@@ -0,0 +1,92 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef BINARY_MESH_FILE
+#define BINARY_MESH_FILE
+
+//The binary mesh file layout
+// + a fixed size header
+// + a coordinate block of 2*vertex_count doubles (x, y); empty vertex slots hold NaN
+// + a vertex index block of 3*triangle_count uint32 (n0, n1, n2); empty triangle slots hold 0s
+// + a neighbour block of 3*triangle_count uint32 (a0, a1, a2); 0 means no neighbour
+// + slot 0 of both the vertex and triangle blocks is the reserved null slot
+// + every block is aligned to its element size so the file can be used directly through mmap
+#define BINARY_MESH_MAGIC		"TRIMESH"
+#define BINARY_MESH_VERSION		1
+#define BINARY_MESH_BYTE_ORDER	0x01020304
+
+struct BinaryMeshHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+
+	uint32_t vertex_count;
+	uint32_t triangle_count;
+
+	uint64_t coordinate_offset;
+	uint64_t vertex_index_offset;
+	uint64_t neighbour_offset;
+	uint64_t file_size;
+};
+
+class BinaryMeshFile {
+public:
+	BinaryMeshFile();
+	~BinaryMeshFile();
+
+	//////////////
+	// File i/o //
+	//////////////
+
+	//Map a binary mesh file into memory, the blocks are then used in place
+	int Open(const char* filename);
+	int Close();
+
+	int IsOpen();
+
+	//Fill in a header for a mesh of the given size
+	// + returns the total file size
+	static uint64_t ComputeLayout(BinaryMeshHeader& header, uint32_t vertex_count, uint32_t triangle_count);
+
+	//Returns true if the file starts with the binary mesh magic
+	static int TestFile(const char* filename);
+
+	/////////////////////
+	// Data management //
+	/////////////////////
+
+	unsigned int GetVertexCount();
+	unsigned int GetTriangleCount();
+
+	//These point straight into the mapped file
+	const double* GetCoordinates();
+	const uint32_t* GetVertexIndices();
+	const uint32_t* GetNeighbours();
+
+	//Returns true if the vertex slot holds a vertex
+	int HasVertex(unsigned int vindex);
+
+	//Returns true if the triangle slot holds a triangle
+	int HasTriangle(unsigned int tindex);
+
+	//Any data stored after the mesh, the size is set to the number of bytes
+	const char* GetTrailingData(size_t& size);
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	int validate_header();
+
+	//The mapped file
+	int file_descriptor;
+	void* mapped_data;
+	size_t mapped_size;
+
+	BinaryMeshHeader* header;
+};
+
+#endif
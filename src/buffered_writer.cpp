@@ -0,0 +1,280 @@
+#include "buffered_writer.h"
+
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+BufferedWriter::BufferedWriter() {
+	initialize(BUFFERED_WRITER_SIZE);
+}
+
+BufferedWriter::BufferedWriter(size_t buffer_size) {
+	initialize(buffer_size);
+}
+
+BufferedWriter::~BufferedWriter() {
+	Close();
+
+	delete [] buffer;
+}
+
+//////////////
+// File i/o //
+//////////////
+
+int BufferedWriter::Open(const char* filename) {
+	Close();
+
+	file_descriptor = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(file_descriptor < 0) {
+		printf("Error opening %s for writing\n", filename);
+
+		good = false;
+		return false;
+	}
+
+	buffer_used = 0;
+	good = true;
+
+	return true;
+}
+
+int BufferedWriter::Close() {
+	if(file_descriptor < 0)
+		return good;
+
+	Flush();
+
+	if(close(file_descriptor) != 0)
+		good = false;
+
+	file_descriptor = -1;
+	return good;
+}
+
+//Push everything in the buffer out to the file descriptor
+int BufferedWriter::Flush() {
+	write_all(buffer, buffer_used);
+
+	buffer_used = 0;
+	return good;
+}
+
+//Returns false once any write has failed
+int BufferedWriter::IsGood() {
+	return good;
+}
+
+////////////////////
+// Write routines //
+////////////////////
+
+int BufferedWriter::Write(const char* data, size_t length) {
+	//Large writes skip the buffer
+	if(length >= buffer_size) {
+		if(Flush() == false)
+			return false;
+
+		return write_all(data, length);
+	}
+
+	if(reserve(length) == false)
+		return false;
+
+	memcpy(buffer + buffer_used, data, length);
+	buffer_used += length;
+
+	return true;
+}
+
+int BufferedWriter::WriteString(const char* str) {
+	return Write(str, strlen(str));
+}
+
+int BufferedWriter::WriteChar(char c) {
+	if(reserve(1) == false)
+		return false;
+
+	buffer[buffer_used++] = c;
+	return true;
+}
+
+//Fast number formatting straight into the buffer
+int BufferedWriter::WriteUnsigned(uint64_t value) {
+	if(reserve(20) == false)
+		return false;
+
+	//Write the digits backwards into a scratch area, then copy them forward
+	char digits[20];
+	int count = 0;
+
+	do {
+		digits[count++] = char('0' + (value % 10));
+		value /= 10;
+	} while(value != 0);
+
+	char* p = buffer + buffer_used;
+	for(int i=count-1; i>=0; i--)
+		*(p++) = digits[i];
+
+	buffer_used += count;
+	return true;
+}
+
+int BufferedWriter::WriteInteger(int64_t value) {
+	if(value < 0) {
+		if(WriteChar('-') == false)
+			return false;
+
+		return WriteUnsigned(uint64_t(0) - uint64_t(value));
+	}
+
+	return WriteUnsigned(uint64_t(value));
+}
+
+int BufferedWriter::WriteDouble(double value) {
+	//Whole numbers are common in generated grids and take the integer path
+	if(value == floor(value) && fabs(value) < 1e15) {
+		if(value == 0.0 && signbit(value))
+			return WriteString("-0");
+
+		return WriteInteger(int64_t(value));
+	}
+
+	//Everything else gets enough digits to read back exactly
+	if(reserve(32) == false)
+		return false;
+
+	int length = snprintf(buffer + buffer_used, 32, "%.17g", value);
+	if(length < 0 || length >= 32)
+		return (good = false);
+
+	buffer_used += length;
+	return true;
+}
+
+//Write a double rounded to a fixed number of decimals (at most 9), dropping trailing zeros
+int BufferedWriter::WriteFixed(double value, int decimals) {
+	static const double scales[10] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+	if(decimals < 0) decimals = 0;
+	if(decimals > 9) decimals = 9;
+
+	//Values too large for the integer path fall back to the full precision path
+	double scaled = value * scales[decimals];
+	if(!(fabs(scaled) < 9e15))
+		return WriteDouble(value);
+
+	int64_t rounded = int64_t(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+
+	if(rounded < 0) {
+		if(WriteChar('-') == false)
+			return false;
+
+		rounded = -rounded;
+	}
+
+	uint64_t whole = uint64_t(rounded) / uint64_t(scales[decimals]);
+	uint64_t fraction = uint64_t(rounded) % uint64_t(scales[decimals]);
+
+	if(WriteUnsigned(whole) == false)
+		return false;
+
+	if(fraction == 0)
+		return true;
+
+	//Drop the trailing zeros of the fraction
+	while(fraction % 10 == 0) {
+		fraction /= 10;
+		decimals--;
+	}
+
+	char digits[10];
+	for(int i=decimals-1; i>=0; i--) {
+		digits[i] = char('0' + (fraction % 10));
+		fraction /= 10;
+	}
+
+	WriteChar('.');
+	return Write(digits, decimals);
+}
+
+//Writes ' name="value"'
+int BufferedWriter::WriteAttribute(const char* name, uint64_t value) {
+	WriteChar(' ');
+	WriteString(name);
+	Write("=\"", 2);
+	WriteUnsigned(value);
+
+	return WriteChar('"');
+}
+
+int BufferedWriter::WriteAttribute(const char* name, double value) {
+	WriteChar(' ');
+	WriteString(name);
+	Write("=\"", 2);
+	WriteDouble(value);
+
+	return WriteChar('"');
+}
+
+int BufferedWriter::WriteAttribute(const char* name, const char* value) {
+	WriteChar(' ');
+	WriteString(name);
+	Write("=\"", 2);
+	WriteString(value);
+
+	return WriteChar('"');
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+int BufferedWriter::initialize(size_t buffer_size) {
+	file_descriptor = -1;
+
+	if(buffer_size < 64)
+		buffer_size = 64;
+
+	this->buffer_size = buffer_size;
+	buffer = new char[buffer_size];
+	buffer_used = 0;
+
+	good = false;
+
+	return true;
+}
+
+//Write data straight to the file descriptor
+int BufferedWriter::write_all(const char* data, size_t length) {
+	size_t written = 0;
+
+	while(good == true && written < length) {
+		ssize_t ret = write(file_descriptor, data + written, length - written);
+
+		if(ret < 0 && errno == EINTR)
+			continue;
+
+		if(ret <= 0) {
+			good = false;
+			break;
+		}
+
+		written += size_t(ret);
+	}
+
+	return good;
+}
+
+//Make sure there are at least length free bytes in the buffer
+int BufferedWriter::reserve(size_t length) {
+	if(good == false)
+		return false;
+
+	if(buffer_used + length > buffer_size)
+		return Flush();
+
+	return true;
+}
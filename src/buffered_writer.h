@@ -0,0 +1,76 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef BUFFERED_WRITER
+#define BUFFERED_WRITER
+
+//The default size of the write buffer
+#define BUFFERED_WRITER_SIZE	(4 << 20)
+
+class BufferedWriter {
+public:
+	BufferedWriter();
+	BufferedWriter(size_t buffer_size);
+	~BufferedWriter();
+
+	//////////////
+	// File i/o //
+	//////////////
+
+	int Open(const char* filename);
+	int Close();
+
+	//Push everything in the buffer out to the file descriptor
+	int Flush();
+
+	//Returns false once any write has failed
+	int IsGood();
+
+	////////////////////
+	// Write routines //
+	////////////////////
+
+	int Write(const char* data, size_t length);
+	int WriteString(const char* str);
+	int WriteChar(char c);
+
+	//Fast number formatting straight into the buffer
+	int WriteUnsigned(uint64_t value);
+	int WriteInteger(int64_t value);
+	int WriteDouble(double value);
+
+	//Write a double rounded to a fixed number of decimals (at most 9), dropping trailing zeros
+	int WriteFixed(double value, int decimals);
+
+	//Writes ' name="value"'
+	int WriteAttribute(const char* name, uint64_t value);
+	int WriteAttribute(const char* name, double value);
+	int WriteAttribute(const char* name, const char* value);
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	int initialize(size_t buffer_size);
+
+	//Write data straight to the file descriptor
+	int write_all(const char* data, size_t length);
+
+	//Make sure there are at least length free bytes in the buffer
+	int reserve(size_t length);
+
+	//The output file
+	int file_descriptor;
+
+	//The write buffer
+	char* buffer;
+	size_t buffer_size;
+	size_t buffer_used;
+
+	int good;
+};
+
+#endif
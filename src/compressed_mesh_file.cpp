@@ -0,0 +1,496 @@
+#include "compressed_mesh_file.h"
+
+#include <math.h>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//Variable length integers, 7 bits per byte, low bits first
+static inline void put_varint(vector<unsigned char>& stream, uint64_t value) {
+	while(value >= 0x80) {
+		stream.push_back((unsigned char) (value | 0x80));
+		value >>= 7;
+	}
+
+	stream.push_back((unsigned char) value);
+}
+
+static inline int get_varint(const unsigned char*& p, const unsigned char* end, uint64_t& value) {
+	value = 0;
+
+	for(int shift=0; shift<64; shift+=7) {
+		if(p >= end)
+			return false;
+
+		unsigned char byte = *(p++);
+		value |= uint64_t(byte & 0x7f) << shift;
+
+		if((byte & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+//Map signed values onto unsigned ones so small magnitudes stay small
+static inline uint64_t zigzag_encode(int64_t value) {
+	return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t value) {
+	return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+//Interleave the bits of two 32 bit values
+static inline uint64_t spread_bits(uint64_t value) {
+	value &= 0xffffffffULL;
+	value = (value | (value << 16)) & 0x0000ffff0000ffffULL;
+	value = (value | (value << 8)) & 0x00ff00ff00ff00ffULL;
+	value = (value | (value << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	value = (value | (value << 2)) & 0x3333333333333333ULL;
+	value = (value | (value << 1)) & 0x5555555555555555ULL;
+
+	return value;
+}
+
+static inline uint64_t morton_key(uint32_t x, uint32_t y) {
+	return spread_bits(x) | (spread_bits(y) << 1);
+}
+
+//Quantize a coordinate into [0, qmax]
+static inline uint32_t quantize(double value, double min, double scale, double qmax) {
+	double q = floor((value - min) * scale + 0.5);
+
+	if(q < 0.0) q = 0.0;
+	if(q > qmax) q = qmax;
+
+	return (uint32_t) q;
+}
+
+static inline uint64_t double_bits(double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	return bits;
+}
+
+//A triangle rotated so its smallest vertex is first, for sorting
+struct EncodedTriangle {
+	uint32_t v[3];
+
+	bool operator<(const EncodedTriangle& other) const {
+		if(v[0] != other.v[0]) return (v[0] < other.v[0]);
+		if(v[1] != other.v[1]) return (v[1] < other.v[1]);
+
+		return (v[2] < other.v[2]);
+	}
+};
+
+CompressedMeshFile::CompressedMeshFile() {
+	Clear();
+}
+
+CompressedMeshFile::~CompressedMeshFile() {
+	//Do nothing
+}
+
+//////////////
+// File i/o //
+//////////////
+
+//Encode a mesh and write it to a file
+// + quantization_bits of 0 keeps the coordinates exactly, otherwise 1 to 31 bits are kept per coordinate
+int CompressedMeshFile::Write(const char* filename, const vector<double>& coordinates, const vector<uint32_t>& vertex_indices, unsigned int quantization_bits) {
+	if(quantization_bits > 31) {
+		printf("Error: at most 31 quantization bits are supported\n");
+		return false;
+	}
+
+	CompressedMeshHeader header;
+	memset(&header, 0, sizeof(CompressedMeshHeader));
+
+	memcpy(header.magic, COMPRESSED_MESH_MAGIC, sizeof(header.magic));
+	header.version = COMPRESSED_MESH_VERSION;
+	header.byte_order = COMPRESSED_MESH_BYTE_ORDER;
+	header.quantization_bits = quantization_bits;
+
+	//Find the live vertices and their bounding box
+	unsigned int slot_count = coordinates.size() / 2;
+	vector<uint32_t> live_vertices;
+
+	for(unsigned int i=1; i<slot_count; i++) {
+		double x = coordinates[2*i];
+		double y = coordinates[2*i+1];
+
+		if(isnan(x))
+			continue;
+
+		if(live_vertices.empty() == true) {
+			header.xmin = header.xmax = x;
+			header.ymin = header.ymax = y;
+		}
+
+		header.xmin = min(header.xmin, x);
+		header.xmax = max(header.xmax, x);
+		header.ymin = min(header.ymin, y);
+		header.ymax = max(header.ymax, y);
+
+		live_vertices.push_back(i);
+	}
+
+	header.vertex_count = live_vertices.size();
+
+	//Lossless files still use a 32 bit grid to find the spatial order
+	double qmax = (quantization_bits > 0 ? double((uint64_t(1) << quantization_bits) - 1) : 4294967295.0);
+	double scale_x = (header.xmax > header.xmin ? qmax / (header.xmax - header.xmin) : 0.0);
+	double scale_y = (header.ymax > header.ymin ? qmax / (header.ymax - header.ymin) : 0.0);
+
+	vector< pair<uint64_t, uint32_t> > order(live_vertices.size());
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<long(live_vertices.size()); i++) {
+		uint32_t vindex = live_vertices[i];
+
+		uint32_t qx = quantize(coordinates[2*vindex], header.xmin, scale_x, qmax);
+		uint32_t qy = quantize(coordinates[2*vindex+1], header.ymin, scale_y, qmax);
+
+		order[i] = make_pair(morton_key(qx, qy), vindex);
+	}
+
+	sort(order.begin(), order.end());
+
+	//Renumber the vertices and encode them
+	vector<uint32_t> new_index(slot_count, 0);
+	vector<unsigned char> vertex_stream;
+	vertex_stream.reserve(4 * order.size());
+
+	uint64_t previous_x = 0;
+	uint64_t previous_y = 0;
+
+	for(unsigned int i=0; i<order.size(); i++) {
+		uint32_t vindex = order[i].second;
+		new_index[vindex] = i+1;
+
+		uint64_t x, y;
+		if(quantization_bits > 0) {
+			x = quantize(coordinates[2*vindex], header.xmin, scale_x, qmax);
+			y = quantize(coordinates[2*vindex+1], header.ymin, scale_y, qmax);
+		}
+		else {
+			x = double_bits(coordinates[2*vindex]);
+			y = double_bits(coordinates[2*vindex+1]);
+		}
+
+		put_varint(vertex_stream, zigzag_encode(int64_t(x - previous_x)));
+		put_varint(vertex_stream, zigzag_encode(int64_t(y - previous_y)));
+
+		previous_x = x;
+		previous_y = y;
+	}
+
+	//Renumber, rotate and sort the triangles
+	vector<EncodedTriangle> triangles;
+	triangles.reserve(vertex_indices.size() / 3);
+
+	for(unsigned int i=1; i<vertex_indices.size()/3; i++) {
+		if(vertex_indices[3*i] == 0)
+			continue;
+
+		EncodedTriangle tri;
+		int first = 0;
+
+		for(int j=0; j<3; j++) {
+			uint32_t vindex = vertex_indices[3*i+j];
+			if(vindex >= slot_count || new_index[vindex] == 0) {
+				printf("Error: triangle %u references a missing vertex\n", i);
+				return false;
+			}
+
+			tri.v[j] = new_index[vindex];
+			if(tri.v[j] < tri.v[first])
+				first = j;
+		}
+
+		//Rotating keeps the orientation
+		EncodedTriangle rotated;
+		for(int j=0; j<3; j++)
+			rotated.v[j] = tri.v[(first + j) % 3];
+
+		triangles.push_back(rotated);
+	}
+
+	sort(triangles.begin(), triangles.end());
+
+	header.triangle_count = triangles.size();
+
+	vector<unsigned char> triangle_stream;
+	triangle_stream.reserve(4 * triangles.size());
+
+	uint32_t previous_first = 0;
+	for(unsigned int i=0; i<triangles.size(); i++) {
+		const EncodedTriangle& tri = triangles[i];
+
+		put_varint(triangle_stream, tri.v[0] - previous_first);
+		put_varint(triangle_stream, zigzag_encode(int64_t(tri.v[1]) - int64_t(tri.v[0])));
+		put_varint(triangle_stream, zigzag_encode(int64_t(tri.v[2]) - int64_t(tri.v[0])));
+
+		previous_first = tri.v[0];
+	}
+
+	header.vertex_stream_size = vertex_stream.size();
+	header.triangle_stream_size = triangle_stream.size();
+
+	//Write the file
+	FILE* handle = fopen(filename, "wb");
+	if(handle == NULL) {
+		printf("Error opening %s for writing\n", filename);
+		return false;
+	}
+
+	int ret = (fwrite(&header, sizeof(CompressedMeshHeader), 1, handle) == 1);
+
+	if(ret == true && vertex_stream.empty() == false)
+		ret = (fwrite(&vertex_stream[0], 1, vertex_stream.size(), handle) == vertex_stream.size());
+
+	if(ret == true && triangle_stream.empty() == false)
+		ret = (fwrite(&triangle_stream[0], 1, triangle_stream.size(), handle) == triangle_stream.size());
+
+	if(fclose(handle) != 0)
+		ret = false;
+
+	if(ret == false)
+		printf("Error writing the compressed mesh file %s\n", filename);
+
+	return ret;
+}
+
+//Read and decode a compressed mesh file
+int CompressedMeshFile::Read(const char* filename) {
+	Clear();
+
+	int file_descriptor = open(filename, O_RDONLY);
+	if(file_descriptor < 0) {
+		printf("Error opening the compressed mesh file %s\n", filename);
+		return false;
+	}
+
+	struct stat file_stat;
+	if(fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size < (off_t) sizeof(CompressedMeshHeader)) {
+		printf("Error: %s is too small to be a compressed mesh file\n", filename);
+
+		close(file_descriptor);
+		return false;
+	}
+
+	size_t mapped_size = (size_t) file_stat.st_size;
+	void* mapped_data = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+
+	if(mapped_data == MAP_FAILED) {
+		printf("Error mapping the compressed mesh file %s\n", filename);
+		return false;
+	}
+
+	//The streams are decoded front to back
+	madvise(mapped_data, mapped_size, MADV_SEQUENTIAL);
+
+	CompressedMeshHeader header;
+	memcpy(&header, mapped_data, sizeof(CompressedMeshHeader));
+
+	int ret = true;
+
+	if(memcmp(header.magic, COMPRESSED_MESH_MAGIC, sizeof(header.magic)) != 0 || header.version != COMPRESSED_MESH_VERSION) {
+		printf("Error: %s is not a supported compressed mesh file\n", filename);
+		ret = false;
+	}
+	else if(header.byte_order != COMPRESSED_MESH_BYTE_ORDER) {
+		printf("The compressed mesh file was written with a different byte order\n");
+		ret = false;
+	}
+	else if(header.quantization_bits > 31 || header.vertex_stream_size > mapped_size || header.triangle_stream_size > mapped_size ||
+			sizeof(CompressedMeshHeader) + header.vertex_stream_size + header.triangle_stream_size > mapped_size) {
+		printf("Error: %s is truncated or corrupt\n", filename);
+		ret = false;
+	}
+
+	if(ret == true) {
+		const unsigned char* vertex_stream = (const unsigned char*) mapped_data + sizeof(CompressedMeshHeader);
+		const unsigned char* triangle_stream = vertex_stream + header.vertex_stream_size;
+
+		ret = decode_vertices(vertex_stream, triangle_stream, header);
+
+		if(ret == true)
+			ret = decode_triangles(triangle_stream, triangle_stream + header.triangle_stream_size, header);
+
+		if(ret == true)
+			ret = build_neighbours();
+
+		if(ret == false)
+			printf("Error: %s is truncated or corrupt\n", filename);
+	}
+
+	munmap(mapped_data, mapped_size);
+
+	if(ret == false)
+		Clear();
+
+	return ret;
+}
+
+//Returns true if the file starts with the compressed mesh magic
+int CompressedMeshFile::TestFile(const char* filename) {
+	FILE* handle = fopen(filename, "rb");
+	if(handle == NULL)
+		return false;
+
+	char magic[8];
+	size_t count = fread(magic, 1, sizeof(magic), handle);
+	fclose(handle);
+
+	if(count != sizeof(magic))
+		return false;
+
+	return (memcmp(magic, COMPRESSED_MESH_MAGIC, sizeof(magic)) == 0);
+}
+
+/////////////////////
+// Data management //
+/////////////////////
+
+//The decoded mesh, in the binary mesh file layout
+unsigned int CompressedMeshFile::GetVertexCount() {
+	return coordinates.size() / 2;
+}
+
+unsigned int CompressedMeshFile::GetTriangleCount() {
+	return vertex_indices.size() / 3;
+}
+
+const double* CompressedMeshFile::GetCoordinates() {
+	return &coordinates[0];
+}
+
+const uint32_t* CompressedMeshFile::GetVertexIndices() {
+	return &vertex_indices[0];
+}
+
+const uint32_t* CompressedMeshFile::GetNeighbours() {
+	return &neighbours[0];
+}
+
+int CompressedMeshFile::Clear() {
+	//Slot 0 is always reserved
+	coordinates.assign(2, NAN);
+	vertex_indices.assign(3, 0);
+	neighbours.assign(3, 0);
+
+	return true;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+int CompressedMeshFile::decode_vertices(const unsigned char* p, const unsigned char* end, CompressedMeshHeader& header) {
+	unsigned int vertex_count = header.vertex_count;
+	coordinates.resize(2*(size_t(vertex_count) + 1));
+
+	double qmax = double((uint64_t(1) << header.quantization_bits) - 1);
+	double step_x = (qmax > 0.0 ? (header.xmax - header.xmin) / qmax : 0.0);
+	double step_y = (qmax > 0.0 ? (header.ymax - header.ymin) / qmax : 0.0);
+
+	uint64_t x = 0;
+	uint64_t y = 0;
+
+	for(unsigned int i=1; i<=vertex_count; i++) {
+		uint64_t dx, dy;
+		if(get_varint(p, end, dx) == false || get_varint(p, end, dy) == false)
+			return false;
+
+		x += uint64_t(zigzag_decode(dx));
+		y += uint64_t(zigzag_decode(dy));
+
+		if(header.quantization_bits > 0) {
+			coordinates[2*i] = header.xmin + double(x) * step_x;
+			coordinates[2*i+1] = header.ymin + double(y) * step_y;
+		}
+		else {
+			memcpy(&coordinates[2*i], &x, sizeof(double));
+			memcpy(&coordinates[2*i+1], &y, sizeof(double));
+		}
+	}
+
+	return true;
+}
+
+int CompressedMeshFile::decode_triangles(const unsigned char* p, const unsigned char* end, CompressedMeshHeader& header) {
+	unsigned int triangle_count = header.triangle_count;
+	vertex_indices.resize(3*(size_t(triangle_count) + 1));
+
+	int64_t first = 0;
+
+	for(unsigned int i=1; i<=triangle_count; i++) {
+		uint64_t delta, offset1, offset2;
+		if(get_varint(p, end, delta) == false || get_varint(p, end, offset1) == false || get_varint(p, end, offset2) == false)
+			return false;
+
+		first += int64_t(delta);
+
+		int64_t v[3];
+		v[0] = first;
+		v[1] = first + zigzag_decode(offset1);
+		v[2] = first + zigzag_decode(offset2);
+
+		for(int j=0; j<3; j++) {
+			if(v[j] < 1 || v[j] > int64_t(header.vertex_count))
+				return false;
+
+			vertex_indices[3*i+j] = uint32_t(v[j]);
+		}
+	}
+
+	return true;
+}
+
+//Pair up the triangles that share an edge
+int CompressedMeshFile::build_neighbours() {
+	unsigned int triangle_count = GetTriangleCount();
+	neighbours.assign(3*size_t(triangle_count), 0);
+
+	//One entry per edge, keyed by its sorted end points
+	vector< pair<uint64_t, uint32_t> > edges;
+	edges.reserve(3*size_t(triangle_count));
+
+	for(unsigned int i=1; i<triangle_count; i++) {
+		for(int j=0; j<3; j++) {
+			uint64_t a = vertex_indices[3*i + (j+1)%3];
+			uint64_t b = vertex_indices[3*i + (j+2)%3];
+
+			uint64_t key = (a < b ? (a << 32) | b : (b << 32) | a);
+			edges.push_back(make_pair(key, 3*i + j));
+		}
+	}
+
+	sort(edges.begin(), edges.end());
+
+	//Edges shared by exactly two triangles are interior edges
+	for(unsigned int i=0; i<edges.size(); ) {
+		unsigned int run_end = i+1;
+		while(run_end < edges.size() && edges[run_end].first == edges[i].first)
+			run_end++;
+
+		if(run_end - i == 2) {
+			uint32_t slot0 = edges[i].second;
+			uint32_t slot1 = edges[i+1].second;
+
+			neighbours[slot0] = slot1 / 3;
+			neighbours[slot1] = slot0 / 3;
+		}
+
+		i = run_end;
+	}
+
+	return true;
+}
@@ -0,0 +1,97 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <vector>
+using namespace std;
+
+#ifndef COMPRESSED_MESH_FILE
+#define COMPRESSED_MESH_FILE
+
+//The compressed mesh file layout
+// + a fixed size header
+// + a vertex stream: the vertices in spatial (morton) order, each coordinate a zigzag varint delta from the previous vertex
+//   - quantized files store deltas of the quantized coordinates
+//   - lossless files store deltas of the ieee bit patterns
+// + a triangle stream: the triangles rotated so their smallest vertex comes first and sorted
+//   - each triangle is the varint delta of its first vertex, then zigzag varint offsets of the other two
+// + adjacency is not stored, it is rebuilt from the shared edges when the file is read
+// + vertices and triangles are renumbered densely from 1 on the way through
+#define COMPRESSED_MESH_MAGIC		"TRIMESHZ"
+#define COMPRESSED_MESH_VERSION		1
+#define COMPRESSED_MESH_BYTE_ORDER	0x01020304
+
+struct CompressedMeshHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+
+	uint32_t vertex_count;
+	uint32_t triangle_count;
+
+	//0 for lossless coordinates
+	uint32_t quantization_bits;
+	uint32_t reserved;
+
+	//The bounding box the coordinates are quantized in
+	double xmin, ymin;
+	double xmax, ymax;
+
+	uint64_t vertex_stream_size;
+	uint64_t triangle_stream_size;
+};
+
+//Encodes and decodes compressed mesh files
+// + the mesh is passed in the binary mesh file layout: slot 0 reserved, NaN coordinates and 0 vertex indices mark empty slots
+class CompressedMeshFile {
+public:
+	CompressedMeshFile();
+	~CompressedMeshFile();
+
+	//////////////
+	// File i/o //
+	//////////////
+
+	//Encode a mesh and write it to a file
+	// + quantization_bits of 0 keeps the coordinates exactly, otherwise 1 to 31 bits are kept per coordinate
+	int Write(const char* filename, const vector<double>& coordinates, const vector<uint32_t>& vertex_indices, unsigned int quantization_bits);
+
+	//Read and decode a compressed mesh file
+	int Read(const char* filename);
+
+	//Returns true if the file starts with the compressed mesh magic
+	static int TestFile(const char* filename);
+
+	/////////////////////
+	// Data management //
+	/////////////////////
+
+	//The decoded mesh, in the binary mesh file layout
+	unsigned int GetVertexCount();
+	unsigned int GetTriangleCount();
+
+	const double* GetCoordinates();
+	const uint32_t* GetVertexIndices();
+	const uint32_t* GetNeighbours();
+
+	int Clear();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	int decode_vertices(const unsigned char* p, const unsigned char* end, CompressedMeshHeader& header);
+	int decode_triangles(const unsigned char* p, const unsigned char* end, CompressedMeshHeader& header);
+
+	//Pair up the triangles that share an edge
+	int build_neighbours();
+
+	//The decoded mesh
+	vector<double> coordinates;
+	vector<uint32_t> vertex_indices;
+	vector<uint32_t> neighbours;
+};
+
+#endif
@@ -0,0 +1,957 @@
+#include "delaunay_refiner.h"
+
+DelaunayRefiner::DelaunayRefiner(GlobalMeshData* global_mesh_data) {
+	this->global_mesh_data = global_mesh_data;
+
+	triangle_list = NULL;
+	vertex_list = NULL;
+
+	desired_edge_length = 0.0;
+	minimum_angle = 20.0;
+
+	sizing_function = NULL;
+
+	maximum_radius_edge_ratio = 0.0;
+	maximum_circumradius = 0.0;
+	minimum_edge_length = 0.0;
+
+	inserted_vertex_count = 0;
+
+	triangle_owners = NULL;
+	partition = 0;
+
+	next_vindex = 0;
+	end_vindex = 0;
+	next_tindex = 0;
+	end_tindex = 0;
+}
+
+DelaunayRefiner::~DelaunayRefiner() {
+}
+
+/////////////
+// Options //
+/////////////
+
+//0 turns the size criterion off
+int DelaunayRefiner::SetDesiredEdgeLength(double desired_edge_length) {
+	if(desired_edge_length < 0)
+		return false;
+
+	this->desired_edge_length = desired_edge_length;
+	return true;
+}
+
+//In degrees, 0 turns the angle criterion off
+int DelaunayRefiner::SetMinimumAngle(double minimum_angle) {
+	if(minimum_angle < 0 || minimum_angle >= 60.0)
+		return false;
+
+	this->minimum_angle = minimum_angle;
+	return true;
+}
+
+//A desired edge length that changes over the mesh, looked up at the centroid of every triangle
+int DelaunayRefiner::SetSizingFunction(SizingFunction* sizing_function) {
+	if(sizing_function != NULL && sizing_function->IsEmpty() == true)
+		sizing_function = NULL;
+
+	this->sizing_function = sizing_function;
+	return true;
+}
+
+////////////////
+// Refinement //
+////////////////
+
+//Refine the triangles of a complex
+int DelaunayRefiner::Refine(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list) {
+	this->triangle_list = &triangle_list;
+	this->vertex_list = &vertex_list;
+
+	inserted_vertex_count = 0;
+
+	if(compute_criteria() == false)
+		return false;
+
+	queue_candidates();
+	printf("Refining %u bad triangles\n", (unsigned int) candidates.size());
+
+	unsigned int skipped_count = run_refinement();
+
+	printf("Inserted %u vertices; skipped %u triangles that could not be refined\n", inserted_vertex_count, skipped_count);
+	return true;
+}
+
+//Refine the triangles of a complex, partition_count strips at a time
+int DelaunayRefiner::RefinePartitioned(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list, unsigned int partition_count) {
+	if(partition_count < 2 || triangle_list.size() < partition_count * REFINER_MIN_PARTITION_TRIANGLES)
+		return Refine(triangle_list, vertex_list);
+
+	this->triangle_list = &triangle_list;
+	this->vertex_list = &vertex_list;
+
+	inserted_vertex_count = 0;
+
+	if(compute_criteria() == false)
+		return false;
+
+	//Cut the mesh into strips across its longer side, by the centroids of the triangles
+	double xmin = 0.0, xmax = 0.0, ymin = 0.0, ymax = 0.0;
+	vector<Vector2d> centroids(triangle_list.size());
+	vector<double> cuts;
+	int first = true;
+
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(triangle_list[i]);
+		if(tri == NULL)
+			continue;
+
+		centroids[i] = (*tri->GetVertex(0) + *tri->GetVertex(1) + *tri->GetVertex(2)) / 3.0;
+
+		if(first == true) {
+			xmin = xmax = centroids[i].x;
+			ymin = ymax = centroids[i].y;
+			first = false;
+		}
+
+		xmin = min(xmin, centroids[i].x);
+		xmax = max(xmax, centroids[i].x);
+		ymin = min(ymin, centroids[i].y);
+		ymax = max(ymax, centroids[i].y);
+	}
+
+	int cut_x = (xmax - xmin >= ymax - ymin);
+
+	//Every strip gets the same number of triangles
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		if(global_mesh_data->GetTriangle(triangle_list[i]) != NULL)
+			cuts.push_back(cut_x ? centroids[i].x : centroids[i].y);
+	}
+
+	if(cuts.empty() == true)
+		return false;
+
+	sort(cuts.begin(), cuts.end());
+
+	vector<double> strip_starts;
+	for(unsigned int i=1; i<partition_count; i++)
+		strip_starts.push_back(cuts[(size_t(i) * cuts.size()) / partition_count]);
+
+	//Each strip needs slots for about as many vertices as an equilateral mesh of its triangles at their target size
+	//has triangles, half as many again for high minimum angles, and room for the angle criterion to split every
+	//triangle it starts with
+	vector<vector<unsigned int> > strip_triangles(partition_count);
+	vector<double> strip_target_counts(partition_count, 0.0);
+	vector<int> strip_of(triangle_list.size(), -1);
+
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(triangle_list[i]);
+		if(tri == NULL)
+			continue;
+
+		int strip = upper_bound(strip_starts.begin(), strip_starts.end(), cut_x ? centroids[i].x : centroids[i].y) - strip_starts.begin();
+
+		strip_of[i] = strip;
+		strip_triangles[strip].push_back(triangle_list[i]);
+		//The size the triangle is refined to, at its centroid
+		double size = desired_edge_length;
+		if(sizing_function != NULL) {
+			double local_size = sizing_function->Evaluate(centroids[i]);
+			if(local_size > 0 && (size <= 0 || local_size < size))
+				size = local_size;
+		}
+
+		if(size > 0) {
+			Vector2d e1 = *tri->GetVertex(1) - *tri->GetVertex(0);
+			Vector2d e2 = *tri->GetVertex(2) - *tri->GetVertex(0);
+			strip_target_counts[strip] += 0.5 * fabs(e1.x*e2.y - e1.y*e2.x) / (0.25 * sqrt(3.0) * size * size);
+		}
+	}
+
+	vector<double> vertex_budgets(partition_count, 0.0);
+	double total_vertex_budget = 0.0;
+
+	for(unsigned int i=0; i<partition_count; i++) {
+		vertex_budgets[i] = strip_triangles[i].size() + 16.0 + 1.5 * strip_target_counts[i];
+
+		total_vertex_budget += vertex_budgets[i];
+	}
+
+	double budget_scale = min(1.0, double(REFINER_MAX_RESERVED_VERTICES) / total_vertex_budget);
+
+	//Reserve the slots, every insertion takes one vertex and at most two triangle slots
+	unsigned int first_vindex = global_mesh_data->GetVertexCount();
+	unsigned int first_tindex = global_mesh_data->GetTriangleCount();
+
+	vector<unsigned int> strip_first_vindices(partition_count);
+	vector<unsigned int> strip_vertex_counts(partition_count);
+
+	unsigned int reserved_vertex_count = 0;
+	for(unsigned int i=0; i<partition_count; i++) {
+		strip_first_vindices[i] = reserved_vertex_count;
+		strip_vertex_counts[i] = (unsigned int) (vertex_budgets[i] * budget_scale);
+
+		reserved_vertex_count += strip_vertex_counts[i];
+	}
+
+	global_mesh_data->ResizeVertexList(first_vindex + reserved_vertex_count);
+	global_mesh_data->ResizeTriangleList(first_tindex + 2 * reserved_vertex_count);
+
+	vector<int> owners(first_tindex + 2 * reserved_vertex_count, -1);
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		if(strip_of[i] >= 0)
+			owners[triangle_list[i]] = strip_of[i];
+	}
+
+	printf("Refining %u strips in parallel, %u vertex slots reserved\n", partition_count, reserved_vertex_count);
+
+	//Refine the strips
+	vector<vector<unsigned int> > strip_vertices(partition_count);
+	vector<unsigned int> strip_triangle_counts(partition_count);
+	vector<unsigned int> strip_inserted_counts(partition_count, 0);
+
+	for(unsigned int i=0; i<partition_count; i++)
+		strip_triangle_counts[i] = strip_triangles[i].size();
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int i=0; i<int(partition_count); i++) {
+		DelaunayRefiner strip_refiner(global_mesh_data);
+
+		strip_refiner.desired_edge_length = desired_edge_length;
+		strip_refiner.minimum_angle = minimum_angle;
+		strip_refiner.sizing_function = sizing_function;
+		strip_refiner.maximum_radius_edge_ratio = maximum_radius_edge_ratio;
+		strip_refiner.maximum_circumradius = maximum_circumradius;
+		strip_refiner.minimum_edge_length = minimum_edge_length;
+
+		strip_refiner.triangle_list = &strip_triangles[i];
+		strip_refiner.vertex_list = &strip_vertices[i];
+
+		strip_refiner.triangle_owners = &owners;
+		strip_refiner.partition = i;
+
+		strip_refiner.next_vindex = first_vindex + strip_first_vindices[i];
+		strip_refiner.end_vindex = strip_refiner.next_vindex + strip_vertex_counts[i];
+		strip_refiner.next_tindex = first_tindex + 2 * strip_first_vindices[i];
+		strip_refiner.end_tindex = strip_refiner.next_tindex + 2 * strip_vertex_counts[i];
+
+		strip_refiner.queue_candidates();
+		strip_refiner.run_refinement();
+
+		strip_inserted_counts[i] = strip_refiner.inserted_vertex_count;
+	}
+
+	//Hand the new elements to the complex
+	for(unsigned int i=0; i<partition_count; i++) {
+		triangle_list.insert(triangle_list.end(), strip_triangles[i].begin() + strip_triangle_counts[i], strip_triangles[i].end());
+		vertex_list.insert(vertex_list.end(), strip_vertices[i].begin(), strip_vertices[i].end());
+
+		inserted_vertex_count += strip_inserted_counts[i];
+	}
+
+	//The triangles along the seams were left alone, the edges between them and their strips may not be Delaunay
+	vector<Triangle*> seam_triangles;
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(triangle_list[i]);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			Triangle* adj_tri = tri->GetAdjacentTriangle(j);
+
+			if(adj_tri != NULL && owners[adj_tri->GetTriangleIndex()] != owners[tri->GetTriangleIndex()]) {
+				seam_triangles.push_back(tri);
+				break;
+			}
+		}
+	}
+
+	printf("Inserted %u vertices in the strips, refining %u seam triangles\n", inserted_vertex_count, (unsigned int) seam_triangles.size());
+
+	if(compact_slots(first_vindex, first_tindex) == false)
+		return false;
+
+	legalize_triangles(seam_triangles);
+
+	//Finish serially, the seams are the only bad triangles left unless a strip ran out of slots
+	queue_candidates();
+	printf("Refining %u bad triangles\n", (unsigned int) candidates.size());
+
+	unsigned int skipped_count = run_refinement();
+
+	printf("Inserted %u vertices; skipped %u triangles that could not be refined\n", inserted_vertex_count, skipped_count);
+	return true;
+}
+
+//The number of vertices inserted by the last Refine
+unsigned int DelaunayRefiner::GetInsertedVertexCount() {
+	return inserted_vertex_count;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//Set the refinement criteria for the triangles being refined
+int DelaunayRefiner::compute_criteria() {
+	//An equilateral triangle with the desired edge length has a circumradius of desired_edge_length / sqrt(3)
+	maximum_circumradius = desired_edge_length / sqrt(3.0);
+
+	//The smallest angle of a triangle is asin(shortest edge / (2 circumradius))
+	maximum_radius_edge_ratio = 0.0;
+	if(minimum_angle > 0)
+		maximum_radius_edge_ratio = 1.0 / (2.0 * sin(minimum_angle * PI / 180.0));
+
+	//Measure the mesh so the smallest feature worth fixing scales with it
+	double total_edge_length = 0.0;
+	unsigned int edge_count = 0;
+
+	Prism bounds;
+
+	for(unsigned int i=0; i<triangle_list->size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle((*triangle_list)[i]);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			total_edge_length += tri->ComputeEdgeLength(j);
+
+			if(edge_count == 0)
+				bounds.SetMinMax(*tri->GetVertex(j), *tri->GetVertex(j));
+			else
+				bounds.Expand(*tri->GetVertex(j));
+
+			edge_count++;
+		}
+	}
+
+	if(edge_count == 0)
+		return false;
+
+	double smallest_size = desired_edge_length;
+
+	if(sizing_function != NULL) {
+		sizing_function->BuildLookup(bounds);
+
+		if(smallest_size <= 0 || sizing_function->GetMinimumSize() < smallest_size)
+			smallest_size = sizing_function->GetMinimumSize();
+	}
+
+	double average_edge_length = total_edge_length / double(edge_count);
+	if(smallest_size > 0 && smallest_size < average_edge_length)
+		minimum_edge_length = 0.01 * smallest_size;
+	else
+		minimum_edge_length = 0.01 * average_edge_length;
+
+	return true;
+}
+
+//Queue every bad triangle
+int DelaunayRefiner::queue_candidates() {
+	while(candidates.empty() == false)
+		candidates.pop();
+
+	for(unsigned int i=0; i<triangle_list->size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle((*triangle_list)[i]);
+		if(tri != NULL)
+			push_candidate(tri);
+	}
+
+	return true;
+}
+
+//Fix the worst triangle left until there are none
+unsigned int DelaunayRefiner::run_refinement() {
+	unsigned int skipped_count = 0;
+
+	while(candidates.empty() == false) {
+		RefinementCandidate candidate = candidates.top();
+		candidates.pop();
+
+		if(is_candidate_current(candidate) == false)
+			continue;
+
+		//A strip that has used up its slots leaves the rest to the seam pass
+		if(has_free_slots() == false)
+			break;
+
+		Triangle* tri = global_mesh_data->GetTriangle(candidate.tindex);
+
+		if(refine_triangle(tri) == false) {
+			skipped_count++;
+			continue;
+		}
+
+		//A boundary split doesn't always reach the triangle that asked for it
+		if(is_candidate_current(candidate) == true)
+			candidates.push(candidate);
+	}
+
+	return skipped_count;
+}
+
+//How badly a triangle needs refining, anything over 1 is bad
+double DelaunayRefiner::compute_priority(Triangle* tri) {
+	Vector2d center;
+	double circumradius = 0.0;
+
+	if(tri->GetCircumcircle(center, circumradius) == false)
+		return 0.0;
+
+	double priority = 0.0;
+
+	double largest_circumradius = maximum_circumradius;
+
+	if(sizing_function != NULL) {
+		double size = sizing_function->Evaluate((*tri->GetVertex(0) + *tri->GetVertex(1) + *tri->GetVertex(2)) / 3.0);
+
+		if(size > 0 && (largest_circumradius <= 0 || size / sqrt(3.0) < largest_circumradius))
+			largest_circumradius = size / sqrt(3.0);
+	}
+
+	if(largest_circumradius > 0)
+		priority = circumradius / largest_circumradius;
+
+	if(maximum_radius_edge_ratio > 0) {
+		double shortest_edge_length = min(tri->ComputeEdgeLength(0), min(tri->ComputeEdgeLength(1), tri->ComputeEdgeLength(2)));
+
+		if(shortest_edge_length >= minimum_edge_length)
+			priority = max(priority, circumradius / (shortest_edge_length * maximum_radius_edge_ratio));
+	}
+
+	return priority;
+}
+
+//Queue a triangle if it is bad
+int DelaunayRefiner::push_candidate(Triangle* tri) {
+	//Triangles along the seams wait for the seam pass
+	if(is_interior(tri) == false)
+		return false;
+
+	double priority = compute_priority(tri);
+
+	//Leave some room so that triangles right at the limit don't get split
+	if(priority <= 1.0 + 1e-9)
+		return false;
+
+	RefinementCandidate candidate;
+	candidate.priority = priority;
+	candidate.tindex = tri->GetTriangleIndex();
+
+	for(int i=0; i<3; i++)
+		candidate.vertices[i] = tri->GetVertexIndex(i);
+
+	candidates.push(candidate);
+	return true;
+}
+
+//Returns true if the triangle hasn't changed since it was queued
+int DelaunayRefiner::is_candidate_current(RefinementCandidate& candidate) {
+	Triangle* tri = global_mesh_data->GetTriangle(candidate.tindex);
+	if(tri == NULL)
+		return false;
+
+	for(int i=0; i<3; i++) {
+		if(tri->GetVertexIndex(i) != candidate.vertices[i])
+			return false;
+	}
+
+	return true;
+}
+
+//Fix one bad triangle
+int DelaunayRefiner::refine_triangle(Triangle* tri) {
+	Vector2d center;
+	double circumradius = 0.0;
+
+	if(tri->GetCircumcircle(center, circumradius) == false)
+		return false;
+
+	Triangle* boundary_tri = tri;
+	int boundary_edge = 0;
+
+	Triangle* container = locate_point(center, boundary_tri, boundary_edge);
+
+	//The circumcenter is outside the mesh, split the boundary edge in the way instead
+	if(container == NULL) {
+		if(boundary_tri == NULL || is_interior(boundary_tri) == false)
+			return false;
+
+		return split_edge(boundary_tri, boundary_edge, (*boundary_tri->GetVertex((boundary_edge+1)%3) + *boundary_tri->GetVertex((boundary_edge+2)%3)) * 0.5);
+	}
+
+	if(is_interior(container) == false)
+		return false;
+
+	//Boundary edges the circumcenter encroaches on get split first
+	for(int i=0; i<3; i++) {
+		if(container->GetAdjacentTriangle(i) == NULL && encroaches_edge(container, i, center) == true)
+			return split_edge(container, i, (*container->GetVertex((i+1)%3) + *container->GetVertex((i+2)%3)) * 0.5);
+	}
+
+	return insert_vertex(center, container);
+}
+
+//Walk from a triangle to the one holding a point
+Triangle* DelaunayRefiner::locate_point(Vector2d pt, Triangle*& tri, int& opposing_vertex) {
+	Triangle* current = tri;
+
+	//A walk through a Delaunay mesh never visits a triangle twice, this only guards against broken meshes
+	unsigned int max_steps = triangle_list->size() + 3;
+
+	for(unsigned int step=0; step<max_steps; step++) {
+		int moved = false;
+
+		//Start with a different edge each step, so a walk through a mesh that isn't quite Delaunay can't cycle
+		for(int i=0; i<3; i++) {
+			int j = (i + step) % 3;
+
+			if(edge_side(current, j, pt) >= 0)
+				continue;
+
+			Triangle* adj_tri = current->GetAdjacentTriangle(j);
+			if(adj_tri == NULL) {
+				tri = current;
+				opposing_vertex = j;
+
+				return NULL;
+			}
+
+			//The walk can't go on into another strip
+			if(triangle_owners != NULL && (*triangle_owners)[adj_tri->GetTriangleIndex()] != partition) {
+				tri = NULL;
+				opposing_vertex = 0;
+
+				return NULL;
+			}
+
+			current = adj_tri;
+			moved = true;
+			break;
+		}
+
+		if(moved == false)
+			return current;
+	}
+
+	tri = NULL;
+	opposing_vertex = 0;
+
+	return NULL;
+}
+
+//Insert a new vertex inside a triangle or on one of its edges, then restore the Delaunay condition around it
+int DelaunayRefiner::insert_vertex(Vector2d pt, Triangle* tri) {
+	int on_edge = -1;
+	for(int i=0; i<3; i++) {
+		if(edge_side(tri, i, pt) != 0)
+			continue;
+
+		//On two edges means on a vertex
+		if(on_edge >= 0)
+			return false;
+
+		on_edge = i;
+	}
+
+	if(on_edge >= 0)
+		return split_edge(tri, on_edge, pt);
+
+	//Points too close to the vertices would only make slivers
+	for(int i=0; i<3; i++) {
+		if(tri->GetVertex(i)->distance(pt) < minimum_edge_length)
+			return false;
+	}
+
+	unsigned int vindex = append_vertex(new Vector2d(pt));
+
+	vector<Triangle*> old_triangles;
+	vector<Triangle*> new_triangles;
+
+	old_triangles.push_back(tri);
+
+	for(int i=0; i<3; i++)
+		new_triangles.push_back(create_triangle(tri->GetVertexIndex((i+1)%3), tri->GetVertexIndex((i+2)%3), vindex));
+
+	if(replace_triangles(old_triangles, new_triangles) == false) {
+		delete global_mesh_data->GetVertex(vindex);
+		global_mesh_data->SetVertex(vindex, NULL);
+
+		return false;
+	}
+
+	vertex_list->push_back(vindex);
+	inserted_vertex_count++;
+
+	return legalize_edges(vindex, new_triangles);
+}
+
+int DelaunayRefiner::split_edge(Triangle* tri, int opposing_vertex, Vector2d pt) {
+	unsigned int v1 = tri->GetVertexIndex((opposing_vertex+1)%3);
+	unsigned int v2 = tri->GetVertexIndex((opposing_vertex+2)%3);
+
+	if(tri->GetVertex((opposing_vertex+1)%3)->distance(pt) < minimum_edge_length || tri->GetVertex((opposing_vertex+2)%3)->distance(pt) < minimum_edge_length)
+		return false;
+
+	Triangle* adj_tri = tri->GetAdjacentTriangle(opposing_vertex);
+	if(adj_tri != NULL && is_interior(adj_tri) == false)
+		return false;
+
+	unsigned int vindex = append_vertex(new Vector2d(pt));
+
+	vector<Triangle*> old_triangles;
+	vector<Triangle*> new_triangles;
+
+	//Both triangles on the edge are split in two
+	old_triangles.push_back(tri);
+
+	if(adj_tri != NULL)
+		old_triangles.push_back(adj_tri);
+
+	for(unsigned int i=0; i<old_triangles.size(); i++) {
+		Triangle* old_tri = old_triangles[i];
+
+		unsigned int opposing_vindex = 0;
+		for(int j=0; j<3; j++) {
+			if(old_tri->GetVertexIndex(j) != v1 && old_tri->GetVertexIndex(j) != v2)
+				opposing_vindex = old_tri->GetVertexIndex(j);
+		}
+
+		new_triangles.push_back(create_triangle(opposing_vindex, v1, vindex));
+		new_triangles.push_back(create_triangle(opposing_vindex, vindex, v2));
+	}
+
+	if(replace_triangles(old_triangles, new_triangles) == false) {
+		delete global_mesh_data->GetVertex(vindex);
+		global_mesh_data->SetVertex(vindex, NULL);
+
+		return false;
+	}
+
+	vertex_list->push_back(vindex);
+	inserted_vertex_count++;
+
+	return legalize_edges(vindex, new_triangles);
+}
+
+//Replace some triangles with new ones made from their vertices and a new vertex
+int DelaunayRefiner::replace_triangles(vector<Triangle*>& old_triangles, vector<Triangle*>& new_triangles) {
+	//A degenerate new triangle means the vertex was too close to an edge, leave the mesh alone
+	int degenerate = false;
+	for(unsigned int i=0; i<new_triangles.size(); i++) {
+		if(new_triangles[i] == NULL)
+			degenerate = true;
+	}
+
+	if(degenerate == true) {
+		for(unsigned int i=0; i<new_triangles.size(); i++)
+			delete new_triangles[i];
+
+		new_triangles.clear();
+		return false;
+	}
+
+	//The neighbours of the old triangles
+	vector<Triangle*> outer_triangles;
+	for(unsigned int i=0; i<old_triangles.size(); i++) {
+		for(int j=0; j<3; j++) {
+			Triangle* adj_tri = old_triangles[i]->GetAdjacentTriangle(j);
+			if(adj_tri != NULL && find(old_triangles.begin(), old_triangles.end(), adj_tri) == old_triangles.end())
+				outer_triangles.push_back(adj_tri);
+		}
+	}
+
+	//Connect every new edge to the new or outer triangle that shares it
+	for(unsigned int i=0; i<new_triangles.size(); i++) {
+		Triangle* tri = new_triangles[i];
+
+		for(int j=0; j<3; j++) {
+			unsigned int v1 = tri->GetVertexIndex((j+1)%3);
+			unsigned int v2 = tri->GetVertexIndex((j+2)%3);
+
+			Triangle* adj_tri = NULL;
+
+			for(unsigned int k=0; k<new_triangles.size() && adj_tri == NULL; k++) {
+				if(k != i && new_triangles[k]->IsVertex(v1) && new_triangles[k]->IsVertex(v2))
+					adj_tri = new_triangles[k];
+			}
+
+			for(unsigned int k=0; k<outer_triangles.size() && adj_tri == NULL; k++) {
+				Triangle* outer_tri = outer_triangles[k];
+				if(outer_tri->IsVertex(v1) == false || outer_tri->IsVertex(v2) == false)
+					continue;
+
+				adj_tri = outer_tri;
+
+				for(int l=0; l<3; l++) {
+					if(outer_tri->GetVertexIndex(l) != v1 && outer_tri->GetVertexIndex(l) != v2)
+						outer_tri->SetAdjacentTriangle(l, tri);
+				}
+			}
+
+			tri->SetAdjacentTriangle(j, adj_tri);
+		}
+	}
+
+	//The new triangles take over the slots of the old ones, and the rest are appended
+	for(unsigned int i=0; i<new_triangles.size(); i++) {
+		if(i < old_triangles.size()) {
+			unsigned int tindex = old_triangles[i]->GetTriangleIndex();
+
+			delete old_triangles[i];
+			global_mesh_data->SetTriangle(tindex, new_triangles[i]);
+		}
+		else
+			triangle_list->push_back(append_triangle(new_triangles[i]));
+	}
+
+	old_triangles.clear();
+	return true;
+}
+
+//Lawson flips around a new vertex
+int DelaunayRefiner::legalize_edges(unsigned int vindex, vector<Triangle*>& triangles) {
+	vector<Triangle*> flip_stack = triangles;
+	vector<Triangle*> final_triangles;
+
+	while(flip_stack.empty() == false) {
+		Triangle* tri = flip_stack.back();
+		flip_stack.pop_back();
+
+		//Only the edge across from the new vertex can be illegal
+		int opposing_vertex = -1;
+		for(int i=0; i<3; i++) {
+			if(tri->GetVertexIndex(i) == vindex)
+				opposing_vertex = i;
+		}
+
+		if(opposing_vertex < 0)
+			continue;
+
+		//Edges to triangles along a seam are flipped in the seam pass
+		Triangle* adj_tri = tri->GetAdjacentTriangle(opposing_vertex);
+		if(adj_tri != NULL && is_interior(adj_tri) == true) {
+			Vector2d* external_vertex = NULL;
+			for(int i=0; i<3; i++) {
+				if(tri->IsVertex(adj_tri->GetVertexIndex(i)) == false)
+					external_vertex = adj_tri->GetVertex(i);
+			}
+
+			//After the flip both triangles hold the new vertex, and their far edges have to be checked
+			if(external_vertex != NULL && tri->TestPointInsideCircumcircle(*external_vertex) == true) {
+				if(tri->PerformDelaunayFlip(opposing_vertex) == true) {
+					flip_stack.push_back(tri);
+					flip_stack.push_back(adj_tri);
+
+					continue;
+				}
+			}
+		}
+
+		final_triangles.push_back(tri);
+	}
+
+	//The triangles around the new vertex are the only ones that changed
+	for(unsigned int i=0; i<final_triangles.size(); i++)
+		push_candidate(final_triangles[i]);
+
+	return true;
+}
+
+//Lawson flips over every edge of some triangles and of the triangles flipped in their place
+int DelaunayRefiner::legalize_triangles(vector<Triangle*>& triangles) {
+	vector<Triangle*> flip_stack = triangles;
+	unsigned int flip_count = 0;
+
+	while(flip_stack.empty() == false) {
+		Triangle* tri = flip_stack.back();
+		flip_stack.pop_back();
+
+		Vector2d center;
+		double circumradius = 0.0;
+
+		if(tri->GetCircumcircle(center, circumradius) == false)
+			continue;
+
+		for(int i=0; i<3; i++) {
+			Triangle* adj_tri = tri->GetAdjacentTriangle(i);
+			if(adj_tri == NULL)
+				continue;
+
+			Vector2d* external_vertex = NULL;
+			for(int j=0; j<3; j++) {
+				if(tri->IsVertex(adj_tri->GetVertexIndex(j)) == false)
+					external_vertex = adj_tri->GetVertex(j);
+			}
+
+			//Points only just inside are left alone, the seams of regular grids are full of cocircular
+			//vertices that would otherwise be flipped back and forth
+			if(external_vertex == NULL || external_vertex->distance(center) >= circumradius * (1.0 - 1e-9))
+				continue;
+
+			if(tri->PerformDelaunayFlip(i) == true) {
+				flip_stack.push_back(tri);
+				flip_stack.push_back(adj_tri);
+
+				flip_count++;
+				break;
+			}
+		}
+	}
+
+	printf("Flipped %u seam edges\n", flip_count);
+	return true;
+}
+
+//Create a ccw triangle
+Triangle* DelaunayRefiner::create_triangle(unsigned int v0, unsigned int v1, unsigned int v2) {
+	Triangle* tri = new Triangle(global_mesh_data->GetGlobalVertexList());
+
+	tri->SetVertex(0, v0);
+	tri->SetVertex(1, v1);
+	tri->SetVertex(2, v2);
+
+	if(tri->OrientVertices() == false) {
+		delete tri;
+		return NULL;
+	}
+
+	return tri;
+}
+
+//Add a vertex or triangle to the global mesh, in the reserved slots of the strip when refining one
+unsigned int DelaunayRefiner::append_vertex(Vector2d* vertex) {
+	if(triangle_owners == NULL)
+		return global_mesh_data->AppendVertex(vertex);
+
+	global_mesh_data->SetVertex(next_vindex, vertex);
+	return next_vindex++;
+}
+
+unsigned int DelaunayRefiner::append_triangle(Triangle* tri) {
+	if(triangle_owners == NULL)
+		return global_mesh_data->AppendTriangle(tri);
+
+	global_mesh_data->SetTriangle(next_tindex, tri);
+	(*triangle_owners)[next_tindex] = partition;
+
+	return next_tindex++;
+}
+
+//Returns true if there are slots left for another insertion
+int DelaunayRefiner::has_free_slots() {
+	if(triangle_owners == NULL)
+		return true;
+
+	//An insertion adds one vertex and at most two triangles
+	return (next_vindex < end_vindex && next_tindex + 2 <= end_tindex);
+}
+
+//Returns true if this refiner may change the triangle, always true outside partitioned refinement
+int DelaunayRefiner::is_interior(Triangle* tri) {
+	if(triangle_owners == NULL)
+		return true;
+
+	if((*triangle_owners)[tri->GetTriangleIndex()] != partition)
+		return false;
+
+	for(int i=0; i<3; i++) {
+		Triangle* adj_tri = tri->GetAdjacentTriangle(i);
+		if(adj_tri != NULL && (*triangle_owners)[adj_tri->GetTriangleIndex()] != partition)
+			return false;
+	}
+
+	return true;
+}
+
+//Pack the vertices and triangles from the first reserved slots on together, and renumber them everywhere
+int DelaunayRefiner::compact_slots(unsigned int first_vindex, unsigned int first_tindex) {
+	//Move every vertex down to the first free slot
+	vector<unsigned int> vertex_map(global_mesh_data->GetVertexCount() - first_vindex, 0);
+	unsigned int vertex_count = first_vindex;
+
+	for(unsigned int i=first_vindex; i<global_mesh_data->GetVertexCount(); i++) {
+		Vector2d* vertex = global_mesh_data->GetVertex(i);
+		if(vertex == NULL)
+			continue;
+
+		if(i != vertex_count) {
+			global_mesh_data->SetVertex(vertex_count, vertex);
+			global_mesh_data->SetVertex(i, NULL);
+		}
+
+		vertex_map[i - first_vindex] = vertex_count++;
+	}
+
+	vector<unsigned int> triangle_map(global_mesh_data->GetTriangleCount() - first_tindex, 0);
+	unsigned int triangle_count = first_tindex;
+
+	for(unsigned int i=first_tindex; i<global_mesh_data->GetTriangleCount(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		if(i != triangle_count) {
+			global_mesh_data->SetTriangle(triangle_count, tri);
+			global_mesh_data->SetTriangle(i, NULL);
+		}
+
+		triangle_map[i - first_tindex] = triangle_count++;
+	}
+
+	if(global_mesh_data->ResizeVertexList(vertex_count) == false || global_mesh_data->ResizeTriangleList(triangle_count) == false)
+		return false;
+
+	//The triangles know their new slots, the complex and the vertex indices still have to be renumbered
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<long(triangle_list->size()); i++) {
+		if((*triangle_list)[i] >= first_tindex)
+			(*triangle_list)[i] = triangle_map[(*triangle_list)[i] - first_tindex];
+
+		Triangle* tri = global_mesh_data->GetTriangle((*triangle_list)[i]);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			unsigned int vindex = tri->GetVertexIndex(j);
+			if(vindex >= first_vindex)
+				tri->SetVertex(j, vertex_map[vindex - first_vindex]);
+		}
+	}
+
+	for(unsigned int i=0; i<vertex_list->size(); i++) {
+		if((*vertex_list)[i] >= first_vindex)
+			(*vertex_list)[i] = vertex_map[(*vertex_list)[i] - first_vindex];
+	}
+
+	return true;
+}
+
+//Which side of the edge across from a vertex a point is on, +1 inside, -1 outside, 0 on the edge
+int DelaunayRefiner::edge_side(Triangle* tri, int opposing_vertex, Vector2d pt) {
+	Vector2d* v0 = tri->GetVertex(opposing_vertex);
+	Vector2d* v1 = tri->GetVertex((opposing_vertex+1)%3);
+	Vector2d* v2 = tri->GetVertex((opposing_vertex+2)%3);
+
+	double side = (v2->x - v1->x)*(pt.y - v1->y) - (v2->y - v1->y)*(pt.x - v1->x);
+	double orientation = (v2->x - v1->x)*(v0->y - v1->y) - (v2->y - v1->y)*(v0->x - v1->x);
+
+	//The tolerance is relative to the edge, circumcenters of thin triangles are only accurate to about that,
+	//and anything closer than EFF_ZERO would make a triangle OrientVertices rejects
+	if(fabs(side) <= max(1e-9 * v1->distance2(*v2), EFF_ZERO))
+		return 0;
+
+	return ((side > 0) == (orientation > 0) ? 1 : -1);
+}
+
+//Returns true if a point is inside the diametral circle of the edge across from a vertex
+int DelaunayRefiner::encroaches_edge(Triangle* tri, int opposing_vertex, Vector2d pt) {
+	Vector2d* v1 = tri->GetVertex((opposing_vertex+1)%3);
+	Vector2d* v2 = tri->GetVertex((opposing_vertex+2)%3);
+
+	//The edge subtends an obtuse angle at any point inside its diametral circle
+	double dot = (v1->x - pt.x)*(v2->x - pt.x) + (v1->y - pt.y)*(v2->y - pt.y);
+
+	return (dot < 0);
+}
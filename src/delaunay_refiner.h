@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+using namespace std;
+
+//Triangulation algorithm related code
+#include "utility.h"
+#include "vector2d.h"
+#include "triangle.h"
+
+//Mesh data code
+#include "global_mesh_data.h"
+#include "sizing_function.h"
+
+#ifndef DELAUNAY_REFINER
+#define DELAUNAY_REFINER
+
+//Partitioned refinement isn't worth it below this many triangles per partition
+#define REFINER_MIN_PARTITION_TRIANGLES		1000
+
+//The most vertex slots partitioned refinement reserves, refinement past it is left to the serial seam pass
+#define REFINER_MAX_RESERVED_VERTICES		(1u << 24)
+
+//A triangle waiting to be refined
+// + the vertices are kept so an entry for a triangle that has changed since it was queued can be told apart
+struct RefinementCandidate {
+	double priority;
+
+	unsigned int tindex;
+	unsigned int vertices[3];
+
+	bool operator<(const RefinementCandidate& candidate) const {
+		return priority < candidate.priority;
+	}
+};
+
+//Refines a Delaunay mesh until its triangles are well shaped and small enough, in the manner of Ruppert and Chew
+// + a triangle is bad if its smallest angle is under the minimum angle, or if its circumradius is over that of an
+//   equilateral triangle with the desired edge length, which can come from a sizing function
+// + bad triangles are kept in a priority queue, worst first, and fixed by inserting their circumcenter
+// + a circumcenter outside the mesh, or inside the diametral circle of a boundary edge, splits that edge at its
+//   midpoint instead
+// + every insertion is followed by Lawson flips around the new vertex, so the mesh stays Delaunay
+// + the boundary of the mesh is the only constraint, there are no interior segments
+// + partitioned refinement cuts the mesh into strips that are refined at the same time, a strip only changes
+//   triangles whose neighbours are all its own, so the triangles along the seams stay as they were until a
+//   serial pass flips and refines them once the strips are done
+class DelaunayRefiner {
+public:
+	DelaunayRefiner(GlobalMeshData* global_mesh_data);
+	~DelaunayRefiner();
+
+	/////////////
+	// Options //
+	/////////////
+
+	//0 turns the size criterion off
+	int SetDesiredEdgeLength(double desired_edge_length);
+
+	//In degrees, 0 turns the angle criterion off
+	// + refinement is only guaranteed to finish for angles up to about 20.7 degrees
+	int SetMinimumAngle(double minimum_angle);
+
+	//A desired edge length that changes over the mesh, looked up at the centroid of every triangle
+	// + where it and the desired edge length both apply, the smaller one wins
+	// + its lookup is built for the bounds of the mesh when refinement starts, NULL turns it off
+	int SetSizingFunction(SizingFunction* sizing_function);
+
+	////////////////
+	// Refinement //
+	////////////////
+
+	//Refine the triangles of a complex
+	// + the new triangles and vertices are added to the global mesh and appended to the lists
+	// + a triangle that is replaced hands its global slot to one of the triangles replacing it
+	int Refine(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list);
+
+	//Refine the triangles of a complex, partition_count strips at a time
+	// + new vertices and triangles go to slots reserved for each strip, the slots are packed together
+	//   again before the seams are refined
+	// + small meshes and a partition count under 2 are refined serially
+	int RefinePartitioned(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list, unsigned int partition_count);
+
+	//The number of vertices inserted by the last Refine
+	unsigned int GetInsertedVertexCount();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//Set the refinement criteria for the triangles being refined
+	int compute_criteria();
+
+	//Queue every bad triangle, and fix them worst first
+	// + returns the number of bad triangles that couldn't be fixed
+	int queue_candidates();
+	unsigned int run_refinement();
+
+	//How badly a triangle needs refining, anything over 1 is bad
+	double compute_priority(Triangle* tri);
+
+	//Queue a triangle if it is bad
+	int push_candidate(Triangle* tri);
+
+	//Returns true if the triangle hasn't changed since it was queued
+	int is_candidate_current(RefinementCandidate& candidate);
+
+	//Fix one bad triangle
+	int refine_triangle(Triangle* tri);
+
+	//Walk from a triangle to the one holding a point
+	// + returns the triangle, or NULL if the point is outside the mesh, in which case tri and opposing_vertex
+	//   are the boundary edge the walk left through
+	// + tri is NULL if the walk got lost or would have to leave the strip
+	Triangle* locate_point(Vector2d pt, Triangle*& tri, int& opposing_vertex);
+
+	//Insert a new vertex inside a triangle or on one of its edges, then restore the Delaunay condition around it
+	int insert_vertex(Vector2d pt, Triangle* tri);
+	int split_edge(Triangle* tri, int opposing_vertex, Vector2d pt);
+
+	//Replace some triangles with new ones made from their vertices and a new vertex
+	int replace_triangles(vector<Triangle*>& old_triangles, vector<Triangle*>& new_triangles);
+
+	//Lawson flips around a new vertex
+	int legalize_edges(unsigned int vindex, vector<Triangle*>& triangles);
+
+	//Lawson flips over every edge of some triangles and of the triangles flipped in their place
+	int legalize_triangles(vector<Triangle*>& triangles);
+
+	//Create a ccw triangle
+	Triangle* create_triangle(unsigned int v0, unsigned int v1, unsigned int v2);
+
+	//Add a vertex or triangle to the global mesh, in the reserved slots of the strip when refining one
+	unsigned int append_vertex(Vector2d* vertex);
+	unsigned int append_triangle(Triangle* tri);
+
+	//Returns true if there are slots left for another insertion
+	int has_free_slots();
+
+	//Returns true if this refiner may change the triangle, always true outside partitioned refinement
+	// + the triangle and all its neighbours have to belong to the strip
+	int is_interior(Triangle* tri);
+
+	//Pack the vertices and triangles from the first reserved slots on together, and renumber them everywhere
+	int compact_slots(unsigned int first_vindex, unsigned int first_tindex);
+
+	//Which side of the edge across from a vertex a point is on, +1 inside, -1 outside, 0 on the edge
+	static int edge_side(Triangle* tri, int opposing_vertex, Vector2d pt);
+
+	//Returns true if a point is inside the diametral circle of the edge across from a vertex
+	static int encroaches_edge(Triangle* tri, int opposing_vertex, Vector2d pt);
+
+	//The mesh being refined
+	GlobalMeshData* global_mesh_data;
+
+	//The lists of the complex being refined
+	vector<unsigned int>* triangle_list;
+	vector<unsigned int>* vertex_list;
+
+	//Refinement options
+	double desired_edge_length;
+	double minimum_angle;
+
+	SizingFunction* sizing_function;
+
+	//The largest allowed circumradius to shortest edge ratio, and the largest allowed circumradius
+	double maximum_radius_edge_ratio;
+	double maximum_circumradius;
+
+	//Triangles with a shorter edge than this are left alone by the angle criterion, so slivers that can't
+	//be fixed don't refine forever
+	double minimum_edge_length;
+
+	//The bad triangles
+	priority_queue<RefinementCandidate> candidates;
+
+	unsigned int inserted_vertex_count;
+
+	//The strip that owns each triangle slot, NULL outside partitioned refinement
+	vector<int>* triangle_owners;
+	int partition;
+
+	//The reserved slots of the strip still free, [next, end)
+	unsigned int next_vindex;
+	unsigned int end_vindex;
+	unsigned int next_tindex;
+	unsigned int end_tindex;
+};
+
+#endif
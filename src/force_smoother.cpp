@@ -0,0 +1,277 @@
+#include "force_smoother.h"
+
+ForceSmoother::ForceSmoother(GlobalMeshData* global_mesh_data) {
+	this->global_mesh_data = global_mesh_data;
+
+	moving_count = 0;
+	average_edge_length = 0.0;
+	iteration_count = 0;
+}
+
+ForceSmoother::~ForceSmoother() {
+}
+
+//Build the edge arrays of the triangles and vertices of a complex
+int ForceSmoother::Build(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list) {
+	unsigned int global_vertex_count = global_mesh_data->GetVertexCount();
+
+	//Count the triangles and add up the angles at every vertex, and collect the edges of every triangle
+	vector<unsigned int> triangle_counts(global_vertex_count, 0);
+	vector<double> angles(global_vertex_count, 0.0);
+
+	vector<pair<unsigned int, unsigned int> > edges;
+	edges.reserve(3*triangle_list.size());
+
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(triangle_list[i]);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			double angle = 0.0;
+			if(tri->GetVertexAngle(j, angle) == true) {
+				triangle_counts[tri->GetVertexIndex(j)]++;
+				angles[tri->GetVertexIndex(j)] += angle;
+			}
+
+			unsigned int v0 = tri->GetVertexIndex((j+1)%3);
+			unsigned int v1 = tri->GetVertexIndex((j+2)%3);
+
+			if(v0 == 0 || v1 == 0 || v0 >= global_vertex_count || v1 >= global_vertex_count)
+				continue;
+
+			if(global_mesh_data->GetVertex(v0) == NULL || global_mesh_data->GetVertex(v1) == NULL)
+				continue;
+
+			//The smaller index first, as in Edge
+			if(v0 > v1)
+				swap(v0, v1);
+
+			edges.push_back(pair<unsigned int, unsigned int>(v0, v1));
+		}
+	}
+
+	//Every edge between two triangles was found from both of them
+	sort(edges.begin(), edges.end());
+	edges.erase(unique(edges.begin(), edges.end()), edges.end());
+
+	average_edge_length = 0.0;
+	for(unsigned int i=0; i<edges.size(); i++) {
+		Vector2d* v0 = global_mesh_data->GetVertex(edges[i].first);
+		Vector2d* v1 = global_mesh_data->GetVertex(edges[i].second);
+
+		average_edge_length += (*v1 - *v0).mag();
+	}
+
+	if(edges.size() > 0)
+		average_edge_length /= double(edges.size());
+
+	//The interior vertices of the complex move, and are numbered first
+	vindices.clear();
+	local_indices.assign(global_vertex_count, -1);
+
+	for(unsigned int i=0; i<vertex_list.size(); i++) {
+		unsigned int vindex = vertex_list[i];
+		if(vindex >= global_vertex_count || local_indices[vindex] >= 0)
+			continue;
+
+		if(angles[vindex] < FORCE_SMOOTHER_INTERIOR_ANGLE || triangle_counts[vindex] == 0)
+			continue;
+
+		if(global_mesh_data->GetVertex(vindex) == NULL)
+			continue;
+
+		local_indices[vindex] = vindices.size();
+		vindices.push_back(vindex);
+	}
+
+	moving_count = vindices.size();
+
+	//Only the edges with a moving end point push anything, the other end points are numbered after the moving ones
+	edge_vertices[0].clear();
+	edge_vertices[1].clear();
+
+	incident_starts.assign(moving_count+1, 0);
+
+	for(unsigned int i=0; i<edges.size(); i++) {
+		int local0 = local_indices[edges[i].first];
+		int local1 = local_indices[edges[i].second];
+
+		int moving0 = (local0 >= 0 && (unsigned int) local0 < moving_count);
+		int moving1 = (local1 >= 0 && (unsigned int) local1 < moving_count);
+
+		if(moving0 == false && moving1 == false)
+			continue;
+
+		if(moving0 == true)
+			incident_starts[local0+1]++;
+		if(moving1 == true)
+			incident_starts[local1+1]++;
+
+		edge_vertices[0].push_back(find_local_vertex(edges[i].first));
+		edge_vertices[1].push_back(find_local_vertex(edges[i].second));
+	}
+
+	//The edges at every moving vertex, with the sign of the force of the edge on it
+	for(unsigned int i=0; i<moving_count; i++)
+		incident_starts[i+1] += incident_starts[i];
+
+	incident_edges.assign(incident_starts[moving_count], 0);
+	incident_signs.assign(incident_starts[moving_count], 0.0);
+
+	vector<unsigned int> incident_ends(incident_starts.begin(), incident_starts.end()-1);
+
+	for(unsigned int i=0; i<edge_vertices[0].size(); i++) {
+		for(int j=0; j<2; j++) {
+			unsigned int local_index = edge_vertices[j][i];
+			if(local_index >= moving_count)
+				continue;
+
+			unsigned int& k = incident_ends[local_index];
+
+			incident_edges[k] = i;
+			incident_signs[k++] = (j == 0 ? 1.0 : -1.0);
+		}
+	}
+
+	x.resize(vindices.size());
+	y.resize(vindices.size());
+
+	for(unsigned int i=0; i<vindices.size(); i++) {
+		Vector2d* v = global_mesh_data->GetVertex(vindices[i]);
+
+		x[i] = v->x;
+		y[i] = v->y;
+	}
+
+	velocity_x.assign(moving_count, 0.0);
+	velocity_y.assign(moving_count, 0.0);
+
+	edge_force_x.assign(edge_vertices[0].size(), 0.0);
+	edge_force_y.assign(edge_vertices[0].size(), 0.0);
+
+	printf("Smoothing %u of %u vertices, %u edges\n", moving_count, (unsigned int) vindices.size(), (unsigned int) edge_vertices[0].size());
+
+	return true;
+}
+
+//Run up to some number of time steps, then copy the moved vertices back into the global mesh
+int ForceSmoother::Smooth(unsigned int iterations, double dt, double damping, double tolerance) {
+	iteration_count = 0;
+
+	long row_count = moving_count;
+	if(row_count == 0)
+		return true;
+
+	long edge_count = edge_vertices[0].size();
+	if(edge_count == 0)
+		return true;
+
+	const unsigned int* edge_v0 = &edge_vertices[0][0];
+	const unsigned int* edge_v1 = &edge_vertices[1][0];
+
+	const unsigned int* starts = &incident_starts[0];
+	const unsigned int* incident = &incident_edges[0];
+	const double* signs = &incident_signs[0];
+
+	double* px = &x[0];
+	double* py = &y[0];
+
+	double* vx = &velocity_x[0];
+	double* vy = &velocity_y[0];
+
+	double* fx = &edge_force_x[0];
+	double* fy = &edge_force_y[0];
+
+	double L = average_edge_length;
+	double keep = 1.0 - damping;
+
+	//The squared step every vertex has to stay under
+	double max_step = tolerance * average_edge_length;
+	max_step *= max_step;
+
+	double last_step = 0.0;
+
+	for(unsigned int iter=0; iter<iterations; iter++) {
+		//The force of every edge on its first end point, the second gets the opposite
+		#pragma omp parallel for simd schedule(static)
+		for(long i=0; i<edge_count; i++) {
+			double dx = px[edge_v1[i]] - px[edge_v0[i]];
+			double dy = py[edge_v1[i]] - py[edge_v0[i]];
+
+			double length = sqrt(dx*dx + dy*dy);
+			double scale = (length > 0.0 ? (length - L) / length : 0.0);
+
+			fx[i] = dx * scale;
+			fy[i] = dy * scale;
+		}
+
+		//Every moving vertex adds up the forces of its own edges, then takes a step
+		double step = 0.0;
+
+		#pragma omp parallel for schedule(static) reduction(max:step)
+		for(long i=0; i<row_count; i++) {
+			double force_x = 0.0;
+			double force_y = 0.0;
+
+			#pragma omp simd reduction(+:force_x,force_y)
+			for(unsigned int k=starts[i]; k<starts[i+1]; k++) {
+				force_x += signs[k] * fx[incident[k]];
+				force_y += signs[k] * fy[incident[k]];
+			}
+
+			vx[i] = vx[i] * keep + force_x * dt;
+			vy[i] = vy[i] * keep + force_y * dt;
+
+			double dx = vx[i] * dt;
+			double dy = vy[i] * dt;
+
+			px[i] += dx;
+			py[i] += dy;
+
+			step = max(step, dx*dx + dy*dy);
+		}
+
+		iteration_count++;
+
+		//The first steps are small as the vertices start at rest, so only stop once they are slowing down again
+		if(tolerance > 0.0 && iter > 0 && step < max_step && step < last_step)
+			break;
+
+		last_step = step;
+	}
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<row_count; i++) {
+		Vector2d* v = global_mesh_data->GetVertex(vindices[i]);
+
+		v->x = x[i];
+		v->y = y[i];
+	}
+
+	return true;
+}
+
+//The average edge length the springs pull towards
+double ForceSmoother::GetAverageEdgeLength() {
+	return average_edge_length;
+}
+
+//The number of iterations the last Smooth ran
+unsigned int ForceSmoother::GetIterationCount() {
+	return iteration_count;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//The local index of a global vertex, adding it if it is new
+unsigned int ForceSmoother::find_local_vertex(unsigned int vindex) {
+	if(local_indices[vindex] < 0) {
+		local_indices[vindex] = vindices.size();
+		vindices.push_back(vindex);
+	}
+
+	return local_indices[vindex];
+}
@@ -0,0 +1,92 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+//Triangulation algorithm related code
+#include "utility.h"
+#include "vector2d.h"
+#include "triangle.h"
+
+//Mesh data code
+#include "global_mesh_data.h"
+
+#include <omp.h>
+
+#ifndef FORCE_SMOOTHER
+#define FORCE_SMOOTHER
+
+//A vertex moves only if the angles of its triangles add up to at least this, so it is inside the mesh
+#define FORCE_SMOOTHER_INTERIOR_ANGLE		6.28318
+
+//Force based smoothing of the vertices of a complex, the force based stretched grid method
+// + every edge is a spring pulling or pushing its end points towards the average edge length, and the interior
+//   vertices are moved with their velocities, which the forces change every time step
+// + the edges are built once into flat arrays of end points, every iteration works out the force of each edge on
+//   its own, and each vertex then adds up the forces of its edges through a list of them, so no two threads ever
+//   write the same vertex
+// + the velocities lose the damping fraction of themselves every step, without damping the vertices never settle
+// + the iterations stop early once no vertex moves more than the tolerance times the average edge length in a step
+class ForceSmoother {
+public:
+	ForceSmoother(GlobalMeshData* global_mesh_data);
+	~ForceSmoother();
+
+	//Build the edge arrays of the triangles and vertices of a complex
+	int Build(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list);
+
+	//Run up to some number of time steps, then copy the moved vertices back into the global mesh
+	// + a tolerance of 0 runs every iteration
+	int Smooth(unsigned int iterations, double dt, double damping, double tolerance);
+
+	//The average edge length the springs pull towards
+	double GetAverageEdgeLength();
+
+	//The number of iterations the last Smooth ran
+	unsigned int GetIterationCount();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//The local index of a global vertex, adding it if it is new
+	unsigned int find_local_vertex(unsigned int vindex);
+
+	//The mesh being smoothed
+	GlobalMeshData* global_mesh_data;
+
+	//The global vertex index of every local vertex, the moving ones first
+	vector<unsigned int> vindices;
+	vector<int> local_indices;
+
+	unsigned int moving_count;
+
+	//The local end points of the edges with at least one moving end point
+	vector<unsigned int> edge_vertices[2];
+	double average_edge_length;
+
+	//The edges at moving vertex i are incident_edges[incident_starts[i]] to incident_edges[incident_starts[i+1]-1],
+	//with a sign of 1 where the vertex is the first end point and -1 where it is the second
+	vector<unsigned int> incident_starts;
+	vector<unsigned int> incident_edges;
+	vector<double> incident_signs;
+
+	//The coordinates and velocities
+	vector<double> x;
+	vector<double> y;
+
+	vector<double> velocity_x;
+	vector<double> velocity_y;
+
+	//The force of every edge on its first end point
+	vector<double> edge_force_x;
+	vector<double> edge_force_y;
+
+	unsigned int iteration_count;
+};
+
+#endif
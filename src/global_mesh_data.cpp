@@ -1,5 +1,8 @@
 #include "global_mesh_data.h"
 
+//Streaming svg output code
+#include "svg_writer.h"
+
 GlobalMeshData::GlobalMeshData() {
 	global_vertex_list.clear();
 	global_triangle_list.clear();
@@ -12,7 +15,12 @@ GlobalMeshData::~GlobalMeshData() {
 	for(unsigned int i=0; i<GetVertexCount(); i++) {
 		Vector2d* v = GetVertex(i);
 		if(v != NULL)
-			delete v;
+			free_vertex(v);
+	}
+
+	for(unsigned int i=0; i<vertex_blocks.size(); i++) {
+		if(vertex_blocks[i].adopted == false)
+			delete [] vertex_blocks[i].vertices;
 	}
 
 	for(unsigned int i=0; i<GetTriangleCount(); i++) {
@@ -26,23 +34,45 @@ GlobalMeshData::~GlobalMeshData() {
 // File i/o //
 //////////////
 
+//Guess the file format from the file extension
+// + ".tmb" files are binary, ".tmc" files are compressed, everything else is xml
+int GlobalMeshData::GetFileFormat(const char* filename) {
+	const char* extension = strrchr(filename, '.');
+
+	if(extension != NULL && strcmp(extension, ".tmb") == 0)
+		return GlobalMeshData::BINARY_FILE_FORMAT;
+
+	if(extension != NULL && strcmp(extension, ".tmc") == 0)
+		return GlobalMeshData::COMPRESSED_FILE_FORMAT;
+
+	return GlobalMeshData::XML_FILE_FORMAT;
+}
+
 int GlobalMeshData::LoadFromFile(const char* filename, int load_triangles) {
-	//Open the mesh file as an XML document
-	XML_Document* xml_document = new XML_Document;
-	if(xml_document->LoadFromFile(filename) == false) {
-		printf("Error loading the mesh file\n");
+	return LoadFromFile(filename, load_triangles, GlobalMeshData::UNKNOWN_FILE_FORMAT);
+}
 
-		delete xml_document;
-		return false;
-	}
+int GlobalMeshData::LoadFromFile(const char* filename, int load_triangles, int file_format) {
+	if(file_format == GlobalMeshData::UNKNOWN_FILE_FORMAT)
+		file_format = GetFileFormat(filename);
 
-	if(LoadFromFile(xml_document, load_triangles) == false) {
-		delete xml_document;
+	if(file_format == GlobalMeshData::BINARY_FILE_FORMAT)
+		return LoadFromBinaryFile(filename, load_triangles);
+
+	if(file_format == GlobalMeshData::COMPRESSED_FILE_FORMAT)
+		return LoadFromCompressedFile(filename, load_triangles);
+
+	//Stream the xml straight from the mesh file
+	MeshXMLReader reader;
+	if(reader.Open(filename) == false) {
+		printf("Error loading the mesh file\n");
 		return false;
 	}
 
-	delete xml_document;
-	return true;
+	int ret = LoadFromXMLStream(&reader, load_triangles);
+
+	reader.Close();
+	return ret;
 }
 
 int GlobalMeshData::LoadFromFile(XML_Document* xml_document, int load_triangles) {
@@ -63,16 +93,31 @@ int GlobalMeshData::LoadFromFile(XML_Document* xml_document, int load_triangles)
 }
 
 int GlobalMeshData::SaveToFile(const char* filename, int save_triangles) {
-	//Open the output file as an xml document
-	XML_Document* xml_document = new XML_Document;
+	return SaveToFile(filename, save_triangles, GlobalMeshData::UNKNOWN_FILE_FORMAT);
+}
+
+int GlobalMeshData::SaveToFile(const char* filename, int save_triangles, int file_format) {
+	if(file_format == GlobalMeshData::UNKNOWN_FILE_FORMAT)
+		file_format = GetFileFormat(filename);
+
+	if(file_format == GlobalMeshData::BINARY_FILE_FORMAT)
+		return SaveToBinaryFile(filename, save_triangles);
+
+	if(file_format == GlobalMeshData::COMPRESSED_FILE_FORMAT)
+		return SaveToCompressedFile(filename, save_triangles, 0);
+
+	//Stream the xml straight to the output file
+	BufferedWriter writer;
+	if(writer.Open(filename) == false)
+		return false;
 
-	if(SaveToFile(xml_document, save_triangles) == false) {
-		delete xml_document;
+	if(SaveToXMLStream(&writer, save_triangles) == false) {
+		writer.Close();
 		return false;
 	}
 
-	if(xml_document->WriteToFile(filename) == false) {
-		delete xml_document;
+	if(writer.Close() == false) {
+		printf("Error writing the mesh file %s\n", filename);
 		return false;
 	}
 
@@ -140,82 +185,297 @@ int GlobalMeshData::SaveToFile(XML_Document* xml_document, int save_triangles) {
 	return true;
 }
 
-int GlobalMeshData::WriteSVG(const char* filename, double width, double height) {
-	//Used to format some output
-	char buffer[1000];
+//Read the xml mesh schema in one pass without building a document
+int GlobalMeshData::LoadFromXMLStream(MeshXMLReader* reader, int load_triangles) {
+	//Free all data
+	FreeAllData();
 
-	XML_Document* xml_document = new XML_Document;
-	XML_TreeNode* head_node = xml_document->GetHeadNode();
+	//The adjacency indices, resolved once every triangle exists
+	vector<uint32_t> adjacency(3, 0);
 
-	printf("ASDF1\n");
-	//Create the svg tag
-	XML_TreeNode* svg_head_node = head_node->CreateChildTagPair("svg");
-	XML_Tag* svg_head_node_tag = svg_head_node->GetStartTag();
+	int reserved_vertices = false;
+	int reserved_triangles = false;
 
-	sprintf(buffer, "0 0 %f %f", width, height);
-	svg_head_node_tag->AppendTagAttribute("viewBox", buffer);
-	svg_head_node_tag->AppendTagAttribute("version", "1.1");
+	MeshXMLRecord record;
+	int record_type;
 
-	printf("ASDF2\n");
-	//Create a rectangle
-	XML_TreeNode* svg_rect = svg_head_node->CreateChildTagOpenClosed("rect");
-	XML_Tag* svg_rect_tag = svg_rect->GetStartTag();
+	while((record_type = reader->NextRecord(record)) != MeshXMLReader::END_OF_FILE) {
+		if(record_type == MeshXMLReader::PARSE_ERROR)
+			return false;
 
-	svg_rect_tag->AppendTagAttribute("width", width);
-	svg_rect_tag->AppendTagAttribute("height", height);
-	svg_rect_tag->AppendTagAttribute("fill", "white");
+		if(record_type == MeshXMLReader::VERTEX_RECORD) {
+			//The 0 index is reserved
+			if(record.index == 0 || record.has_x == false || record.has_y == false)
+				return false;
 
-	printf("ASDF3\n");
-	//Draw the triangles
-	for(unsigned int i=0; i<GetTriangleCount(); i++) {
-		Triangle* tri = GetTriangle(i);
+			if(reserved_vertices == false) {
+				global_vertex_list.reserve(reader->EstimateRemainingRecords(record_type) + 2);
+				reserved_vertices = true;
+			}
+
+			Vector2d* pt = GetVertex(record.index);
+			if(pt != NULL) {
+				pt->x = record.x;
+				pt->y = record.y;
+			}
+			else
+				SetVertex(record.index, new Vector2d(record.x, record.y));
+		}
+		else if(record_type == MeshXMLReader::TRIANGLE_RECORD) {
+			if(load_triangles == false)
+				continue;
+
+			//The 0 index is reserved
+			if(record.index == 0 || record.n[0] == 0 || record.n[1] == 0 || record.n[2] == 0)
+				return false;
+
+			if(reserved_triangles == false) {
+				unsigned int estimate = reader->EstimateRemainingRecords(record_type) + 2;
+
+				global_triangle_list.reserve(estimate);
+				adjacency.reserve(3*estimate);
+				reserved_triangles = true;
+			}
+
+			Triangle* tri = GetTriangle(record.index);
+			if(tri == NULL) {
+				//If no triangle with this index existed create a new one
+				tri = new Triangle(GetGlobalVertexList());
+				SetTriangle(record.index, tri);
+			}
+
+			tri->SetVertex(0, record.n[0]);
+			tri->SetVertex(1, record.n[1]);
+			tri->SetVertex(2, record.n[2]);
+
+			if(adjacency.size() < 3*(size_t(record.index)+1))
+				adjacency.resize(3*(size_t(record.index)+1), 0);
+
+			adjacency[3*record.index] = record.a[0];
+			adjacency[3*record.index+1] = record.a[1];
+			adjacency[3*record.index+2] = record.a[2];
+		}
+	}
+
+	//Load in the triangle adjacency information
+	for(unsigned int i=1; i<GetTriangleCount(); i++) {
+		Triangle* tri = global_triangle_list[i];
 		if(tri == NULL)
 			continue;
 
-		Vector2d* v0 = tri->GetVertex(0);
-		Vector2d* v1 = tri->GetVertex(1);
-		Vector2d* v2 = tri->GetVertex(2);
+		for(int j=0; j<3; j++)
+			tri->SetAdjacentTriangle(j, GetTriangle(adjacency[3*i+j]));
+	}
 
-		if(v0 == NULL || v1 == NULL || v2 == NULL)
-			continue;
+	return true;
+}
+
+//Write the xml mesh schema straight to a writer without building a document
+int GlobalMeshData::SaveToXMLStream(BufferedWriter* writer, int save_triangles) {
+	if(GetVertexCount() > 1) {
+		writer->WriteString("<vertexlist>\n");
 
-		XML_TreeNode* svg_polygon = svg_head_node->CreateChildTagOpenClosed("polygon");
-		XML_Tag* svg_polygon_tag = svg_polygon->GetStartTag();
+		//Write the vertices to the file
+		for(unsigned int i=0; i<GetVertexCount(); i++) {
+			Vector2d* pt = GetVertex(i);
+
+			if(pt == NULL)
+				continue;
+
+			writer->WriteString("\t<vertex");
+			writer->WriteAttribute("index", uint64_t(i));
+			writer->WriteAttribute("x", pt->x);
+			writer->WriteAttribute("y", pt->y);
+			writer->WriteString("/>\n");
+		}
 
-		sprintf(buffer, "%f,%f %f,%f %f,%f", v0->x, height-v0->y, v1->x, height-v1->y, v2->x, height-v2->y);
-		svg_polygon_tag->AppendTagAttribute("points", buffer);
-		svg_polygon_tag->AppendTagAttribute("fill", "green");
-		svg_polygon_tag->AppendTagAttribute("stroke", "black");
-		svg_polygon_tag->AppendTagAttribute("stroke-width", "2");
-		svg_polygon_tag->AppendTagAttribute("style", "fill-opacity:0.5");
+		writer->WriteString("</vertexlist>\n");
 	}
 
-	printf("ASDF4\n");
-	//Draw the vertices
-	for(unsigned int i=0; i<GetVertexCount(); i++) {
-		Vector2d* pt = GetVertex(i);
-		if(pt == NULL)
-			continue;
+	if(save_triangles == true && GetTriangleCount() > 1) {
+		writer->WriteString("<trianglelist>\n");
+
+		//Write the triangles to the file
+		for(unsigned int i=0; i<GetTriangleCount(); i++) {
+			Triangle* tri = GetTriangle(i);
+
+			if(tri == NULL)
+				continue;
+
+			unsigned int adjacent_indices[3];
+			for(int j=0; j<3; j++) {
+				adjacent_indices[j] = 0;
+				if(tri->GetAdjacentTriangle(j) != NULL)
+					adjacent_indices[j] = tri->GetAdjacentTriangle(j)->GetTriangleIndex();
+			}
 
-		XML_TreeNode* svg_circle = svg_head_node->CreateChildTagOpenClosed("circle");
-		XML_Tag* svg_circle_tag = svg_circle->GetStartTag();
+			WriteXMLTriangle(writer, tri, adjacent_indices);
+		}
 
-		svg_circle_tag->AppendTagAttribute("cx", pt->x);
-		svg_circle_tag->AppendTagAttribute("cy", height - pt->y);
-		svg_circle_tag->AppendTagAttribute("r", 1.0);
-		svg_circle_tag->AppendTagAttribute("fill", "blue");
+		writer->WriteString("</trianglelist>\n");
 	}
 
-	printf("ASDF5\n");
-	//Write the svg file
-	if(xml_document->WriteToFile(filename) == false) {
-		delete xml_document;
+	return writer->IsGood();
+}
+
+//Write a single triangle element of the xml mesh schema
+int GlobalMeshData::WriteXMLTriangle(BufferedWriter* writer, Triangle* tri, const unsigned int* adjacent_indices) {
+	writer->WriteString("\t<triangle");
+	writer->WriteAttribute("index", uint64_t(tri->GetTriangleIndex()));
+
+	writer->WriteAttribute("n0", uint64_t(tri->GetVertexIndex(0)));
+	writer->WriteAttribute("n1", uint64_t(tri->GetVertexIndex(1)));
+	writer->WriteAttribute("n2", uint64_t(tri->GetVertexIndex(2)));
+
+	writer->WriteAttribute("a0", uint64_t(adjacent_indices[0]));
+	writer->WriteAttribute("a1", uint64_t(adjacent_indices[1]));
+	writer->WriteAttribute("a2", uint64_t(adjacent_indices[2]));
+
+	return writer->WriteString("/>\n");
+}
+
+int GlobalMeshData::WriteSVG(const char* filename, double width, double height) {
+	SVGWriter svg_writer;
+	if(svg_writer.SetSize(width, height) == false) {
+		printf("Error: the svg size must be positive\n");
 		return false;
 	}
 
-	printf("ASDF6\n");
-	delete xml_document;
-	return true;
+	return svg_writer.Write(filename, this);
+}
+
+int GlobalMeshData::LoadFromBinaryFile(const char* filename, int load_triangles) {
+	BinaryMeshFile binary_mesh_file;
+	if(binary_mesh_file.Open(filename) == false)
+		return false;
+
+	int ret = LoadFromBinaryFile(&binary_mesh_file, load_triangles);
+
+	binary_mesh_file.Close();
+	return ret;
+}
+
+int GlobalMeshData::LoadFromBinaryFile(BinaryMeshFile* binary_mesh_file, int load_triangles) {
+	return load_from_arrays(binary_mesh_file->GetVertexCount(), binary_mesh_file->GetCoordinates(),
+			binary_mesh_file->GetTriangleCount(), binary_mesh_file->GetVertexIndices(), binary_mesh_file->GetNeighbours(), load_triangles);
+}
+
+int GlobalMeshData::SaveToBinaryFile(const char* filename, int save_triangles) {
+	FILE* handle = fopen(filename, "wb");
+	if(handle == NULL) {
+		printf("Error opening %s for writing\n", filename);
+		return false;
+	}
+
+	//Use a large stdio buffer, the blocks are written sequentially
+	setvbuf(handle, NULL, _IOFBF, 1 << 20);
+
+	int ret = SaveToBinaryStream(handle, save_triangles);
+
+	if(fclose(handle) != 0)
+		ret = false;
+
+	if(ret == false)
+		printf("Error writing the binary mesh file %s\n", filename);
+
+	return ret;
+}
+
+//Write the binary mesh layout at the current position of an open file
+// + the file is padded out to the size in the header, so more data can follow
+int GlobalMeshData::SaveToBinaryStream(FILE* handle, int save_triangles) {
+	long start = ftell(handle);
+	if(start < 0)
+		return false;
+
+	unsigned int vertex_count = GetVertexCount();
+	unsigned int triangle_count = 0;
+	if(save_triangles == true && GetTriangleCount() > 1)
+		triangle_count = GetTriangleCount();
+
+	BinaryMeshHeader header;
+	uint64_t file_size = BinaryMeshFile::ComputeLayout(header, vertex_count, triangle_count);
+
+	int ret = (fwrite(&header, sizeof(BinaryMeshHeader), 1, handle) == 1);
+
+	//Write the coordinate block, empty slots are marked with NaN
+	const unsigned int chunk_size = 4096;
+	double coordinate_chunk[2*chunk_size];
+
+	for(unsigned int i=0; ret == true && i<vertex_count; i+=chunk_size) {
+		unsigned int count = min(int(chunk_size), int(vertex_count - i));
+
+		for(unsigned int j=0; j<count; j++) {
+			Vector2d* pt = global_vertex_list[i+j];
+
+			coordinate_chunk[2*j] = (pt != NULL ? pt->x : NAN);
+			coordinate_chunk[2*j+1] = (pt != NULL ? pt->y : NAN);
+		}
+
+		ret = (fwrite(coordinate_chunk, sizeof(double), 2*count, handle) == 2*count);
+	}
+
+	//Write the vertex index and neighbour blocks
+	uint32_t index_chunk[3*chunk_size];
+
+	for(int block=0; block<2; block++) {
+		for(unsigned int i=0; ret == true && i<triangle_count; i+=chunk_size) {
+			unsigned int count = min(int(chunk_size), int(triangle_count - i));
+
+			for(unsigned int j=0; j<count; j++) {
+				Triangle* tri = global_triangle_list[i+j];
+
+				for(int k=0; k<3; k++) {
+					uint32_t value = 0;
+
+					if(tri != NULL && block == 0)
+						value = tri->GetVertexIndex(k);
+
+					else if(tri != NULL && tri->GetAdjacentTriangle(k) != NULL)
+						value = tri->GetAdjacentTriangle(k)->GetTriangleIndex();
+
+					index_chunk[3*j+k] = value;
+				}
+			}
+
+			ret = (fwrite(index_chunk, sizeof(uint32_t), 3*count, handle) == 3*count);
+		}
+	}
+
+	//Pad the file out to the size in the header
+	if(ret == true) {
+		long padding = start + long(file_size) - ftell(handle);
+
+		char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		if(padding > 0)
+			ret = (fwrite(zeros, 1, padding, handle) == size_t(padding));
+	}
+
+	return ret;
+}
+
+int GlobalMeshData::LoadFromCompressedFile(const char* filename, int load_triangles) {
+	CompressedMeshFile compressed_mesh_file;
+	if(compressed_mesh_file.Read(filename) == false)
+		return false;
+
+	return load_from_arrays(compressed_mesh_file.GetVertexCount(), compressed_mesh_file.GetCoordinates(),
+			compressed_mesh_file.GetTriangleCount(), compressed_mesh_file.GetVertexIndices(), compressed_mesh_file.GetNeighbours(), load_triangles);
+}
+
+int GlobalMeshData::SaveToCompressedFile(const char* filename, int save_triangles, unsigned int quantization_bits) {
+	//Flatten the mesh into the binary mesh file layout
+	vector<double> coordinates(2*size_t(GetVertexCount()));
+	ExportVertices(&coordinates[0]);
+
+	vector<uint32_t> vertex_indices(3, 0);
+	if(save_triangles == true) {
+		vertex_indices.resize(3*size_t(GetTriangleCount()));
+		ExportTriangles(&vertex_indices[0], NULL);
+	}
+
+	CompressedMeshFile compressed_mesh_file;
+	return compressed_mesh_file.Write(filename, coordinates, vertex_indices, quantization_bits);
 }
 
 ///////////////////////////////
@@ -223,6 +483,61 @@ int GlobalMeshData::WriteSVG(const char* filename, double width, double height)
 ///////////////////////////////
 
 //Free data
+//Replace this mesh with a copy of another one, keeping every vertex and triangle index
+int GlobalMeshData::CopyFrom(GlobalMeshData* global_mesh_data) {
+	FreeAllData();
+
+	//The vertices all go in one block
+	unsigned int vertex_count = global_mesh_data->GetVertexCount();
+
+	if(vertex_count > 1) {
+		unsigned int first_vindex = 0;
+		Vector2d* vertices = AllocateVertexBlock(vertex_count - 1, first_vindex);
+
+		#pragma omp parallel for schedule(static)
+		for(long i=1; i<long(vertex_count); i++) {
+			Vector2d* v = global_mesh_data->GetVertex(i);
+
+			if(v != NULL)
+				vertices[i-1] = *v;
+			else
+				global_vertex_list[i] = NULL;
+		}
+	}
+
+	//The triangles keep their slots, so the adjacencies can be looked up by index
+	unsigned int triangle_count = global_mesh_data->GetTriangleCount();
+	global_triangle_list.resize(triangle_count, NULL);
+
+	#pragma omp parallel for schedule(static)
+	for(long i=1; i<long(triangle_count); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		Triangle* new_tri = new Triangle(&global_vertex_list, tri);
+		new_tri->SetTriangleIndex(i);
+
+		global_triangle_list[i] = new_tri;
+	}
+
+	#pragma omp parallel for schedule(static)
+	for(long i=1; i<long(triangle_count); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			Triangle* adj_tri = tri->GetAdjacentTriangle(j);
+
+			if(adj_tri != NULL)
+				global_triangle_list[i]->SetAdjacentTriangle(j, GetTriangle(adj_tri->GetTriangleIndex()));
+		}
+	}
+
+	return true;
+}
+
 int GlobalMeshData::FreeAllData() {
 	if(FreeTriangleData() == false)
 		return false;
@@ -237,11 +552,17 @@ int GlobalMeshData::FreeVertexData() {
 	for(unsigned int i=0; i<GetVertexCount(); i++) {
 		Vector2d* v = GetVertex(i);
 		if(v != NULL)
-			delete v;
+			free_vertex(v);
 	}
 	global_vertex_list.clear();
 	global_vertex_list.push_back(NULL);
 
+	for(unsigned int i=0; i<vertex_blocks.size(); i++) {
+		if(vertex_blocks[i].adopted == false)
+			delete [] vertex_blocks[i].vertices;
+	}
+	vertex_blocks.clear();
+
 	return true;
 }
 
@@ -282,6 +603,159 @@ unsigned int GlobalMeshData::AppendVertex(Vector2d* vertex) {
 	return (global_vertex_list.size()-1);
 }
 
+//Remove a vertex, the caller has to make sure no triangle uses it any more
+int GlobalMeshData::DeleteVertex(unsigned int vindex) {
+	Vector2d* vertex = GetVertex(vindex);
+	if(vertex == NULL)
+		return true;
+
+	free_vertex(vertex);
+	global_vertex_list[vindex] = NULL;
+
+	return true;
+}
+
+//Grow or shrink the list to count slots, new slots are empty
+int GlobalMeshData::ResizeVertexList(unsigned int count) {
+	//Slot 0 is always there
+	if(count < 1)
+		return false;
+
+	for(unsigned int i=count; i<GetVertexCount(); i++) {
+		if(global_vertex_list[i] != NULL) {
+			printf("Error: can't cut off vertex %u\n", i);
+			return false;
+		}
+	}
+
+	global_vertex_list.resize(count, NULL);
+	return true;
+}
+
+//Append count vertices stored in one array, used for bulk loading
+// + returns the array, first_vindex is set to the index of its first vertex
+Vector2d* GlobalMeshData::AllocateVertexBlock(unsigned int count, unsigned int& first_vindex) {
+	first_vindex = 0;
+	if(count == 0)
+		return NULL;
+
+	Vector2d* vertices = new Vector2d[count];
+	append_vertex_block(vertices, count, false, first_vindex);
+
+	return vertices;
+}
+
+//Remove the vertices of a block, and free it
+int GlobalMeshData::FreeVertexBlock(Vector2d* vertices) {
+	for(unsigned int i=0; i<vertex_blocks.size(); i++) {
+		VertexBlock block = vertex_blocks[i];
+		if(block.vertices != vertices)
+			continue;
+
+		//Clear any slots still pointing into the block
+		unsigned int end = min(GetVertexCount(), block.first_vindex + block.count);
+		for(unsigned int j=block.first_vindex; j<end; j++) {
+			Vector2d* v = global_vertex_list[j];
+			if(v >= block.vertices && v < block.vertices + block.count)
+				global_vertex_list[j] = NULL;
+		}
+
+		//If the block was at the end of the list, give its slots back
+		if(end == GetVertexCount()) {
+			while(GetVertexCount() > 1 && global_vertex_list.back() == NULL)
+				global_vertex_list.pop_back();
+		}
+
+		if(block.adopted == false)
+			delete [] block.vertices;
+
+		vertex_blocks.erase(vertex_blocks.begin() + i);
+
+		return true;
+	}
+
+	return false;
+}
+
+//Copy count vertices into one block, from separate x and y arrays or from one interleaved xy array
+unsigned int GlobalMeshData::AppendVertices(const double* x, const double* y, unsigned int count) {
+	unsigned int first_vindex = 0;
+
+	Vector2d* vertices = AllocateVertexBlock(count, first_vindex);
+	if(vertices == NULL)
+		return 0;
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<long(count); i++) {
+		vertices[i].x = x[i];
+		vertices[i].y = y[i];
+	}
+
+	return first_vindex;
+}
+
+unsigned int GlobalMeshData::AppendVertices(const double* xy, unsigned int count) {
+	unsigned int first_vindex = 0;
+
+	Vector2d* vertices = AllocateVertexBlock(count, first_vindex);
+	if(vertices == NULL)
+		return 0;
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<long(count); i++) {
+		vertices[i].x = xy[2*i];
+		vertices[i].y = xy[2*i+1];
+	}
+
+	return first_vindex;
+}
+
+//Use an interleaved xy array as a vertex block without copying it
+// + a Vector2d is laid out as two doubles, so the array can be used as is
+unsigned int GlobalMeshData::AdoptVertices(double* xy, unsigned int count) {
+	if(xy == NULL || count == 0)
+		return 0;
+
+	if(sizeof(Vector2d) != 2*sizeof(double)) {
+		printf("Error: vertices can't be adopted, a Vector2d isn't two doubles on this platform\n");
+		return 0;
+	}
+
+	unsigned int first_vindex = 0;
+	append_vertex_block((Vector2d*) xy, count, true, first_vindex);
+
+	return first_vindex;
+}
+
+//Copy the coordinates out in slot order, GetVertexCount() entries with NaN for empty slots
+int GlobalMeshData::ExportVertices(double* xy) {
+	Vector2d** slots = &global_vertex_list[0];
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<long(GetVertexCount()); i++) {
+		Vector2d* pt = slots[i];
+
+		xy[2*i] = (pt != NULL ? pt->x : NAN);
+		xy[2*i+1] = (pt != NULL ? pt->y : NAN);
+	}
+
+	return true;
+}
+
+int GlobalMeshData::ExportVertices(double* x, double* y) {
+	Vector2d** slots = &global_vertex_list[0];
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<long(GetVertexCount()); i++) {
+		Vector2d* pt = slots[i];
+
+		x[i] = (pt != NULL ? pt->x : NAN);
+		y[i] = (pt != NULL ? pt->y : NAN);
+	}
+
+	return true;
+}
+
 VertexList* GlobalMeshData::GetGlobalVertexList() {
 	return &global_vertex_list;
 }
@@ -303,7 +777,9 @@ int GlobalMeshData::SetTriangle(unsigned int index, Triangle* tri) {
 		global_triangle_list.resize(index+1, NULL);
 
 	global_triangle_list[index] = tri;
-	tri->SetTriangleIndex(index);
+	if(tri != NULL)
+		tri->SetTriangleIndex(index);
+
 	return true;
 }
 
@@ -314,6 +790,96 @@ unsigned int GlobalMeshData::AppendTriangle(Triangle* tri) {
 	return (global_triangle_list.size()-1);
 }
 
+//Grow or shrink the list to count slots, new slots are empty
+int GlobalMeshData::ResizeTriangleList(unsigned int count) {
+	//Slot 0 is always there
+	if(count < 1)
+		return false;
+
+	for(unsigned int i=count; i<GetTriangleCount(); i++) {
+		if(global_triangle_list[i] != NULL) {
+			printf("Error: can't cut off triangle %u\n", i);
+			return false;
+		}
+	}
+
+	global_triangle_list.resize(count, NULL);
+	return true;
+}
+
+//Create count triangles from 3*count vertex indices, oriented ccw and connected wherever two of them share an edge
+unsigned int GlobalMeshData::AppendTriangles(const uint32_t* vertex_indices, unsigned int count) {
+	if(count == 0)
+		return 0;
+
+	//Check every index before anything is added
+	for(unsigned int i=0; i<3*count; i++) {
+		if(GetVertex(vertex_indices[i]) == NULL) {
+			printf("Error: triangle %u references a missing vertex\n", i/3);
+			return 0;
+		}
+	}
+
+	unsigned int first_tindex = GetTriangleCount();
+	global_triangle_list.resize(size_t(first_tindex) + count, NULL);
+
+	Triangle** slots = &global_triangle_list[first_tindex];
+	VertexList* vertex_list = GetGlobalVertexList();
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<long(count); i++) {
+		unsigned int n0 = vertex_indices[3*i];
+		unsigned int n1 = vertex_indices[3*i+1];
+		unsigned int n2 = vertex_indices[3*i+2];
+
+		//The mesher relies on ccw triangles
+		Vector2d* v0 = (*vertex_list)[n0];
+		Vector2d* v1 = (*vertex_list)[n1];
+		Vector2d* v2 = (*vertex_list)[n2];
+
+		if((v1->x - v0->x)*(v2->y - v0->y) - (v1->y - v0->y)*(v2->x - v0->x) < 0) {
+			unsigned int swap = n1;
+			n1 = n2;
+			n2 = swap;
+		}
+
+		Triangle* new_tri = new Triangle(vertex_list);
+
+		new_tri->SetVertex(0, n0);
+		new_tri->SetVertex(1, n1);
+		new_tri->SetVertex(2, n2);
+		new_tri->SetTriangleIndex(first_tindex + i);
+
+		slots[i] = new_tri;
+	}
+
+	connect_triangles(first_tindex, count);
+
+	return first_tindex;
+}
+
+//Copy the triangles out in slot order, 3*GetTriangleCount() entries with 0 for empty slots and missing neighbours
+int GlobalMeshData::ExportTriangles(uint32_t* vertex_indices, uint32_t* neighbours) {
+	Triangle** slots = &global_triangle_list[0];
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<long(GetTriangleCount()); i++) {
+		Triangle* tri = slots[i];
+
+		for(int j=0; j<3; j++) {
+			if(vertex_indices != NULL)
+				vertex_indices[3*i+j] = (tri != NULL ? tri->GetVertexIndex(j) : 0);
+
+			if(neighbours != NULL) {
+				Triangle* adj_tri = (tri != NULL ? tri->GetAdjacentTriangle(j) : NULL);
+				neighbours[3*i+j] = (adj_tri != NULL ? adj_tri->GetTriangleIndex() : 0);
+			}
+		}
+	}
+
+	return true;
+}
+
 int GlobalMeshData::DeleteTriangle(unsigned int tindex) {
 	Triangle* tri = GetTriangle(tindex);
 	if(tri == NULL)
@@ -347,6 +913,19 @@ int GlobalMeshData::DeleteTriangle(unsigned int tindex) {
 	return true;
 }
 
+//Free a triangle without searching the other triangles for adjacencies to it
+// + the caller has to make sure nothing points to it any more
+int GlobalMeshData::ReleaseTriangle(unsigned int tindex) {
+	Triangle* tri = GetTriangle(tindex);
+	if(tri == NULL)
+		return true;
+
+	delete tri;
+	global_triangle_list[tindex] = NULL;
+
+	return true;
+}
+
 TriangleList* GlobalMeshData::GetGlobalTriangleList() {
 	return &global_triangle_list;
 }
@@ -355,6 +934,92 @@ TriangleList* GlobalMeshData::GetGlobalTriangleList() {
 // Internal use functions //
 ////////////////////////////
 
+//Returns true if the vertex lives in a vertex block rather than its own allocation
+int GlobalMeshData::is_block_vertex(Vector2d* vertex) {
+	for(unsigned int i=0; i<vertex_blocks.size(); i++) {
+		const VertexBlock& block = vertex_blocks[i];
+
+		if(vertex >= block.vertices && vertex < block.vertices + block.count)
+			return true;
+	}
+
+	return false;
+}
+
+//Add a block of vertices and point new slots at it
+int GlobalMeshData::append_vertex_block(Vector2d* vertices, unsigned int count, int adopted, unsigned int& first_vindex) {
+	VertexBlock block;
+	block.vertices = vertices;
+	block.first_vindex = GetVertexCount();
+	block.count = count;
+	block.adopted = adopted;
+
+	vertex_blocks.push_back(block);
+
+	//Point the new slots into the block
+	global_vertex_list.resize(size_t(block.first_vindex) + count, NULL);
+
+	Vector2d** slots = &global_vertex_list[block.first_vindex];
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<long(count); i++)
+		slots[i] = vertices + i;
+
+	first_vindex = block.first_vindex;
+	return true;
+}
+
+//Pair up the edges of a run of triangles
+// + the same edge sort the compressed mesh files use to rebuild their adjacencies
+int GlobalMeshData::connect_triangles(unsigned int first_tindex, unsigned int count) {
+	//One entry per edge, keyed by its sorted end points
+	vector< pair<uint64_t, uint64_t> > edges;
+	edges.reserve(3*size_t(count));
+
+	for(unsigned int i=0; i<count; i++) {
+		Triangle* tri = global_triangle_list[first_tindex + i];
+
+		for(int j=0; j<3; j++) {
+			uint64_t a = tri->GetVertexIndex((j+1)%3);
+			uint64_t b = tri->GetVertexIndex((j+2)%3);
+
+			uint64_t key = (a < b ? (a << 32) | b : (b << 32) | a);
+			edges.push_back(make_pair(key, 3*uint64_t(first_tindex + i) + j));
+		}
+	}
+
+	sort(edges.begin(), edges.end());
+
+	//Edges shared by exactly two triangles are interior edges
+	for(unsigned int i=0; i<edges.size(); ) {
+		unsigned int run_end = i+1;
+		while(run_end < edges.size() && edges[run_end].first == edges[i].first)
+			run_end++;
+
+		if(run_end - i == 2) {
+			Triangle* tri0 = global_triangle_list[edges[i].second / 3];
+			Triangle* tri1 = global_triangle_list[edges[i+1].second / 3];
+
+			tri0->SetAdjacentTriangle(edges[i].second % 3, tri1);
+			tri1->SetAdjacentTriangle(edges[i+1].second % 3, tri0);
+		}
+
+		i = run_end;
+	}
+
+	return true;
+}
+
+//Free a vertex, whichever way it was allocated
+int GlobalMeshData::free_vertex(Vector2d* vertex) {
+	//Block vertices are freed with their block
+	if(vertex == NULL || is_block_vertex(vertex) == true)
+		return true;
+
+	delete vertex;
+	return true;
+}
+
 int GlobalMeshData::load_vertices_from_file(XML_Document* xml_document) {
 	//Load in the vertices from the mesh file
 	vector<XML_TreeNode*> vertexlists;
@@ -522,3 +1187,82 @@ int GlobalMeshData::load_triangles_from_file(XML_Document* xml_document) {
 
 	return true;
 }
+
+//Load the mesh from arrays in the binary mesh file layout
+int GlobalMeshData::load_from_arrays(unsigned int vertex_count, const double* coordinates, unsigned int triangle_count, const uint32_t* vertex_indices, const uint32_t* neighbours, int load_triangles) {
+	//Check every index before anything is freed or added, so a bad file leaves the current mesh as it was
+	if(load_triangles == true && triangle_count > 1) {
+		long first_bad_triangle = triangle_count;
+
+		#pragma omp parallel for schedule(static) reduction(min:first_bad_triangle)
+		for(long i=1; i<long(triangle_count); i++) {
+			if(vertex_indices[3*i] == 0)
+				continue;
+
+			for(int j=0; j<3; j++) {
+				uint32_t n = vertex_indices[3*i+j];
+				if(n == 0 || n >= vertex_count || isnan(coordinates[2*n]) || neighbours[3*i+j] >= triangle_count)
+					first_bad_triangle = min(first_bad_triangle, i);
+			}
+		}
+
+		if(first_bad_triangle < long(triangle_count)) {
+			printf("Error: triangle %ld references a missing vertex or triangle\n", first_bad_triangle);
+			return false;
+		}
+	}
+
+	//Free all data
+	FreeAllData();
+
+	//Copy the coordinates into one vertex block, the vertices keep their slots and empty slots are NaN
+	if(vertex_count > 1) {
+		unsigned int first_vindex = 0;
+		Vector2d* vertices = AllocateVertexBlock(vertex_count - 1, first_vindex);
+
+		#pragma omp parallel for schedule(static)
+		for(long i=1; i<long(vertex_count); i++) {
+			if(isnan(coordinates[2*i]))
+				global_vertex_list[i] = NULL;
+			else {
+				vertices[i-1].x = coordinates[2*i];
+				vertices[i-1].y = coordinates[2*i+1];
+			}
+		}
+	}
+
+	if(load_triangles == false || triangle_count <= 1)
+		return true;
+
+	//Create the triangles
+	global_triangle_list.resize(triangle_count, NULL);
+
+	for(unsigned int i=1; i<triangle_count; i++) {
+		if(vertex_indices[3*i] == 0)
+			continue;
+
+		unsigned int n0 = vertex_indices[3*i];
+		unsigned int n1 = vertex_indices[3*i+1];
+		unsigned int n2 = vertex_indices[3*i+2];
+
+		Triangle* new_tri = new Triangle(GetGlobalVertexList());
+
+		new_tri->SetVertex(0, n0);
+		new_tri->SetVertex(1, n1);
+		new_tri->SetVertex(2, n2);
+
+		SetTriangle(i, new_tri);
+	}
+
+	//The neighbours are stored by index, so they can be resolved directly
+	for(unsigned int i=1; i<triangle_count; i++) {
+		Triangle* tri = global_triangle_list[i];
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++)
+			tri->SetAdjacentTriangle(j, global_triangle_list[neighbours[3*i+j]]);
+	}
+
+	return true;
+}
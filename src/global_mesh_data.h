@@ -1,5 +1,10 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+
+#include <vector>
+#include <algorithm>
+using namespace std;
 
 //XML i/o code
 #include "SimpleXML/src/xml_document.h"
@@ -9,9 +14,30 @@
 #include "vector2d.h"
 #include "triangle.h"
 
+//Binary mesh file code
+#include "binary_mesh_file.h"
+#include "compressed_mesh_file.h"
+
+//Streaming output code
+#include "buffered_writer.h"
+
+//Streaming input code
+#include "mesh_xml_reader.h"
+
 #ifndef GLOBAL_MESH_DATA
 #define GLOBAL_MESH_DATA
 
+//A contiguous run of vertices that is allocated and freed as one
+struct VertexBlock {
+	Vector2d* vertices;
+
+	unsigned int first_vindex;
+	unsigned int count;
+
+	//Adopted blocks belong to the caller and are never freed here
+	int adopted;
+};
+
 class GlobalMeshData {
 public:
 	GlobalMeshData();
@@ -21,18 +47,58 @@ public:
 	// File i/o //
 	//////////////
 
+	//The mesh file formats
+	enum {
+		UNKNOWN_FILE_FORMAT=0,
+		XML_FILE_FORMAT,
+		BINARY_FILE_FORMAT,
+		COMPRESSED_FILE_FORMAT
+	};
+
+	//Guess the file format from the file extension
+	// + ".tmb" files are binary, ".tmc" files are compressed, everything else is xml
+	static int GetFileFormat(const char* filename);
+
 	int LoadFromFile(const char* filename, int load_triangles);
+	int LoadFromFile(const char* filename, int load_triangles, int file_format);
 	int LoadFromFile(XML_Document* xml_document, int load_triangles);
 
 	int SaveToFile(const char* filename, int save_triangles);
+	int SaveToFile(const char* filename, int save_triangles, int file_format);
 	int SaveToFile(XML_Document* xml_document, int save_triangles);
 
+	//Read the xml mesh schema in one pass without building a document
+	int LoadFromXMLStream(MeshXMLReader* reader, int load_triangles);
+
+	//Write the xml mesh schema straight to a writer without building a document
+	int SaveToXMLStream(BufferedWriter* writer, int save_triangles);
+
+	//Write a single triangle element of the xml mesh schema
+	static int WriteXMLTriangle(BufferedWriter* writer, Triangle* tri, const unsigned int* adjacent_indices);
+
+	int LoadFromBinaryFile(const char* filename, int load_triangles);
+	int LoadFromBinaryFile(BinaryMeshFile* binary_mesh_file, int load_triangles);
+
+	int SaveToBinaryFile(const char* filename, int save_triangles);
+
+	//Write the binary mesh layout at the current position of an open file
+	// + the file is padded out to the size in the header, so more data can follow
+	int SaveToBinaryStream(FILE* handle, int save_triangles);
+
+	//Compressed files renumber the vertices and triangles densely
+	// + quantization_bits of 0 keeps the coordinates exactly
+	int LoadFromCompressedFile(const char* filename, int load_triangles);
+	int SaveToCompressedFile(const char* filename, int save_triangles, unsigned int quantization_bits);
+
 	int WriteSVG(const char* filename, double width, double height);
 
 	///////////////////////////////
 	// Data managament functions //
 	///////////////////////////////
 
+	//Replace this mesh with a copy of another one, keeping every vertex and triangle index
+	int CopyFrom(GlobalMeshData* global_mesh_data);
+
 	//Free data
 	int FreeAllData();
 	int FreeVertexData();
@@ -45,6 +111,35 @@ public:
 	int SetVertex(unsigned int index, Vector2d* vertex);
 	unsigned int AppendVertex(Vector2d* vertex);
 
+	//Remove a vertex, the caller has to make sure no triangle uses it any more
+	// + a vertex in a vertex block stays allocated until the block is freed
+	int DeleteVertex(unsigned int vindex);
+
+	//Grow or shrink the list to count slots, new slots are empty
+	// + slots that are cut off have to be empty already
+	int ResizeVertexList(unsigned int count);
+
+	//Append count vertices stored in one array, used for bulk loading
+	// + returns the array, first_vindex is set to the index of its first vertex
+	Vector2d* AllocateVertexBlock(unsigned int count, unsigned int& first_vindex);
+
+	//Remove the vertices of a block, and free it
+	int FreeVertexBlock(Vector2d* vertices);
+
+	//Copy count vertices into one block, from separate x and y arrays or from one interleaved xy array
+	// + returns the index of the first vertex, or 0 if nothing was added
+	unsigned int AppendVertices(const double* x, const double* y, unsigned int count);
+	unsigned int AppendVertices(const double* xy, unsigned int count);
+
+	//Use an interleaved xy array as a vertex block without copying it
+	// + the array stays the caller's, it has to outlive the vertices and FreeVertexBlock only detaches it
+	// + anything that moves vertices moves them in the caller's array
+	unsigned int AdoptVertices(double* xy, unsigned int count);
+
+	//Copy the coordinates out in slot order, GetVertexCount() entries with NaN for empty slots
+	int ExportVertices(double* xy);
+	int ExportVertices(double* x, double* y);
+
 	VertexList* GetGlobalVertexList();
 
 	//Triangles
@@ -54,8 +149,25 @@ public:
 	int SetTriangle(unsigned int index, Triangle* tri);
 	unsigned int AppendTriangle(Triangle* tri);
 
+	//Grow or shrink the list to count slots, new slots are empty
+	// + slots that are cut off have to be empty already
+	int ResizeTriangleList(unsigned int count);
+
+	//Create count triangles from 3*count vertex indices, oriented ccw and connected wherever two of them share an edge
+	// + adjacencies to the triangles already in the mesh are not looked for
+	// + returns the index of the first triangle, or 0 if nothing was added
+	unsigned int AppendTriangles(const uint32_t* vertex_indices, unsigned int count);
+
+	//Copy the triangles out in slot order, 3*GetTriangleCount() entries with 0 for empty slots and missing neighbours
+	// + neighbours can be NULL
+	int ExportTriangles(uint32_t* vertex_indices, uint32_t* neighbours);
+
 	int DeleteTriangle(unsigned int tindex);
 
+	//Free a triangle without searching the other triangles for adjacencies to it
+	// + the caller has to make sure nothing points to it any more
+	int ReleaseTriangle(unsigned int tindex);
+
 	TriangleList* GetGlobalTriangleList();
 
 private:
@@ -66,12 +178,30 @@ private:
 	int load_vertices_from_file(XML_Document* xml_document);
 	int load_triangles_from_file(XML_Document* xml_document);
 
+	//Load the mesh from arrays in the binary mesh file layout
+	int load_from_arrays(unsigned int vertex_count, const double* coordinates, unsigned int triangle_count, const uint32_t* vertex_indices, const uint32_t* neighbours, int load_triangles);
+
+	//Returns true if the vertex lives in a vertex block rather than its own allocation
+	int is_block_vertex(Vector2d* vertex);
+
+	//Add a block of vertices and point new slots at it
+	int append_vertex_block(Vector2d* vertices, unsigned int count, int adopted, unsigned int& first_vindex);
+
+	//Pair up the edges of a run of triangles
+	int connect_triangles(unsigned int first_tindex, unsigned int count);
+
+	//Free a vertex, whichever way it was allocated
+	int free_vertex(Vector2d* vertex);
+
 	//////////////////////
 	// Global mesh data //
 	//////////////////////
 
 	VertexList global_vertex_list;
 	TriangleList global_triangle_list;
+
+	//Bulk allocated vertices
+	vector<VertexBlock> vertex_blocks;
 };
 
 #endif
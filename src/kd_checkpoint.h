@@ -0,0 +1,50 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef KD_CHECKPOINT
+#define KD_CHECKPOINT
+
+//The kd-tree checkpoint file layout
+// + a binary mesh file holding the global mesh, so a checkpoint also loads as an ordinary mesh
+// + a kd checkpoint header, straight after the end of the binary mesh
+// + the local index of every triangle slot (uint32)
+// + every kd node in pre-order, each a KDCheckpointNode followed by its lists:
+//   vertex_list (uint32), triangle_list (uint32), incomplete_vertices (uint32), incomplete_vertices_angles (double), kd_bridge_triangles (uint32)
+// + the pre-order ids of the leaf nodes, in kd_leaf_nodes order (uint32)
+#define KD_CHECKPOINT_MAGIC		"TRIKDCHK"
+#define KD_CHECKPOINT_VERSION	1
+
+struct KDCheckpointHeader {
+	char magic[8];
+	uint32_t version;
+
+	//The number of reduction levels that were completed
+	uint32_t level;
+
+	uint32_t node_count;
+	uint32_t leaf_count;
+	uint32_t triangle_count;
+	uint32_t reserved;
+};
+
+struct KDCheckpointNode {
+	//The pre-order id of the parent, -1 for the root, and which of its children this is
+	int32_t parent;
+	int32_t child_slot;
+
+	int32_t splitting_dimension;
+	int32_t incomplete_lists_computed;
+
+	int32_t has_prism;
+	uint32_t vertex_count;
+	uint32_t triangle_count;
+	uint32_t incomplete_count;
+	uint32_t bridge_count;
+	uint32_t reserved;
+
+	double prism_min[2];
+	double prism_max[2];
+};
+
+#endif
@@ -0,0 +1,222 @@
+#include "laplacian_smoother.h"
+
+LaplacianSmoother::LaplacianSmoother(GlobalMeshData* global_mesh_data) {
+	this->global_mesh_data = global_mesh_data;
+
+	moving_count = 0;
+}
+
+LaplacianSmoother::~LaplacianSmoother() {
+}
+
+//Build the neighbour rows of the triangles and vertices of a complex, with the weights scaled by alpha
+int LaplacianSmoother::Build(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list, double alpha) {
+	unsigned int global_vertex_count = global_mesh_data->GetVertexCount();
+
+	//Count the triangles and add up the angles at every vertex
+	vector<unsigned int> triangle_counts(global_vertex_count, 0);
+	vector<double> angles(global_vertex_count, 0.0);
+
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(triangle_list[i]);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			double angle = 0.0;
+			if(tri->GetVertexAngle(j, angle) == true) {
+				triangle_counts[tri->GetVertexIndex(j)]++;
+				angles[tri->GetVertexIndex(j)] += angle;
+			}
+		}
+	}
+
+	//The interior vertices of the complex move, and are numbered first
+	vindices.clear();
+	local_indices.assign(global_vertex_count, -1);
+
+	for(unsigned int i=0; i<vertex_list.size(); i++) {
+		unsigned int vindex = vertex_list[i];
+		if(vindex >= global_vertex_count || local_indices[vindex] >= 0)
+			continue;
+
+		if(angles[vindex] < SMOOTHER_INTERIOR_ANGLE || triangle_counts[vindex] == 0)
+			continue;
+
+		local_indices[vindex] = vindices.size();
+		vindices.push_back(vindex);
+	}
+
+	moving_count = vindices.size();
+
+	//Every triangle gives each of its moving vertices an entry for both of the other vertices
+	row_starts.assign(moving_count+1, 0);
+
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(triangle_list[i]);
+		if(tri == NULL || tri->GetVertex(0) == NULL || tri->GetVertex(1) == NULL || tri->GetVertex(2) == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			int local_index = local_indices[tri->GetVertexIndex(j)];
+			if(local_index >= 0 && (unsigned int) local_index < moving_count)
+				row_starts[local_index+1] += 2;
+		}
+	}
+
+	for(unsigned int i=0; i<moving_count; i++)
+		row_starts[i+1] += row_starts[i];
+
+	columns.assign(row_starts[moving_count], 0);
+	weights.assign(row_starts[moving_count], 0.0);
+
+	vector<unsigned int> row_ends(row_starts.begin(), row_starts.end()-1);
+
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(triangle_list[i]);
+		if(tri == NULL || tri->GetVertex(0) == NULL || tri->GetVertex(1) == NULL || tri->GetVertex(2) == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			int local_index = local_indices[tri->GetVertexIndex(j)];
+			if(local_index < 0 || (unsigned int) local_index >= moving_count)
+				continue;
+
+			//The edge to the next vertex is across from the previous one, and the other way around
+			unsigned int& k = row_ends[local_index];
+
+			columns[k] = tri->GetVertexIndex((j+1)%3);
+			weights[k++] = (tri->GetAdjacentTriangle((j+2)%3) == NULL ? 0.5 : 0.25);
+
+			columns[k] = tri->GetVertexIndex((j+2)%3);
+			weights[k++] = (tri->GetAdjacentTriangle((j+1)%3) == NULL ? 0.5 : 0.25);
+		}
+	}
+
+	//Merge the two entries of every edge inside the mesh, and fold in alpha over the triangle count
+	unsigned int entry_count = 0;
+
+	for(unsigned int i=0; i<moving_count; i++) {
+		unsigned int start = row_starts[i];
+		unsigned int end = row_starts[i+1];
+
+		for(unsigned int k=start+1; k<end; k++) {
+			for(unsigned int m=k; m>start && columns[m-1] > columns[m]; m--) {
+				swap(columns[m-1], columns[m]);
+				swap(weights[m-1], weights[m]);
+			}
+		}
+
+		row_starts[i] = entry_count;
+
+		for(unsigned int k=start; k<end; k++) {
+			if(k > start && columns[k] == columns[k-1])
+				weights[entry_count-1] += weights[k];
+			else {
+				columns[entry_count] = columns[k];
+				weights[entry_count] = weights[k];
+				entry_count++;
+			}
+		}
+
+		double scale = alpha / double(triangle_counts[vindices[i]]);
+		for(unsigned int k=row_starts[i]; k<entry_count; k++)
+			weights[k] *= scale;
+	}
+
+	row_starts[moving_count] = entry_count;
+
+	columns.resize(entry_count);
+	weights.resize(entry_count);
+
+	//The neighbours that don't move are numbered after the ones that do
+	for(unsigned int k=0; k<entry_count; k++)
+		columns[k] = find_local_vertex(columns[k]);
+
+	x.resize(vindices.size());
+	y.resize(vindices.size());
+
+	for(unsigned int i=0; i<vindices.size(); i++) {
+		Vector2d* v = global_mesh_data->GetVertex(vindices[i]);
+
+		x[i] = v->x;
+		y[i] = v->y;
+	}
+
+	next_x = x;
+	next_y = y;
+
+	printf("Smoothing %u of %u vertices, %u neighbours\n", moving_count, (unsigned int) vindices.size(), entry_count);
+
+	return true;
+}
+
+//Run some iterations, then copy the moved vertices back into the global mesh
+int LaplacianSmoother::Smooth(unsigned int iterations) {
+	long row_count = moving_count;
+	if(row_count == 0)
+		return true;
+
+	const unsigned int* starts = &row_starts[0];
+	const unsigned int* neighbours = &columns[0];
+	const double* neighbour_weights = &weights[0];
+
+	for(unsigned int iter=0; iter<iterations; iter++) {
+		const double* px = &x[0];
+		const double* py = &y[0];
+
+		double* next_px = &next_x[0];
+		double* next_py = &next_y[0];
+
+		#pragma omp parallel for schedule(static)
+		for(long i=0; i<row_count; i++) {
+			double xi = px[i];
+			double yi = py[i];
+
+			double dx = 0.0;
+			double dy = 0.0;
+
+			#pragma omp simd reduction(+:dx,dy)
+			for(unsigned int k=starts[i]; k<starts[i+1]; k++) {
+				dx += neighbour_weights[k] * (px[neighbours[k]] - xi);
+				dy += neighbour_weights[k] * (py[neighbours[k]] - yi);
+			}
+
+			next_px[i] = xi + dx;
+			next_py[i] = yi + dy;
+		}
+
+		//The vertices that don't move are the same in both copies
+		x.swap(next_x);
+		y.swap(next_y);
+	}
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<row_count; i++) {
+		Vector2d* v = global_mesh_data->GetVertex(vindices[i]);
+
+		v->x = x[i];
+		v->y = y[i];
+	}
+
+	return true;
+}
+
+//The number of vertices that move
+unsigned int LaplacianSmoother::GetMovingVertexCount() {
+	return moving_count;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//The local index of a global vertex, adding it if it is new
+unsigned int LaplacianSmoother::find_local_vertex(unsigned int vindex) {
+	if(local_indices[vindex] < 0) {
+		local_indices[vindex] = vindices.size();
+		vindices.push_back(vindex);
+	}
+
+	return local_indices[vindex];
+}
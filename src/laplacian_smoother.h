@@ -0,0 +1,76 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+//Triangulation algorithm related code
+#include "utility.h"
+#include "vector2d.h"
+#include "triangle.h"
+
+//Mesh data code
+#include "global_mesh_data.h"
+
+#include <omp.h>
+
+#ifndef LAPLACIAN_SMOOTHER
+#define LAPLACIAN_SMOOTHER
+
+//A vertex moves only if the angles of its triangles add up to at least this, so it is inside the mesh
+#define SMOOTHER_INTERIOR_ANGLE		6.28318
+
+//Laplacian smoothing of the vertices of a complex, the stretched grid method
+// + every interior vertex moves by alpha times the weighted sum of the vectors to its neighbours, divided by the
+//   number of its triangles, the weight of an edge is 0.25 from each triangle beside it, or 0.5 on the boundary
+// + boundary vertices, and vertices not in the complex, stay where they are
+// + the neighbours and their weights are built once into rows, one per moving vertex, and the coordinates are
+//   copied into x and y arrays, the moving vertices first
+// + every iteration reads one copy of the coordinates and writes the other, so all the rows run in parallel
+class LaplacianSmoother {
+public:
+	LaplacianSmoother(GlobalMeshData* global_mesh_data);
+	~LaplacianSmoother();
+
+	//Build the neighbour rows of the triangles and vertices of a complex, with the weights scaled by alpha
+	int Build(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list, double alpha);
+
+	//Run some iterations, then copy the moved vertices back into the global mesh
+	int Smooth(unsigned int iterations);
+
+	//The number of vertices that move
+	unsigned int GetMovingVertexCount();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//The local index of a global vertex, adding it if it is new
+	unsigned int find_local_vertex(unsigned int vindex);
+
+	//The mesh being smoothed
+	GlobalMeshData* global_mesh_data;
+
+	//The global vertex index of every local vertex, the moving ones first
+	vector<unsigned int> vindices;
+	vector<int> local_indices;
+
+	unsigned int moving_count;
+
+	//Row i holds the neighbours of moving vertex i, from columns[row_starts[i]] to columns[row_starts[i+1]-1]
+	vector<unsigned int> row_starts;
+	vector<unsigned int> columns;
+	vector<double> weights;
+
+	//The coordinates being read and written
+	vector<double> x;
+	vector<double> y;
+
+	vector<double> next_x;
+	vector<double> next_y;
+};
+
+#endif
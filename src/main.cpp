@@ -1,13 +1,84 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 #include "triangle_mesher.h"
+#include "mesher_batch.h"
+#include "mesher_service.h"
 
 int main(int argc, char** argv) {
 	//Seed random
 	srand(time(0));
 
+	//main -batch manifest runs every command file listed in the manifest in this one process
+	if(argc >= 3 && strcmp(argv[1], "-batch") == 0) {
+		MesherBatch mesher_batch;
+		if(mesher_batch.LoadManifest(argv[2]) == false)
+			return 1;
+
+		return (mesher_batch.RunJobs() == true ? 0 : 1);
+	}
+
+	//main -serve socket_path answers meshing requests on a unix domain socket, main -serve - on stdin/stdout
+	if(argc >= 3 && strcmp(argv[1], "-serve") == 0) {
+		MesherService mesher_service;
+
+		int ret = false;
+		if(strcmp(argv[2], "-") == 0)
+			ret = mesher_service.ServeStdio();
+		else
+			ret = mesher_service.ServeSocket(argv[2]);
+
+		return (ret == true ? 0 : 1);
+	}
+
+	//main -dry-run cmdfile [calibration] predicts what every command will cost without meshing anything
+	if(argc >= 3 && strcmp(argv[1], "-dry-run") == 0) {
+		TriangleMesher triangle_mesher;
+		if(triangle_mesher.LoadCommandsFromFile(argv[2]) == false) {
+			printf("Error loading file %s\n", argv[2]);
+			return 1;
+		}
+
+		MesherCostModel cost_model;
+		if(argc >= 4 && cost_model.LoadCalibration(argv[3]) == false)
+			return 1;
+
+		vector<CommandEstimate> estimates;
+		triangle_mesher.EstimateMesherCommands(&cost_model, estimates);
+
+		MesherCostModel::PrintEstimates(estimates);
+
+		string estimate_filename = string(argv[2]) + ".estimate.json";
+		if(MesherCostModel::WriteEstimates(estimate_filename.c_str(), argv[2], estimates) == false)
+			return 1;
+
+		return 0;
+	}
+
+	//main -calibrate cmdfile calibration runs the commands and fits the cost model to how long they took
+	if(argc >= 4 && strcmp(argv[1], "-calibrate") == 0) {
+		TriangleMesher triangle_mesher;
+		if(triangle_mesher.LoadCommandsFromFile(argv[2]) == false) {
+			printf("Error loading file %s\n", argv[2]);
+			return 1;
+		}
+
+		//An existing calibration keeps the command types this file doesn't run
+		MesherCostModel cost_model;
+		FILE* handle = fopen(argv[3], "r");
+		if(handle != NULL) {
+			fclose(handle);
+			cost_model.LoadCalibration(argv[3]);
+		}
+
+		triangle_mesher.RunMesherCommands();
+		triangle_mesher.CalibrateCostModel(&cost_model);
+
+		return (cost_model.SaveCalibration(argv[3]) == true ? 0 : 1);
+	}
+
 	char filename[1000];
 	if(argc >= 2)
 		sprintf(filename, "%s", argv[1]);
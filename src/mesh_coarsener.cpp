@@ -0,0 +1,599 @@
+#include "mesh_coarsener.h"
+
+MeshCoarsener::MeshCoarsener(GlobalMeshData* global_mesh_data) {
+	this->global_mesh_data = global_mesh_data;
+
+	triangle_list = NULL;
+	vertex_list = NULL;
+
+	desired_edge_length = 0.0;
+	target_triangle_count = 0;
+
+	triangle_count = 0;
+	collapsed_edge_count = 0;
+}
+
+MeshCoarsener::~MeshCoarsener() {
+}
+
+/////////////
+// Options //
+/////////////
+
+//Edges shorter than this are collapsed, 0 lets any edge collapse
+int MeshCoarsener::SetDesiredEdgeLength(double desired_edge_length) {
+	if(desired_edge_length < 0)
+		return false;
+
+	this->desired_edge_length = desired_edge_length;
+	return true;
+}
+
+//Stop once the mesh is down to this many triangles, 0 turns it off
+int MeshCoarsener::SetTargetTriangleCount(unsigned int target_triangle_count) {
+	this->target_triangle_count = target_triangle_count;
+	return true;
+}
+
+////////////////
+// Coarsening //
+////////////////
+
+//Coarsen the triangles of a complex
+int MeshCoarsener::Coarsen(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list) {
+	this->triangle_list = &triangle_list;
+	this->vertex_list = &vertex_list;
+
+	collapsed_edge_count = 0;
+
+	//Without either limit every edge would be collapsed
+	if(desired_edge_length <= 0 && target_triangle_count == 0) {
+		printf("Error: coarsening needs a desired edge length or a target triangle count\n");
+		return false;
+	}
+
+	if(build_vertex_triangles() == false)
+		return false;
+
+	while(candidates.empty() == false)
+		candidates.pop();
+
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(triangle_list[i]);
+		if(tri != NULL)
+			push_candidates(tri, 0);
+	}
+
+	printf("Coarsening %u triangles, %u short edges\n", triangle_count, (unsigned int) candidates.size());
+
+	unsigned int skipped_count = 0;
+
+	while(candidates.empty() == false) {
+		if(target_triangle_count > 0 && triangle_count <= target_triangle_count)
+			break;
+
+		CollapseCandidate candidate = candidates.top();
+		candidates.pop();
+
+		Vector2d* v0 = global_mesh_data->GetVertex(candidate.vertices[0]);
+		Vector2d* v1 = global_mesh_data->GetVertex(candidate.vertices[1]);
+
+		if(v0 == NULL || v1 == NULL)
+			continue;
+
+		//An end point has moved since the edge was queued, queue it again with its new length
+		double length = v0->distance(*v1);
+		if(length != candidate.length) {
+			if(desired_edge_length <= 0 || length < desired_edge_length) {
+				candidate.length = length;
+				candidates.push(candidate);
+			}
+
+			continue;
+		}
+
+		if(collapse_edge(candidate.vertices[0], candidate.vertices[1]) == true)
+			collapsed_edge_count++;
+		else
+			skipped_count++;
+	}
+
+	while(candidates.empty() == false)
+		candidates.pop();
+
+	vector<Triangle*>().swap(vertex_triangles);
+
+	//Take the freed triangles and vertices out of the lists
+	unsigned int count = 0;
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		if(global_mesh_data->GetTriangle(triangle_list[i]) != NULL)
+			triangle_list[count++] = triangle_list[i];
+	}
+	triangle_list.resize(count);
+
+	count = 0;
+	for(unsigned int i=0; i<vertex_list.size(); i++) {
+		if(global_mesh_data->GetVertex(vertex_list[i]) != NULL)
+			vertex_list[count++] = vertex_list[i];
+	}
+	vertex_list.resize(count);
+
+	printf("Collapsed %u edges; turned down %u collapses; %u triangles left\n", collapsed_edge_count, skipped_count, triangle_count);
+	return true;
+}
+
+//The number of edges collapsed by the last Coarsen
+unsigned int MeshCoarsener::GetCollapsedEdgeCount() {
+	return collapsed_edge_count;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//Point every vertex of the complex at one of its triangles
+int MeshCoarsener::build_vertex_triangles() {
+	vertex_triangles.assign(global_mesh_data->GetVertexCount(), NULL);
+	triangle_count = 0;
+
+	for(unsigned int i=0; i<triangle_list->size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle((*triangle_list)[i]);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			unsigned int vindex = tri->GetVertexIndex(j);
+			if(vindex >= vertex_triangles.size()) {
+				printf("Error: triangle %u has a vertex that isn't in the mesh\n", (*triangle_list)[i]);
+				return false;
+			}
+
+			vertex_triangles[vindex] = tri;
+		}
+
+		triangle_count++;
+	}
+
+	return true;
+}
+
+//Queue the edges of a triangle that are short enough to collapse, only the ones at vindex if it isn't 0
+int MeshCoarsener::push_candidates(Triangle* tri, unsigned int vindex) {
+	for(int i=0; i<3; i++) {
+		unsigned int v0 = tri->GetVertexIndex((i+1)%3);
+		unsigned int v1 = tri->GetVertexIndex((i+2)%3);
+
+		if(vindex != 0 && v0 != vindex && v1 != vindex)
+			continue;
+
+		//The triangle on the other side queues the edge the other way around
+		if(v0 > v1 && tri->GetAdjacentTriangle(i) != NULL)
+			continue;
+
+		CollapseCandidate candidate;
+		candidate.length = tri->GetVertex((i+1)%3)->distance(*tri->GetVertex((i+2)%3));
+		candidate.vertices[0] = v0;
+		candidate.vertices[1] = v1;
+
+		if(desired_edge_length <= 0 || candidate.length < desired_edge_length)
+			candidates.push(candidate);
+	}
+
+	return true;
+}
+
+//Collapse one edge
+int MeshCoarsener::collapse_edge(unsigned int v0, unsigned int v1) {
+	vector<Triangle*> star0, star1;
+	int on_boundary0 = false, on_boundary1 = false;
+
+	if(gather_star(v0, star0, on_boundary0) == false || gather_star(v1, star1, on_boundary1) == false)
+		return false;
+
+	//This also finds out if the edge is still there
+	vector<unsigned int> edge_apexes;
+	if(test_link_condition(v0, v1, star0, star1, edge_apexes) == false)
+		return false;
+
+	int edge_on_boundary = (edge_apexes.size() == 1);
+
+	//Pick the end point to remove and where the kept one goes
+	int remove_first = true;
+
+	if(on_boundary0 == true && on_boundary1 == true) {
+		//An interior edge between two boundary vertices would pinch the mesh
+		if(edge_on_boundary == false)
+			return false;
+
+		if(is_flat_boundary_vertex(v0, star0) == true)
+			remove_first = true;
+
+		else if(is_flat_boundary_vertex(v1, star1) == true)
+			remove_first = false;
+
+		else
+			return false;
+	}
+
+	else if(on_boundary0 == true)
+		remove_first = false;
+
+	unsigned int remove_vindex = (remove_first ? v0 : v1);
+	unsigned int keep_vindex = (remove_first ? v1 : v0);
+
+	vector<Triangle*>& remove_star = (remove_first ? star0 : star1);
+	vector<Triangle*>& keep_star = (remove_first ? star1 : star0);
+
+	Vector2d* keep_vertex = global_mesh_data->GetVertex(keep_vindex);
+	Vector2d* remove_vertex = global_mesh_data->GetVertex(remove_vindex);
+
+	Vector2d pt = *keep_vertex;
+	if(on_boundary0 == false && on_boundary1 == false)
+		pt = (*keep_vertex + *remove_vertex) / 2.0;
+
+	//No triangle may fold over or get much worse
+	double min_angle_before = 180.0;
+	double min_angle_after = 180.0;
+
+	if(test_moved_star(remove_vindex, keep_vindex, remove_star, pt, min_angle_before, min_angle_after) == false)
+		return false;
+
+	if(test_moved_star(keep_vindex, remove_vindex, keep_star, pt, min_angle_before, min_angle_after) == false)
+		return false;
+
+	if(min_angle_after < min(COARSENER_MINIMUM_ANGLE, min_angle_before))
+		return false;
+
+	//No edge may get much longer than the desired edge length
+	if(desired_edge_length > 0) {
+		double max_edge_length = COARSENER_MAX_EDGE_RATIO * desired_edge_length;
+
+		for(unsigned int i=0; i<star0.size() + star1.size(); i++) {
+			Triangle* tri = (i < star0.size() ? star0[i] : star1[i - star0.size()]);
+
+			for(int j=0; j<3; j++) {
+				unsigned int vindex = tri->GetVertexIndex(j);
+				if(vindex != v0 && vindex != v1 && tri->GetVertex(j)->distance(pt) > max_edge_length)
+					return false;
+			}
+		}
+	}
+
+	//The triangles on the edge are dropped, and their neighbours across the other two edges are joined up
+	vector<Triangle*> edge_triangles;
+	vector<Triangle*> keep_sides, remove_sides;
+	vector<unsigned int> apexes;
+
+	for(unsigned int i=0; i<remove_star.size(); i++) {
+		Triangle* tri = remove_star[i];
+		if(tri->IsVertex(keep_vindex) == false)
+			continue;
+
+		Triangle* keep_side = NULL;
+		Triangle* remove_side = NULL;
+		unsigned int apex_vindex = 0;
+
+		for(int j=0; j<3; j++) {
+			if(tri->GetVertexIndex(j) == remove_vindex)
+				keep_side = tri->GetAdjacentTriangle(j);
+
+			else if(tri->GetVertexIndex(j) == keep_vindex)
+				remove_side = tri->GetAdjacentTriangle(j);
+
+			else
+				apex_vindex = tri->GetVertexIndex(j);
+		}
+
+		//The apex would be left on its own
+		if(keep_side == NULL && remove_side == NULL)
+			return false;
+
+		edge_triangles.push_back(tri);
+		keep_sides.push_back(keep_side);
+		remove_sides.push_back(remove_side);
+		apexes.push_back(apex_vindex);
+	}
+
+	//Nothing would be left
+	if(remove_star.size() + keep_star.size() == 2 * edge_triangles.size())
+		return false;
+
+	for(unsigned int i=0; i<edge_triangles.size(); i++) {
+		Triangle* tri = edge_triangles[i];
+
+		for(int j=0; j<3; j++) {
+			if(keep_sides[i] != NULL && keep_sides[i]->GetAdjacentTriangle(j) == tri)
+				keep_sides[i]->SetAdjacentTriangle(j, remove_sides[i]);
+
+			if(remove_sides[i] != NULL && remove_sides[i]->GetAdjacentTriangle(j) == tri)
+				remove_sides[i]->SetAdjacentTriangle(j, keep_sides[i]);
+		}
+
+		vertex_triangles[apexes[i]] = (keep_sides[i] != NULL ? keep_sides[i] : remove_sides[i]);
+
+		global_mesh_data->ReleaseTriangle(tri->GetTriangleIndex());
+		triangle_count--;
+	}
+
+	//The kept vertex takes over the rest of the star, and moves
+	vector<Triangle*> changed_triangles;
+
+	for(unsigned int i=0; i<remove_star.size(); i++) {
+		if(find(edge_triangles.begin(), edge_triangles.end(), remove_star[i]) == edge_triangles.end())
+			changed_triangles.push_back(remove_star[i]);
+	}
+
+	for(unsigned int i=0; i<keep_star.size(); i++) {
+		if(find(edge_triangles.begin(), edge_triangles.end(), keep_star[i]) == edge_triangles.end())
+			changed_triangles.push_back(keep_star[i]);
+	}
+
+	*keep_vertex = pt;
+
+	//Setting a vertex also clears the cached circumcircle
+	for(unsigned int i=0; i<changed_triangles.size(); i++) {
+		Triangle* tri = changed_triangles[i];
+
+		for(int j=0; j<3; j++) {
+			if(tri->GetVertexIndex(j) == remove_vindex || tri->GetVertexIndex(j) == keep_vindex)
+				tri->SetVertex(j, keep_vindex);
+		}
+	}
+
+	vertex_triangles[keep_vindex] = changed_triangles[0];
+	vertex_triangles[remove_vindex] = NULL;
+
+	global_mesh_data->DeleteVertex(remove_vindex);
+
+	legalize_triangles(changed_triangles);
+
+	//The edges at the kept vertex are the ones that changed
+	vector<Triangle*> star;
+	int on_boundary = false;
+
+	if(gather_star(keep_vindex, star, on_boundary) == true) {
+		for(unsigned int i=0; i<star.size(); i++)
+			push_candidates(star[i], keep_vindex);
+	}
+
+	return true;
+}
+
+//The triangles around a vertex in ccw order, starting at the boundary if the vertex is on it
+int MeshCoarsener::gather_star(unsigned int vindex, vector<Triangle*>& star, int& on_boundary) {
+	star.clear();
+	on_boundary = false;
+
+	if(vindex >= vertex_triangles.size() || vertex_triangles[vindex] == NULL)
+		return false;
+
+	Triangle* start = vertex_triangles[vindex];
+
+	//Walk ccw, across the edge from the vertex to the one after it
+	Triangle* tri = start;
+	while(tri != NULL) {
+		star.push_back(tri);
+
+		//Something is wrong with the adjacencies
+		if(star.size() > triangle_count)
+			return false;
+
+		int vertex = -1;
+		for(int i=0; i<3; i++) {
+			if(tri->GetVertexIndex(i) == vindex)
+				vertex = i;
+		}
+
+		if(vertex < 0)
+			return false;
+
+		tri = tri->GetAdjacentTriangle((vertex+1)%3);
+		if(tri == start)
+			return true;
+	}
+
+	//The walk ran into the boundary, so walk cw from the start to the other side of it
+	on_boundary = true;
+
+	vector<Triangle*> cw_triangles;
+	tri = start;
+
+	while(true) {
+		int vertex = -1;
+		for(int i=0; i<3; i++) {
+			if(tri->GetVertexIndex(i) == vindex)
+				vertex = i;
+		}
+
+		if(vertex < 0)
+			return false;
+
+		tri = tri->GetAdjacentTriangle((vertex+2)%3);
+		if(tri == NULL)
+			break;
+
+		cw_triangles.push_back(tri);
+
+		if(star.size() + cw_triangles.size() > triangle_count)
+			return false;
+	}
+
+	star.insert(star.begin(), cw_triangles.rbegin(), cw_triangles.rend());
+	return true;
+}
+
+//Returns true if the two stars share exactly the vertices across from the edge between their centers
+int MeshCoarsener::test_link_condition(unsigned int v0, unsigned int v1, vector<Triangle*>& star0, vector<Triangle*>& star1, vector<unsigned int>& edge_apexes) {
+	vector<unsigned int> ring0, ring1;
+	edge_apexes.clear();
+
+	for(unsigned int i=0; i<star0.size(); i++) {
+		for(int j=0; j<3; j++) {
+			unsigned int vindex = star0[i]->GetVertexIndex(j);
+			if(vindex != v0 && vindex != v1)
+				ring0.push_back(vindex);
+		}
+
+		if(star0[i]->IsVertex(v1) == true) {
+			for(int j=0; j<3; j++) {
+				unsigned int vindex = star0[i]->GetVertexIndex(j);
+				if(vindex != v0 && vindex != v1)
+					edge_apexes.push_back(vindex);
+			}
+		}
+	}
+
+	for(unsigned int i=0; i<star1.size(); i++) {
+		for(int j=0; j<3; j++) {
+			unsigned int vindex = star1[i]->GetVertexIndex(j);
+			if(vindex != v0 && vindex != v1)
+				ring1.push_back(vindex);
+		}
+	}
+
+	//The edge is gone
+	if(edge_apexes.empty() == true)
+		return false;
+
+	sort(ring0.begin(), ring0.end());
+	ring0.erase(unique(ring0.begin(), ring0.end()), ring0.end());
+
+	sort(ring1.begin(), ring1.end());
+	ring1.erase(unique(ring1.begin(), ring1.end()), ring1.end());
+
+	sort(edge_apexes.begin(), edge_apexes.end());
+
+	vector<unsigned int> shared;
+	set_intersection(ring0.begin(), ring0.end(), ring1.begin(), ring1.end(), back_inserter(shared));
+
+	return (shared == edge_apexes);
+}
+
+//Returns true if a boundary vertex can be removed without changing the shape of the boundary
+int MeshCoarsener::is_flat_boundary_vertex(unsigned int vindex, vector<Triangle*>& star) {
+	if(star.empty() == true)
+		return false;
+
+	//The boundary neighbours are the first vertex after the center in the first triangle of the star, and the
+	//last vertex in the last triangle
+	Vector2d* prev_vertex = NULL;
+	Vector2d* next_vertex = NULL;
+
+	for(int i=0; i<3; i++) {
+		if(star.front()->GetVertexIndex(i) == vindex)
+			prev_vertex = star.front()->GetVertex((i+1)%3);
+
+		if(star.back()->GetVertexIndex(i) == vindex)
+			next_vertex = star.back()->GetVertex((i+2)%3);
+	}
+
+	Vector2d* vertex = global_mesh_data->GetVertex(vindex);
+	if(prev_vertex == NULL || next_vertex == NULL || vertex == NULL)
+		return false;
+
+	Vector2d chord = *next_vertex - *prev_vertex;
+	Vector2d offset = *vertex - *prev_vertex;
+
+	double chord_length2 = chord.x*chord.x + chord.y*chord.y;
+	double along = chord.x*offset.x + chord.y*offset.y;
+
+	if(along <= 0 || along >= chord_length2)
+		return false;
+
+	return (fabs(chord.x*offset.y - chord.y*offset.x) <= COARSENER_BOUNDARY_TOLERANCE * chord_length2);
+}
+
+//Returns true if the triangles of a star that don't hold the other end point stay good with their center at pt
+int MeshCoarsener::test_moved_star(unsigned int vindex, unsigned int other_vindex, vector<Triangle*>& star, Vector2d pt, double& min_angle_before, double& min_angle_after) {
+	for(unsigned int i=0; i<star.size(); i++) {
+		Triangle* tri = star[i];
+
+		Vector2d before[3];
+		Vector2d after[3];
+
+		for(int j=0; j<3; j++) {
+			before[j] = *tri->GetVertex(j);
+			after[j] = (tri->GetVertexIndex(j) == vindex ? pt : before[j]);
+		}
+
+		min_angle_before = min(min_angle_before, compute_minimum_angle(before[0], before[1], before[2]));
+
+		//The triangles on the edge go away
+		if(tri->IsVertex(other_vindex) == true)
+			continue;
+
+		if(compute_orientation(after[0], after[1], after[2]) <= 0)
+			return false;
+
+		min_angle_after = min(min_angle_after, compute_minimum_angle(after[0], after[1], after[2]));
+	}
+
+	return true;
+}
+
+//Lawson flips over every edge of some triangles and of the triangles flipped in their place
+int MeshCoarsener::legalize_triangles(vector<Triangle*>& triangles) {
+	vector<Triangle*> flip_stack = triangles;
+
+	while(flip_stack.empty() == false) {
+		Triangle* tri = flip_stack.back();
+		flip_stack.pop_back();
+
+		Vector2d center;
+		double circumradius = 0.0;
+
+		if(tri->GetCircumcircle(center, circumradius) == false)
+			continue;
+
+		for(int i=0; i<3; i++) {
+			Triangle* adj_tri = tri->GetAdjacentTriangle(i);
+			if(adj_tri == NULL)
+				continue;
+
+			Vector2d* external_vertex = NULL;
+			for(int j=0; j<3; j++) {
+				if(tri->IsVertex(adj_tri->GetVertexIndex(j)) == false)
+					external_vertex = adj_tri->GetVertex(j);
+			}
+
+			//Cocircular vertices are left alone, so they aren't flipped back and forth
+			if(external_vertex == NULL || external_vertex->distance(center) >= circumradius * (1.0 - 1e-9))
+				continue;
+
+			if(tri->PerformDelaunayFlip(i) == true) {
+				//The shared edge's end points may have pointed at the triangle that lost them
+				for(int j=0; j<3; j++) {
+					vertex_triangles[tri->GetVertexIndex(j)] = tri;
+					vertex_triangles[adj_tri->GetVertexIndex(j)] = adj_tri;
+				}
+
+				flip_stack.push_back(tri);
+				flip_stack.push_back(adj_tri);
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+//The smallest angle of a triangle in degrees
+double MeshCoarsener::compute_minimum_angle(Vector2d v0, Vector2d v1, Vector2d v2) {
+	Vector2d v[3] = {v0, v1, v2};
+	double min_angle = 180.0;
+
+	for(int i=0; i<3; i++) {
+		Vector2d e0 = v[(i+1)%3] - v[i];
+		Vector2d e1 = v[(i+2)%3] - v[i];
+
+		double angle = atan2(fabs(e0.x*e1.y - e0.y*e1.x), e0.x*e1.x + e0.y*e1.y) * 180.0 / PI;
+		min_angle = min(min_angle, angle);
+	}
+
+	return min_angle;
+}
+
+//The signed area of a triangle times two, positive if it is ccw
+double MeshCoarsener::compute_orientation(Vector2d v0, Vector2d v1, Vector2d v2) {
+	return (v1.x - v0.x)*(v2.y - v0.y) - (v1.y - v0.y)*(v2.x - v0.x);
+}
@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+using namespace std;
+
+//Triangulation algorithm related code
+#include "utility.h"
+#include "vector2d.h"
+#include "triangle.h"
+
+//Mesh data code
+#include "global_mesh_data.h"
+
+#ifndef MESH_COARSENER
+#define MESH_COARSENER
+
+//A collapse is turned down if it makes an edge longer than this times the desired edge length
+#define COARSENER_MAX_EDGE_RATIO		(4.0/3.0)
+
+//A collapse may not make a triangle with a smaller angle than this, in degrees, unless the triangles it
+//changes already had one
+#define COARSENER_MINIMUM_ANGLE			15.0
+
+//A boundary vertex is only removed if it is this close to the line through its boundary neighbours,
+//relative to their distance
+#define COARSENER_BOUNDARY_TOLERANCE	1e-3
+
+//An edge waiting to be collapsed
+// + the length is kept so an entry for an edge that has moved since it was queued can be told apart
+struct CollapseCandidate {
+	double length;
+
+	unsigned int vertices[2];
+
+	//Shortest edge first
+	bool operator<(const CollapseCandidate& candidate) const {
+		return length > candidate.length;
+	}
+};
+
+//Coarsens a mesh by collapsing its short edges, shortest first
+// + an edge collapse removes one end point and the one or two triangles on the edge, the other end point takes
+//   over the triangles of the removed one
+// + interior edges collapse to their midpoint, an edge with a boundary end point collapses onto that end point,
+//   and boundary edges only collapse where the boundary is straight, so the domain keeps its shape
+// + every collapse is checked against the stars of its end points, found through a vertex to triangle index and
+//   the adjacencies, it has to keep the mesh a manifold (the link condition), must not fold any triangle over,
+//   and must not make the triangles much worse
+// + every collapse is followed by Lawson flips around the kept vertex, so a Delaunay mesh stays Delaunay
+class MeshCoarsener {
+public:
+	MeshCoarsener(GlobalMeshData* global_mesh_data);
+	~MeshCoarsener();
+
+	/////////////
+	// Options //
+	/////////////
+
+	//Edges shorter than this are collapsed, 0 lets any edge collapse
+	int SetDesiredEdgeLength(double desired_edge_length);
+
+	//Stop once the mesh is down to this many triangles, 0 turns it off
+	int SetTargetTriangleCount(unsigned int target_triangle_count);
+
+	////////////////
+	// Coarsening //
+	////////////////
+
+	//Coarsen the triangles of a complex
+	// + the removed triangles and vertices are freed in the global mesh and taken out of the lists
+	// + the complex has to hold every triangle its triangles are connected to, as the top complex does
+	int Coarsen(vector<unsigned int>& triangle_list, vector<unsigned int>& vertex_list);
+
+	//The number of edges collapsed by the last Coarsen
+	unsigned int GetCollapsedEdgeCount();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//Point every vertex of the complex at one of its triangles
+	int build_vertex_triangles();
+
+	//Queue the edges of a triangle that are short enough to collapse, only the ones at vindex if it isn't 0
+	// + an edge between two triangles is only queued from one of them
+	int push_candidates(Triangle* tri, unsigned int vindex);
+
+	//Collapse one edge, returns false if the edge is gone or the collapse was turned down
+	int collapse_edge(unsigned int v0, unsigned int v1);
+
+	//The triangles around a vertex in ccw order, starting at the boundary if the vertex is on it
+	// + returns false if the star doesn't close up or run into the boundary both ways
+	int gather_star(unsigned int vindex, vector<Triangle*>& star, int& on_boundary);
+
+	//Returns true if the two stars share exactly the vertices across from the edge between their centers
+	int test_link_condition(unsigned int v0, unsigned int v1, vector<Triangle*>& star0, vector<Triangle*>& star1, vector<unsigned int>& edge_apexes);
+
+	//Returns true if a boundary vertex can be removed without changing the shape of the boundary
+	int is_flat_boundary_vertex(unsigned int vindex, vector<Triangle*>& star);
+
+	//Returns true if the triangles of a star that don't hold the other end point stay good with their center at pt
+	// + min_angle_before is lowered to the smallest angle of the star as it is now
+	int test_moved_star(unsigned int vindex, unsigned int other_vindex, vector<Triangle*>& star, Vector2d pt, double& min_angle_before, double& min_angle_after);
+
+	//Lawson flips over every edge of some triangles and of the triangles flipped in their place
+	int legalize_triangles(vector<Triangle*>& triangles);
+
+	//The smallest angle of a triangle in degrees, and its signed area times two
+	static double compute_minimum_angle(Vector2d v0, Vector2d v1, Vector2d v2);
+	static double compute_orientation(Vector2d v0, Vector2d v1, Vector2d v2);
+
+	//The mesh being coarsened
+	GlobalMeshData* global_mesh_data;
+
+	//The lists of the complex being coarsened
+	vector<unsigned int>* triangle_list;
+	vector<unsigned int>* vertex_list;
+
+	//Coarsening options
+	double desired_edge_length;
+	unsigned int target_triangle_count;
+
+	//One triangle holding each vertex, by global vertex index
+	vector<Triangle*> vertex_triangles;
+
+	//The edges that are short enough
+	priority_queue<CollapseCandidate> candidates;
+
+	unsigned int triangle_count;
+	unsigned int collapsed_edge_count;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "mesh_stream_writer.h"
+
+//The stand-in neighbour for freed triangles
+// + it has no vertices, so every Delaunay test against it passes, and its index of 0 reads as no neighbour
+static Triangle sealed_triangle(NULL);
+
+MeshStreamWriter::MeshStreamWriter() {
+	is_open = false;
+
+	global_mesh_data = NULL;
+	triangle_count = 0;
+}
+
+MeshStreamWriter::~MeshStreamWriter() {
+	if(is_open == true)
+		Close();
+}
+
+//////////////
+// File i/o //
+//////////////
+
+//Open the file and write the vertices
+int MeshStreamWriter::Open(const char* filename, GlobalMeshData* global_mesh_data) {
+	if(is_open == true)
+		Close();
+
+	if(writer.Open(filename) == false)
+		return false;
+
+	this->global_mesh_data = global_mesh_data;
+	triangle_count = 0;
+	sealed_links.clear();
+
+	//The vertices don't change while meshing, so they all go first
+	global_mesh_data->SaveToXMLStream(&writer, false);
+	writer.WriteString("<trianglelist>\n");
+
+	if(writer.IsGood() == false) {
+		printf("Error writing the mesh stream %s\n", filename);
+
+		writer.Close();
+		return false;
+	}
+
+	is_open = true;
+	return true;
+}
+
+//Write every triangle still in the global mesh and finish the file
+// + the sealed links of the remaining triangles are cleared
+int MeshStreamWriter::Close() {
+	if(is_open == false)
+		return false;
+
+	for(unsigned int i=0; i<global_mesh_data->GetTriangleCount(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		WriteTriangle(tri);
+
+		for(int j=0; j<3; j++) {
+			if(tri->GetAdjacentTriangle(j) == GetSealedTriangle())
+				tri->SetAdjacentTriangle(j, NULL);
+		}
+	}
+
+	writer.WriteString("</trianglelist>\n");
+
+	int ret = writer.IsGood();
+	if(writer.Close() == false)
+		ret = false;
+
+	if(ret == false)
+		printf("Error writing the mesh stream\n");
+
+	printf("Streamed %u triangles\n", triangle_count);
+
+	is_open = false;
+	global_mesh_data = NULL;
+	sealed_links.clear();
+
+	return ret;
+}
+
+int MeshStreamWriter::IsOpen() {
+	return is_open;
+}
+
+///////////////
+// Streaming //
+///////////////
+
+//Write one final triangle
+int MeshStreamWriter::WriteTriangle(Triangle* tri) {
+	if(is_open == false || tri == NULL)
+		return false;
+
+	unsigned int adjacent_indices[3];
+
+	for(int j=0; j<3; j++) {
+		Triangle* adj_tri = tri->GetAdjacentTriangle(j);
+		adjacent_indices[j] = 0;
+
+		if(adj_tri == GetSealedTriangle()) {
+			map<uint64_t, unsigned int>::iterator it = sealed_links.find(link_key(tri, j));
+
+			if(it != sealed_links.end()) {
+				adjacent_indices[j] = it->second;
+				sealed_links.erase(it);
+			}
+		}
+		else if(adj_tri != NULL)
+			adjacent_indices[j] = adj_tri->GetTriangleIndex();
+	}
+
+	GlobalMeshData::WriteXMLTriangle(&writer, tri, adjacent_indices);
+	triangle_count++;
+
+	return writer.IsGood();
+}
+
+//Point an adjacency at the sealed triangle, remembering the index of the freed triangle for the file
+int MeshStreamWriter::SealLink(Triangle* tri, int opposing_vertex, unsigned int released_tindex) {
+	if(opposing_vertex < 0 || opposing_vertex > 2)
+		return false;
+
+	tri->SetAdjacentTriangle(opposing_vertex, GetSealedTriangle());
+	sealed_links[link_key(tri, opposing_vertex)] = released_tindex;
+
+	return true;
+}
+
+//The stand-in neighbour for freed triangles
+Triangle* MeshStreamWriter::GetSealedTriangle() {
+	return &sealed_triangle;
+}
+
+//The number of triangles written so far
+unsigned int MeshStreamWriter::GetTriangleCount() {
+	return triangle_count;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+uint64_t MeshStreamWriter::link_key(Triangle* tri, int opposing_vertex) {
+	return 3*uint64_t(tri->GetTriangleIndex()) + uint64_t(opposing_vertex);
+}
@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include <map>
+using namespace std;
+
+//Triangulation algorithm related code
+#include "triangle.h"
+
+//Mesh data code
+#include "global_mesh_data.h"
+
+//Streaming output code
+#include "buffered_writer.h"
+
+#ifndef MESH_STREAM_WRITER
+#define MESH_STREAM_WRITER
+
+//Writes an xml mesh file while the mesh is still being built
+// + the vertex list is written when the file is opened, the triangles are written as they become final
+// + triangles keep their global index in the file, so adjacencies stay valid after the triangles are freed
+// + a triangle that stays in memory next to a freed one points to the sealed triangle instead, which
+//   looks like a neighbour to the mesher and never fails a Delaunay test
+// + none of the functions are thread safe, the caller has to serialize them
+class MeshStreamWriter {
+public:
+	MeshStreamWriter();
+	~MeshStreamWriter();
+
+	//////////////
+	// File i/o //
+	//////////////
+
+	//Open the file and write the vertices
+	int Open(const char* filename, GlobalMeshData* global_mesh_data);
+
+	//Write every triangle still in the global mesh and finish the file
+	// + the sealed links of the remaining triangles are cleared
+	int Close();
+
+	int IsOpen();
+
+	///////////////
+	// Streaming //
+	///////////////
+
+	//Write one final triangle
+	int WriteTriangle(Triangle* tri);
+
+	//Point an adjacency at the sealed triangle, remembering the index of the freed triangle for the file
+	int SealLink(Triangle* tri, int opposing_vertex, unsigned int released_tindex);
+
+	//The stand-in neighbour for freed triangles
+	static Triangle* GetSealedTriangle();
+
+	//The number of triangles written so far
+	unsigned int GetTriangleCount();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	static uint64_t link_key(Triangle* tri, int opposing_vertex);
+
+	//The output file
+	BufferedWriter writer;
+	int is_open;
+
+	GlobalMeshData* global_mesh_data;
+	unsigned int triangle_count;
+
+	//Sealed adjacency -> index of the freed triangle
+	map<uint64_t, unsigned int> sealed_links;
+};
+
+#endif
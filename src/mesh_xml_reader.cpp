@@ -0,0 +1,442 @@
+#include "mesh_xml_reader.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//Powers of ten that are exact in a double
+static const double exact_powers_of_ten[23] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//Rough sizes of one record in bytes, used to guess how much to preallocate
+#define VERTEX_RECORD_SIZE		40
+#define TRIANGLE_RECORD_SIZE	80
+
+static inline int is_space(char c) {
+	return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+static inline int is_digit(char c) {
+	return (c >= '0' && c <= '9');
+}
+
+//Compare the token [p, p+length) against a null terminated name
+static inline int token_equals(const char* p, size_t length, const char* name) {
+	return (strlen(name) == length && memcmp(p, name, length) == 0);
+}
+
+MeshXMLReader::MeshXMLReader() {
+	file_descriptor = -1;
+	data = NULL;
+	data_size = 0;
+
+	position = NULL;
+	end = NULL;
+
+	in_vertexlist = false;
+	in_trianglelist = false;
+}
+
+MeshXMLReader::~MeshXMLReader() {
+	Close();
+}
+
+//////////////
+// File i/o //
+//////////////
+
+int MeshXMLReader::Open(const char* filename) {
+	Close();
+
+	file_descriptor = open(filename, O_RDONLY);
+	if(file_descriptor < 0) {
+		printf("Error opening the mesh file %s\n", filename);
+		return false;
+	}
+
+	struct stat file_stat;
+	if(fstat(file_descriptor, &file_stat) != 0) {
+		printf("Error reading the mesh file %s\n", filename);
+
+		Close();
+		return false;
+	}
+
+	//An empty file simply has no records
+	data_size = (size_t) file_stat.st_size;
+	if(data_size > 0) {
+		void* mapped_data = mmap(NULL, data_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+		if(mapped_data == MAP_FAILED) {
+			printf("Error mapping the mesh file %s\n", filename);
+
+			data_size = 0;
+			Close();
+			return false;
+		}
+
+		//The file is scanned once, front to back
+		madvise(mapped_data, data_size, MADV_SEQUENTIAL);
+
+		data = (const char*) mapped_data;
+	}
+
+	position = data;
+	end = data + data_size;
+
+	return true;
+}
+
+int MeshXMLReader::Close() {
+	if(data != NULL)
+		munmap((void*) data, data_size);
+
+	if(file_descriptor >= 0)
+		close(file_descriptor);
+
+	file_descriptor = -1;
+	data = NULL;
+	data_size = 0;
+
+	position = NULL;
+	end = NULL;
+
+	in_vertexlist = false;
+	in_trianglelist = false;
+
+	return true;
+}
+
+/////////////
+// Parsing //
+/////////////
+
+//Read up to the next vertex/triangle tag and fill in the record
+int MeshXMLReader::NextRecord(MeshXMLRecord& record) {
+	while(position < end) {
+		//Find the start of the next tag
+		const char* tag_start = (const char*) memchr(position, '<', end - position);
+		if(tag_start == NULL) {
+			position = end;
+			break;
+		}
+
+		position = tag_start + 1;
+		if(position >= end)
+			break;
+
+		//Comments
+		if(end - position >= 3 && memcmp(position, "!--", 3) == 0) {
+			const char* p = position + 3;
+			while(p + 2 < end && !(p[0] == '-' && p[1] == '-' && p[2] == '>'))
+				p++;
+
+			if(p + 2 >= end) {
+				printf("Error: unterminated comment in the mesh file\n");
+				return MeshXMLReader::PARSE_ERROR;
+			}
+
+			position = p + 3;
+			continue;
+		}
+
+		//Declarations and processing instructions
+		if(*position == '?' || *position == '!') {
+			if(skip_tag() == false)
+				return MeshXMLReader::PARSE_ERROR;
+
+			continue;
+		}
+
+		//Closing tags
+		int closing = false;
+		if(*position == '/') {
+			closing = true;
+			position++;
+		}
+
+		//Read the tag name
+		const char* name = position;
+		while(position < end && !is_space(*position) && *position != '/' && *position != '>')
+			position++;
+
+		size_t name_length = position - name;
+
+		if(closing == true) {
+			if(token_equals(name, name_length, "vertexlist"))
+				in_vertexlist = false;
+
+			else if(token_equals(name, name_length, "trianglelist"))
+				in_trianglelist = false;
+
+			if(skip_tag() == false)
+				return MeshXMLReader::PARSE_ERROR;
+
+			continue;
+		}
+
+		if(in_vertexlist == true && token_equals(name, name_length, "vertex"))
+			return parse_attributes(MeshXMLReader::VERTEX_RECORD, record);
+
+		if(in_trianglelist == true && token_equals(name, name_length, "triangle"))
+			return parse_attributes(MeshXMLReader::TRIANGLE_RECORD, record);
+
+		int is_vertexlist = token_equals(name, name_length, "vertexlist");
+		int is_trianglelist = token_equals(name, name_length, "trianglelist");
+
+		if(skip_tag() == false)
+			return MeshXMLReader::PARSE_ERROR;
+
+		//A self closing list tag is an empty list
+		if(position[-2] == '/')
+			continue;
+
+		if(is_vertexlist)
+			in_vertexlist = true;
+
+		if(is_trianglelist)
+			in_trianglelist = true;
+	}
+
+	return MeshXMLReader::END_OF_FILE;
+}
+
+//Guess how many more records of the current list are left, used to preallocate
+unsigned int MeshXMLReader::EstimateRemainingRecords(int record_type) {
+	size_t remaining = end - position;
+
+	if(record_type == MeshXMLReader::VERTEX_RECORD)
+		return (unsigned int) (remaining / VERTEX_RECORD_SIZE);
+
+	return (unsigned int) (remaining / TRIANGLE_RECORD_SIZE);
+}
+
+//Fast number parsing, exposed for other text readers
+// + these return a pointer past the number, or NULL if there was no number
+const char* MeshXMLReader::ParseUnsigned(const char* p, const char* end, unsigned int& value) {
+	while(p < end && is_space(*p))
+		p++;
+
+	if(p >= end || !is_digit(*p))
+		return NULL;
+
+	uint64_t result = 0;
+	while(p < end && is_digit(*p)) {
+		result = result*10 + (*p - '0');
+		if(result > 0xffffffffULL)
+			return NULL;
+
+		p++;
+	}
+
+	value = (unsigned int) result;
+	return p;
+}
+
+const char* MeshXMLReader::ParseDouble(const char* p, const char* end, double& value) {
+	while(p < end && is_space(*p))
+		p++;
+
+	const char* start = p;
+
+	int negative = false;
+	if(p < end && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		p++;
+	}
+
+	//Collect up to 19 significant digits into an integer mantissa
+	uint64_t mantissa = 0;
+	int digit_count = 0;
+	int significant_digits = 0;
+	int exponent = 0;
+
+	while(p < end && is_digit(*p)) {
+		if(significant_digits < 19) {
+			mantissa = mantissa*10 + (*p - '0');
+			if(mantissa != 0)
+				significant_digits++;
+		}
+		else
+			exponent++;
+
+		digit_count++;
+		p++;
+	}
+
+	if(p < end && *p == '.') {
+		p++;
+
+		while(p < end && is_digit(*p)) {
+			if(significant_digits < 19) {
+				mantissa = mantissa*10 + (*p - '0');
+				if(mantissa != 0)
+					significant_digits++;
+
+				exponent--;
+			}
+
+			digit_count++;
+			p++;
+		}
+	}
+
+	int fast_path = (digit_count > 0 && significant_digits < 19);
+
+	if(digit_count > 0 && p < end && (*p == 'e' || *p == 'E')) {
+		const char* q = p + 1;
+
+		int exponent_negative = false;
+		if(q < end && (*q == '-' || *q == '+')) {
+			exponent_negative = (*q == '-');
+			q++;
+		}
+
+		if(q < end && is_digit(*q)) {
+			int explicit_exponent = 0;
+			while(q < end && is_digit(*q)) {
+				if(explicit_exponent < 10000)
+					explicit_exponent = explicit_exponent*10 + (*q - '0');
+				q++;
+			}
+
+			exponent += (exponent_negative ? -explicit_exponent : explicit_exponent);
+			p = q;
+		}
+	}
+
+	//The mantissa and the power of ten are both exact, so one multiply or divide rounds correctly
+	if(fast_path && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+		double result = double(mantissa);
+
+		if(exponent < 0)
+			result /= exact_powers_of_ten[-exponent];
+		else
+			result *= exact_powers_of_ten[exponent];
+
+		value = (negative ? -result : result);
+		return p;
+	}
+
+	//Everything else goes through strtod on a null terminated copy
+	char buffer[64];
+	size_t length = end - start;
+	if(length > sizeof(buffer)-1)
+		length = sizeof(buffer)-1;
+
+	memcpy(buffer, start, length);
+	buffer[length] = '\0';
+
+	char* parse_end = NULL;
+	double result = strtod(buffer, &parse_end);
+	if(parse_end == buffer)
+		return NULL;
+
+	value = result;
+	return start + (parse_end - buffer);
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//Parse the attributes of a tag, stopping at the closing '>'
+int MeshXMLReader::parse_attributes(int record_type, MeshXMLRecord& record) {
+	memset(&record, 0, sizeof(MeshXMLRecord));
+	record.record_type = record_type;
+
+	while(true) {
+		while(position < end && is_space(*position))
+			position++;
+
+		if(position >= end) {
+			printf("Error: unterminated tag in the mesh file\n");
+			return MeshXMLReader::PARSE_ERROR;
+		}
+
+		if(*position == '/' || *position == '>')
+			break;
+
+		//Attribute name
+		const char* name = position;
+		while(position < end && !is_space(*position) && *position != '=' && *position != '>')
+			position++;
+
+		size_t name_length = position - name;
+
+		while(position < end && is_space(*position))
+			position++;
+
+		if(position >= end || *position != '=') {
+			printf("Error: malformed attribute in the mesh file\n");
+			return MeshXMLReader::PARSE_ERROR;
+		}
+		position++;
+
+		while(position < end && is_space(*position))
+			position++;
+
+		//Quoted attribute value
+		if(position >= end || (*position != '"' && *position != '\'')) {
+			printf("Error: unquoted attribute value in the mesh file\n");
+			return MeshXMLReader::PARSE_ERROR;
+		}
+
+		char quote = *position;
+		const char* value = position + 1;
+		const char* value_end = (const char*) memchr(value, quote, end - value);
+		if(value_end == NULL) {
+			printf("Error: unterminated attribute value in the mesh file\n");
+			return MeshXMLReader::PARSE_ERROR;
+		}
+
+		position = value_end + 1;
+
+		//Pick out the attributes of our schema
+		const char* parsed = value;
+
+		if(token_equals(name, name_length, "index"))
+			parsed = ParseUnsigned(value, value_end, record.index);
+
+		else if(record_type == MeshXMLReader::VERTEX_RECORD) {
+			if(token_equals(name, name_length, "x")) {
+				parsed = ParseDouble(value, value_end, record.x);
+				record.has_x = (parsed != NULL);
+			}
+			else if(token_equals(name, name_length, "y")) {
+				parsed = ParseDouble(value, value_end, record.y);
+				record.has_y = (parsed != NULL);
+			}
+		}
+		else if(name_length == 2 && (name[0] == 'n' || name[0] == 'a') && name[1] >= '0' && name[1] <= '2') {
+			unsigned int* target = (name[0] == 'n' ? record.n : record.a);
+			parsed = ParseUnsigned(value, value_end, target[name[1] - '0']);
+		}
+
+		if(parsed == NULL) {
+			printf("Error: bad number in the mesh file attribute %.*s\n", int(name_length), name);
+			return MeshXMLReader::PARSE_ERROR;
+		}
+	}
+
+	if(skip_tag() == false)
+		return MeshXMLReader::PARSE_ERROR;
+
+	return record_type;
+}
+
+//Skip past the end of the current tag
+int MeshXMLReader::skip_tag() {
+	const char* tag_end = (const char*) memchr(position, '>', end - position);
+	if(tag_end == NULL) {
+		printf("Error: unterminated tag in the mesh file\n");
+
+		position = end;
+		return false;
+	}
+
+	position = tag_end + 1;
+	return true;
+}
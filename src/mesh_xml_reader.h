@@ -0,0 +1,87 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef MESH_XML_READER
+#define MESH_XML_READER
+
+//One vertex or triangle tag from a mesh file
+struct MeshXMLRecord {
+	int record_type;
+
+	unsigned int index;
+
+	//Vertex records
+	double x, y;
+	int has_x, has_y;
+
+	//Triangle records
+	unsigned int n[3];
+	unsigned int a[3];
+};
+
+//A pull parser for the mesh xml schema
+// + the file is mapped into memory and scanned once, front to back
+// + only vertex tags inside a vertexlist and triangle tags inside a trianglelist are reported
+class MeshXMLReader {
+public:
+	MeshXMLReader();
+	~MeshXMLReader();
+
+	//////////////
+	// File i/o //
+	//////////////
+
+	int Open(const char* filename);
+	int Close();
+
+	/////////////
+	// Parsing //
+	/////////////
+
+	//The record types returned by NextRecord
+	enum {
+		END_OF_FILE=0,
+		VERTEX_RECORD,
+		TRIANGLE_RECORD,
+		PARSE_ERROR
+	};
+
+	//Read up to the next vertex/triangle tag and fill in the record
+	int NextRecord(MeshXMLRecord& record);
+
+	//Guess how many more records of the current list are left, used to preallocate
+	unsigned int EstimateRemainingRecords(int record_type);
+
+	//Fast number parsing, exposed for other text readers
+	// + these return a pointer past the number, or NULL if there was no number
+	static const char* ParseUnsigned(const char* p, const char* end, unsigned int& value);
+	static const char* ParseDouble(const char* p, const char* end, double& value);
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//Parse the attributes of a tag, stopping at the closing '>'
+	int parse_attributes(int record_type, MeshXMLRecord& record);
+
+	//Skip past the end of the current tag
+	int skip_tag();
+
+	//The mapped file
+	int file_descriptor;
+	const char* data;
+	size_t data_size;
+
+	//The current read position
+	const char* position;
+	const char* end;
+
+	//Which list we are inside of
+	int in_vertexlist;
+	int in_trianglelist;
+};
+
+#endif
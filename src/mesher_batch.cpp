@@ -0,0 +1,141 @@
+#include "mesher_batch.h"
+
+MesherBatch::MesherBatch() {
+	ClearJobs();
+}
+
+MesherBatch::~MesherBatch() {
+}
+
+////////////////////
+// Job management //
+////////////////////
+
+//Read a manifest: one command file per line, blank lines and lines starting with # are skipped
+int MesherBatch::LoadManifest(const char* filename) {
+	FILE* handle = fopen(filename, "r");
+	if(handle == NULL) {
+		printf("Error opening the manifest %s\n", filename);
+		return false;
+	}
+
+	char line[1000];
+	while(fgets(line, sizeof(line), handle) != NULL) {
+		//Trim the line
+		char* start = line;
+		while(*start == ' ' || *start == '\t')
+			start++;
+
+		char* end = start + strlen(start);
+		while(end > start && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+			end--;
+		*end = '\0';
+
+		if(*start == '\0' || *start == '#')
+			continue;
+
+		AppendJob(start);
+	}
+
+	fclose(handle);
+	return true;
+}
+
+unsigned int MesherBatch::GetJobCount() {
+	return job_filenames.size();
+}
+
+const char* MesherBatch::GetJobFilename(unsigned int index) {
+	if(index >= GetJobCount())
+		return NULL;
+
+	return job_filenames[index].c_str();
+}
+
+int MesherBatch::AppendJob(const char* command_filename) {
+	job_filenames.push_back(command_filename);
+	job_results.push_back(MesherBatch::NOT_YET_RUN_RESULT);
+	job_wall_times.push_back(0);
+
+	return true;
+}
+
+int MesherBatch::ClearJobs() {
+	job_filenames.clear();
+	job_results.clear();
+	job_wall_times.clear();
+
+	return true;
+}
+
+//Once the jobs have been run, their results and wall times are populated
+int MesherBatch::GetJobResult(unsigned int index) {
+	if(index >= GetJobCount())
+		return -1;
+
+	return job_results[index];
+}
+
+double MesherBatch::GetJobWallTime(unsigned int index) {
+	if(index >= GetJobCount())
+		return 0;
+
+	return job_wall_times[index];
+}
+
+//Run every job
+int MesherBatch::RunJobs() {
+	int job_count = GetJobCount();
+	int failed_count = 0;
+
+	//The jobs are the parallelism, the loops inside each job run on its own thread
+	int max_active_levels = omp_get_max_active_levels();
+	omp_set_max_active_levels(1);
+
+	#pragma omp parallel
+	{
+		TriangleMesher* triangle_mesher = new TriangleMesher;
+
+		#pragma omp for schedule(dynamic, 1)
+		for(int i=0; i<job_count; i++) {
+			double start_time = omp_get_wtime();
+
+			triangle_mesher->Reset();
+
+			//The xml parser isn't known to be reentrant, parsing is cheap next to meshing anyway
+			int ret = false;
+
+			#pragma omp critical(mesher_batch_command_files)
+			ret = triangle_mesher->LoadCommandsFromFile(job_filenames[i].c_str());
+
+			if(ret == false)
+				printf("Error loading file %s\n", job_filenames[i].c_str());
+
+			else {
+				triangle_mesher->SetFailBehaviour(TriangleMesher::QUIT_ON_FAILURE);
+				ret = triangle_mesher->RunMesherCommands();
+			}
+
+			job_results[i] = (ret == true ? MesherBatch::SUCCESS_RESULT : MesherBatch::FAILURE_RESULT);
+			job_wall_times[i] = omp_get_wtime() - start_time;
+
+			if(ret == false) {
+				#pragma omp atomic
+				failed_count++;
+			}
+		}
+
+		delete triangle_mesher;
+	}
+
+	omp_set_max_active_levels(max_active_levels);
+
+	//Summarize the jobs once their output is done
+	printf("\nBatch results:\n");
+	for(unsigned int i=0; i<GetJobCount(); i++)
+		printf("%s: %s (%fs)\n", GetJobFilename(i), (GetJobResult(i) == MesherBatch::SUCCESS_RESULT ? "success" : "failure"), GetJobWallTime(i));
+
+	printf("%d of %d jobs failed\n", failed_count, job_count);
+
+	return (failed_count == 0);
+}
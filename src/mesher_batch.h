@@ -0,0 +1,62 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <omp.h>
+
+//Triangulation algorithm related code
+#include "triangle_mesher.h"
+
+#ifndef MESHER_BATCH
+#define MESHER_BATCH
+
+//Runs many command files in one process
+// + each job is an ordinary command file, writing its own output files and profile report
+// + the jobs are spread over the OpenMP threads, one job per thread at a time, so small jobs fill idle cores
+// + each thread keeps one TriangleMesher for all of its jobs and resets it between them
+// + nested parallelism is off while the jobs run, so the cpu times in the profile of a job are those of its own
+//   thread, the peak memory in it is still that of the whole process
+class MesherBatch {
+public:
+	MesherBatch();
+	~MesherBatch();
+
+	////////////////////
+	// Job management //
+	////////////////////
+
+	//Read a manifest: one command file per line, blank lines and lines starting with # are skipped
+	int LoadManifest(const char* filename);
+
+	unsigned int GetJobCount();
+	const char* GetJobFilename(unsigned int index);
+
+	int AppendJob(const char* command_filename);
+	int ClearJobs();
+
+	//Once the jobs have been run, their results and wall times are populated
+	int GetJobResult(unsigned int index);
+	double GetJobWallTime(unsigned int index);
+
+	enum {
+		NOT_YET_RUN_RESULT=0,
+		FAILURE_RESULT,
+		SUCCESS_RESULT
+	};
+
+	//Run every job
+	// + returns false if any job failed
+	int RunJobs();
+
+private:
+	//The jobs, their results and how long each took
+	vector<string> job_filenames;
+	vector<int> job_results;
+	vector<double> job_wall_times;
+};
+
+#endif
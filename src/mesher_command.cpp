@@ -21,18 +21,37 @@ MesherCommand::MesherCommand() {
 	xcount = 0;
 	ycount = 0;
 
-	//Run Triangle Mesher options
+	//Load Points From File options
+	point_format = PointCloudFile::UNKNOWN_POINT_FORMAT;
+
+	//Run/Resume Triangle Mesher options
 	use_kd_tree = true;
 
+	strcpy(checkpoint_filename, "");
+	checkpoint_interval = 1;
+
+	strcpy(stream_filename, "");
+
 	//Load/Save Mesh From/To File options
 	strcpy(filename, "");
 	load_save_triangles = true;
+	file_format = GlobalMeshData::UNKNOWN_FILE_FORMAT;
+	quantization_bits = 0;
 
 	//Write SVG options
 	strcpy(svg_filename, "");
 	svg_width = 0.0;
 	svg_height = 0.0;
 
+	svg_use_viewport = false;
+
+	svg_merge_subpixel = false;
+	svg_draw_vertices = true;
+	svg_max_elements = 0;
+
+	//Save Mesh To File/Write SVG options
+	async_export = false;
+
 	//Append Vertex options
 	vertex = Vector2d(0, 0);
 
@@ -48,9 +67,24 @@ MesherCommand::MesherCommand() {
 	//Stretched Grid options
 	stretched_grid_iterations = 1;
 	stretched_grid_alpha = 0.01;
+	stretched_grid_method = MesherCommand::FORCE_STRETCHED_GRID_METHOD;
+	stretched_grid_damping = 0.0;
+	stretched_grid_tolerance = 0.0;
 
 	//Refine mesh options
 	desired_edge_length = 0.0;
+	refine_method = MesherCommand::QUALITY_REFINE_METHOD;
+	refine_minimum_angle = 20.0;
+
+	strcpy(sizing_grid_filename, "");
+	strcpy(sizing_sources_filename, "");
+	strcpy(sizing_mesh_filename, "");
+
+	//Uniform refine options
+	uniform_refine_levels = 1;
+	uniform_refine_use_prism = false;
+
+	coarsen_triangle_count = 0;
 
 	/////////////////////////////////
 	// Mesher Command Results data //
@@ -131,6 +165,24 @@ int MesherCommand::LoadFromTagData(XML_Tag* mesh_command_tag) {
 		if(ycount_str != "") ycount = (unsigned int) atoi(ycount_str.c_str());
 	}
 
+	else if(strcmp(command_type_str.c_str(), "LoadPointsFromFile") == 0) {
+		command_type = MesherCommand::LOAD_POINTS_FROM_FILE;
+
+		string filename_str = mesh_command_tag->GetAttributeValue("filename");
+		if(filename_str != "")
+			strncpy(filename, filename_str.c_str(), 1000);
+
+		string point_format_str = mesh_command_tag->GetAttributeValue("format");
+		if(strcmp(point_format_str.c_str(), "text") == 0)
+			point_format = PointCloudFile::TEXT_POINT_FORMAT;
+
+		else if(strcmp(point_format_str.c_str(), "float64") == 0)
+			point_format = PointCloudFile::FLOAT64_POINT_FORMAT;
+
+		else if(strcmp(point_format_str.c_str(), "float32") == 0)
+			point_format = PointCloudFile::FLOAT32_POINT_FORMAT;
+	}
+
 	else if(strcmp(command_type_str.c_str(), "TriangleMesher") == 0) {
 		command_type = MesherCommand::RUN_TRIANGLE_MESHER;
 
@@ -140,6 +192,30 @@ int MesherCommand::LoadFromTagData(XML_Tag* mesh_command_tag) {
 
 		else if(strcmp(use_kd_tree_str.c_str(), "no") == 0)
 			use_kd_tree = false;
+
+		string checkpoint_str = mesh_command_tag->GetAttributeValue("checkpoint");
+		if(checkpoint_str != "")
+			strncpy(checkpoint_filename, checkpoint_str.c_str(), 1000);
+
+		string checkpoint_interval_str = mesh_command_tag->GetAttributeValue("checkpoint_interval");
+		if(checkpoint_interval_str != "")
+			checkpoint_interval = (unsigned int) atoi(checkpoint_interval_str.c_str());
+
+		string stream_str = mesh_command_tag->GetAttributeValue("stream");
+		if(stream_str != "")
+			strncpy(stream_filename, stream_str.c_str(), 1000);
+	}
+
+	else if(strcmp(command_type_str.c_str(), "ResumeTriangleMesher") == 0) {
+		command_type = MesherCommand::RESUME_TRIANGLE_MESHER;
+
+		string checkpoint_str = mesh_command_tag->GetAttributeValue("checkpoint");
+		if(checkpoint_str != "")
+			strncpy(checkpoint_filename, checkpoint_str.c_str(), 1000);
+
+		string checkpoint_interval_str = mesh_command_tag->GetAttributeValue("checkpoint_interval");
+		if(checkpoint_interval_str != "")
+			checkpoint_interval = (unsigned int) atoi(checkpoint_interval_str.c_str());
 	}
 
 	else if(strcmp(command_type_str.c_str(), "LoadMeshFromFile") == 0) {
@@ -152,6 +228,16 @@ int MesherCommand::LoadFromTagData(XML_Tag* mesh_command_tag) {
 		string load_save_triangles_str = mesh_command_tag->GetAttributeValue("load_triangles");
 		if(strcmp(load_save_triangles_str.c_str(), "false") == 0)
 			load_save_triangles = false;
+
+		string file_format_str = mesh_command_tag->GetAttributeValue("format");
+		if(strcmp(file_format_str.c_str(), "xml") == 0)
+			file_format = GlobalMeshData::XML_FILE_FORMAT;
+
+		else if(strcmp(file_format_str.c_str(), "binary") == 0)
+			file_format = GlobalMeshData::BINARY_FILE_FORMAT;
+
+		else if(strcmp(file_format_str.c_str(), "compressed") == 0)
+			file_format = GlobalMeshData::COMPRESSED_FILE_FORMAT;
 	}
 
 	else if(strcmp(command_type_str.c_str(), "SaveMeshToFile") == 0) {
@@ -164,6 +250,28 @@ int MesherCommand::LoadFromTagData(XML_Tag* mesh_command_tag) {
 		string load_save_triangles_str = mesh_command_tag->GetAttributeValue("save_triangles");
 		if(strcmp(load_save_triangles_str.c_str(), "false") == 0)
 			load_save_triangles = false;
+
+		string file_format_str = mesh_command_tag->GetAttributeValue("format");
+		if(strcmp(file_format_str.c_str(), "xml") == 0)
+			file_format = GlobalMeshData::XML_FILE_FORMAT;
+
+		else if(strcmp(file_format_str.c_str(), "binary") == 0)
+			file_format = GlobalMeshData::BINARY_FILE_FORMAT;
+
+		else if(strcmp(file_format_str.c_str(), "compressed") == 0)
+			file_format = GlobalMeshData::COMPRESSED_FILE_FORMAT;
+
+		//Only used by compressed files, 0 keeps the coordinates exactly
+		string quantization_bits_str = mesh_command_tag->GetAttributeValue("quantization_bits");
+		if(quantization_bits_str != "")
+			quantization_bits = (unsigned int) atoi(quantization_bits_str.c_str());
+
+		string async_str = mesh_command_tag->GetAttributeValue("async");
+		if(strcmp(async_str.c_str(), "yes") == 0)
+			async_export = true;
+
+		else if(strcmp(async_str.c_str(), "no") == 0)
+			async_export = false;
 	}
 
 	else if(strcmp(command_type_str.c_str(), "WriteSVG") == 0) {
@@ -178,6 +286,46 @@ int MesherCommand::LoadFromTagData(XML_Tag* mesh_command_tag) {
 
 		if(width_str != "") svg_width = atof(width_str.c_str());
 		if(height_str != "") svg_height = atof(height_str.c_str());
+
+		//The viewport is only used if all four sides are given
+		string xmin_str, xmax_str;
+		string ymin_str, ymax_str;
+
+		xmin_str = mesh_command_tag->GetAttributeValue("xmin");
+		xmax_str = mesh_command_tag->GetAttributeValue("xmax");
+		ymin_str = mesh_command_tag->GetAttributeValue("ymin");
+		ymax_str = mesh_command_tag->GetAttributeValue("ymax");
+
+		if(xmin_str != "" && xmax_str != "" && ymin_str != "" && ymax_str != "") {
+			svg_use_viewport = true;
+			svg_viewport.SetMin(atof(xmin_str.c_str()), atof(ymin_str.c_str()));
+			svg_viewport.SetMax(atof(xmax_str.c_str()), atof(ymax_str.c_str()));
+		}
+
+		string merge_subpixel_str = mesh_command_tag->GetAttributeValue("merge_subpixel");
+		if(strcmp(merge_subpixel_str.c_str(), "yes") == 0)
+			svg_merge_subpixel = true;
+
+		else if(strcmp(merge_subpixel_str.c_str(), "no") == 0)
+			svg_merge_subpixel = false;
+
+		string draw_vertices_str = mesh_command_tag->GetAttributeValue("draw_vertices");
+		if(strcmp(draw_vertices_str.c_str(), "yes") == 0)
+			svg_draw_vertices = true;
+
+		else if(strcmp(draw_vertices_str.c_str(), "no") == 0)
+			svg_draw_vertices = false;
+
+		string max_elements_str = mesh_command_tag->GetAttributeValue("max_elements");
+		if(max_elements_str != "")
+			svg_max_elements = (unsigned int) atoi(max_elements_str.c_str());
+
+		string async_str = mesh_command_tag->GetAttributeValue("async");
+		if(strcmp(async_str.c_str(), "yes") == 0)
+			async_export = true;
+
+		else if(strcmp(async_str.c_str(), "no") == 0)
+			async_export = false;
 	}
 
 	else if(strcmp(command_type_str.c_str(), "SubdivideTriangle") == 0) {
@@ -203,6 +351,14 @@ int MesherCommand::LoadFromTagData(XML_Tag* mesh_command_tag) {
 	else if(strcmp(command_type_str.c_str(), "BasicTriangleMesher") == 0)
 		command_type = MesherCommand::BASIC_TRIANGLE_MESHER;
 
+	else if(strcmp(command_type_str.c_str(), "BasicDelaunayFlipper") == 0) {
+		command_type = MesherCommand::BASIC_DELAUNAY_FLIPPER;
+
+		string max_iterations_str = mesh_command_tag->GetAttributeValue("max_iterations");
+		if(max_iterations_str != "")
+			delaunay_max_iterations = (unsigned int) atoi(max_iterations_str.c_str());
+	}
+
 	else if(strcmp(command_type_str.c_str(), "StretchedGrid") == 0) {
 		command_type = MesherCommand::STRETCHED_GRID;
 
@@ -214,6 +370,21 @@ int MesherCommand::LoadFromTagData(XML_Tag* mesh_command_tag) {
 
 		if(sg_alpha_str != "")
 			stretched_grid_alpha = atof(sg_alpha_str.c_str());
+
+		string sg_method_str = mesh_command_tag->GetAttributeValue("method");
+		if(strcmp(sg_method_str.c_str(), "force") == 0)
+			stretched_grid_method = MesherCommand::FORCE_STRETCHED_GRID_METHOD;
+
+		else if(strcmp(sg_method_str.c_str(), "laplacian") == 0)
+			stretched_grid_method = MesherCommand::LAPLACIAN_STRETCHED_GRID_METHOD;
+
+		string sg_damping_str = mesh_command_tag->GetAttributeValue("damping");
+		if(sg_damping_str != "")
+			stretched_grid_damping = atof(sg_damping_str.c_str());
+
+		string sg_tolerance_str = mesh_command_tag->GetAttributeValue("tolerance");
+		if(sg_tolerance_str != "")
+			stretched_grid_tolerance = atof(sg_tolerance_str.c_str());
 	}
 
 	else if(strcmp(command_type_str.c_str(), "RefineMesh") == 0) {
@@ -222,6 +393,68 @@ int MesherCommand::LoadFromTagData(XML_Tag* mesh_command_tag) {
 		string desired_edge_length_str = mesh_command_tag->GetAttributeValue("desired_edge_length");
 		if(desired_edge_length_str != "")
 			desired_edge_length = atof(desired_edge_length_str.c_str());
+
+		string method_str = mesh_command_tag->GetAttributeValue("method");
+		if(strcmp(method_str.c_str(), "quality") == 0)
+			refine_method = MesherCommand::QUALITY_REFINE_METHOD;
+
+		else if(strcmp(method_str.c_str(), "obtuse") == 0)
+			refine_method = MesherCommand::OBTUSE_REFINE_METHOD;
+
+		string min_angle_str = mesh_command_tag->GetAttributeValue("min_angle");
+		if(min_angle_str != "")
+			refine_minimum_angle = atof(min_angle_str.c_str());
+
+		string sizing_grid_str = mesh_command_tag->GetAttributeValue("sizing_grid");
+		if(sizing_grid_str != "")
+			strncpy(sizing_grid_filename, sizing_grid_str.c_str(), 1000);
+
+		string sizing_sources_str = mesh_command_tag->GetAttributeValue("sizing_sources");
+		if(sizing_sources_str != "")
+			strncpy(sizing_sources_filename, sizing_sources_str.c_str(), 1000);
+
+		string sizing_mesh_str = mesh_command_tag->GetAttributeValue("sizing_mesh");
+		if(sizing_mesh_str != "")
+			strncpy(sizing_mesh_filename, sizing_mesh_str.c_str(), 1000);
+	}
+
+	else if(strcmp(command_type_str.c_str(), "UniformRefine") == 0) {
+		command_type = MesherCommand::UNIFORM_REFINE;
+
+		string levels_str = mesh_command_tag->GetAttributeValue("levels");
+		if(levels_str != "")
+			uniform_refine_levels = (unsigned int) atoi(levels_str.c_str());
+
+		string desired_edge_length_str = mesh_command_tag->GetAttributeValue("desired_edge_length");
+		if(desired_edge_length_str != "")
+			desired_edge_length = atof(desired_edge_length_str.c_str());
+
+		//The prism is only used if all four sides are given
+		string xmin_str, xmax_str;
+		string ymin_str, ymax_str;
+
+		xmin_str = mesh_command_tag->GetAttributeValue("xmin");
+		xmax_str = mesh_command_tag->GetAttributeValue("xmax");
+		ymin_str = mesh_command_tag->GetAttributeValue("ymin");
+		ymax_str = mesh_command_tag->GetAttributeValue("ymax");
+
+		if(xmin_str != "" && xmax_str != "" && ymin_str != "" && ymax_str != "") {
+			uniform_refine_use_prism = true;
+			uniform_refine_prism.SetMin(atof(xmin_str.c_str()), atof(ymin_str.c_str()));
+			uniform_refine_prism.SetMax(atof(xmax_str.c_str()), atof(ymax_str.c_str()));
+		}
+	}
+
+	else if(strcmp(command_type_str.c_str(), "CoarsenMesh") == 0) {
+		command_type = MesherCommand::COARSEN_MESH;
+
+		string desired_edge_length_str = mesh_command_tag->GetAttributeValue("desired_edge_length");
+		if(desired_edge_length_str != "")
+			desired_edge_length = atof(desired_edge_length_str.c_str());
+
+		string triangle_count_str = mesh_command_tag->GetAttributeValue("triangle_count");
+		if(triangle_count_str != "")
+			coarsen_triangle_count = (unsigned int) atoi(triangle_count_str.c_str());
 	}
 
 	else
@@ -230,6 +463,122 @@ int MesherCommand::LoadFromTagData(XML_Tag* mesh_command_tag) {
 	return true;
 }
 
+//The tag name of the command
+const char* MesherCommand::GetCommandName() {
+	return GetCommandTypeName(command_type);
+}
+
+const char* MesherCommand::GetCommandTypeName(int command_type) {
+	switch(command_type) {
+		case MesherCommand::GENERATE_RANDOM_GRID:		return "GenerateRandomGrid";
+		case MesherCommand::GENERATE_UNIFORM_GRID:		return "GenerateUniformGrid";
+		case MesherCommand::GENERATE_HEX_GRID:			return "GenerateHexGrid";
+		case MesherCommand::LOAD_POINTS_FROM_FILE:		return "LoadPointsFromFile";
+		case MesherCommand::RUN_TRIANGLE_MESHER:		return "TriangleMesher";
+		case MesherCommand::RESUME_TRIANGLE_MESHER:		return "ResumeTriangleMesher";
+		case MesherCommand::LOAD_MESH_FROM_FILE:		return "LoadMeshFromFile";
+		case MesherCommand::SAVE_MESH_TO_FILE:			return "SaveMeshToFile";
+		case MesherCommand::WRITE_SVG:					return "WriteSVG";
+		case MesherCommand::APPEND_VERTEX:				return "AppendVertex";
+		case MesherCommand::SUBDIVIDE_TRIANGLE:			return "SubdivideTriangle";
+		case MesherCommand::BARYCENTRIC_SUBDIVIDE:		return "BarycentricSubdivide";
+		case MesherCommand::BASIC_TRIANGLE_MESHER:		return "BasicTriangleMesher";
+		case MesherCommand::BASIC_DELAUNAY_FLIPPER:		return "BasicDelaunayFlipper";
+		case MesherCommand::STRETCHED_GRID:				return "StretchedGrid";
+		case MesherCommand::REFINE_MESH:				return "RefineMesh";
+		case MesherCommand::UNIFORM_REFINE:				return "UniformRefine";
+		case MesherCommand::COARSEN_MESH:				return "CoarsenMesh";
+	}
+
+	return "DoNothing";
+}
+
+//Returns true if the two commands touch the same mesh or file and at least one of them writes it,
+//in which case they have to run in their original order
+int MesherCommand::ConflictsWith(MesherCommand* mc) {
+	int mesh_access = GetMeshAccess();
+	int mc_mesh_access = mc->GetMeshAccess();
+
+	if(mesh_access != MesherCommand::NO_MESH_ACCESS && mc_mesh_access != MesherCommand::NO_MESH_ACCESS) {
+		if(mesh_access == MesherCommand::WRITE_MESH_ACCESS || mc_mesh_access == MesherCommand::WRITE_MESH_ACCESS)
+			return true;
+	}
+
+	return FileConflictsWith(mc);
+}
+
+//The same, only looking at the files
+int MesherCommand::FileConflictsWith(MesherCommand* mc) {
+	vector<string> read_files, write_files;
+	vector<string> mc_read_files, mc_write_files;
+
+	GetFileAccess(read_files, write_files);
+	mc->GetFileAccess(mc_read_files, mc_write_files);
+
+	for(unsigned int i=0; i<write_files.size(); i++) {
+		if(find(mc_read_files.begin(), mc_read_files.end(), write_files[i]) != mc_read_files.end())
+			return true;
+
+		if(find(mc_write_files.begin(), mc_write_files.end(), write_files[i]) != mc_write_files.end())
+			return true;
+	}
+
+	for(unsigned int i=0; i<mc_write_files.size(); i++) {
+		if(find(read_files.begin(), read_files.end(), mc_write_files[i]) != read_files.end())
+			return true;
+	}
+
+	return false;
+}
+
+//How a command uses the mesh
+int MesherCommand::GetMeshAccess() {
+	if(command_type == MesherCommand::DO_NOTHING)
+		return MesherCommand::NO_MESH_ACCESS;
+
+	//The exports only look at the mesh
+	if(command_type == MesherCommand::SAVE_MESH_TO_FILE || command_type == MesherCommand::WRITE_SVG)
+		return MesherCommand::READ_MESH_ACCESS;
+
+	return MesherCommand::WRITE_MESH_ACCESS;
+}
+
+//The files a command reads and writes
+int MesherCommand::GetFileAccess(vector<string>& read_files, vector<string>& write_files) {
+	read_files.clear();
+	write_files.clear();
+
+	if(command_type == MesherCommand::LOAD_POINTS_FROM_FILE || command_type == MesherCommand::LOAD_MESH_FROM_FILE)
+		read_files.push_back(filename);
+
+	else if(command_type == MesherCommand::SAVE_MESH_TO_FILE)
+		write_files.push_back(filename);
+
+	else if(command_type == MesherCommand::WRITE_SVG)
+		write_files.push_back(svg_filename);
+
+	else if(command_type == MesherCommand::REFINE_MESH) {
+		if(strcmp(sizing_grid_filename, "") != 0)
+			read_files.push_back(sizing_grid_filename);
+
+		if(strcmp(sizing_sources_filename, "") != 0)
+			read_files.push_back(sizing_sources_filename);
+
+		if(strcmp(sizing_mesh_filename, "") != 0)
+			read_files.push_back(sizing_mesh_filename);
+	}
+
+	else if(command_type == MesherCommand::RUN_TRIANGLE_MESHER || command_type == MesherCommand::RESUME_TRIANGLE_MESHER) {
+		if(strcmp(checkpoint_filename, "") != 0)
+			write_files.push_back(checkpoint_filename);
+
+		if(command_type == MesherCommand::RUN_TRIANGLE_MESHER && strcmp(stream_filename, "") != 0)
+			write_files.push_back(stream_filename);
+	}
+
+	return true;
+}
+
 //Debugging function
 int MesherCommand::print() {
 	if(command_type == MesherCommand::DO_NOTHING)
@@ -258,21 +607,40 @@ int MesherCommand::print() {
 		printf("y vertex count: %u\n", ycount);
 	}
 
+	else if(command_type == MesherCommand::LOAD_POINTS_FROM_FILE) {
+		printf("Mesher command: Load points from file\n");
+		printf("filename: %s\n", filename);
+		printf("point format: %d\n", point_format);
+	}
+
 	else if(command_type == MesherCommand::RUN_TRIANGLE_MESHER) {
 		printf("Mesher command: Run triangle mesher\n");
 		printf("use_kd_tree: %d\n", use_kd_tree);
+		printf("checkpoint: %s\n", checkpoint_filename);
+		printf("checkpoint interval: %u\n", checkpoint_interval);
+		printf("stream: %s\n", stream_filename);
+	}
+
+	else if(command_type == MesherCommand::RESUME_TRIANGLE_MESHER) {
+		printf("Mesher command: Resume triangle mesher\n");
+		printf("checkpoint: %s\n", checkpoint_filename);
+		printf("checkpoint interval: %u\n", checkpoint_interval);
 	}
 
 	else if(command_type == MesherCommand::LOAD_MESH_FROM_FILE) {
 		printf("Mesher command: Load mesh from file\n");
 		printf("filename: %s\n", filename);
 		printf("load triangles: %d\n", load_save_triangles);
+		printf("file format: %d\n", file_format);
 	}
 
 	else if(command_type == MesherCommand::SAVE_MESH_TO_FILE) {
 		printf("Mesher command: Save mesh to file\n");
 		printf("filename: %s\n", filename);
 		printf("save triangles: %d\n", load_save_triangles);
+		printf("file format: %d\n", file_format);
+		printf("quantization bits: %u\n", quantization_bits);
+		printf("async: %d\n", async_export);
 	}
 
 	else if(command_type == MesherCommand::WRITE_SVG) {
@@ -280,6 +648,19 @@ int MesherCommand::print() {
 		printf("filename: %s\n", svg_filename);
 		printf("svg width: %f\n", svg_width);
 		printf("svg height: %f\n", svg_height);
+
+		if(svg_use_viewport == true) {
+			Vector2d viewport_min = svg_viewport.GetMin();
+			Vector2d viewport_max = svg_viewport.GetMax();
+
+			printf("viewport xmin: %f; xmax: %f\n", viewport_min.x, viewport_max.x);
+			printf("viewport ymin: %f; ymax: %f\n", viewport_min.y, viewport_max.y);
+		}
+
+		printf("merge subpixel triangles: %d\n", svg_merge_subpixel);
+		printf("draw vertices: %d\n", svg_draw_vertices);
+		printf("max elements: %u\n", svg_max_elements);
+		printf("async: %d\n", async_export);
 	}
 
 	else if(command_type == MesherCommand::SUBDIVIDE_TRIANGLE) {
@@ -296,15 +677,48 @@ int MesherCommand::print() {
 	else if(command_type == MesherCommand::BASIC_TRIANGLE_MESHER)
 		printf("Mesher command: Basic triangle mesher\n");
 
+	else if(command_type == MesherCommand::BASIC_DELAUNAY_FLIPPER) {
+		printf("Mesher command: Basic Delaunay flipper\n");
+		printf("Maximum iterations: %u\n", delaunay_max_iterations);
+	}
+
 	else if(command_type == MesherCommand::STRETCHED_GRID) {
 		printf("Mesher command: Stretched grid\n");
 		printf("Number of iterations: %u\n", stretched_grid_iterations);
 		printf("Alpha value: %f\n", stretched_grid_alpha);
+		printf("Method: %d\n", stretched_grid_method);
+		printf("Damping: %f\n", stretched_grid_damping);
+		printf("Tolerance: %f\n", stretched_grid_tolerance);
 	}
 
 	else if(command_type == MesherCommand::REFINE_MESH) {
 		printf("Mesher command: Refine mesh\n");
 		printf("Desired edge length: %f\n", desired_edge_length);
+		printf("Refine method: %d\n", refine_method);
+		printf("Minimum angle: %f\n", refine_minimum_angle);
+		printf("Sizing grid: %s\n", sizing_grid_filename);
+		printf("Sizing sources: %s\n", sizing_sources_filename);
+		printf("Sizing mesh: %s\n", sizing_mesh_filename);
+	}
+
+	else if(command_type == MesherCommand::UNIFORM_REFINE) {
+		printf("Mesher command: Uniform refine\n");
+		printf("Levels: %u\n", uniform_refine_levels);
+		printf("Desired edge length: %f\n", desired_edge_length);
+
+		if(uniform_refine_use_prism == true) {
+			Vector2d prism_min = uniform_refine_prism.GetMin();
+			Vector2d prism_max = uniform_refine_prism.GetMax();
+
+			printf("prism xmin: %f; xmax: %f\n", prism_min.x, prism_max.x);
+			printf("prism ymin: %f; ymax: %f\n", prism_min.y, prism_max.y);
+		}
+	}
+
+	else if(command_type == MesherCommand::COARSEN_MESH) {
+		printf("Mesher command: Coarsen mesh\n");
+		printf("Desired edge length: %f\n", desired_edge_length);
+		printf("Target triangle count: %u\n", coarsen_triangle_count);
 	}
 
 	else {
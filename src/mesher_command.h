@@ -13,6 +13,11 @@ using namespace std;
 //Triangulation algorithm related code
 #include "utility.h"
 #include "vector2d.h"
+#include "prism.h"
+
+//Mesh data code
+#include "global_mesh_data.h"
+#include "point_cloud_file.h"
 
 #ifndef MESHER_COMMAND
 #define MESHER_COMMAND
@@ -28,6 +33,28 @@ public:
 	//Debugging function
 	int print();
 
+	//The tag name of the command
+	const char* GetCommandName();
+	static const char* GetCommandTypeName(int command_type);
+
+	//Returns true if the two commands touch the same mesh or file and at least one of them writes it,
+	//in which case they have to run in their original order
+	int ConflictsWith(MesherCommand* mc);
+
+	//The same, only looking at the files
+	int FileConflictsWith(MesherCommand* mc);
+
+	//How a command uses the mesh
+	enum {
+		NO_MESH_ACCESS=0,
+		READ_MESH_ACCESS,
+		WRITE_MESH_ACCESS
+	};
+
+	int GetMeshAccess();
+
+	//The files a command reads and writes
+	int GetFileAccess(vector<string>& read_files, vector<string>& write_files);
 
 	/////////////////////////////
 	// The Mesher Command Type //
@@ -41,7 +68,10 @@ public:
 		GENERATE_UNIFORM_GRID,
 		GENERATE_HEX_GRID,
 
+		LOAD_POINTS_FROM_FILE,
+
 		RUN_TRIANGLE_MESHER,
+		RESUME_TRIANGLE_MESHER,
 
 		LOAD_MESH_FROM_FILE,
 		SAVE_MESH_TO_FILE,
@@ -58,7 +88,12 @@ public:
 
 		STRETCHED_GRID,
 
-		REFINE_MESH
+		REFINE_MESH,
+		UNIFORM_REFINE,
+		COARSEN_MESH,
+
+		//The number of command types
+		COMMAND_TYPE_COUNT
 	};
 
 	////////////////////////////////
@@ -73,18 +108,39 @@ public:
 	unsigned int xcount;
 	unsigned int ycount;
 
-	//Run Triangle Mesher options
+	//Load Points From File options
+	int point_format;
+
+	//Run/Resume Triangle Mesher options
 	int use_kd_tree;
 
+	char checkpoint_filename[1000];
+	unsigned int checkpoint_interval;
+
+	char stream_filename[1000];
+
 	//Load/Save Mesh From/To File options
 	char filename[1000];
 	int load_save_triangles;
+	int file_format;
+	unsigned int quantization_bits;
 
 	//Write SVG options
 	char svg_filename[1000];
 	double svg_width;
 	double svg_height;
 
+	int svg_use_viewport;
+	Prism svg_viewport;
+
+	int svg_merge_subpixel;
+	int svg_draw_vertices;
+	unsigned int svg_max_elements;
+
+	//Save Mesh To File/Write SVG options
+	// + async exports run in the background on a copy of the mesh
+	int async_export;
+
 	//Append Vertex options
 	Vector2d vertex;
 
@@ -95,15 +151,52 @@ public:
 	//Basic Triangle Mesher options
 
 	//Basic Delaunay Flipper options
+	// + the flipper works through a queue of edges, it stops after as many edge tests as this many sweeps
 	unsigned int delaunay_max_iterations;
 
 	//Stretched Grid options
 	unsigned int stretched_grid_iterations;
 	double stretched_grid_alpha;
 
+	int stretched_grid_method;
+	enum {
+		FORCE_STRETCHED_GRID_METHOD=0,
+		LAPLACIAN_STRETCHED_GRID_METHOD
+	};
+
+	//The force method only, the fraction of the velocities lost every step, and the step relative to the average
+	//edge length it stops under, 0 turns either off
+	double stretched_grid_damping;
+	double stretched_grid_tolerance;
+
 	//Refine mesh options
 	double desired_edge_length;
 
+	int refine_method;
+	enum {
+		QUALITY_REFINE_METHOD=0,
+		OBTUSE_REFINE_METHOD
+	};
+
+	//In degrees, only used by the quality method
+	double refine_minimum_angle;
+
+	//Sizing function sources for the quality method, see SizingFunction for the file layouts
+	char sizing_grid_filename[1000];
+	char sizing_sources_filename[1000];
+	char sizing_mesh_filename[1000];
+
+	//Uniform refine options
+	// + a desired edge length picks the number of levels, and refines the whole mesh
+	unsigned int uniform_refine_levels;
+
+	int uniform_refine_use_prism;
+	Prism uniform_refine_prism;
+
+	//Coarsen mesh options
+	// + the desired edge length is shared with the refinements, 0 turns either limit off
+	unsigned int coarsen_triangle_count;
+
 	/////////////////////////////////
 	// Mesher Command Results data //
 	/////////////////////////////////
@@ -0,0 +1,733 @@
+#include "mesher_cost_model.h"
+
+//The approximate size of an xml mesh file per element, used when a command loads one
+#define XML_BYTES_PER_VERTEX	60.0
+#define XML_BYTES_PER_TRIANGLE	75.0
+
+//The approximate size of a text point file per point
+#define TEXT_BYTES_PER_POINT	30.0
+
+//What the allocator adds to every block it hands out
+#define ALLOCATION_OVERHEAD		16.0
+
+MesherCostModel::MesherCostModel() {
+	time_coefficients.assign(MesherCostModel::COST_TYPE_COUNT, 0.0);
+
+	//Rough single thread numbers, in seconds per unit of work
+	time_coefficients[MesherCommand::GENERATE_RANDOM_GRID] = 1.2e-7;
+	time_coefficients[MesherCommand::GENERATE_UNIFORM_GRID] = 1.2e-7;
+	time_coefficients[MesherCommand::GENERATE_HEX_GRID] = 1.2e-7;
+	time_coefficients[MesherCommand::LOAD_POINTS_FROM_FILE] = 1.5e-7;
+	time_coefficients[MesherCommand::RUN_TRIANGLE_MESHER] = 1.3e-5;
+	time_coefficients[MesherCommand::RESUME_TRIANGLE_MESHER] = 1.3e-5;
+	time_coefficients[MesherCommand::LOAD_MESH_FROM_FILE] = 4.0e-7;
+	time_coefficients[MesherCommand::SAVE_MESH_TO_FILE] = 3.0e-7;
+	time_coefficients[MesherCommand::WRITE_SVG] = 5.0e-7;
+	time_coefficients[MesherCommand::APPEND_VERTEX] = 1.0e-6;
+	time_coefficients[MesherCommand::SUBDIVIDE_TRIANGLE] = 1.0e-6;
+	time_coefficients[MesherCommand::BARYCENTRIC_SUBDIVIDE] = 1.0e-6;
+	time_coefficients[MesherCommand::BASIC_TRIANGLE_MESHER] = 1.3e-5;
+	time_coefficients[MesherCommand::BASIC_DELAUNAY_FLIPPER] = 2.0e-7;
+	time_coefficients[MesherCommand::STRETCHED_GRID] = 1.0e-7;
+	time_coefficients[MesherCommand::REFINE_MESH] = 2.0e-7;
+	time_coefficients[MesherCommand::UNIFORM_REFINE] = 4.0e-7;
+	time_coefficients[MesherCommand::COARSEN_MESH] = 5.0e-7;
+	time_coefficients[MesherCostModel::OBTUSE_REFINE_COST_TYPE] = 2.0e-9;
+
+	refinement_density = 2.0;
+}
+
+MesherCostModel::~MesherCostModel() {
+}
+
+/////////////////
+// Calibration //
+/////////////////
+
+//The calibration file has one "<command name> <seconds per unit of work>" line per cost type
+int MesherCostModel::LoadCalibration(const char* filename) {
+	FILE* handle = fopen(filename, "r");
+	if(handle == NULL) {
+		printf("Error: could not open the calibration file %s\n", filename);
+		return false;
+	}
+
+	char line[1000];
+	unsigned int line_number = 0;
+
+	while(fgets(line, sizeof(line), handle) != NULL) {
+		line_number++;
+
+		char name[1000];
+		double seconds_per_unit = 0;
+
+		//Skip blank lines and comments
+		if(sscanf(line, " %999s", name) != 1 || name[0] == '#')
+			continue;
+
+		if(sscanf(line, " %999s %lf", name, &seconds_per_unit) != 2 || seconds_per_unit < 0) {
+			printf("Warning: skipping line %u of the calibration file %s\n", line_number, filename);
+			continue;
+		}
+
+		if(strcmp(name, "RefinementDensity") == 0) {
+			if(seconds_per_unit > 0)
+				refinement_density = seconds_per_unit;
+			continue;
+		}
+
+		int cost_type = 0;
+		while(cost_type < int(time_coefficients.size()) && strcmp(GetCostTypeName(cost_type), name) != 0)
+			cost_type++;
+
+		if(cost_type == int(time_coefficients.size())) {
+			printf("Warning: unknown command %s in the calibration file %s\n", name, filename);
+			continue;
+		}
+
+		time_coefficients[cost_type] = seconds_per_unit;
+	}
+
+	fclose(handle);
+	return true;
+}
+
+int MesherCostModel::SaveCalibration(const char* filename) {
+	FILE* handle = fopen(filename, "w");
+	if(handle == NULL) {
+		printf("Error: could not open the calibration file %s\n", filename);
+		return false;
+	}
+
+	fprintf(handle, "# <command name> <seconds per unit of work>\n");
+
+	for(unsigned int i=1; i<time_coefficients.size(); i++)
+		fprintf(handle, "%s %.6e\n", GetCostTypeName(i), time_coefficients[i]);
+
+	fprintf(handle, "RefinementDensity %.6e\n", refinement_density);
+
+	int ret = (ferror(handle) == 0);
+	if(fclose(handle) != 0)
+		ret = false;
+
+	if(ret == false)
+		printf("Error writing the calibration file %s\n", filename);
+
+	return ret;
+}
+
+//Fit the coefficients to the profiles of commands that were actually run
+int MesherCostModel::Calibrate(MesherProfiler* mesher_profiler, vector<MesherCommand*>& commands) {
+	vector<double> total_times(time_coefficients.size(), 0.0);
+	vector<double> total_work(time_coefficients.size(), 0.0);
+
+	//Replay the estimates to know the domain each refinement covered
+	vector<CommandEstimate> estimates;
+	if(mesher_profiler->GetCommandProfileCount() > 0) {
+		CommandProfile* first_profile = mesher_profiler->GetCommandProfile(0);
+		EstimateCommands(commands, first_profile->vertex_count_before, first_profile->triangle_count_before, estimates);
+	}
+
+	double total_triangle_count = 0;
+	double total_target_triangle_count = 0;
+
+	for(unsigned int i=0; i<mesher_profiler->GetCommandProfileCount(); i++) {
+		CommandProfile* profile = mesher_profiler->GetCommandProfile(i);
+		if(profile->command_index >= commands.size())
+			continue;
+
+		if(profile->async_export == true || profile->result != MesherCommand::SUCCESS_RESULT)
+			continue;
+
+		MesherCommand* mc = commands[profile->command_index];
+		int cost_type = GetCostType(mc);
+		if(cost_type <= 0)
+			continue;
+
+		double work = compute_work(mc, profile->vertex_count_before, profile->triangle_count_before, profile->vertex_count_after, profile->triangle_count_after);
+		if(work <= 0)
+			continue;
+
+		total_times[cost_type] += profile->wall_time;
+		total_work[cost_type] += work;
+
+		//Refinements that changed the mesh say how dense they make it
+		if(mc->command_type == MesherCommand::REFINE_MESH && profile->command_index < estimates.size() && estimates[profile->command_index].domain_area_known == true &&
+				profile->triangle_count_after > profile->triangle_count_before) {
+			double target_triangle_count = compute_target_triangle_count(estimates[profile->command_index].domain_area, mc->desired_edge_length);
+			if(target_triangle_count > 0) {
+				total_triangle_count += profile->triangle_count_after;
+				total_target_triangle_count += target_triangle_count;
+			}
+		}
+	}
+
+	if(total_target_triangle_count > 0)
+		refinement_density = total_triangle_count / total_target_triangle_count;
+
+	//Command types that weren't run keep the coefficient they had
+	unsigned int calibrated_count = 0;
+	for(unsigned int i=1; i<time_coefficients.size(); i++) {
+		if(total_work[i] > 0) {
+			time_coefficients[i] = total_times[i] / total_work[i];
+			calibrated_count++;
+		}
+	}
+
+	printf("Calibrated %u command types\n", calibrated_count);
+	return true;
+}
+
+int MesherCostModel::GetCostType(MesherCommand* mc) {
+	if(mc->command_type == MesherCommand::REFINE_MESH && mc->refine_method == MesherCommand::OBTUSE_REFINE_METHOD)
+		return MesherCostModel::OBTUSE_REFINE_COST_TYPE;
+
+	if(mc->command_type < 0 || mc->command_type >= MesherCommand::COMMAND_TYPE_COUNT)
+		return MesherCommand::DO_NOTHING;
+
+	return mc->command_type;
+}
+
+const char* MesherCostModel::GetCostTypeName(int cost_type) {
+	if(cost_type == MesherCostModel::OBTUSE_REFINE_COST_TYPE)
+		return "RefineMeshObtuse";
+
+	return MesherCommand::GetCommandTypeName(cost_type);
+}
+
+double MesherCostModel::GetTimeCoefficient(int cost_type) {
+	if(cost_type < 0 || cost_type >= int(time_coefficients.size()))
+		return 0;
+
+	return time_coefficients[cost_type];
+}
+
+int MesherCostModel::SetTimeCoefficient(int cost_type, double seconds_per_unit) {
+	if(cost_type < 0 || cost_type >= int(time_coefficients.size()))
+		return false;
+
+	time_coefficients[cost_type] = seconds_per_unit;
+	return true;
+}
+
+////////////////
+// Estimation //
+////////////////
+
+//Predict the cost of every command, starting from a mesh of the given size
+int MesherCostModel::EstimateCommands(vector<MesherCommand*>& commands, double vertex_count, double triangle_count, vector<CommandEstimate>& estimates) {
+	estimates.clear();
+
+	//The area of the domain the generators and loaded files have covered, refinements need it to count triangles
+	// + the area of a mesh that is already there isn't known
+	double domain_area = 0;
+	int domain_area_known = (vertex_count == 0);
+
+	int counts_known = true;
+
+	double vertex_memory = GetVertexMemory();
+	double triangle_memory = GetTriangleMemory();
+
+	for(unsigned int i=0; i<commands.size(); i++) {
+		MesherCommand* mc = commands[i];
+
+		double vertex_count_before = vertex_count;
+		double triangle_count_before = triangle_count;
+
+		//The memory the command needs on top of the mesh while it runs
+		double transient_memory = 0;
+
+		//Refining or coarsening to an edge length can't be counted without the area
+		int uses_domain_area = (mc->command_type == MesherCommand::REFINE_MESH || mc->command_type == MesherCommand::UNIFORM_REFINE ||
+				mc->command_type == MesherCommand::COARSEN_MESH) && mc->desired_edge_length > 0;
+
+		if(uses_domain_area == true && domain_area_known == false) {
+			if(counts_known == true)
+				printf("Warning: the domain area is unknown at command %u (%s), its element counts are not estimated\n", i, mc->GetCommandName());
+
+			counts_known = false;
+		}
+
+		switch(mc->command_type) {
+			case MesherCommand::GENERATE_RANDOM_GRID:
+			case MesherCommand::GENERATE_UNIFORM_GRID:
+			case MesherCommand::GENERATE_HEX_GRID:
+				if(mc->command_type == MesherCommand::GENERATE_RANDOM_GRID)
+					vertex_count += mc->vertex_count;
+				else
+					vertex_count += double(mc->xcount) * double(mc->ycount);
+
+				domain_area += (mc->xmax - mc->xmin) * (mc->ymax - mc->ymin);
+				break;
+
+			case MesherCommand::LOAD_POINTS_FROM_FILE: {
+				double point_count = 0;
+				double area = -1;
+				estimate_point_count(mc->filename, mc->point_format, point_count, area);
+
+				vertex_count += point_count;
+
+				if(area >= 0)
+					domain_area += area;
+				else
+					domain_area_known = false;
+				break;
+			}
+
+			//The triangle mesher replaces whatever triangles there were with a triangulation of every vertex
+			// + the kd tree keeps a vertex index list per level while it splits
+			case MesherCommand::RUN_TRIANGLE_MESHER:
+			case MesherCommand::RESUME_TRIANGLE_MESHER:
+			case MesherCommand::BASIC_TRIANGLE_MESHER:
+				triangle_count = (vertex_count >= 3 ? 2.0 * vertex_count : 0);
+
+				if(vertex_count > MAXIMUM_MESH_SIZE)
+					transient_memory = sizeof(unsigned int) * vertex_count * log2(vertex_count / MAXIMUM_MESH_SIZE);
+				break;
+
+			//Loading a mesh replaces the counts and the domain, a file that isn't there yet leaves them as they were
+			case MesherCommand::LOAD_MESH_FROM_FILE: {
+				double area = -1;
+				if(estimate_mesh_counts(mc->filename, mc->file_format, mc->load_save_triangles, vertex_count, triangle_count, area) == true) {
+					domain_area = (area >= 0 ? area : 0);
+					domain_area_known = (area >= 0);
+					counts_known = true;
+				}
+				break;
+			}
+
+			//Binary and compressed saves gather the mesh into flat arrays first
+			case MesherCommand::SAVE_MESH_TO_FILE: {
+				int file_format = mc->file_format;
+				if(file_format == GlobalMeshData::UNKNOWN_FILE_FORMAT)
+					file_format = GlobalMeshData::GetFileFormat(mc->filename);
+
+				if(file_format != GlobalMeshData::XML_FILE_FORMAT)
+					transient_memory = 2 * sizeof(double) * vertex_count + 6 * sizeof(uint32_t) * triangle_count;
+				break;
+			}
+
+			case MesherCommand::APPEND_VERTEX:
+				vertex_count += 1;
+				break;
+
+			//A subdivision adds a vertex and splits one triangle into three
+			case MesherCommand::SUBDIVIDE_TRIANGLE:
+			case MesherCommand::BARYCENTRIC_SUBDIVIDE:
+				vertex_count += 1;
+				triangle_count += 2;
+				break;
+
+			//Refinement only ever adds elements, until the triangles are down to the desired edge length
+			// + quality refinement keeps the mesh a triangulation, so it adds a vertex for every two triangles
+			// + the obtuse edge splits add about one vertex for every three triangles
+			case MesherCommand::REFINE_MESH: {
+				if(domain_area_known == false)
+					break;
+
+				double target_triangle_count = refinement_density * compute_target_triangle_count(domain_area, mc->desired_edge_length);
+				if(target_triangle_count > triangle_count) {
+					if(mc->refine_method == MesherCommand::OBTUSE_REFINE_METHOD)
+						vertex_count += (target_triangle_count - triangle_count) / 3.0;
+					else
+						vertex_count += (target_triangle_count - triangle_count) / 2.0;
+
+					triangle_count = target_triangle_count;
+				}
+				break;
+			}
+
+			//Every level splits the triangles in four and adds a vertex on every edge, about 1.5 per triangle
+			// + a prism is counted as the whole mesh
+			case MesherCommand::UNIFORM_REFINE: {
+				unsigned int levels = mc->uniform_refine_levels;
+
+				//The edge length of the equilateral mesh with as many triangles over the domain
+				if(mc->desired_edge_length > 0) {
+					levels = 0;
+
+					if(domain_area_known == true && domain_area > 0 && triangle_count > 0) {
+						double edge_length = sqrt(domain_area / (sqrt(3.0) / 4.0 * triangle_count));
+						if(edge_length > mc->desired_edge_length)
+							levels = (unsigned int) ceil(log2(edge_length / mc->desired_edge_length));
+					}
+				}
+
+				for(unsigned int j=0; j<levels; j++) {
+					vertex_count += 1.5 * triangle_count;
+					triangle_count *= 4.0;
+				}
+				break;
+			}
+
+			//Coarsening only ever removes elements, every collapse takes out a vertex and two triangles
+			// + it stops at the target triangle count, or at an equilateral mesh of the desired edge length
+			case MesherCommand::COARSEN_MESH: {
+				if(uses_domain_area == true && domain_area_known == false)
+					break;
+
+				double target_triangle_count = compute_target_triangle_count(domain_area, mc->desired_edge_length);
+				if(mc->coarsen_triangle_count > 0)
+					target_triangle_count = max(target_triangle_count, double(mc->coarsen_triangle_count));
+
+				if(target_triangle_count > 0 && target_triangle_count < triangle_count) {
+					vertex_count -= (triangle_count - target_triangle_count) / 2.0;
+					triangle_count = target_triangle_count;
+				}
+				break;
+			}
+		}
+
+		double mesh_memory = vertex_count * vertex_memory + triangle_count * triangle_memory;
+
+		//An async export works on its own copy of the mesh
+		if(mc->async_export == true && (mc->command_type == MesherCommand::SAVE_MESH_TO_FILE || mc->command_type == MesherCommand::WRITE_SVG))
+			transient_memory += mesh_memory;
+
+		CommandEstimate estimate;
+		estimate.command_index = i;
+		estimate.command_name = mc->GetCommandName();
+
+		estimate.vertex_count = vertex_count;
+		estimate.triangle_count = triangle_count;
+		estimate.domain_area = domain_area;
+		estimate.domain_area_known = domain_area_known;
+		estimate.counts_known = counts_known;
+
+		estimate.memory = mesh_memory;
+		estimate.peak_memory = mesh_memory + transient_memory;
+
+		estimate.wall_time = GetTimeCoefficient(GetCostType(mc)) * compute_work(mc, vertex_count_before, triangle_count_before, vertex_count, triangle_count);
+
+		estimates.push_back(estimate);
+	}
+
+	return true;
+}
+
+int MesherCostModel::PrintEstimates(vector<CommandEstimate>& estimates) {
+	double total_wall_time = 0;
+	double peak_memory = 0;
+	int counts_known = true;
+
+	printf("%5s  %-22s %12s %12s %12s %12s\n", "index", "command", "vertices", "triangles", "peak MB", "seconds");
+
+	for(unsigned int i=0; i<estimates.size(); i++) {
+		CommandEstimate& estimate = estimates[i];
+
+		if(estimate.counts_known == true)
+			printf("%5u  %-22s %12.0f %12.0f %12.1f %12.3f\n", estimate.command_index, estimate.command_name.c_str(), estimate.vertex_count,
+					estimate.triangle_count, estimate.peak_memory / (1024.0 * 1024.0), estimate.wall_time);
+		else {
+			printf("%5u  %-22s %12s %12s %12s %12s\n", estimate.command_index, estimate.command_name.c_str(), "unknown", "unknown", "unknown", "unknown");
+			counts_known = false;
+		}
+
+		total_wall_time += estimate.wall_time;
+		if(estimate.peak_memory > peak_memory)
+			peak_memory = estimate.peak_memory;
+	}
+
+	//Commands with unknown counts were costed from what was known, so the totals are lower bounds
+	printf("Estimated total: %s%.3f seconds, %.1f MB peak mesh memory\n", (counts_known == true ? "" : "at least "), total_wall_time, peak_memory / (1024.0 * 1024.0));
+	return true;
+}
+
+//Write the estimates to a json file
+int MesherCostModel::WriteEstimates(const char* filename, const char* command_filename, vector<CommandEstimate>& estimates) {
+	BufferedWriter writer(1 << 16);
+	if(writer.Open(filename) == false) {
+		printf("Error: could not open the estimate report %s\n", filename);
+		return false;
+	}
+
+	double total_wall_time = 0;
+	double peak_memory = 0;
+	int counts_known = true;
+
+	for(unsigned int i=0; i<estimates.size(); i++) {
+		total_wall_time += estimates[i].wall_time;
+		if(estimates[i].peak_memory > peak_memory)
+			peak_memory = estimates[i].peak_memory;
+
+		if(estimates[i].counts_known == false)
+			counts_known = false;
+	}
+
+	//Command names and file names never need escaping beyond quotes and backslashes
+	string escaped_filename = "";
+	for(const char* p = command_filename; *p; p++) {
+		if(*p == '"' || *p == '\\')
+			escaped_filename += '\\';
+		escaped_filename += *p;
+	}
+
+	writer.WriteString("{\n\t\"command_file\": \"");
+	writer.WriteString(escaped_filename.c_str());
+	writer.WriteString("\",\n\t\"total_wall_time\": ");
+	writer.WriteDouble(total_wall_time);
+	writer.WriteString(",\n\t\"peak_memory_bytes\": ");
+	writer.WriteDouble(peak_memory);
+	writer.WriteString(",\n\t\"counts_known\": ");
+	writer.WriteString(counts_known == true ? "true" : "false");
+	writer.WriteString(",\n\t\"commands\": [");
+
+	for(unsigned int i=0; i<estimates.size(); i++) {
+		CommandEstimate& estimate = estimates[i];
+
+		writer.WriteString(i == 0 ? "\n" : ",\n");
+		writer.WriteString("\t\t{\n\t\t\t\"index\": ");
+		writer.WriteUnsigned(estimate.command_index);
+		writer.WriteString(",\n\t\t\t\"command\": \"");
+		writer.WriteString(estimate.command_name.c_str());
+		writer.WriteString("\",\n\t\t\t\"domain_area\": ");
+		if(estimate.domain_area_known == true)
+			writer.WriteDouble(estimate.domain_area);
+		else
+			writer.WriteString("null");
+
+		//Unknown counts are null rather than the lower bounds they were costed from
+		if(estimate.counts_known == true) {
+			writer.WriteString(",\n\t\t\t\"vertices\": ");
+			writer.WriteDouble(floor(estimate.vertex_count + 0.5));
+			writer.WriteString(",\n\t\t\t\"triangles\": ");
+			writer.WriteDouble(floor(estimate.triangle_count + 0.5));
+			writer.WriteString(",\n\t\t\t\"memory_bytes\": ");
+			writer.WriteDouble(floor(estimate.memory + 0.5));
+			writer.WriteString(",\n\t\t\t\"peak_memory_bytes\": ");
+			writer.WriteDouble(floor(estimate.peak_memory + 0.5));
+			writer.WriteString(",\n\t\t\t\"wall_time\": ");
+			writer.WriteDouble(estimate.wall_time);
+		}
+		else
+			writer.WriteString(",\n\t\t\t\"vertices\": null,\n\t\t\t\"triangles\": null,\n\t\t\t\"memory_bytes\": null,\n\t\t\t\"peak_memory_bytes\": null,\n\t\t\t\"wall_time\": null");
+
+		writer.WriteString("\n\t\t}");
+	}
+
+	writer.WriteString(estimates.size() > 0 ? "\n\t]\n}\n" : "]\n}\n");
+
+	int ret = writer.IsGood();
+	if(writer.Close() == false)
+		ret = false;
+
+	if(ret == false)
+		printf("Error writing the estimate report %s\n", filename);
+
+	return ret;
+}
+
+//The memory a live vertex or triangle takes up in the global lists, in bytes
+// + a vertex is a coordinate pair and its slot in the global list and the complex's index list
+double MesherCostModel::GetVertexMemory() {
+	return sizeof(Vector2d) + sizeof(Vector2d*) + sizeof(unsigned int);
+}
+
+// + a triangle is allocated on its own along with its circumcenter, and has a slot in the global list and
+//   the complex's index list
+double MesherCostModel::GetTriangleMemory() {
+	return sizeof(Triangle) + sizeof(Vector2d) + 2 * ALLOCATION_OVERHEAD + sizeof(Triangle*) + sizeof(unsigned int);
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//The units of work a command does, given the mesh sizes before and after it
+double MesherCostModel::compute_work(MesherCommand* mc, double vertex_count_before, double triangle_count_before, double vertex_count_after, double triangle_count_after) {
+	switch(mc->command_type) {
+		//Generators and loaders do a constant amount of work per element they add
+		case MesherCommand::GENERATE_RANDOM_GRID:
+		case MesherCommand::GENERATE_UNIFORM_GRID:
+		case MesherCommand::GENERATE_HEX_GRID:
+		case MesherCommand::LOAD_POINTS_FROM_FILE:
+			return vertex_count_after - vertex_count_before;
+
+		case MesherCommand::LOAD_MESH_FROM_FILE:
+			return vertex_count_after + triangle_count_after;
+
+		//Meshing sorts the vertices into the kd tree and meshes the leaves, both grow as V log V
+		case MesherCommand::RUN_TRIANGLE_MESHER:
+		case MesherCommand::RESUME_TRIANGLE_MESHER:
+		case MesherCommand::BASIC_TRIANGLE_MESHER:
+			if(vertex_count_after < 2)
+				return 0;
+			return vertex_count_after * log2(vertex_count_after);
+
+		//Exports visit every element once
+		case MesherCommand::SAVE_MESH_TO_FILE:
+		case MesherCommand::WRITE_SVG:
+			return vertex_count_before + triangle_count_before;
+
+		case MesherCommand::APPEND_VERTEX:
+		case MesherCommand::SUBDIVIDE_TRIANGLE:
+		case MesherCommand::BARYCENTRIC_SUBDIVIDE:
+			return 1;
+
+		case MesherCommand::BASIC_DELAUNAY_FLIPPER:
+			return triangle_count_after;
+
+		case MesherCommand::STRETCHED_GRID:
+			return double(mc->stretched_grid_iterations) * vertex_count_after;
+
+		//Quality refinement pulls every new triangle through its priority queue, the obtuse edge splitting
+		//rescans the triangles from the start after every split
+		case MesherCommand::REFINE_MESH:
+			if(mc->refine_method == MesherCommand::OBTUSE_REFINE_METHOD)
+				return triangle_count_before * (triangle_count_after - triangle_count_before);
+
+			if(triangle_count_after < 2)
+				return 0;
+			return triangle_count_after * log2(triangle_count_after);
+
+		//The last level makes three quarters of the triangles
+		case MesherCommand::UNIFORM_REFINE:
+			return triangle_count_after;
+
+		//Every edge goes through the priority queue
+		case MesherCommand::COARSEN_MESH:
+			if(triangle_count_before < 2)
+				return 0;
+			return triangle_count_before * log2(triangle_count_before);
+	}
+
+	return 0;
+}
+
+//The number of equilateral triangles with the given edge length that cover an area
+double MesherCostModel::compute_target_triangle_count(double domain_area, double edge_length) {
+	if(domain_area <= 0 || edge_length <= 0)
+		return 0;
+
+	return domain_area / (sqrt(3.0) / 4.0 * edge_length * edge_length);
+}
+
+//Point files are scanned for their exact count and bounding box, the count is guessed from the size if that fails
+int MesherCostModel::estimate_point_count(const char* filename, int point_format, double& point_count, double& area) {
+	point_count = 0;
+	area = -1;
+
+	double file_size = get_file_size(filename);
+	if(file_size < 0) {
+		printf("Warning: could not find the point file %s\n", filename);
+		return false;
+	}
+
+	if(point_format == PointCloudFile::UNKNOWN_POINT_FORMAT)
+		point_format = PointCloudFile::GetPointFormat(filename);
+
+	PointCloudFile point_cloud_file;
+	if(point_cloud_file.Open(filename, point_format) == true) {
+		point_count = point_cloud_file.GetPointCount();
+
+		Vector2d min, max;
+		if(point_count == 0)
+			area = 0;
+		else if(point_cloud_file.ReadBounds(min, max) == true)
+			area = (max.x - min.x) * (max.y - min.y);
+
+		return true;
+	}
+
+	if(point_format == PointCloudFile::FLOAT64_POINT_FORMAT)
+		point_count = floor(file_size / (2 * sizeof(double)));
+
+	else if(point_format == PointCloudFile::FLOAT32_POINT_FORMAT)
+		point_count = floor(file_size / (2 * sizeof(float)));
+
+	else
+		point_count = floor(file_size / TEXT_BYTES_PER_POINT);
+
+	return true;
+}
+
+//Binary and compressed files have the exact counts in their headers, xml files are guessed from their size
+// + compressed headers hold the bounding box, binary files are mapped and their coordinates scanned for it
+// + the area of xml files isn't known
+int MesherCostModel::estimate_mesh_counts(const char* filename, int file_format, int load_triangles, double& vertex_count, double& triangle_count, double& area) {
+	area = -1;
+
+	if(file_format == GlobalMeshData::UNKNOWN_FILE_FORMAT)
+		file_format = GlobalMeshData::GetFileFormat(filename);
+
+	if(file_format == GlobalMeshData::BINARY_FILE_FORMAT) {
+		if(get_file_size(filename) < 0) {
+			printf("Warning: could not find the mesh file %s\n", filename);
+			return false;
+		}
+
+		BinaryMeshFile binary_mesh_file;
+		if(binary_mesh_file.Open(filename) == false) {
+			printf("Warning: could not read the header of the mesh file %s\n", filename);
+			return false;
+		}
+
+		//Binary files count the null slot and any empty ones, empty vertex slots are NaN and never compare
+		long slot_count = binary_mesh_file.GetVertexCount();
+		const double* coordinates = binary_mesh_file.GetCoordinates();
+
+		double xmin = HUGE_VAL, ymin = HUGE_VAL;
+		double xmax = -HUGE_VAL, ymax = -HUGE_VAL;
+
+		#pragma omp parallel for schedule(static) reduction(min:xmin,ymin) reduction(max:xmax,ymax)
+		for(long i=1; i<slot_count; i++) {
+			xmin = (coordinates[2*i] < xmin ? coordinates[2*i] : xmin);
+			xmax = (coordinates[2*i] > xmax ? coordinates[2*i] : xmax);
+			ymin = (coordinates[2*i+1] < ymin ? coordinates[2*i+1] : ymin);
+			ymax = (coordinates[2*i+1] > ymax ? coordinates[2*i+1] : ymax);
+		}
+
+		area = (xmax >= xmin && ymax >= ymin ? (xmax - xmin) * (ymax - ymin) : 0);
+
+		//Loading a mesh replaces the current one
+		vertex_count = (slot_count > 0 ? slot_count - 1 : 0);
+		triangle_count = (load_triangles == true && binary_mesh_file.GetTriangleCount() > 0 ? binary_mesh_file.GetTriangleCount() - 1 : 0);
+
+		return true;
+	}
+
+	if(file_format == GlobalMeshData::COMPRESSED_FILE_FORMAT) {
+		FILE* handle = fopen(filename, "rb");
+		if(handle == NULL) {
+			printf("Warning: could not find the mesh file %s\n", filename);
+			return false;
+		}
+
+		CompressedMeshHeader header;
+		int ret = (fread(&header, sizeof(CompressedMeshHeader), 1, handle) == 1 && memcmp(header.magic, COMPRESSED_MESH_MAGIC, sizeof(header.magic)) == 0);
+
+		fclose(handle);
+
+		if(ret == false) {
+			printf("Warning: could not read the header of the mesh file %s\n", filename);
+			return false;
+		}
+
+		area = (header.vertex_count > 0 ? (header.xmax - header.xmin) * (header.ymax - header.ymin) : 0);
+
+		vertex_count = header.vertex_count;
+		triangle_count = (load_triangles == true ? header.triangle_count : 0);
+
+		return true;
+	}
+
+	double file_size = get_file_size(filename);
+	if(file_size < 0) {
+		printf("Warning: could not find the mesh file %s\n", filename);
+		return false;
+	}
+
+	//Assume the file holds a triangulation, with about twice as many triangles as vertices
+	vertex_count = floor(file_size / (XML_BYTES_PER_VERTEX + 2 * XML_BYTES_PER_TRIANGLE));
+	triangle_count = (load_triangles == true ? 2 * vertex_count : 0);
+
+	return true;
+}
+
+double MesherCostModel::get_file_size(const char* filename) {
+	struct stat file_stat;
+	if(stat(filename, &file_stat) != 0)
+		return -1;
+
+	return double(file_stat.st_size);
+}
@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <sys/stat.h>
+
+//Triangulation algorithm related code
+#include "vector2d.h"
+#include "triangle.h"
+#include "triangle_complex.h"
+
+//Mesh data code
+#include "global_mesh_data.h"
+#include "mesher_command.h"
+#include "mesher_profiler.h"
+#include "point_cloud_file.h"
+#include "binary_mesh_file.h"
+#include "compressed_mesh_file.h"
+
+//Report output code
+#include "buffered_writer.h"
+
+#ifndef MESHER_COST_MODEL
+#define MESHER_COST_MODEL
+
+//What one command is predicted to cost
+struct CommandEstimate {
+	unsigned int command_index;
+	string command_name;
+
+	//The live element counts once the command is done
+	double vertex_count;
+	double triangle_count;
+
+	//The area the generators and loaded files have covered so far
+	double domain_area;
+	int domain_area_known;
+
+	//False once a command whose counts follow from the domain area ran without a known area, the counts, memory
+	//and time are then only lower bounds
+	int counts_known;
+
+	//The mesh memory once the command is done and the most it needs while running, in bytes
+	double memory;
+	double peak_memory;
+
+	double wall_time;
+};
+
+//Predicts what a command file will cost without running it
+// + element counts follow from the command options: generator sizes, file headers and sizes, and the
+//   desired edge length of refinements over the domain
+// + the domain is the area of the generators plus the bounding boxes of loaded files, compressed meshes keep theirs in
+//   the header while point files and binary meshes are scanned for it, xml meshes leave it unknown
+// + run times are a coefficient per command type times the work the command does, e.g. V log V for the
+//   triangle mesher and V + T for exports, the coefficients are fitted to the profiles of real runs
+// + refinements are also fitted for how many more triangles they make than an equilateral mesh would need
+// + the built in coefficients are rough single thread numbers, calibrate on the machine that will do the runs
+class MesherCostModel {
+public:
+	MesherCostModel();
+	~MesherCostModel();
+
+	/////////////////
+	// Calibration //
+	/////////////////
+
+	//The calibration file has one "<command name> <seconds per unit of work>" line per cost type,
+	//and a "RefinementDensity <ratio>" line
+	int LoadCalibration(const char* filename);
+	int SaveCalibration(const char* filename);
+
+	//Fit the coefficients to the profiles of commands that were actually run
+	// + commands that failed or were exported in the background say nothing about their cost and are skipped
+	int Calibrate(MesherProfiler* mesher_profiler, vector<MesherCommand*>& commands);
+
+	//Commands are costed by their command type, except for refinements with the obtuse edge splitting
+	//method, which scale differently from the default quality refinement
+	enum {
+		OBTUSE_REFINE_COST_TYPE = MesherCommand::COMMAND_TYPE_COUNT,
+		COST_TYPE_COUNT
+	};
+
+	static int GetCostType(MesherCommand* mc);
+	static const char* GetCostTypeName(int cost_type);
+
+	double GetTimeCoefficient(int cost_type);
+	int SetTimeCoefficient(int cost_type, double seconds_per_unit);
+
+	////////////////
+	// Estimation //
+	////////////////
+
+	//Predict the cost of every command, starting from a mesh of the given size
+	int EstimateCommands(vector<MesherCommand*>& commands, double vertex_count, double triangle_count, vector<CommandEstimate>& estimates);
+
+	static int PrintEstimates(vector<CommandEstimate>& estimates);
+
+	//Write the estimates to a json file
+	static int WriteEstimates(const char* filename, const char* command_filename, vector<CommandEstimate>& estimates);
+
+	//The memory a live vertex or triangle takes up in the global lists, in bytes
+	static double GetVertexMemory();
+	static double GetTriangleMemory();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//The units of work a command does, given the mesh sizes before and after it
+	static double compute_work(MesherCommand* mc, double vertex_count_before, double triangle_count_before, double vertex_count_after, double triangle_count_after);
+
+	//The number of equilateral triangles with the given edge length that cover an area
+	static double compute_target_triangle_count(double domain_area, double edge_length);
+
+	//Element counts and bounding box areas of files the commands read, the area is negative if it isn't known
+	static int estimate_point_count(const char* filename, int point_format, double& point_count, double& area);
+	static int estimate_mesh_counts(const char* filename, int file_format, int load_triangles, double& vertex_count, double& triangle_count, double& area);
+
+	static double get_file_size(const char* filename);
+
+	//Seconds per unit of work, one per cost type
+	vector<double> time_coefficients;
+
+	//The triangles a refinement ends up with over the equilateral triangles of the desired edge length that cover the domain
+	double refinement_density;
+};
+
+#endif
@@ -0,0 +1,349 @@
+#include "mesher_profiler.h"
+
+//The phase times reported by threads that aren't running a command themselves, like the
+//workers of a parallel loop inside a command
+static vector<PhaseProfile> shared_phases;
+
+//The phase times of the command running on this thread
+// + batch jobs each run on their own thread, so their phase times never mix
+static vector<PhaseProfile>* thread_phases = NULL;
+#pragma omp threadprivate(thread_phases)
+
+//Orders command profiles by command index
+static bool command_profile_less(const CommandProfile& a, const CommandProfile& b) {
+	return a.command_index < b.command_index;
+}
+
+MesherProfiler::MesherProfiler() {
+	command_profiles.clear();
+
+	counted_mesh = NULL;
+	counted_vertex_count = 0;
+	counted_triangle_count = 0;
+}
+
+MesherProfiler::~MesherProfiler() {
+}
+
+//////////////////////
+// Command profiles //
+//////////////////////
+
+//Start timing a command, the profile is filled in by EndCommand
+int MesherProfiler::BeginCommand(CommandProfile& profile, unsigned int command_index, const char* command_name, int async_export, int mesh_access, GlobalMeshData* global_mesh_data) {
+	profile.command_index = command_index;
+	profile.command_name = command_name;
+
+	profile.async_export = async_export;
+	profile.result = 0;
+	profile.mesh_access = mesh_access;
+
+	//Only commands that write the mesh change the counts, so the ones the last command ended with still hold
+	int counted = false;
+
+	#pragma omp critical(mesher_profiler_commands)
+	if(counted_mesh != NULL && counted_mesh == global_mesh_data) {
+		profile.vertex_count_before = counted_vertex_count;
+		profile.triangle_count_before = counted_triangle_count;
+		counted = true;
+	}
+
+	if(counted == false)
+		count_elements(global_mesh_data, profile.vertex_count_before, profile.triangle_count_before);
+	profile.vertex_count_after = 0;
+	profile.triangle_count_after = 0;
+
+	profile.phases.clear();
+	thread_phases = &profile.phases;
+
+	//Drop phase times left over from work done outside of a command
+	vector<PhaseProfile> stale_phases;
+	take_phase_times(stale_phases);
+
+	//Only a thread of its own tells the cpu time of this command apart from whatever runs next to it
+	profile.thread_cpu_time = IsSingleThreaded();
+
+	profile.process_peak_rss_at_end = 0;
+	profile.cpu_time = (profile.thread_cpu_time == true ? GetThreadCPUTime() : GetProcessCPUTime());
+	profile.wall_time = GetWallTime();
+
+	return true;
+}
+
+//Stop timing a command and keep its profile
+int MesherProfiler::EndCommand(CommandProfile& profile, int result, GlobalMeshData* global_mesh_data) {
+	profile.wall_time = GetWallTime() - profile.wall_time;
+	profile.cpu_time = (profile.thread_cpu_time == true ? GetThreadCPUTime() : GetProcessCPUTime()) - profile.cpu_time;
+	profile.process_peak_rss_at_end = GetProcessPeakRSS();
+
+	profile.result = result;
+
+	if(profile.mesh_access == MesherCommand::WRITE_MESH_ACCESS)
+		count_elements(global_mesh_data, profile.vertex_count_after, profile.triangle_count_after);
+	else {
+		profile.vertex_count_after = profile.vertex_count_before;
+		profile.triangle_count_after = profile.triangle_count_before;
+	}
+
+	thread_phases = NULL;
+	take_phase_times(profile.phases);
+
+	#pragma omp critical(mesher_profiler_commands)
+	{
+		command_profiles.push_back(profile);
+
+		counted_mesh = global_mesh_data;
+		counted_vertex_count = profile.vertex_count_after;
+		counted_triangle_count = profile.triangle_count_after;
+	}
+
+	return true;
+}
+
+unsigned int MesherProfiler::GetCommandProfileCount() {
+	return command_profiles.size();
+}
+
+CommandProfile* MesherProfiler::GetCommandProfile(unsigned int index) {
+	if(index >= command_profiles.size())
+		return NULL;
+
+	return &command_profiles[index];
+}
+
+int MesherProfiler::Clear() {
+	command_profiles.clear();
+
+	//The mesh may be changed outside of commands before the next ones run
+	counted_mesh = NULL;
+
+	vector<PhaseProfile> stale_phases;
+	take_phase_times(stale_phases);
+
+	return true;
+}
+
+//Write the profiles to a json file, sorted by command index
+int MesherProfiler::WriteReport(const char* filename, const char* command_filename, double total_wall_time) {
+	BufferedWriter writer(1 << 16);
+	if(writer.Open(filename) == false) {
+		printf("Error: could not open the profile report %s\n", filename);
+		return false;
+	}
+
+	stable_sort(command_profiles.begin(), command_profiles.end(), command_profile_less);
+
+	writer.WriteString("{\n\t\"command_file\": ");
+	write_json_string(&writer, command_filename);
+	writer.WriteString(",\n\t\"thread_count\": ");
+	writer.WriteUnsigned(omp_get_max_threads());
+	writer.WriteString(",\n\t\"total_wall_time\": ");
+	writer.WriteDouble(total_wall_time);
+	writer.WriteString(",\n\t\"process_peak_rss_kb\": ");
+	writer.WriteInteger(GetProcessPeakRSS());
+	writer.WriteString(",\n\t\"commands\": [");
+
+	for(unsigned int i=0; i<command_profiles.size(); i++) {
+		CommandProfile& profile = command_profiles[i];
+
+		const char* result_str = "not_yet_run";
+		if(profile.result == MesherCommand::FAILURE_RESULT)
+			result_str = "failure";
+		else if(profile.result == MesherCommand::SUCCESS_RESULT)
+			result_str = "success";
+
+		writer.WriteString(i == 0 ? "\n" : ",\n");
+		writer.WriteString("\t\t{\n\t\t\t\"index\": ");
+		writer.WriteUnsigned(profile.command_index);
+		writer.WriteString(",\n\t\t\t\"command\": ");
+		write_json_string(&writer, profile.command_name.c_str());
+		writer.WriteString(",\n\t\t\t\"async\": ");
+		writer.WriteString(profile.async_export ? "true" : "false");
+		writer.WriteString(",\n\t\t\t\"result\": \"");
+		writer.WriteString(result_str);
+		writer.WriteString("\",\n\t\t\t\"wall_time\": ");
+		writer.WriteDouble(profile.wall_time);
+		writer.WriteString(profile.thread_cpu_time ? ",\n\t\t\t\"cpu_time\": " : ",\n\t\t\t\"process_cpu_time\": ");
+		writer.WriteDouble(profile.cpu_time);
+		writer.WriteString(",\n\t\t\t\"process_peak_rss_kb_at_end\": ");
+		writer.WriteInteger(profile.process_peak_rss_at_end);
+		writer.WriteString(",\n\t\t\t\"vertices_before\": ");
+		writer.WriteUnsigned(profile.vertex_count_before);
+		writer.WriteString(",\n\t\t\t\"vertices_after\": ");
+		writer.WriteUnsigned(profile.vertex_count_after);
+		writer.WriteString(",\n\t\t\t\"triangles_before\": ");
+		writer.WriteUnsigned(profile.triangle_count_before);
+		writer.WriteString(",\n\t\t\t\"triangles_after\": ");
+		writer.WriteUnsigned(profile.triangle_count_after);
+		writer.WriteString(",\n\t\t\t\"phases\": [");
+
+		for(unsigned int j=0; j<profile.phases.size(); j++) {
+			writer.WriteString(j == 0 ? "\n" : ",\n");
+			writer.WriteString("\t\t\t\t{\"name\": ");
+			write_json_string(&writer, profile.phases[j].name.c_str());
+			writer.WriteString(", \"calls\": ");
+			writer.WriteUnsigned(profile.phases[j].call_count);
+			writer.WriteString(", \"wall_time\": ");
+			writer.WriteDouble(profile.phases[j].wall_time);
+			writer.WriteString("}");
+		}
+
+		writer.WriteString(profile.phases.size() > 0 ? "\n\t\t\t]\n\t\t}" : "]\n\t\t}");
+	}
+
+	writer.WriteString(command_profiles.size() > 0 ? "\n\t]\n}\n" : "]\n}\n");
+
+	int ret = writer.IsGood();
+	if(writer.Close() == false)
+		ret = false;
+
+	if(ret == false)
+		printf("Error writing the profile report %s\n", filename);
+
+	return ret;
+}
+
+//////////////////
+// Phase timers //
+//////////////////
+
+//Add time spent in a phase of the current command, safe to call from any thread
+int MesherProfiler::AddPhaseTime(const char* phase, double wall_time) {
+	if(thread_phases != NULL)
+		return add_phase_time(*thread_phases, phase, 1, wall_time);
+
+	#pragma omp critical(mesher_profiler_phases)
+	add_phase_time(shared_phases, phase, 1, wall_time);
+
+	return true;
+}
+
+double MesherProfiler::GetWallTime() {
+	return omp_get_wtime();
+}
+
+//User and system time of every thread in the process
+double MesherProfiler::GetProcessCPUTime() {
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+	return compute_cpu_time(usage);
+}
+
+//User and system time of the calling thread
+double MesherProfiler::GetThreadCPUTime() {
+	struct rusage usage;
+	if(getrusage(RUSAGE_THREAD, &usage) != 0)
+		return 0;
+
+	return compute_cpu_time(usage);
+}
+
+long MesherProfiler::GetProcessPeakRSS() {
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+	return usage.ru_maxrss;
+}
+
+//Returns true if a parallel loop started on the calling thread would get no more threads
+// + batch jobs and the commands of a concurrent wave run inside a parallel region with nesting turned off
+int MesherProfiler::IsSingleThreaded() {
+	if(omp_get_max_threads() == 1)
+		return true;
+
+	return (omp_in_parallel() && omp_get_active_level() >= omp_get_max_active_levels());
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//Move the phase times the worker threads collected so far into a list
+int MesherProfiler::take_phase_times(vector<PhaseProfile>& phases) {
+	#pragma omp critical(mesher_profiler_phases)
+	{
+		for(unsigned int i=0; i<shared_phases.size(); i++)
+			add_phase_time(phases, shared_phases[i].name.c_str(), shared_phases[i].call_count, shared_phases[i].wall_time);
+
+		shared_phases.clear();
+	}
+
+	return true;
+}
+
+int MesherProfiler::add_phase_time(vector<PhaseProfile>& phases, const char* phase, unsigned int call_count, double wall_time) {
+	unsigned int i = 0;
+	while(i < phases.size() && phases[i].name != phase)
+		i++;
+
+	if(i == phases.size()) {
+		PhaseProfile phase_profile;
+		phase_profile.name = phase;
+		phase_profile.call_count = 0;
+		phase_profile.wall_time = 0;
+
+		phases.push_back(phase_profile);
+	}
+
+	phases[i].call_count += call_count;
+	phases[i].wall_time += wall_time;
+
+	return true;
+}
+
+int MesherProfiler::count_elements(GlobalMeshData* global_mesh_data, unsigned int& vertex_count, unsigned int& triangle_count) {
+	vertex_count = 0;
+	triangle_count = 0;
+
+	if(global_mesh_data == NULL)
+		return false;
+
+	//Slot 0 and freed slots are empty
+	unsigned int vcount = 0;
+	unsigned int tcount = 0;
+
+	#pragma omp parallel for schedule(static) reduction(+:vcount)
+	for(int i=1; i<int(global_mesh_data->GetVertexCount()); i++) {
+		if(global_mesh_data->GetVertex(i) != NULL)
+			vcount++;
+	}
+
+	#pragma omp parallel for schedule(static) reduction(+:tcount)
+	for(int i=1; i<int(global_mesh_data->GetTriangleCount()); i++) {
+		if(global_mesh_data->GetTriangle(i) != NULL)
+			tcount++;
+	}
+
+	vertex_count = vcount;
+	triangle_count = tcount;
+
+	return true;
+}
+
+double MesherProfiler::compute_cpu_time(struct rusage& usage) {
+	return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + 1e-6 * double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+int MesherProfiler::write_json_string(BufferedWriter* writer, const char* str) {
+	writer->WriteChar('"');
+
+	for(const char* p = str; *p; p++) {
+		if(*p == '"' || *p == '\\') {
+			writer->WriteChar('\\');
+			writer->WriteChar(*p);
+		}
+		else if((unsigned char)(*p) < 0x20) {
+			char escaped[8];
+			sprintf(escaped, "\\u%04x", (unsigned int)(unsigned char)(*p));
+			writer->WriteString(escaped);
+		}
+		else
+			writer->WriteChar(*p);
+	}
+
+	writer->WriteChar('"');
+	return true;
+}
@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <omp.h>
+
+//Mesh data code
+#include "global_mesh_data.h"
+#include "mesher_command.h"
+
+//Report output code
+#include "buffered_writer.h"
+
+#ifndef MESHER_PROFILER
+#define MESHER_PROFILER
+
+//The time spent in one part of the mesher while a command ran
+// + phases run by several threads at once add up their wall times, so they are thread-seconds
+struct PhaseProfile {
+	string name;
+
+	unsigned int call_count;
+	double wall_time;
+};
+
+//What one command cost
+struct CommandProfile {
+	unsigned int command_index;
+	string command_name;
+
+	//Async exports only count the time to start them
+	int async_export;
+	int result;
+
+	//The MesherCommand mesh access, only commands that write the mesh can change the element counts
+	int mesh_access;
+
+	double wall_time;
+
+	//The cpu time of the command, measured on its own thread when the command ran on that thread alone (a batch
+	//job, or a command in a concurrent wave, with nested parallelism off), otherwise the cpu time of the whole
+	//process while the command ran, which counts anything running next to it
+	double cpu_time;
+	int thread_cpu_time;
+
+	//The high-water mark of the whole process once the command finished, in kB, not the peak of the command
+	long process_peak_rss_at_end;
+
+	unsigned int vertex_count_before, vertex_count_after;
+	unsigned int triangle_count_before, triangle_count_after;
+
+	vector<PhaseProfile> phases;
+};
+
+//Collects a profile of every command run, and writes them out as a json report
+// + phase times go to the command running on the reporting thread; the workers of a parallel loop report
+//   to a shared list that the next command to finish picks up, so a command running a parallel loop
+//   should not overlap other commands (commands that change the mesh always run alone)
+class MesherProfiler {
+public:
+	MesherProfiler();
+	~MesherProfiler();
+
+	//////////////////////
+	// Command profiles //
+	//////////////////////
+
+	//Start timing a command, the profile is filled in by EndCommand
+	// + the element counts of the mesh are carried over from the last command, they are only counted again when a
+	//   command that writes the mesh ends, or when this is the first command on the mesh since Clear
+	int BeginCommand(CommandProfile& profile, unsigned int command_index, const char* command_name, int async_export, int mesh_access, GlobalMeshData* global_mesh_data);
+
+	//Stop timing a command and keep its profile
+	int EndCommand(CommandProfile& profile, int result, GlobalMeshData* global_mesh_data);
+
+	unsigned int GetCommandProfileCount();
+	CommandProfile* GetCommandProfile(unsigned int index);
+
+	int Clear();
+
+	//Write the profiles to a json file, sorted by command index
+	int WriteReport(const char* filename, const char* command_filename, double total_wall_time);
+
+	//////////////////
+	// Phase timers //
+	//////////////////
+
+	//Add time spent in a phase of the current command, safe to call from any thread
+	static int AddPhaseTime(const char* phase, double wall_time);
+
+	//Wall clock, and the cpu time of the whole process or of the calling thread, in seconds
+	static double GetWallTime();
+	static double GetProcessCPUTime();
+	static double GetThreadCPUTime();
+
+	//The peak resident set size of the process in kB
+	static long GetProcessPeakRSS();
+
+	//Returns true if a parallel loop started on the calling thread would get no more threads
+	static int IsSingleThreaded();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//Move the phase times the worker threads collected so far into a list
+	static int take_phase_times(vector<PhaseProfile>& phases);
+
+	static int add_phase_time(vector<PhaseProfile>& phases, const char* phase, unsigned int call_count, double wall_time);
+
+	static int count_elements(GlobalMeshData* global_mesh_data, unsigned int& vertex_count, unsigned int& triangle_count);
+
+	static int write_json_string(BufferedWriter* writer, const char* str);
+
+	static double compute_cpu_time(struct rusage& usage);
+
+	//The profiles of the commands run so far
+	vector<CommandProfile> command_profiles;
+
+	//The element counts of the mesh after the last command, NULL once nothing has been counted
+	GlobalMeshData* counted_mesh;
+	unsigned int counted_vertex_count;
+	unsigned int counted_triangle_count;
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include "mesher_service.h"
+
+MesherService::MesherService() {
+	triangle_mesher = new TriangleMesher;
+
+	coordinates.clear();
+	request_count = 0;
+}
+
+MesherService::~MesherService() {
+	delete triangle_mesher;
+	triangle_mesher = NULL;
+}
+
+/////////////
+// Serving //
+/////////////
+
+//Accept connections on a unix domain socket until the process is stopped
+int MesherService::ServeSocket(const char* socket_path) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if(strlen(socket_path) >= sizeof(address.sun_path)) {
+		printf("Error: the socket path %s is too long\n", socket_path);
+		return false;
+	}
+
+	strcpy(address.sun_path, socket_path);
+
+	int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(listen_fd < 0) {
+		printf("Error creating a socket\n");
+		return false;
+	}
+
+	//A socket file left over from an earlier run would make bind fail, anything else at the path is left alone
+	struct stat path_stat;
+	if(lstat(socket_path, &path_stat) == 0) {
+		if(S_ISSOCK(path_stat.st_mode) == false) {
+			printf("Error: %s exists and is not a socket\n", socket_path);
+
+			close(listen_fd);
+			return false;
+		}
+
+		unlink(socket_path);
+	}
+
+	else if(errno != ENOENT) {
+		printf("Error checking the socket path %s\n", socket_path);
+
+		close(listen_fd);
+		return false;
+	}
+
+	if(bind(listen_fd, (struct sockaddr*) &address, sizeof(address)) != 0 || listen(listen_fd, 16) != 0) {
+		printf("Error listening on %s\n", socket_path);
+
+		close(listen_fd);
+		return false;
+	}
+
+	//A client going away mid-response must not take the service down with it
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("Serving meshing requests on %s\n", socket_path);
+
+	//Running out of descriptors or memory can clear up, so accept backs off and tries again, any other error is fatal
+	int ret = true;
+	useconds_t backoff = 0;
+
+	while(true) {
+		int connection_fd = accept(listen_fd, NULL, NULL);
+		if(connection_fd < 0) {
+			if(errno == EINTR || errno == ECONNABORTED)
+				continue;
+
+			if(errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+				backoff = (backoff == 0 ? MESHER_SERVICE_MIN_BACKOFF : min(2*backoff, (useconds_t) MESHER_SERVICE_MAX_BACKOFF));
+				printf("Warning: could not accept a connection (%s), retrying in %u ms\n", strerror(errno), (unsigned int) (backoff / 1000));
+
+				usleep(backoff);
+				continue;
+			}
+
+			printf("Error accepting connections on %s: %s\n", socket_path, strerror(errno));
+			ret = false;
+			break;
+		}
+
+		backoff = 0;
+
+		if(ServeConnection(connection_fd, connection_fd) == false)
+			printf("Warning: dropped a connection with a broken request stream\n");
+
+		close(connection_fd);
+	}
+
+	close(listen_fd);
+	unlink(socket_path);
+
+	return ret;
+}
+
+//Answer requests on stdin until it is closed
+int MesherService::ServeStdio() {
+	//Keep stdout for the responses and send everything printed to stderr instead
+	fflush(stdout);
+
+	int output_fd = dup(STDOUT_FILENO);
+	if(output_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+		fprintf(stderr, "Error redirecting stdout\n");
+		return false;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+
+	int ret = ServeConnection(STDIN_FILENO, output_fd);
+	close(output_fd);
+
+	return ret;
+}
+
+//Answer every request on a connection until the other end closes it
+int MesherService::ServeConnection(int input_fd, int output_fd) {
+	vector<char> mesh_data;
+
+	while(true) {
+		MesherServiceRequest request;
+
+		//A clean close happens between requests
+		ssize_t count = 0;
+		do {
+			count = read(input_fd, &request, 1);
+		} while(count < 0 && errno == EINTR);
+
+		if(count == 0)
+			return true;
+
+		if(count != 1 || read_all(input_fd, ((char*) &request) + 1, sizeof(MesherServiceRequest) - 1) == false)
+			return false;
+
+		//Without a valid header the rest of the stream can't be framed
+		if(memcmp(request.magic, MESHER_SERVICE_REQUEST_MAGIC, sizeof(request.magic)) != 0 || request.point_count > MESHER_SERVICE_MAX_POINTS) {
+			mesh_data.clear();
+			write_response(output_fd, MesherService::BAD_REQUEST_STATUS, mesh_data);
+
+			return false;
+		}
+
+		coordinates.resize(2*size_t(request.point_count));
+		if(request.point_count > 0 && read_all(input_fd, &coordinates[0], 2*size_t(request.point_count)*sizeof(double)) == false)
+			return false;
+
+		unsigned int status = MesherService::SUCCESS_STATUS;
+
+		if(request.version != MESHER_SERVICE_VERSION || request.flags != 0)
+			status = MesherService::BAD_REQUEST_STATUS;
+
+		else if(mesh_points(request.point_count, mesh_data) == false)
+			status = MesherService::MESHING_FAILED_STATUS;
+
+		if(status != MesherService::SUCCESS_STATUS)
+			mesh_data.clear();
+
+		request_count++;
+
+		if(write_response(output_fd, status, mesh_data) == false)
+			return false;
+	}
+
+	return true;
+}
+
+//The number of requests answered so far
+unsigned int MesherService::GetRequestCount() {
+	return request_count;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//Mesh the points of one request into a binary mesh
+int MesherService::mesh_points(unsigned int point_count, vector<char>& mesh_data) {
+	mesh_data.clear();
+
+	if(point_count < 3) {
+		printf("Error: at least 3 points are needed to mesh\n");
+		return false;
+	}
+
+	int ret = (triangle_mesher->AdoptVertices(&coordinates[0], point_count) != 0);
+
+	if(ret == true)
+		ret = triangle_mesher->RunTriangleMesher(true);
+
+	//The binary layout is padded using the stream position, so it is built in memory first
+	if(ret == true) {
+		char* buffer = NULL;
+		size_t buffer_size = 0;
+
+		FILE* handle = open_memstream(&buffer, &buffer_size);
+		if(handle == NULL)
+			ret = false;
+
+		else {
+			ret = triangle_mesher->SaveMeshToBinaryStream(handle, true);
+
+			if(fclose(handle) != 0)
+				ret = false;
+
+			if(ret == true)
+				mesh_data.assign(buffer, buffer + buffer_size);
+
+			free(buffer);
+		}
+	}
+
+	//Let go of the coordinates and keep the lists for the next request
+	triangle_mesher->Reset();
+
+	return ret;
+}
+
+int MesherService::write_response(int output_fd, unsigned int status, const vector<char>& mesh_data) {
+	MesherServiceResponse response;
+	memset(&response, 0, sizeof(MesherServiceResponse));
+
+	memcpy(response.magic, MESHER_SERVICE_RESPONSE_MAGIC, sizeof(response.magic));
+	response.version = MESHER_SERVICE_VERSION;
+	response.status = status;
+	response.mesh_size = mesh_data.size();
+
+	if(write_all(output_fd, &response, sizeof(MesherServiceResponse)) == false)
+		return false;
+
+	if(mesh_data.size() > 0 && write_all(output_fd, &mesh_data[0], mesh_data.size()) == false)
+		return false;
+
+	return true;
+}
+
+int MesherService::read_all(int fd, void* data, size_t size) {
+	char* p = (char*) data;
+
+	while(size > 0) {
+		ssize_t count = read(fd, p, size);
+		if(count < 0 && errno == EINTR)
+			continue;
+
+		if(count <= 0)
+			return false;
+
+		p += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+int MesherService::write_all(int fd, const void* data, size_t size) {
+	const char* p = (const char*) data;
+
+	while(size > 0) {
+		ssize_t count = write(fd, p, size);
+		if(count < 0 && errno == EINTR)
+			continue;
+
+		if(count <= 0)
+			return false;
+
+		p += count;
+		size -= count;
+	}
+
+	return true;
+}
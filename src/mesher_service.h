@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <vector>
+using namespace std;
+
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+
+//Triangulation algorithm related code
+#include "triangle_mesher.h"
+
+#ifndef MESHER_SERVICE
+#define MESHER_SERVICE
+
+//The meshing service protocol
+// + a request is a MesherServiceRequest followed by 2*point_count doubles (x, y)
+// + every request gets a MesherServiceResponse, followed on success by mesh_size bytes of a binary mesh file
+//   holding the points as vertices 1 to point_count and their Delaunay triangulation
+// + a connection carries any number of requests, one after the other
+// + everything is in the byte order of the machine running the service
+#define MESHER_SERVICE_REQUEST_MAGIC	"TRIMREQ"
+#define MESHER_SERVICE_RESPONSE_MAGIC	"TRIMRSP"
+#define MESHER_SERVICE_VERSION			1
+
+//The largest request accepted, anything bigger is treated as a broken stream
+#define MESHER_SERVICE_MAX_POINTS		(1u << 26)
+
+//How long accept waits before trying again when it runs out of descriptors or memory, in microseconds, doubling
+//every time it fails in a row
+#define MESHER_SERVICE_MIN_BACKOFF		10000
+#define MESHER_SERVICE_MAX_BACKOFF		1000000
+
+struct MesherServiceRequest {
+	char magic[8];
+	uint32_t version;
+
+	uint32_t point_count;
+
+	//Reserved for request options, must be 0
+	uint32_t flags;
+	uint32_t reserved;
+};
+
+struct MesherServiceResponse {
+	char magic[8];
+	uint32_t version;
+
+	uint32_t status;
+	uint64_t mesh_size;
+};
+
+//Answers meshing requests over a unix domain socket or stdin/stdout
+// + one TriangleMesher serves every request, it is reset in between so its lists and the OpenMP threads stay warm
+// + the mesher's progress output goes to stderr in stdin/stdout mode, stdout carries the responses
+class MesherService {
+public:
+	MesherService();
+	~MesherService();
+
+	//The response status codes
+	enum {
+		SUCCESS_STATUS=0,
+		BAD_REQUEST_STATUS,
+		MESHING_FAILED_STATUS
+	};
+
+	/////////////
+	// Serving //
+	/////////////
+
+	//Accept connections on a unix domain socket until the process is stopped
+	int ServeSocket(const char* socket_path);
+
+	//Answer requests on stdin until it is closed
+	int ServeStdio();
+
+	//Answer every request on a connection until the other end closes it
+	// + returns false if the stream broke, true on a clean close
+	int ServeConnection(int input_fd, int output_fd);
+
+	//The number of requests answered so far
+	unsigned int GetRequestCount();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//Mesh the points of one request into a binary mesh
+	int mesh_points(unsigned int point_count, vector<char>& mesh_data);
+
+	int write_response(int output_fd, unsigned int status, const vector<char>& mesh_data);
+
+	static int read_all(int fd, void* data, size_t size);
+	static int write_all(int fd, const void* data, size_t size);
+
+	//The mesher kept warm between requests
+	TriangleMesher* triangle_mesher;
+
+	//The coordinates of the current request, the mesher uses them in place
+	vector<double> coordinates;
+
+	unsigned int request_count;
+};
+
+#endif
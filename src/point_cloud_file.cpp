@@ -0,0 +1,392 @@
+#include "point_cloud_file.h"
+
+//Fast number parsing
+#include "mesh_xml_reader.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//The size of the text chunks that are parsed in parallel
+#define POINT_CLOUD_CHUNK_SIZE	(4 << 20)
+
+static inline int is_separator(char c) {
+	return (c == ' ' || c == '\t' || c == ',' || c == ';');
+}
+
+//Lines holding a point start with a number, everything else is skipped
+static inline int starts_point_line(const char* p, const char* line_end) {
+	while(p < line_end && (*p == ' ' || *p == '\t'))
+		p++;
+
+	if(p >= line_end)
+		return false;
+
+	return ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.');
+}
+
+//Parse the x and y of a point line
+static inline int parse_point_line(const char* p, const char* line_end, double& x, double& y) {
+	const char* q = MeshXMLReader::ParseDouble(p, line_end, x);
+
+	while(q != NULL && q < line_end && is_separator(*q))
+		q++;
+
+	if(q != NULL)
+		q = MeshXMLReader::ParseDouble(q, line_end, y);
+
+	if(q == NULL) {
+		printf("Error: bad point on line \"%.*s\"\n", int(line_end - p < 80 ? line_end - p : 80), p);
+		return false;
+	}
+
+	return true;
+}
+
+PointCloudFile::PointCloudFile() {
+	file_descriptor = -1;
+	data = NULL;
+	data_size = 0;
+
+	point_format = PointCloudFile::UNKNOWN_POINT_FORMAT;
+	point_count = 0;
+}
+
+PointCloudFile::~PointCloudFile() {
+	Close();
+}
+
+//Guess the point format from the file extension
+// + ".f64" and ".f32" files are binary, everything else is text
+int PointCloudFile::GetPointFormat(const char* filename) {
+	const char* extension = strrchr(filename, '.');
+
+	if(extension != NULL && strcmp(extension, ".f64") == 0)
+		return PointCloudFile::FLOAT64_POINT_FORMAT;
+
+	if(extension != NULL && strcmp(extension, ".f32") == 0)
+		return PointCloudFile::FLOAT32_POINT_FORMAT;
+
+	return PointCloudFile::TEXT_POINT_FORMAT;
+}
+
+//////////////
+// File i/o //
+//////////////
+
+int PointCloudFile::Open(const char* filename, int point_format) {
+	Close();
+
+	if(point_format == PointCloudFile::UNKNOWN_POINT_FORMAT)
+		point_format = GetPointFormat(filename);
+
+	this->point_format = point_format;
+
+	file_descriptor = open(filename, O_RDONLY);
+	if(file_descriptor < 0) {
+		printf("Error opening the point file %s\n", filename);
+		return false;
+	}
+
+	struct stat file_stat;
+	if(fstat(file_descriptor, &file_stat) != 0) {
+		printf("Error reading the point file %s\n", filename);
+
+		Close();
+		return false;
+	}
+
+	//An empty file simply has no points
+	data_size = (size_t) file_stat.st_size;
+	if(data_size > 0) {
+		void* mapped_data = mmap(NULL, data_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+		if(mapped_data == MAP_FAILED) {
+			printf("Error mapping the point file %s\n", filename);
+
+			data_size = 0;
+			Close();
+			return false;
+		}
+
+		//Every chunk is read at once by a different thread
+		madvise(mapped_data, data_size, MADV_WILLNEED);
+
+		data = (const char*) mapped_data;
+	}
+
+	//Binary files are fixed size records
+	if(point_format == PointCloudFile::FLOAT64_POINT_FORMAT || point_format == PointCloudFile::FLOAT32_POINT_FORMAT) {
+		size_t point_size = (point_format == PointCloudFile::FLOAT64_POINT_FORMAT ? 2*sizeof(double) : 2*sizeof(float));
+
+		if(data_size % point_size != 0) {
+			printf("Error: the size of %s is not a whole number of points\n", filename);
+
+			Close();
+			return false;
+		}
+
+		if(data_size / point_size >= 0xffffffffULL) {
+			printf("Error: %s has too many points\n", filename);
+
+			Close();
+			return false;
+		}
+
+		point_count = (unsigned int) (data_size / point_size);
+		return true;
+	}
+
+	//Text files are split into chunks and every chunk is counted
+	if(split_text_chunks() == false) {
+		printf("Error: %s has too many points\n", filename);
+
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+int PointCloudFile::Close() {
+	if(data != NULL)
+		munmap((void*) data, data_size);
+
+	if(file_descriptor >= 0)
+		close(file_descriptor);
+
+	file_descriptor = -1;
+	data = NULL;
+	data_size = 0;
+
+	point_count = 0;
+
+	chunk_starts.clear();
+	chunk_offsets.clear();
+
+	return true;
+}
+
+/////////////
+// Reading //
+/////////////
+
+//The number of points in the file
+unsigned int PointCloudFile::GetPointCount() {
+	return point_count;
+}
+
+//Read every point into the array, which must hold GetPointCount() points
+// + the file is split into chunks that are parsed in parallel
+int PointCloudFile::ReadPoints(Vector2d* points) {
+	if(point_count == 0)
+		return true;
+
+	if(point_format == PointCloudFile::FLOAT64_POINT_FORMAT) {
+		const double* coordinates = (const double*) data;
+
+		#pragma omp parallel for schedule(static)
+		for(long i=0; i<long(point_count); i++) {
+			points[i].x = coordinates[2*i];
+			points[i].y = coordinates[2*i+1];
+		}
+
+		return true;
+	}
+
+	if(point_format == PointCloudFile::FLOAT32_POINT_FORMAT) {
+		const float* coordinates = (const float*) data;
+
+		#pragma omp parallel for schedule(static)
+		for(long i=0; i<long(point_count); i++) {
+			points[i].x = double(coordinates[2*i]);
+			points[i].y = double(coordinates[2*i+1]);
+		}
+
+		return true;
+	}
+
+	//Every text chunk knows where its first point goes
+	int chunk_count = int(chunk_starts.size()) - 1;
+	int ret = true;
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int i=0; i<chunk_count; i++) {
+		if(parse_text_points(chunk_starts[i], chunk_starts[i+1], points + chunk_offsets[i]) == false) {
+			#pragma omp critical
+			ret = false;
+		}
+	}
+
+	return ret;
+}
+
+//The bounding box of every point, without keeping the points
+int PointCloudFile::ReadBounds(Vector2d& min, Vector2d& max) {
+	if(point_count == 0)
+		return false;
+
+	double xmin = HUGE_VAL, ymin = HUGE_VAL;
+	double xmax = -HUGE_VAL, ymax = -HUGE_VAL;
+	int ret = true;
+
+	if(point_format == PointCloudFile::FLOAT64_POINT_FORMAT) {
+		const double* coordinates = (const double*) data;
+
+		#pragma omp parallel for schedule(static) reduction(min:xmin,ymin) reduction(max:xmax,ymax)
+		for(long i=0; i<long(point_count); i++) {
+			xmin = (coordinates[2*i] < xmin ? coordinates[2*i] : xmin);
+			xmax = (coordinates[2*i] > xmax ? coordinates[2*i] : xmax);
+			ymin = (coordinates[2*i+1] < ymin ? coordinates[2*i+1] : ymin);
+			ymax = (coordinates[2*i+1] > ymax ? coordinates[2*i+1] : ymax);
+		}
+	}
+
+	else if(point_format == PointCloudFile::FLOAT32_POINT_FORMAT) {
+		const float* coordinates = (const float*) data;
+
+		#pragma omp parallel for schedule(static) reduction(min:xmin,ymin) reduction(max:xmax,ymax)
+		for(long i=0; i<long(point_count); i++) {
+			xmin = (coordinates[2*i] < xmin ? coordinates[2*i] : xmin);
+			xmax = (coordinates[2*i] > xmax ? coordinates[2*i] : xmax);
+			ymin = (coordinates[2*i+1] < ymin ? coordinates[2*i+1] : ymin);
+			ymax = (coordinates[2*i+1] > ymax ? coordinates[2*i+1] : ymax);
+		}
+	}
+
+	//Every text chunk finds its own box, the boxes are merged after
+	else {
+		int chunk_count = int(chunk_starts.size()) - 1;
+
+		#pragma omp parallel for schedule(dynamic) reduction(min:xmin,ymin) reduction(max:xmax,ymax)
+		for(int i=0; i<chunk_count; i++) {
+			Vector2d chunk_min(HUGE_VAL, HUGE_VAL);
+			Vector2d chunk_max(-HUGE_VAL, -HUGE_VAL);
+
+			if(parse_text_bounds(chunk_starts[i], chunk_starts[i+1], chunk_min, chunk_max) == false) {
+				#pragma omp critical
+				ret = false;
+			}
+
+			xmin = (chunk_min.x < xmin ? chunk_min.x : xmin);
+			ymin = (chunk_min.y < ymin ? chunk_min.y : ymin);
+			xmax = (chunk_max.x > xmax ? chunk_max.x : xmax);
+			ymax = (chunk_max.y > ymax ? chunk_max.y : ymax);
+		}
+	}
+
+	min = Vector2d(xmin, ymin);
+	max = Vector2d(xmax, ymax);
+
+	return ret;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//Split the text into chunks that start at the beginning of a line
+int PointCloudFile::split_text_chunks() {
+	const char* end = data + data_size;
+
+	chunk_starts.clear();
+	chunk_starts.push_back(data);
+
+	for(size_t offset=POINT_CLOUD_CHUNK_SIZE; offset<data_size; offset+=POINT_CLOUD_CHUNK_SIZE) {
+		const char* line_end = (const char*) memchr(data + offset, '\n', data_size - offset);
+		if(line_end == NULL)
+			break;
+
+		if(line_end + 1 > chunk_starts.back() && line_end + 1 < end)
+			chunk_starts.push_back(line_end + 1);
+	}
+
+	chunk_starts.push_back(end);
+
+	//Count the points in every chunk in parallel, then turn the counts into offsets
+	int chunk_count = int(chunk_starts.size()) - 1;
+	vector<unsigned int> chunk_counts(chunk_count, 0);
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int i=0; i<chunk_count; i++)
+		chunk_counts[i] = count_text_points(chunk_starts[i], chunk_starts[i+1]);
+
+	chunk_offsets.resize(chunk_count, 0);
+
+	uint64_t total = 0;
+	for(int i=0; i<chunk_count; i++) {
+		chunk_offsets[i] = (unsigned int) total;
+		total += chunk_counts[i];
+	}
+
+	if(total >= 0xffffffffULL)
+		return false;
+
+	point_count = (unsigned int) total;
+	return true;
+}
+
+//Count/parse the points in one text chunk
+unsigned int PointCloudFile::count_text_points(const char* p, const char* end) {
+	unsigned int count = 0;
+
+	while(p < end) {
+		const char* line_end = (const char*) memchr(p, '\n', end - p);
+		if(line_end == NULL)
+			line_end = end;
+
+		if(starts_point_line(p, line_end))
+			count++;
+
+		p = line_end + 1;
+	}
+
+	return count;
+}
+
+int PointCloudFile::parse_text_points(const char* p, const char* end, Vector2d* points) {
+	unsigned int count = 0;
+
+	while(p < end) {
+		const char* line_end = (const char*) memchr(p, '\n', end - p);
+		if(line_end == NULL)
+			line_end = end;
+
+		if(starts_point_line(p, line_end)) {
+			double x, y;
+			if(parse_point_line(p, line_end, x, y) == false)
+				return false;
+
+			points[count].x = x;
+			points[count].y = y;
+			count++;
+		}
+
+		p = line_end + 1;
+	}
+
+	return true;
+}
+
+int PointCloudFile::parse_text_bounds(const char* p, const char* end, Vector2d& min, Vector2d& max) {
+	while(p < end) {
+		const char* line_end = (const char*) memchr(p, '\n', end - p);
+		if(line_end == NULL)
+			line_end = end;
+
+		if(starts_point_line(p, line_end)) {
+			double x, y;
+			if(parse_point_line(p, line_end, x, y) == false)
+				return false;
+
+			min.x = (x < min.x ? x : min.x);
+			min.y = (y < min.y ? y : min.y);
+			max.x = (x > max.x ? x : max.x);
+			max.y = (y > max.y ? y : max.y);
+		}
+
+		p = line_end + 1;
+	}
+
+	return true;
+}
@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <vector>
+using namespace std;
+
+//Triangulation algorithm related code
+#include "vector2d.h"
+
+#ifndef POINT_CLOUD_FILE
+#define POINT_CLOUD_FILE
+
+//Reads large point clouds straight out of a mapped file
+// + binary files are packed xy pairs of float64 or float32, in native byte order
+// + text files have one point per line, x and y separated by whitespace, commas or semicolons
+// + in text files any extra columns are ignored, as are lines that don't start with a number (headers, comments)
+class PointCloudFile {
+public:
+	PointCloudFile();
+	~PointCloudFile();
+
+	//The point file formats
+	enum {
+		UNKNOWN_POINT_FORMAT=0,
+		TEXT_POINT_FORMAT,
+		FLOAT64_POINT_FORMAT,
+		FLOAT32_POINT_FORMAT
+	};
+
+	//Guess the point format from the file extension
+	// + ".f64" and ".f32" files are binary, everything else is text
+	static int GetPointFormat(const char* filename);
+
+	//////////////
+	// File i/o //
+	//////////////
+
+	int Open(const char* filename, int point_format);
+	int Close();
+
+	/////////////
+	// Reading //
+	/////////////
+
+	//The number of points in the file
+	unsigned int GetPointCount();
+
+	//Read every point into the array, which must hold GetPointCount() points
+	// + the file is split into chunks that are parsed in parallel
+	int ReadPoints(Vector2d* points);
+
+	//The bounding box of every point, without keeping the points
+	// + returns false if there are no points
+	int ReadBounds(Vector2d& min, Vector2d& max);
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//Split the text into chunks that start at the beginning of a line
+	int split_text_chunks();
+
+	//Count/parse the points in one text chunk
+	unsigned int count_text_points(const char* p, const char* end);
+	int parse_text_points(const char* p, const char* end, Vector2d* points);
+	int parse_text_bounds(const char* p, const char* end, Vector2d& min, Vector2d& max);
+
+	//The mapped file
+	int file_descriptor;
+	const char* data;
+	size_t data_size;
+
+	int point_format;
+	unsigned int point_count;
+
+	//Text chunk boundaries and the index of the first point in each chunk
+	vector<const char*> chunk_starts;
+	vector<unsigned int> chunk_offsets;
+};
+
+#endif
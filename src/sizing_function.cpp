@@ -0,0 +1,515 @@
+#include "sizing_function.h"
+
+SizingFunction::SizingFunction() {
+	grid_xcount = 0;
+	grid_ycount = 0;
+
+	source_buckets_built = false;
+
+	background_mesh = NULL;
+
+	minimum_size = 0.0;
+}
+
+SizingFunction::~SizingFunction() {
+	if(background_mesh != NULL)
+		delete background_mesh;
+}
+
+/////////////
+// Sources //
+/////////////
+
+//A grid file is "xcount ycount xmin xmax ymin ymax" followed by xcount*ycount sizes, row by row from ymin
+int SizingFunction::LoadGridFile(const char* filename) {
+	FILE* handle = fopen(filename, "r");
+	if(handle == NULL) {
+		printf("Error: could not open the sizing grid file %s\n", filename);
+		return false;
+	}
+
+	unsigned int xcount = 0, ycount = 0;
+	double xmin = 0, xmax = 0, ymin = 0, ymax = 0;
+
+	if(fscanf(handle, "%u %u %lf %lf %lf %lf", &xcount, &ycount, &xmin, &xmax, &ymin, &ymax) != 6 || xcount == 0 || ycount == 0) {
+		printf("Error: bad header in the sizing grid file %s\n", filename);
+		fclose(handle);
+		return false;
+	}
+
+	vector<double> sizes(size_t(xcount) * ycount, 0.0);
+	for(size_t i=0; i<sizes.size(); i++) {
+		if(fscanf(handle, "%lf", &sizes[i]) != 1 || sizes[i] <= 0) {
+			printf("Error: bad size %u in the sizing grid file %s\n", (unsigned int) i, filename);
+			fclose(handle);
+			return false;
+		}
+	}
+
+	fclose(handle);
+
+	grid_xcount = xcount;
+	grid_ycount = ycount;
+	grid_bounds.SetMin(xmin, ymin);
+	grid_bounds.SetMax(xmax, ymax);
+	grid_sizes.swap(sizes);
+
+	double smallest_size = *min_element(grid_sizes.begin(), grid_sizes.end());
+	if(minimum_size == 0 || smallest_size < minimum_size)
+		minimum_size = smallest_size;
+
+	printf("Loaded a %u x %u sizing grid\n", grid_xcount, grid_ycount);
+	return true;
+}
+
+//A point source file has one "x y size grading" line per source
+int SizingFunction::LoadPointSourceFile(const char* filename) {
+	FILE* handle = fopen(filename, "r");
+	if(handle == NULL) {
+		printf("Error: could not open the sizing source file %s\n", filename);
+		return false;
+	}
+
+	char line[1000];
+	unsigned int line_number = 0;
+	unsigned int source_count = 0;
+
+	while(fgets(line, sizeof(line), handle) != NULL) {
+		line_number++;
+
+		char first[1000];
+		double x = 0, y = 0, size = 0, grading = 0;
+
+		//Skip blank lines and comments
+		if(sscanf(line, " %999s", first) != 1 || first[0] == '#')
+			continue;
+
+		if(sscanf(line, " %lf %lf %lf %lf", &x, &y, &size, &grading) != 4 || AppendPointSource(Vector2d(x, y), size, grading) == false) {
+			printf("Warning: skipping line %u of the sizing source file %s\n", line_number, filename);
+			continue;
+		}
+
+		source_count++;
+	}
+
+	fclose(handle);
+
+	printf("Loaded %u sizing sources\n", source_count);
+	return true;
+}
+
+int SizingFunction::AppendPointSource(Vector2d position, double size, double grading) {
+	if(size <= 0 || grading < 0)
+		return false;
+
+	SizingSource source;
+	source.position = position;
+	source.size = size;
+	source.grading = grading;
+
+	sources.push_back(source);
+	source_buckets_built = false;
+
+	if(minimum_size == 0 || size < minimum_size)
+		minimum_size = size;
+
+	return true;
+}
+
+//The background mesh is loaded with its triangles, from any of the mesh file formats
+int SizingFunction::LoadBackgroundMesh(const char* filename) {
+	GlobalMeshData* mesh = new GlobalMeshData;
+
+	if(mesh->LoadFromFile(filename, true) == false) {
+		printf("Error: could not load the background mesh %s\n", filename);
+		delete mesh;
+		return false;
+	}
+
+	if(background_mesh != NULL)
+		delete background_mesh;
+
+	background_mesh = mesh;
+
+	return build_background_buckets();
+}
+
+//Returns true if there are no sources
+int SizingFunction::IsEmpty() {
+	return (grid_sizes.empty() == true && sources.empty() == true && background_mesh == NULL);
+}
+
+/////////////
+// Lookups //
+/////////////
+
+//Build the buckets, after the sources are in and before any lookups
+int SizingFunction::BuildLookup(Prism domain) {
+	if(sources.empty() == false)
+		return build_point_source_buckets(domain);
+
+	return true;
+}
+
+//The size at a point, 0 if no source covers it
+double SizingFunction::Evaluate(Vector2d pt) {
+	double size = 0.0;
+
+	double grid_size = evaluate_grid(pt);
+	if(grid_size > 0 && (size == 0 || grid_size < size))
+		size = grid_size;
+
+	double source_size = evaluate_point_sources(pt);
+	if(source_size > 0 && (size == 0 || source_size < size))
+		size = source_size;
+
+	double background_size = evaluate_background_mesh(pt);
+	if(background_size > 0 && (size == 0 || background_size < size))
+		size = background_size;
+
+	return size;
+}
+
+//The smallest size any source asks for, 0 if there are none
+double SizingFunction::GetMinimumSize() {
+	return minimum_size;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+double SizingFunction::evaluate_grid(Vector2d pt) {
+	if(grid_sizes.empty() == true)
+		return 0.0;
+
+	Vector2d grid_min = grid_bounds.GetMin();
+	Vector2d grid_max = grid_bounds.GetMax();
+
+	//Position in grid points, clamped to the edges of the grid
+	double fx = 0.0, fy = 0.0;
+
+	if(grid_xcount > 1 && grid_max.x > grid_min.x)
+		fx = min(max((pt.x - grid_min.x) / (grid_max.x - grid_min.x), 0.0), 1.0) * (grid_xcount - 1);
+
+	if(grid_ycount > 1 && grid_max.y > grid_min.y)
+		fy = min(max((pt.y - grid_min.y) / (grid_max.y - grid_min.y), 0.0), 1.0) * (grid_ycount - 1);
+
+	unsigned int x0 = min((unsigned int) fx, grid_xcount - 1);
+	unsigned int y0 = min((unsigned int) fy, grid_ycount - 1);
+	unsigned int x1 = min(x0 + 1, grid_xcount - 1);
+	unsigned int y1 = min(y0 + 1, grid_ycount - 1);
+
+	double tx = fx - x0;
+	double ty = fy - y0;
+
+	double s00 = grid_sizes[size_t(y0) * grid_xcount + x0];
+	double s10 = grid_sizes[size_t(y0) * grid_xcount + x1];
+	double s01 = grid_sizes[size_t(y1) * grid_xcount + x0];
+	double s11 = grid_sizes[size_t(y1) * grid_xcount + x1];
+
+	return (1-ty) * ((1-tx) * s00 + tx * s10) + ty * ((1-tx) * s01 + tx * s11);
+}
+
+double SizingFunction::evaluate_point_sources(Vector2d pt) {
+	if(sources.empty() == true)
+		return 0.0;
+
+	double size = 0.0;
+
+	//Outside the buckets every source has to be checked
+	int bucket = (source_buckets_built == true ? find_bucket(source_buckets, pt) : -1);
+
+	if(bucket < 0) {
+		for(unsigned int i=0; i<sources.size(); i++) {
+			double source_size = sources[i].size + sources[i].grading * sources[i].position.distance(pt);
+			if(size == 0 || source_size < size)
+				size = source_size;
+		}
+
+		return size;
+	}
+
+	for(unsigned int i=source_buckets.starts[bucket]; i<source_buckets.starts[bucket+1]; i++) {
+		SizingSource& source = sources[source_buckets.items[i]];
+
+		double source_size = source.size + source.grading * source.position.distance(pt);
+		if(size == 0 || source_size < size)
+			size = source_size;
+	}
+
+	return size;
+}
+
+double SizingFunction::evaluate_background_mesh(Vector2d pt) {
+	if(background_mesh == NULL)
+		return 0.0;
+
+	int bucket = find_bucket(background_buckets, pt);
+	if(bucket < 0)
+		return 0.0;
+
+	for(unsigned int i=background_buckets.starts[bucket]; i<background_buckets.starts[bucket+1]; i++) {
+		Triangle* tri = background_mesh->GetTriangle(background_buckets.items[i]);
+
+		Vector2d* a = tri->GetVertex(0);
+		Vector2d* b = tri->GetVertex(1);
+		Vector2d* c = tri->GetVertex(2);
+
+		double det = (b->x - a->x)*(c->y - a->y) - (b->y - a->y)*(c->x - a->x);
+		if(fabs(det) <= EFF_ZERO * EFF_ZERO)
+			continue;
+
+		//Barycentric coordinates, with a little slack so points on an edge are found
+		double la = ((b->x - pt.x)*(c->y - pt.y) - (b->y - pt.y)*(c->x - pt.x)) / det;
+		double lb = ((pt.x - a->x)*(c->y - a->y) - (pt.y - a->y)*(c->x - a->x)) / det;
+		double lc = 1.0 - la - lb;
+
+		if(la < -1e-9 || lb < -1e-9 || lc < -1e-9)
+			continue;
+
+		return la * background_vertex_sizes[tri->GetVertexIndex(0)] +
+			   lb * background_vertex_sizes[tri->GetVertexIndex(1)] +
+			   lc * background_vertex_sizes[tri->GetVertexIndex(2)];
+	}
+
+	return 0.0;
+}
+
+//Keep only the point sources that can be the smallest somewhere in each bucket
+// + a source is kept if the smallest size it can ask for in the bucket is no more than the largest size the
+//   best source asks for there
+// + this takes buckets times sources, point sources are expected to number in the thousands at most
+int SizingFunction::build_point_source_buckets(Prism domain) {
+	Prism bounds = domain;
+	for(unsigned int i=0; i<sources.size(); i++)
+		bounds.Expand(sources[i].position);
+
+	unsigned int bucket_count = min((unsigned int) (4 * sources.size()), 16384u);
+	init_buckets(source_buckets, bounds, bucket_count);
+
+	unsigned int total_bucket_count = source_buckets.xcount * source_buckets.ycount;
+	vector<vector<unsigned int> > bucket_sources(total_bucket_count);
+
+	Vector2d bounds_min = source_buckets.bounds.GetMin();
+	Vector2d bounds_max = source_buckets.bounds.GetMax();
+
+	double bucket_width = (bounds_max.x - bounds_min.x) / source_buckets.xcount;
+	double bucket_height = (bounds_max.y - bounds_min.y) / source_buckets.ycount;
+
+	#pragma omp parallel for schedule(dynamic, 16)
+	for(long i=0; i<long(total_bucket_count); i++) {
+		unsigned int x = i % source_buckets.xcount;
+		unsigned int y = i / source_buckets.xcount;
+
+		Prism bucket;
+		bucket.SetMin(bounds_min.x + x * bucket_width, bounds_min.y + y * bucket_height);
+		bucket.SetMax(bounds_min.x + (x+1) * bucket_width, bounds_min.y + (y+1) * bucket_height);
+
+		double best_upper_size = 0.0;
+		for(unsigned int j=0; j<sources.size(); j++) {
+			double upper_size = sources[j].size + sources[j].grading * max_distance(bucket, sources[j].position);
+			if(j == 0 || upper_size < best_upper_size)
+				best_upper_size = upper_size;
+		}
+
+		for(unsigned int j=0; j<sources.size(); j++) {
+			double lower_size = sources[j].size + sources[j].grading * min_distance(bucket, sources[j].position);
+			if(lower_size <= best_upper_size)
+				bucket_sources[i].push_back(j);
+		}
+	}
+
+	source_buckets.starts[0] = 0;
+	for(unsigned int i=0; i<total_bucket_count; i++)
+		source_buckets.starts[i+1] = source_buckets.starts[i] + bucket_sources[i].size();
+
+	source_buckets.items.resize(source_buckets.starts[total_bucket_count]);
+	for(unsigned int i=0; i<total_bucket_count; i++)
+		copy(bucket_sources[i].begin(), bucket_sources[i].end(), source_buckets.items.begin() + source_buckets.starts[i]);
+
+	source_buckets_built = true;
+
+	printf("Bucketed %u sizing sources into %u x %u buckets, %.1f per bucket\n", (unsigned int) sources.size(),
+		source_buckets.xcount, source_buckets.ycount, double(source_buckets.items.size()) / total_bucket_count);
+	return true;
+}
+
+//Bucket the background triangles by their bounding boxes, and work out the vertex sizes
+int SizingFunction::build_background_buckets() {
+	unsigned int vertex_count = background_mesh->GetVertexCount();
+	unsigned int triangle_count = background_mesh->GetTriangleCount();
+
+	//The size at a vertex is the average length of the edges around it, interior edges are seen twice
+	vector<double> edge_length_sums(vertex_count, 0.0);
+	vector<unsigned int> edge_counts(vertex_count, 0);
+
+	Prism bounds;
+	int first = true;
+
+	for(unsigned int i=0; i<triangle_count; i++) {
+		Triangle* tri = background_mesh->GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			double edge_length = tri->ComputeEdgeLength(j);
+
+			for(int k=1; k<3; k++) {
+				unsigned int vindex = tri->GetVertexIndex((j+k)%3);
+
+				edge_length_sums[vindex] += edge_length;
+				edge_counts[vindex]++;
+			}
+
+			if(first == true) {
+				bounds.SetMinMax(*tri->GetVertex(j), *tri->GetVertex(j));
+				first = false;
+			}
+			else
+				bounds.Expand(*tri->GetVertex(j));
+		}
+	}
+
+	if(first == true) {
+		printf("Error: the background mesh has no triangles\n");
+
+		delete background_mesh;
+		background_mesh = NULL;
+		return false;
+	}
+
+	background_vertex_sizes.assign(vertex_count, 0.0);
+	for(unsigned int i=0; i<vertex_count; i++) {
+		if(edge_counts[i] == 0)
+			continue;
+
+		background_vertex_sizes[i] = edge_length_sums[i] / edge_counts[i];
+		if(minimum_size == 0 || background_vertex_sizes[i] < minimum_size)
+			minimum_size = background_vertex_sizes[i];
+	}
+
+	//About one bucket per triangle, each triangle goes in every bucket its bounding box touches
+	init_buckets(background_buckets, bounds, triangle_count);
+
+	vector<unsigned int>& starts = background_buckets.starts;
+	vector<unsigned int>& items = background_buckets.items;
+
+	for(int pass=0; pass<2; pass++) {
+		vector<unsigned int> fill_counts;
+		if(pass == 1) {
+			for(unsigned int i=1; i<starts.size(); i++)
+				starts[i] += starts[i-1];
+
+			items.resize(starts.back());
+			fill_counts.assign(starts.begin(), starts.end() - 1);
+		}
+
+		for(unsigned int i=0; i<triangle_count; i++) {
+			Triangle* tri = background_mesh->GetTriangle(i);
+			if(tri == NULL)
+				continue;
+
+			Prism tri_bounds;
+			tri_bounds.SetMinMax(*tri->GetVertex(0), *tri->GetVertex(0));
+			tri_bounds.Expand(*tri->GetVertex(1));
+			tri_bounds.Expand(*tri->GetVertex(2));
+
+			unsigned int x0, x1, y0, y1;
+			find_bucket_range(background_buckets, tri_bounds, x0, x1, y0, y1);
+
+			for(unsigned int y=y0; y<=y1; y++) {
+				for(unsigned int x=x0; x<=x1; x++) {
+					unsigned int bucket = y * background_buckets.xcount + x;
+
+					if(pass == 0)
+						starts[bucket+1]++;
+					else
+						items[fill_counts[bucket]++] = i;
+				}
+			}
+		}
+	}
+
+	printf("Loaded a background mesh with %u triangles into %u x %u buckets\n", triangle_count, background_buckets.xcount, background_buckets.ycount);
+	return true;
+}
+
+//Set up an empty bucket grid with about the given number of buckets
+int SizingFunction::init_buckets(SizingBuckets& buckets, Prism bounds, unsigned int bucket_count) {
+	Vector2d bounds_min = bounds.GetMin();
+	Vector2d bounds_max = bounds.GetMax();
+
+	//Give flat bounds some width, so every point maps to a bucket
+	double width = max(bounds_max.x - bounds_min.x, EFF_ZERO);
+	double height = max(bounds_max.y - bounds_min.y, EFF_ZERO);
+
+	buckets.bounds.SetMin(bounds_min);
+	buckets.bounds.SetMax(bounds_min.x + width, bounds_min.y + height);
+
+	//Buckets about as wide as they are high
+	bucket_count = max(bucket_count, 1u);
+
+	double xcount = sqrt(double(bucket_count) * width / height);
+	buckets.xcount = (unsigned int) min(max(xcount, 1.0), 4096.0);
+	buckets.ycount = (unsigned int) min(max(double(bucket_count) / buckets.xcount, 1.0), 4096.0);
+
+	buckets.starts.assign(size_t(buckets.xcount) * buckets.ycount + 1, 0);
+	buckets.items.clear();
+
+	return true;
+}
+
+//The bucket holding a point, -1 if it is outside the grid
+int SizingFunction::find_bucket(SizingBuckets& buckets, Vector2d pt) {
+	Vector2d bounds_min = buckets.bounds.GetMin();
+	Vector2d bounds_max = buckets.bounds.GetMax();
+
+	if(pt.x < bounds_min.x || pt.x > bounds_max.x || pt.y < bounds_min.y || pt.y > bounds_max.y)
+		return -1;
+
+	unsigned int x = min((unsigned int) ((pt.x - bounds_min.x) / (bounds_max.x - bounds_min.x) * buckets.xcount), buckets.xcount - 1);
+	unsigned int y = min((unsigned int) ((pt.y - bounds_min.y) / (bounds_max.y - bounds_min.y) * buckets.ycount), buckets.ycount - 1);
+
+	return int(y * buckets.xcount + x);
+}
+
+//The bucket ranges a prism overlaps, clamped to the grid
+int SizingFunction::find_bucket_range(SizingBuckets& buckets, Prism p, unsigned int& x0, unsigned int& x1, unsigned int& y0, unsigned int& y1) {
+	Vector2d bounds_min = buckets.bounds.GetMin();
+	Vector2d bounds_max = buckets.bounds.GetMax();
+
+	Vector2d p_min = p.GetMin();
+	Vector2d p_max = p.GetMax();
+
+	double scale_x = buckets.xcount / (bounds_max.x - bounds_min.x);
+	double scale_y = buckets.ycount / (bounds_max.y - bounds_min.y);
+
+	x0 = (unsigned int) min(max((p_min.x - bounds_min.x) * scale_x, 0.0), double(buckets.xcount - 1));
+	x1 = (unsigned int) min(max((p_max.x - bounds_min.x) * scale_x, 0.0), double(buckets.xcount - 1));
+	y0 = (unsigned int) min(max((p_min.y - bounds_min.y) * scale_y, 0.0), double(buckets.ycount - 1));
+	y1 = (unsigned int) min(max((p_max.y - bounds_min.y) * scale_y, 0.0), double(buckets.ycount - 1));
+
+	return true;
+}
+
+//The nearest and farthest distances from a point to a prism
+double SizingFunction::min_distance(Prism p, Vector2d pt) {
+	Vector2d p_min = p.GetMin();
+	Vector2d p_max = p.GetMax();
+
+	double dx = max(max(p_min.x - pt.x, pt.x - p_max.x), 0.0);
+	double dy = max(max(p_min.y - pt.y, pt.y - p_max.y), 0.0);
+
+	return sqrt(dx*dx + dy*dy);
+}
+
+double SizingFunction::max_distance(Prism p, Vector2d pt) {
+	Vector2d p_min = p.GetMin();
+	Vector2d p_max = p.GetMax();
+
+	double dx = max(fabs(pt.x - p_min.x), fabs(pt.x - p_max.x));
+	double dy = max(fabs(pt.y - p_min.y), fabs(pt.y - p_max.y));
+
+	return sqrt(dx*dx + dy*dy);
+}
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+//Triangulation algorithm related code
+#include "utility.h"
+#include "vector2d.h"
+#include "prism.h"
+#include "triangle.h"
+
+//Mesh data code
+#include "global_mesh_data.h"
+
+#ifndef SIZING_FUNCTION
+#define SIZING_FUNCTION
+
+//A point where the mesh has to be fine, the size grows by grading per unit of distance away from it
+struct SizingSource {
+	Vector2d position;
+
+	double size;
+	double grading;
+};
+
+//A uniform grid of buckets over a prism, each holding a list of item indices
+// + the lists are stored one after the other, bucket i holds items[starts[i]] to items[starts[i+1]-1]
+struct SizingBuckets {
+	Prism bounds;
+
+	unsigned int xcount;
+	unsigned int ycount;
+
+	vector<unsigned int> starts;
+	vector<unsigned int> items;
+};
+
+//A desired edge length that changes over the domain
+// + the size at a point is the smallest size any of the sources asks for there:
+//   - a grid file, interpolated bilinearly and clamped to its edges
+//   - point sources, each asking for its size plus its grading times the distance to it
+//   - a background mesh, where the size at a vertex is the average length of its edges, interpolated over
+//     the triangles
+// + lookups go through bucket grids, built once the sources are in
+// + lookups only read, so any number of threads can share one sizing function
+class SizingFunction {
+public:
+	SizingFunction();
+	~SizingFunction();
+
+	/////////////
+	// Sources //
+	/////////////
+
+	//A grid file is "xcount ycount xmin xmax ymin ymax" followed by xcount*ycount sizes, row by row from ymin
+	int LoadGridFile(const char* filename);
+
+	//A point source file has one "x y size grading" line per source
+	int LoadPointSourceFile(const char* filename);
+	int AppendPointSource(Vector2d position, double size, double grading);
+
+	//The background mesh is loaded with its triangles, from any of the mesh file formats
+	int LoadBackgroundMesh(const char* filename);
+
+	//Returns true if there are no sources
+	int IsEmpty();
+
+	/////////////
+	// Lookups //
+	/////////////
+
+	//Build the buckets, after the sources are in and before any lookups
+	// + point sources are bucketed over the domain, lookups outside it check every source
+	int BuildLookup(Prism domain);
+
+	//The size at a point, 0 if no source covers it
+	double Evaluate(Vector2d pt);
+
+	//The smallest size any source asks for, 0 if there are none
+	double GetMinimumSize();
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	double evaluate_grid(Vector2d pt);
+	double evaluate_point_sources(Vector2d pt);
+	double evaluate_background_mesh(Vector2d pt);
+
+	//Keep only the point sources that can be the smallest somewhere in each bucket
+	int build_point_source_buckets(Prism domain);
+
+	//Bucket the background triangles by their bounding boxes, and work out the vertex sizes
+	int build_background_buckets();
+
+	//Set up an empty bucket grid with about the given number of buckets
+	static int init_buckets(SizingBuckets& buckets, Prism bounds, unsigned int bucket_count);
+
+	//The bucket holding a point, -1 if it is outside the grid
+	static int find_bucket(SizingBuckets& buckets, Vector2d pt);
+
+	//The bucket ranges a prism overlaps, clamped to the grid
+	static int find_bucket_range(SizingBuckets& buckets, Prism p, unsigned int& x0, unsigned int& x1, unsigned int& y0, unsigned int& y1);
+
+	//The nearest and farthest distances from a point to a prism
+	static double min_distance(Prism p, Vector2d pt);
+	static double max_distance(Prism p, Vector2d pt);
+
+	//Grid source
+	unsigned int grid_xcount;
+	unsigned int grid_ycount;
+	Prism grid_bounds;
+	vector<double> grid_sizes;
+
+	//Point sources
+	vector<SizingSource> sources;
+	SizingBuckets source_buckets;
+	int source_buckets_built;
+
+	//Background mesh source
+	GlobalMeshData* background_mesh;
+	vector<double> background_vertex_sizes;
+	SizingBuckets background_buckets;
+
+	double minimum_size;
+};
+
+#endif
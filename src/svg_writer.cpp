@@ -0,0 +1,382 @@
+#include "svg_writer.h"
+
+//The number of decimals written for svg coordinates
+#define SVG_WRITER_DECIMALS		2
+
+SVGWriter::SVGWriter() {
+	width = 0.0;
+	height = 0.0;
+
+	use_viewport = false;
+
+	merge_subpixel_triangles = false;
+	draw_vertices = true;
+	max_elements = 0;
+
+	scale_x = 1.0;
+	scale_y = 1.0;
+
+	bitmap_width = 0;
+	bitmap_height = 0;
+	cell_size = 1.0;
+}
+
+SVGWriter::~SVGWriter() {
+	//Do nothing
+}
+
+/////////////
+// Options //
+/////////////
+
+//The size of the svg view box
+int SVGWriter::SetSize(double width, double height) {
+	if(width <= 0.0 || height <= 0.0)
+		return false;
+
+	this->width = width;
+	this->height = height;
+
+	return true;
+}
+
+//Only draw what overlaps the viewport, the viewport is stretched over the whole view box
+int SVGWriter::SetViewport(Prism viewport) {
+	Vector2d min = viewport.GetMin();
+	Vector2d max = viewport.GetMax();
+
+	if(max.x <= min.x || max.y <= min.y)
+		return false;
+
+	this->viewport = viewport;
+	use_viewport = true;
+
+	return true;
+}
+
+int SVGWriter::ClearViewport() {
+	use_viewport = false;
+	return true;
+}
+
+//Triangles smaller than a pixel are merged into runs of filled pixels
+int SVGWriter::SetMergeSubpixelTriangles(int merge_subpixel_triangles) {
+	this->merge_subpixel_triangles = merge_subpixel_triangles;
+	return true;
+}
+
+//Draw a circle for every vertex
+int SVGWriter::SetDrawVertices(int draw_vertices) {
+	this->draw_vertices = draw_vertices;
+	return true;
+}
+
+//Sample the triangles, merged sub-pixel runs and vertices so that roughly this many elements are written, 0 is
+//no limit
+int SVGWriter::SetElementBudget(unsigned int max_elements) {
+	this->max_elements = max_elements;
+	return true;
+}
+
+/////////////
+// Writing //
+/////////////
+
+int SVGWriter::Write(const char* filename, GlobalMeshData* global_mesh_data) {
+	if(width <= 0.0 || height <= 0.0) {
+		printf("Error: the svg size must be positive\n");
+		return false;
+	}
+
+	if(compute_transform() == false)
+		return false;
+
+	//Mark the sub-pixel triangles first, so their merged runs count towards the budget
+	unsigned int element_count = 0;
+
+	if(max_elements > 0 || merge_subpixel_triangles == true) {
+		for(unsigned int i=1; i<global_mesh_data->GetTriangleCount(); i++) {
+			Triangle* tri = global_mesh_data->GetTriangle(i);
+			if(tri == NULL)
+				continue;
+
+			int triangle_class = classify_triangle(tri);
+
+			if(triangle_class == SVGWriter::SUBPIXEL_TRIANGLE)
+				mark_subpixel_triangle(tri);
+
+			else if(triangle_class == SVGWriter::DRAWN_TRIANGLE)
+				element_count++;
+		}
+	}
+
+	//Work out how sparsely the triangles, runs and vertices need to be sampled to meet the budget
+	unsigned int stride = 1;
+
+	if(max_elements > 0) {
+		if(merge_subpixel_triangles == true)
+			element_count += count_subpixel_runs();
+
+		if(draw_vertices == true) {
+			for(unsigned int i=1; i<global_mesh_data->GetVertexCount(); i++) {
+				if(test_vertex_visible(global_mesh_data->GetVertex(i)) == true)
+					element_count++;
+			}
+		}
+
+		if(element_count > max_elements)
+			stride = (element_count + max_elements - 1) / max_elements;
+	}
+
+	BufferedWriter writer;
+	if(writer.Open(filename) == false)
+		return false;
+
+	//Create the svg tag
+	writer.WriteString("<svg viewBox=\"0 0 ");
+	writer.WriteDouble(width);
+	writer.WriteChar(' ');
+	writer.WriteDouble(height);
+	writer.WriteString("\" version=\"1.1\" xmlns=\"http://www.w3.org/2000/svg\">\n");
+
+	//Create a rectangle
+	writer.WriteString("<rect");
+	writer.WriteAttribute("width", width);
+	writer.WriteAttribute("height", height);
+	writer.WriteString(" fill=\"white\"/>\n");
+
+	//Draw the triangles, the style is shared by the whole group
+	writer.WriteString("<g fill=\"green\" stroke=\"black\" stroke-width=\"2\" style=\"fill-opacity:0.5\">\n");
+
+	unsigned int drawn_count = 0;
+	for(unsigned int i=1; i<global_mesh_data->GetTriangleCount(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		//The sub-pixel triangles are in the bitmap already
+		if(classify_triangle(tri) != SVGWriter::DRAWN_TRIANGLE || (drawn_count++ % stride) != 0)
+			continue;
+
+		writer.WriteString("<polygon points=\"");
+		for(int j=0; j<3; j++) {
+			Vector2d* pt = tri->GetVertex(j);
+
+			if(j > 0)
+				writer.WriteChar(' ');
+
+			writer.WriteFixed(to_svg_x(pt->x), SVG_WRITER_DECIMALS);
+			writer.WriteChar(',');
+			writer.WriteFixed(to_svg_y(pt->y), SVG_WRITER_DECIMALS);
+		}
+		writer.WriteString("\"/>\n");
+	}
+
+	writer.WriteString("</g>\n");
+
+	//Draw the merged sub-pixel triangles
+	if(merge_subpixel_triangles == true)
+		write_subpixel_runs(&writer, stride);
+
+	//Draw the vertices
+	if(draw_vertices == true) {
+		writer.WriteString("<g fill=\"blue\">\n");
+
+		unsigned int vertex_count = 0;
+		for(unsigned int i=1; i<global_mesh_data->GetVertexCount(); i++) {
+			Vector2d* pt = global_mesh_data->GetVertex(i);
+			if(test_vertex_visible(pt) == false || (vertex_count++ % stride) != 0)
+				continue;
+
+			writer.WriteString("<circle cx=\"");
+			writer.WriteFixed(to_svg_x(pt->x), SVG_WRITER_DECIMALS);
+			writer.WriteString("\" cy=\"");
+			writer.WriteFixed(to_svg_y(pt->y), SVG_WRITER_DECIMALS);
+			writer.WriteString("\" r=\"1\"/>\n");
+		}
+
+		writer.WriteString("</g>\n");
+	}
+
+	writer.WriteString("</svg>\n");
+
+	//The bitmap is only needed while writing
+	vector<unsigned char>().swap(bitmap);
+
+	if(writer.Close() == false) {
+		printf("Error writing the svg file %s\n", filename);
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//Work out the mapping from mesh coordinates to svg units
+int SVGWriter::compute_transform() {
+	//Without a viewport the mesh coordinates are the svg units
+	if(use_viewport == false) {
+		view_min = Vector2d(0.0, 0.0);
+		view_max = Vector2d(width, height);
+	}
+	else {
+		view_min = viewport.GetMin();
+		view_max = viewport.GetMax();
+	}
+
+	scale_x = width / (view_max.x - view_min.x);
+	scale_y = height / (view_max.y - view_min.y);
+
+	//Size the occupancy bitmap, very large view boxes get cells bigger than a pixel
+	bitmap.clear();
+	bitmap_width = 0;
+	bitmap_height = 0;
+	cell_size = 1.0;
+
+	if(merge_subpixel_triangles == false)
+		return true;
+
+	double largest_side = (width > height ? width : height);
+	if(largest_side > SVG_WRITER_MAX_BITMAP_SIZE)
+		cell_size = largest_side / SVG_WRITER_MAX_BITMAP_SIZE;
+
+	bitmap_width = (unsigned int) ceil(width / cell_size);
+	bitmap_height = (unsigned int) ceil(height / cell_size);
+
+	bitmap.assign((size_t(bitmap_width)*bitmap_height + 7) / 8, 0);
+
+	return true;
+}
+
+//Sort a triangle into one of the classes below
+int SVGWriter::classify_triangle(Triangle* tri) {
+	Vector2d* v0 = tri->GetVertex(0);
+	Vector2d* v1 = tri->GetVertex(1);
+	Vector2d* v2 = tri->GetVertex(2);
+
+	if(v0 == NULL || v1 == NULL || v2 == NULL)
+		return SVGWriter::CULLED_TRIANGLE;
+
+	//The bounding box in svg units
+	double x0 = to_svg_x(v0->x), x1 = to_svg_x(v1->x), x2 = to_svg_x(v2->x);
+	double y0 = to_svg_y(v0->y), y1 = to_svg_y(v1->y), y2 = to_svg_y(v2->y);
+
+	double xmin = min(x0, min(x1, x2));
+	double xmax = max(x0, max(x1, x2));
+	double ymin = min(y0, min(y1, y2));
+	double ymax = max(y0, max(y1, y2));
+
+	if(xmax < 0.0 || xmin > width || ymax < 0.0 || ymin > height)
+		return SVGWriter::CULLED_TRIANGLE;
+
+	if(merge_subpixel_triangles == true && xmax - xmin < cell_size && ymax - ymin < cell_size)
+		return SVGWriter::SUBPIXEL_TRIANGLE;
+
+	return SVGWriter::DRAWN_TRIANGLE;
+}
+
+int SVGWriter::test_vertex_visible(Vector2d* pt) {
+	if(pt == NULL)
+		return false;
+
+	double x = to_svg_x(pt->x);
+	double y = to_svg_y(pt->y);
+
+	return (x >= 0.0 && x <= width && y >= 0.0 && y <= height);
+}
+
+//Mark the bitmap cell under a sub-pixel triangle
+int SVGWriter::mark_subpixel_triangle(Triangle* tri) {
+	Vector2d* v0 = tri->GetVertex(0);
+	Vector2d* v1 = tri->GetVertex(1);
+	Vector2d* v2 = tri->GetVertex(2);
+
+	double cx = to_svg_x((v0->x + v1->x + v2->x) / 3.0) / cell_size;
+	double cy = to_svg_y((v0->y + v1->y + v2->y) / 3.0) / cell_size;
+
+	if(cx < 0.0 || cy < 0.0 || cx >= bitmap_width || cy >= bitmap_height)
+		return false;
+
+	size_t bit = size_t(cy)*bitmap_width + size_t(cx);
+	bitmap[bit >> 3] |= (unsigned char) (1 << (bit & 7));
+
+	return true;
+}
+
+//The number of horizontal runs of marked bitmap cells
+unsigned int SVGWriter::count_subpixel_runs() {
+	unsigned int run_count = 0;
+
+	for(unsigned int row=0; row<bitmap_height; row++) {
+		size_t row_start = size_t(row)*bitmap_width;
+
+		//A run starts at every marked cell without a marked cell on its left
+		int last_marked = false;
+		for(unsigned int column=0; column<bitmap_width; column++) {
+			size_t bit = row_start + column;
+			int marked = ((bitmap[bit >> 3] & (1 << (bit & 7))) != 0);
+
+			if(marked == true && last_marked == false)
+				run_count++;
+
+			last_marked = marked;
+		}
+	}
+
+	return run_count;
+}
+
+//Write the marked bitmap cells as horizontal runs, only every stride-th run
+int SVGWriter::write_subpixel_runs(BufferedWriter* writer, unsigned int stride) {
+	writer->WriteString("<g fill=\"green\" style=\"fill-opacity:0.5\">\n");
+
+	unsigned int run_count = 0;
+
+	for(unsigned int row=0; row<bitmap_height; row++) {
+		size_t row_start = size_t(row)*bitmap_width;
+
+		unsigned int column = 0;
+		while(column < bitmap_width) {
+			size_t bit = row_start + column;
+			if((bitmap[bit >> 3] & (1 << (bit & 7))) == 0) {
+				column++;
+				continue;
+			}
+
+			//Find the end of this run
+			unsigned int run_start = column;
+			while(column < bitmap_width) {
+				bit = row_start + column;
+				if((bitmap[bit >> 3] & (1 << (bit & 7))) == 0)
+					break;
+
+				column++;
+			}
+
+			if((run_count++ % stride) != 0)
+				continue;
+
+			writer->WriteString("<rect");
+			writer->WriteAttribute("x", double(run_start)*cell_size);
+			writer->WriteAttribute("y", double(row)*cell_size);
+			writer->WriteAttribute("width", double(column - run_start)*cell_size);
+			writer->WriteAttribute("height", cell_size);
+			writer->WriteString("/>\n");
+		}
+	}
+
+	writer->WriteString("</g>\n");
+	return writer->IsGood();
+}
+
+//Mesh to svg coordinates
+double SVGWriter::to_svg_x(double x) {
+	return (x - view_min.x) * scale_x;
+}
+
+double SVGWriter::to_svg_y(double y) {
+	return height - (y - view_min.y) * scale_y;
+}
@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <vector>
+using namespace std;
+
+//Triangulation algorithm related code
+#include "utility.h"
+#include "vector2d.h"
+#include "prism.h"
+
+//Mesh data code
+#include "global_mesh_data.h"
+
+//Streaming output code
+#include "buffered_writer.h"
+
+#ifndef SVG_WRITER
+#define SVG_WRITER
+
+//The largest sub-pixel occupancy bitmap, per side
+#define SVG_WRITER_MAX_BITMAP_SIZE	4096
+
+//Writes an svg preview of a mesh straight to a file
+// + nothing is held in memory except the sub-pixel occupancy bitmap
+// + by default the mesh coordinates are used directly as svg units, like the old dom writer
+class SVGWriter {
+public:
+	SVGWriter();
+	~SVGWriter();
+
+	/////////////
+	// Options //
+	/////////////
+
+	//The size of the svg view box
+	int SetSize(double width, double height);
+
+	//Only draw what overlaps the viewport, the viewport is stretched over the whole view box
+	int SetViewport(Prism viewport);
+	int ClearViewport();
+
+	//Triangles smaller than a pixel are merged into runs of filled pixels
+	int SetMergeSubpixelTriangles(int merge_subpixel_triangles);
+
+	//Draw a circle for every vertex
+	int SetDrawVertices(int draw_vertices);
+
+	//Sample the triangles, merged sub-pixel runs and vertices so that roughly this many elements are written, 0 is
+	//no limit
+	int SetElementBudget(unsigned int max_elements);
+
+	/////////////
+	// Writing //
+	/////////////
+
+	int Write(const char* filename, GlobalMeshData* global_mesh_data);
+
+private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//Work out the mapping from mesh coordinates to svg units
+	int compute_transform();
+
+	//Sort a triangle into one of the classes below
+	int classify_triangle(Triangle* tri);
+	enum {
+		CULLED_TRIANGLE=0,
+		SUBPIXEL_TRIANGLE,
+		DRAWN_TRIANGLE
+	};
+
+	int test_vertex_visible(Vector2d* pt);
+
+	//Mark the bitmap cell under a sub-pixel triangle
+	int mark_subpixel_triangle(Triangle* tri);
+
+	//The number of horizontal runs of marked bitmap cells
+	unsigned int count_subpixel_runs();
+
+	//Write the marked bitmap cells as horizontal runs, only every stride-th run
+	int write_subpixel_runs(BufferedWriter* writer, unsigned int stride);
+
+	//Mesh to svg coordinates
+	double to_svg_x(double x);
+	double to_svg_y(double y);
+
+	//Options
+	double width, height;
+
+	int use_viewport;
+	Prism viewport;
+
+	int merge_subpixel_triangles;
+	int draw_vertices;
+	unsigned int max_elements;
+
+	//The transform
+	Vector2d view_min, view_max;
+	double scale_x, scale_y;
+
+	//The sub-pixel occupancy bitmap, one bit per cell
+	vector<unsigned char> bitmap;
+	unsigned int bitmap_width, bitmap_height;
+	double cell_size;
+};
+
+#endif
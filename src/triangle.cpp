@@ -69,8 +69,28 @@ Triangle::Triangle(VertexList* global_vertex_list) {
 	triangle_index = 0;
 
 	//Establish the local index
-	global_triangle_count++;
-	local_index = global_triangle_count;
+	// + triangles get created on several threads at once, by the kd-tree mesher and by batch jobs
+	local_index = __sync_add_and_fetch(&global_triangle_count, 1);
+}
+
+//Copy the vertices and local index of another triangle, without counting it as a new triangle
+// + the adjacencies are left for the caller to fill in
+Triangle::Triangle(VertexList* global_vertex_list, Triangle* tri) {
+	this->global_vertex_list = global_vertex_list;
+
+	vertices[0] = tri->vertices[0];
+	vertices[1] = tri->vertices[1];
+	vertices[2] = tri->vertices[2];
+
+	adjacent_triangles[0] = NULL;
+	adjacent_triangles[1] = NULL;
+	adjacent_triangles[2] = NULL;
+
+	circumcenter = NULL;
+	circumradius = 0.0;
+
+	triangle_index = 0;
+	local_index = tri->local_index;
 }
 
 Triangle::~Triangle() {
@@ -347,8 +367,10 @@ unsigned int Triangle::GetLocalIndex() {
 int Triangle::SetLocalIndex(unsigned int local_index) {
 	this->local_index = local_index;
 
-	if(local_index >= global_triangle_count)
-		global_triangle_count = local_index;
+	//Raise the global count to at least local_index
+	unsigned int count = global_triangle_count;
+	while(local_index > count && __sync_bool_compare_and_swap(&global_triangle_count, count, local_index) == false)
+		count = global_triangle_count;
 
 	return true;
 }
@@ -730,6 +752,17 @@ int Triangle::GetCircumcircle(Vector2d& center, double& radius) {
 	return true;
 }
 
+int Triangle::ResetCircumcircle() {
+	if(circumcenter != NULL) {
+		delete circumcenter;
+		circumcenter = NULL;
+
+		circumradius = 0.0;
+	}
+
+	return true;
+}
+
 int Triangle::GetCentroid(Vector2d& centroid) {
 	centroid.x = 0.0;
 	centroid.y = 0.0;
@@ -1187,12 +1220,13 @@ int Triangle::SubdivideAlongEdge(int opposing_vertex, vector<double> lambda, vec
 		}
 		results.push_back(new_tri);
 
+		//These triangles run the other way around, so the neighbours along the edge are across from the other vertices
 		for(unsigned int i=lambda.size()+1; i<2*(lambda.size()+1); i++) {
 			if(i < 2*lambda.size()+1)
-				results[i]->SetAdjacentTriangle(1, results[i+1]);
+				results[i]->SetAdjacentTriangle(2, results[i+1]);
 
 			if(i > lambda.size()+1)
-				results[i]->SetAdjacentTriangle(2, results[i-1]);
+				results[i]->SetAdjacentTriangle(1, results[i-1]);
 
 			results[i]->SetAdjacentTriangle(0, results[i - (lambda.size()+1)]);
 			results[i - (lambda.size()+1)]->SetAdjacentTriangle(0, results[i]);
@@ -1212,7 +1246,7 @@ int Triangle::SubdivideAlongEdge(int opposing_vertex, vector<double> lambda, vec
 		}
 		for(int i=0; i<3; i++) {
 			if(GetAdjacentTriangle(i) != adj_tri)
-				adj_tri->SetAdjacentTriangle(i, NULL);
+				SetAdjacentTriangle(i, NULL);
 		}
 	}
 	else {
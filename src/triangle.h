@@ -18,6 +18,11 @@ int TestLineSegmentOverlap(Vector2d v1, Vector2d v2, Vector2d w1, Vector2d w2);
 class Triangle {
 public:
 	Triangle(VertexList* global_vertex_list);
+
+	//Copy the vertices and local index of another triangle, without counting it as a new triangle
+	// + the adjacencies are left for the caller to fill in
+	Triangle(VertexList* global_vertex_list, Triangle* tri);
+
 	~Triangle();
 
 	/////////////////////
@@ -94,6 +99,9 @@ public:
 	//Get the circumcircle of this triangle
 	int GetCircumcircle(Vector2d& center, double& radius);
 
+	//Forget the cached circumcircle, after a vertex of this triangle has been moved
+	int ResetCircumcircle();
+
 	//Get the centroid of this triangle
 	int GetCentroid(Vector2d& centroid);
 
@@ -363,6 +363,15 @@ int TriangleComplex::AppendTriangleIndex(unsigned int tindex) {
 	return true;
 }
 
+//Append a run of consecutive global indices
+int TriangleComplex::AppendTriangleIndices(unsigned int first_tindex, unsigned int count) {
+	triangle_list.reserve(triangle_list.size() + count);
+	for(unsigned int i=0; i<count; i++)
+		triangle_list.push_back(first_tindex + i);
+
+	return true;
+}
+
 int TriangleComplex::AppendAllTriangleIndices() {
 	//First remove all triangles from this complex
 	RemoveAllTriangles();
@@ -384,6 +393,8 @@ int TriangleComplex::SetTriangle(unsigned int tindex, Triangle* tri) {
 unsigned int TriangleComplex::AppendTriangle(Triangle* tri) {
 	unsigned int tindex = global_mesh_data->AppendTriangle(tri);
 	AppendTriangleIndex(tindex);
+
+	return tindex;
 }
 
 int TriangleComplex::RemoveTriangle(unsigned int triangle) {
@@ -448,6 +459,15 @@ int TriangleComplex::AppendVertexIndex(unsigned int vindex) {
 	return true;
 }
 
+//Append a run of consecutive global indices
+int TriangleComplex::AppendVertexIndices(unsigned int first_vindex, unsigned int count) {
+	vertex_list.reserve(vertex_list.size() + count);
+	for(unsigned int i=0; i<count; i++)
+		vertex_list.push_back(first_vindex + i);
+
+	return true;
+}
+
 int TriangleComplex::AppendAllVertexIndices() {
 	//First remove all the vertices from this complex
 	RemoveAllVertices();
@@ -563,6 +583,29 @@ int TriangleComplex::GenerateHexGrid(double xmin, double xmax, double ymin, doub
 	return true;
 }
 
+//Load a large point cloud straight into one vertex block
+int TriangleComplex::LoadPointsFromFile(const char* filename, int point_format) {
+	PointCloudFile point_cloud_file;
+	if(point_cloud_file.Open(filename, point_format) == false)
+		return false;
+
+	unsigned int point_count = point_cloud_file.GetPointCount();
+	if(point_count == 0) {
+		printf("Error: no points were found in %s\n", filename);
+		return false;
+	}
+
+	unsigned int first_vindex = 0;
+	Vector2d* points = global_mesh_data->AllocateVertexBlock(point_count, first_vindex);
+
+	if(point_cloud_file.ReadPoints(points) == false) {
+		global_mesh_data->FreeVertexBlock(points);
+		return false;
+	}
+
+	return AppendVertexIndices(first_vindex, point_count);
+}
+
 vector<unsigned int> TriangleComplex::GetIncompleteVertices() {
 	return incomplete_vertices;
 }
@@ -579,93 +622,24 @@ int TriangleComplex::SetIncompleteListsComputed(int incomplete_lists_computed) {
 
 //Meshing functions
 int TriangleComplex::RunTriangleMesher() {
+	return RunTriangleMesher(NULL, 0);
+}
+
+int TriangleComplex::RunTriangleMesher(const char* checkpoint_filename, unsigned int checkpoint_interval) {
 	//If this is the kd_parent
 	//if(kd_parent == NULL && global_vertex_list->size() >= MAXIMUM_MESH_SIZE) {
 	if(kd_parent == NULL && GetVertexCount() >= MAXIMUM_MESH_SIZE) {
-		//Keep track of the number of runs
-		char filename[1000];
-		int run_count = 0;
-
 		printf("MESHING THE PARENT NODE!!\n");
-		if(CreateKDTree() == false)
-			return false;
-
-		printf("DONE FOREVER WITH CREATING THE KD-TREE\n\n");
-
-		while(kd_leaf_nodes->size() > 1) {
-			//Mesh all the leaf nodes
-
-			#pragma omp parallel for
-			for(int i=0; i<kd_leaf_nodes->size(); i++) {
-				printf("Starting to mesh leaf node %u\n", i);
-				(*kd_leaf_nodes)[i]->RunTriangleMesher();
-
-				printf("Done meshing leaf node %u\n\n", i);
-			}
 
-			//Write an output file
-			//sprintf(filename, "out%d.svg", run_count++);
-			//write_svg(filename, 1000, 1000);
-
-			//Combine sibling leaf-nodes
-			vector<TriangleComplex*> new_kd_leaf_nodes;
-			new_kd_leaf_nodes.clear();
-
-			printf("Starting with %u kd leaf nodes\n", kd_leaf_nodes->size());
-			int done = false;
-			while(kd_leaf_nodes->size() > 1) {
-				TriangleComplex* tc_parent = (*kd_leaf_nodes)[0]->GetKDParent();
-
-				//Safety check
-				if(tc_parent == NULL) {
-					printf("OH NOES\n");
-					return false;
-				}
-
-				//Combine the children to create a new leaf node
-				// + This will delete the children from kd_leaf_nodes
-				if(tc_parent->CombineChildren() == false) {
-					printf("No children!!\n");
-					new_kd_leaf_nodes.push_back((*kd_leaf_nodes)[0]);
-					kd_leaf_nodes->erase(kd_leaf_nodes->begin());
-
-					//printf("FAILED TO COMBINE CHILDREN: %u\n", kd_leaf_nodes->size());
-					//return false;
-				}
-				else
-					new_kd_leaf_nodes.push_back(tc_parent);
-			}
-			if(done == true)
-				break;
-
-			*kd_leaf_nodes = new_kd_leaf_nodes;
-			printf("KD LEAF NODE COUNT: %u\n", kd_leaf_nodes->size());
-
-			//Write an output file
-			//sprintf(filename, "out%d.svg", run_count++);
-			//write_svg(filename, 1000, 1000);
-		}
-
-		CombineChildren();
-
-		if(basic_triangle_mesher() == false)
-			return false;
-
-		if(basic_delaunay_flipper() == false)
+		double start_time = MesherProfiler::GetWallTime();
+		if(CreateKDTree() == false)
 			return false;
 
-		//Clean up the mesh
-		//if(basic_mesh_cleaner() == false)
-		//	return false;
+		MesherProfiler::AddPhaseTime("create_kd_tree", MesherProfiler::GetWallTime() - start_time);
 
-		//Reset the local indices of all triangles
-		unsigned int index = 1;
-		for(unsigned int i=0; i<GetTriangleCount(); i++) {
-			Triangle* tri = GetTriangle(i);
+		printf("DONE FOREVER WITH CREATING THE KD-TREE\n\n");
 
-			if(tri != NULL)
-				tri->SetLocalIndex(index++);
-		}
+		return run_kd_tree_levels(0, checkpoint_filename, checkpoint_interval);
 	}
 
 	//Otherwise
@@ -695,13 +669,59 @@ int TriangleComplex::RunTriangleMesher() {
 	return true;
 }
 
+//Pick a kd-tree meshing run back up from a checkpoint
+int TriangleComplex::ResumeTriangleMesher(const char* checkpoint_filename, unsigned int checkpoint_interval) {
+	unsigned int level = 0;
+	if(LoadKDCheckpoint(checkpoint_filename, level) == false)
+		return false;
+
+	printf("Resuming the kd-tree mesher at level %u with %u leaf nodes\n", level, (unsigned int) kd_leaf_nodes->size());
+
+	return run_kd_tree_levels(level, checkpoint_filename, checkpoint_interval);
+}
+
+//Stream triangles out as soon as they are final during kd-tree meshing, and free them
+int TriangleComplex::SetMeshStreamWriter(MeshStreamWriter* mesh_stream_writer) {
+	this->mesh_stream_writer = mesh_stream_writer;
+
+	return true;
+}
+
 int TriangleComplex::RunDelaunayFlips() {
-	if(basic_delaunay_flipper() == false)
+	return RunDelaunayFlips(DELAUNAY_MAXIMUM_PASS_COUNT);
+}
+
+int TriangleComplex::RunDelaunayFlips(unsigned int maximum_pass_count) {
+	//The vertices may have moved since the circumcircles were cached
+	long triangle_count = triangle_list.size();
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<triangle_count; i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		Vector2d center;
+		double radius;
+
+		tri->ResetCircumcircle();
+		tri->GetCircumcircle(center, radius);
+	}
+
+	if(omp_get_max_threads() > 1 && triangle_count >= PARALLEL_FLIPPER_MIN_TRIANGLES) {
+		if(parallel_delaunay_flipper(maximum_pass_count) == false)
+			return false;
+	}
+	else if(basic_delaunay_flipper(maximum_pass_count) == false)
 		return false;
 
 	return true;
 }
 
+unsigned int TriangleComplex::GetDelaunayFlipCount() {
+	return delaunay_flip_count;
+}
+
 int TriangleComplex::BasicTriangleMesher() {
 	if(basic_triangle_mesher() == false)
 		return false;
@@ -710,13 +730,10 @@ int TriangleComplex::BasicTriangleMesher() {
 }
 
 int TriangleComplex::SubdivideTriangle(unsigned int vindex, unsigned int triangle_local_index) {
-	int found = false;
 	for(unsigned int i=0; i<GetTriangleCount(); i++) {
 		Triangle* tri = GetTriangle(i);
 
 		if(tri != NULL && tri->GetLocalIndex() == triangle_local_index) {
-			found = true;
-
 			//Try to subdivide this triangle
 			vector<Triangle*> results;
 
@@ -735,24 +752,21 @@ int TriangleComplex::SubdivideTriangle(unsigned int vindex, unsigned int triangl
 				AppendVertexIndex(vindex);
 
 			//And replace this triangle with its subdivision
-			DeleteTriangle(i);
-			AppendTriangle(results[0]);
-			AppendTriangle(results[1]);
-			AppendTriangle(results[2]);
+			replace_triangles(tri, NULL, results);
+			local_delaunay_flipper(results);
+
+			return true;
 		}
 	}
 
-	return found;
+	return false;
 }
 
 int TriangleComplex::BarycentricSubdivide(unsigned int triangle_local_index) {
-	int found = false;
 	for(unsigned int i=0; i<GetTriangleCount(); i++) {
 		Triangle* tri = GetTriangle(i);
 
 		if(tri != NULL && tri->GetLocalIndex() == triangle_local_index) {
-			found = true;
-
 			//Try to barycentric subdivide this triangle
 			unsigned int centroid_vindex = 0;
 			vector<Triangle*> results;
@@ -764,18 +778,22 @@ int TriangleComplex::BarycentricSubdivide(unsigned int triangle_local_index) {
 			AppendVertexIndex(centroid_vindex);
 
 			//And replace this triangle with its subdivision
-			DeleteTriangle(i);
-			AppendTriangle(results[0]);
-			AppendTriangle(results[1]);
-			AppendTriangle(results[2]);
+			replace_triangles(tri, NULL, results);
+			local_delaunay_flipper(results);
+
+			return true;
 		}
 	}
 
-	return found;
+	return false;
 }
 
 int TriangleComplex::StretchedGridMethod(unsigned int iterations, double alpha) {
-	if(force_stretched_grid_method(iterations, alpha) == false)
+	return StretchedGridMethod(iterations, alpha, 0.0, 0.0);
+}
+
+int TriangleComplex::StretchedGridMethod(unsigned int iterations, double alpha, double damping, double tolerance) {
+	if(force_stretched_grid_method(iterations, alpha, damping, tolerance) == false)
 		return false;
 
 	//if(basic_stretched_grid_method(iterations, alpha) == false)
@@ -784,6 +802,13 @@ int TriangleComplex::StretchedGridMethod(unsigned int iterations, double alpha)
 	return true;
 }
 
+int TriangleComplex::LaplacianStretchedGridMethod(unsigned int iterations, double alpha) {
+	if(basic_stretched_grid_method(iterations, alpha) == false)
+		return false;
+
+	return true;
+}
+
 int TriangleComplex::AdjustCellEdgeLength(double desired_edge_length) {
 	unsigned int edge_count;
 	double current_cell_edge_length = 0.0;
@@ -815,6 +840,110 @@ int TriangleComplex::AdjustCellEdgeLength(double desired_edge_length) {
 }
 
 
+//Refine the mesh until no triangle has an angle under minimum_angle (in degrees) or is bigger than an
+//equilateral triangle with the desired edge length, 0 turns either criterion off
+int TriangleComplex::QualityRefine(double desired_edge_length, double minimum_angle) {
+	return QualityRefine(desired_edge_length, minimum_angle, NULL);
+}
+
+//The same, with a desired edge length that changes over the mesh
+int TriangleComplex::QualityRefine(double desired_edge_length, double minimum_angle, SizingFunction* sizing_function) {
+	printf("RUNNING QUALITY MESH REFINEMENT %f %f\n", desired_edge_length, minimum_angle);
+
+	double start_time = MesherProfiler::GetWallTime();
+
+	DelaunayRefiner delaunay_refiner(global_mesh_data);
+	if(delaunay_refiner.SetDesiredEdgeLength(desired_edge_length) == false || delaunay_refiner.SetMinimumAngle(minimum_angle) == false) {
+		printf("Error: bad refinement options\n");
+		return false;
+	}
+
+	delaunay_refiner.SetSizingFunction(sizing_function);
+
+	//One strip per thread
+	int ret = delaunay_refiner.RefinePartitioned(triangle_list, vertex_list, omp_get_max_threads());
+
+	MesherProfiler::AddPhaseTime("delaunay_refine", MesherProfiler::GetWallTime() - start_time);
+
+	printf("\n");
+	return ret;
+}
+
+//Split every triangle 1-to-4 through its edge midpoints, levels times
+int TriangleComplex::UniformRefine(unsigned int levels, Prism* prism) {
+	printf("RUNNING UNIFORM MESH REFINEMENT %u\n", levels);
+
+	double start_time = MesherProfiler::GetWallTime();
+
+	for(unsigned int i=0; i<levels; i++) {
+		if(uniform_refine_level(prism) == false)
+			return false;
+	}
+
+	MesherProfiler::AddPhaseTime("uniform_refine", MesherProfiler::GetWallTime() - start_time);
+
+	printf("\n");
+	return true;
+}
+
+//Split every triangle 1-to-4 until the average edge length is down to the desired edge length
+int TriangleComplex::UniformRefine(double desired_edge_length) {
+	printf("RUNNING UNIFORM MESH REFINEMENT %f\n", desired_edge_length);
+
+	//Every edge is counted once, by the triangle with the lower index, without building the edge list
+	unsigned int edge_count = 0;
+	double total_edge_length = 0.0;
+
+	for(unsigned int i=0; i<GetTriangleCount(); i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			Triangle* adj_tri = tri->GetAdjacentTriangle(j);
+
+			if(adj_tri == NULL || tri->GetTriangleIndex() < adj_tri->GetTriangleIndex()) {
+				total_edge_length += tri->ComputeEdgeLength(j);
+				edge_count++;
+			}
+		}
+	}
+
+	if(edge_count == 0)
+		return false;
+
+	double average_edge_length = total_edge_length / double(edge_count);
+
+	double start_time = MesherProfiler::GetWallTime();
+
+	int ret = barycentric_subdivion(desired_edge_length, average_edge_length);
+
+	MesherProfiler::AddPhaseTime("uniform_refine", MesherProfiler::GetWallTime() - start_time);
+
+	printf("Cell edge length: %f\n\n", average_edge_length);
+	return ret;
+}
+
+//Collapse edges shorter than the desired edge length, shortest first
+int TriangleComplex::CoarsenMesh(double desired_edge_length, unsigned int target_triangle_count) {
+	printf("RUNNING MESH COARSENING %f %u\n", desired_edge_length, target_triangle_count);
+
+	double start_time = MesherProfiler::GetWallTime();
+
+	MeshCoarsener mesh_coarsener(global_mesh_data);
+	if(mesh_coarsener.SetDesiredEdgeLength(desired_edge_length) == false || mesh_coarsener.SetTargetTriangleCount(target_triangle_count) == false) {
+		printf("Error: bad coarsening options\n");
+		return false;
+	}
+
+	int ret = mesh_coarsener.Coarsen(triangle_list, vertex_list);
+
+	MesherProfiler::AddPhaseTime("coarsen", MesherProfiler::GetWallTime() - start_time);
+
+	printf("\n");
+	return ret;
+}
+
 /////////////////////////////
 // Mesh Geometry functions //
 /////////////////////////////
@@ -863,32 +992,19 @@ int TriangleComplex::GetEdges(vector<Edge*> &result) {
 			tri->GetOpposingEdge(e, j);
 
 			//Make sure this is a good edge
-			if(e->IsGoodEdge() == false)
+			if(e->IsGoodEdge() == false) {
+				delete e;
 				continue;
-
-			//Look through the results to put it in the right spot
-			int inserted = false;
-			for(unsigned int k=0; k<result.size(); k++) {
-				//If the edge is in the list already, skip it
-				if((*result[k]) == (*e)) {
-					delete e;
-					inserted = true;
-					break;
-				}
-
-				//We have found the right insertion point
-				if((*e) < (*result[k])) {
-					result.insert(result.begin() + k, e);
-					inserted = true;
-					break;
-				}
 			}
-			//If the edge was not found already and has yet to be inserted, put it at the end of the list
-			if(inserted == false)
-				result.push_back(e);
+
+			result.push_back(e);
 		}
 	}
 
+	//Sort the edges and drop the second copy of every edge between two triangles
+	if(sort_edge_list(result) == false)
+		return false;
+
 	return true;
 }
 
@@ -906,40 +1022,26 @@ int TriangleComplex::GetEdgesInsidePrism(vector<Edge*> &result, Prism p) {
 			tri->GetOpposingEdge(e, j);
 
 			//Make sure this is a good edge
-			if(e->IsGoodEdge() == false)
+			if(e->IsGoodEdge() == false) {
+				delete e;
 				continue;
+			}
 
 			Vector2d* p1 = e->GetVertex(0);
 			Vector2d* p2 = e->GetVertex(1);
-			if(p1 == NULL || p2 == NULL)
-				continue;
-
-			if(prism_line_segment_intersection_closed(p, *p1, *p2) == false)
+			if(p1 == NULL || p2 == NULL || prism_line_segment_intersection_closed(p, *p1, *p2) == false) {
+				delete e;
 				continue;
-
-			//Look through the results to put it in the right spot
-			int inserted = false;
-			for(unsigned int k=0; k<result.size(); k++) {
-				//If the edge is in the list already, skip it
-				if((*result[k]) == (*e)) {
-					delete e;
-					inserted = true;
-					break;
-				}
-
-				//We have found the right insertion point
-				if((*e) < (*result[k])) {
-					result.insert(result.begin() + k, e);
-					inserted = true;
-					break;
-				}
 			}
-			//If the edge was not found already and has yet to be inserted, put it at the end of the list
-			if(inserted == false)
-				result.push_back(e);
+
+			result.push_back(e);
 		}
 	}
 
+	//Sort the edges and drop the second copy of every edge between two triangles
+	if(sort_edge_list(result) == false)
+		return false;
+
 	return true;
 }
 
@@ -1177,7 +1279,7 @@ int TriangleComplex::CombineChildren() {
 		return false;
 
 	//Calculate the time spent combining children
-	clock_t start_time = clock();
+	double start_time = MesherProfiler::GetWallTime();
 
 	//Get all the triangles from the children
 	for(unsigned int i=0; i<kd_child[0]->GetTriangleCount(); i++) {
@@ -1204,6 +1306,10 @@ int TriangleComplex::CombineChildren() {
 		//AppendTriangle(tri);
 	}
 
+	//The children split up the vertices of this complex, and may have dropped the ones that were streamed out
+	vertex_list = kd_child[0]->vertex_list;
+	vertex_list.insert(vertex_list.end(), kd_child[1]->vertex_list.begin(), kd_child[1]->vertex_list.end());
+
 	//Get the incomplete vertex lists from the children
 	incomplete_vertices.clear();
 	incomplete_vertices_angles.clear();
@@ -1258,8 +1364,10 @@ int TriangleComplex::CombineChildren() {
 	SetIncompleteListsComputed(true);
 
 	//Calculate the time spent combining children
-	clock_t end_time = clock();
-	printf("Time spent combining children: %fs\n", double(end_time - start_time) / double(CLOCKS_PER_SEC));
+	double elapsed_time = MesherProfiler::GetWallTime() - start_time;
+	MesherProfiler::AddPhaseTime("combine_children", elapsed_time);
+
+	printf("Time spent combining children: %fs\n", elapsed_time);
 
 	return true;
 }
@@ -1321,100 +1429,362 @@ int TriangleComplex::IsBridgeTriangleIndex(unsigned int local_index) {
 	return false;
 }
 
-
-//Debugging functions
-/*int TriangleComplex::write_svg(const char* filename, double w, double h) {
-	//Simple error check
-	//if(global_vertex_list->size() <= 1)
-	//	return false;
-
-	//Open the file for writing
-	FILE* handle = fopen(filename, "w");
-	if(!handle)
+//Write the whole kd-tree and the global mesh to a checkpoint file
+// + the file is written next to the old one and renamed over it, so a crash never leaves a partial checkpoint
+int TriangleComplex::SaveKDCheckpoint(const char* filename, unsigned int level) {
+	if(kd_parent != NULL || kd_leaf_nodes == NULL)
 		return false;
 
-	//Write a background rectangle
-	fprintf(handle, "<svg viewBox=\"0 0 %f %f\" version=\"1.1\">\n", w, h);
-	fprintf(handle, "<rect x=\"%f\" y=\"%f\" width=\"%f\" height=\"%f\" fill=\"white\"/>\n", 0.0, 0.0, w, h);
+	//Number the nodes in pre-order
+	vector<TriangleComplex*> nodes;
+	vector<int> parents;
+	collect_kd_nodes(nodes, parents, -1);
 
-	//Write all the triangle/vertex data
-	if(write_svg(handle, w, h, true) == false) {
-		fclose(handle);
+	string temp_filename = string(filename) + ".tmp";
+
+	FILE* handle = fopen(temp_filename.c_str(), "wb");
+	if(handle == NULL) {
+		printf("Error opening %s for writing\n", temp_filename.c_str());
 		return false;
 	}
 
-	//Close the file and return
-	fprintf(handle, "</svg>\n");
-	fclose(handle);
-	return true;
-}*/
+	setvbuf(handle, NULL, _IOFBF, 1 << 20);
 
-/*int TriangleComplex::write_svg(FILE* handle, double w, double h, int draw_verts) {
-	//Write the triangles/edges
-	//for(unsigned int i=0; i<triangle_list->size(); i++)
-	//	(*triangle_list)[i]->write_svg(handle, w, h);
-	for(unsigned int i=0; i<GetTriangleCount(); i++) {
-		Triangle* tri = GetTriangle(i);
+	double start_time = MesherProfiler::GetWallTime();
+
+	//The global mesh goes first so the checkpoint is also a binary mesh file
+	int ret = global_mesh_data->SaveToBinaryStream(handle, true);
+
+	KDCheckpointHeader header;
+	memset(&header, 0, sizeof(KDCheckpointHeader));
+
+	memcpy(header.magic, KD_CHECKPOINT_MAGIC, sizeof(header.magic));
+	header.version = KD_CHECKPOINT_VERSION;
+	header.level = level;
+	header.node_count = nodes.size();
+	header.leaf_count = kd_leaf_nodes->size();
+	header.triangle_count = global_mesh_data->GetTriangleCount();
+
+	if(ret == true)
+		ret = (fwrite(&header, sizeof(KDCheckpointHeader), 1, handle) == 1);
+
+	//The local indices aren't part of the binary mesh
+	vector<unsigned int> local_indices(header.triangle_count, 0);
+	for(unsigned int i=1; i<header.triangle_count; i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(i);
 		if(tri != NULL)
-			tri->write_svg(handle, w, h);
+			local_indices[i] = tri->GetLocalIndex();
 	}
 
-	//Write the vertices
-	if(draw_verts == true) {
-		for(unsigned int i=0; i<global_mesh_data->GetVertexCount(); i++) {
-		//for(unsigned int i=0; i<global_vertex_list->size(); i++) {
-			Vector2d* pt = global_mesh_data->GetVertex(i);
-			if(pt == NULL)
-				continue;
+	if(ret == true)
+		ret = write_checkpoint_list(handle, local_indices);
 
-			//double cx = (*global_vertex_list)[i]->x;
-			//double cy = (*global_vertex_list)[i]->y;
-			double cx = pt->x;
-			double cy = pt->y;
-			double r = 1.0;
+	//The nodes
+	for(unsigned int i=0; ret == true && i<nodes.size(); i++) {
+		TriangleComplex* tc = nodes[i];
 
-			fprintf(handle, "<circle cx=\"%f\" cy=\"%f\" r=\"%f\" fill=\"blue\"/>\n", cx, h-cy, r);
-		}
-	}
+		KDCheckpointNode node;
+		memset(&node, 0, sizeof(KDCheckpointNode));
 
-	//Write the kd-tree prism
-	if(kd_prism != NULL)
-		kd_prism->write_svg(handle, w, h);
+		node.parent = parents[i];
+		node.child_slot = (parents[i] >= 0 && nodes[parents[i]]->kd_child[1] == tc ? 1 : 0);
 
-	//If there are kd-children have them write their own triangle/vertex data
-	if(kd_child[0] != NULL) kd_child[0]->write_svg(handle, w, h, false);
-	if(kd_child[1] != NULL) kd_child[1]->write_svg(handle, w, h, false);
+		node.splitting_dimension = tc->kd_splitting_dimension;
+		node.incomplete_lists_computed = tc->incomplete_lists_computed;
 
-	return true;
-}*/
+		node.vertex_count = tc->vertex_list.size();
+		node.triangle_count = tc->triangle_list.size();
+		node.incomplete_count = tc->incomplete_vertices.size();
+		node.bridge_count = tc->kd_bridge_triangles.size();
 
-/*int TriangleComplex::generate_random_vertex_list(int num, double xmin, double xmax) {
-	for(int i=0; i<num; i++) {
-		Vector2d* new_vertex = new Vector2d;
-		new_vertex->set(get_rand(xmin, xmax), get_rand(xmin, xmax));
+		if(tc->kd_prism != NULL) {
+			node.has_prism = true;
 
-		unsigned int vindex = global_mesh_data->AppendVertex(new_vertex);
-		AppendVertexIndex(vindex);
-		//global_vertex_list->push_back(new_vector);
-		//AppendVertexIndex(i+1);
-	}
+			Vector2d min = tc->kd_prism->GetMin();
+			Vector2d max = tc->kd_prism->GetMax();
 
-	return true;
-}*/
+			node.prism_min[0] = min.x;
+			node.prism_min[1] = min.y;
+			node.prism_max[0] = max.x;
+			node.prism_max[1] = max.y;
+		}
 
-//Internal use functions
-int TriangleComplex::initialize() {
-	vertex_list.clear();
-	triangle_list.clear();
+		ret = (fwrite(&node, sizeof(KDCheckpointNode), 1, handle) == 1);
 
-	//triangle_list = new TriangleList;
-	//triangle_list->clear();
+		if(ret == true) ret = write_checkpoint_list(handle, tc->vertex_list);
+		if(ret == true) ret = write_checkpoint_list(handle, tc->triangle_list);
+		if(ret == true) ret = write_checkpoint_list(handle, tc->incomplete_vertices);
 
-	//Clear some lists
-	incomplete_vertices.clear();
-	incomplete_vertices_angles.clear();
+		if(ret == true && node.incomplete_count > 0)
+			ret = (fwrite(&tc->incomplete_vertices_angles[0], sizeof(double), node.incomplete_count, handle) == node.incomplete_count);
 
-	incomplete_lists_computed = false;
+		if(ret == true) ret = write_checkpoint_list(handle, tc->kd_bridge_triangles);
+	}
+
+	//The leaf nodes, by their pre-order ids
+	vector<unsigned int> leaf_ids;
+	for(unsigned int i=0; i<kd_leaf_nodes->size(); i++) {
+		for(unsigned int j=0; j<nodes.size(); j++) {
+			if(nodes[j] == (*kd_leaf_nodes)[i]) {
+				leaf_ids.push_back(j);
+				break;
+			}
+		}
+	}
+
+	if(ret == true)
+		ret = (leaf_ids.size() == kd_leaf_nodes->size() && write_checkpoint_list(handle, leaf_ids));
+
+	if(fclose(handle) != 0)
+		ret = false;
+
+	if(ret == true && rename(temp_filename.c_str(), filename) != 0)
+		ret = false;
+
+	if(ret == false) {
+		remove(temp_filename.c_str());
+		return false;
+	}
+
+	double elapsed_time = MesherProfiler::GetWallTime() - start_time;
+	MesherProfiler::AddPhaseTime("save_kd_checkpoint", elapsed_time);
+
+	printf("Saved checkpoint %s at level %u: %fs\n", filename, level, elapsed_time);
+
+	return true;
+}
+
+//Rebuild the kd-tree and the global mesh from a checkpoint file
+// + this has to be called on the top node, and replaces any mesh and kd-tree it had
+int TriangleComplex::LoadKDCheckpoint(const char* filename, unsigned int& level) {
+	if(kd_parent != NULL)
+		return false;
+
+	BinaryMeshFile binary_mesh_file;
+	if(binary_mesh_file.Open(filename) == false)
+		return false;
+
+	size_t trailing_size = 0;
+	const char* p = binary_mesh_file.GetTrailingData(trailing_size);
+	const char* end = p + trailing_size;
+
+	KDCheckpointHeader header;
+	if(read_checkpoint_data(p, end, &header, sizeof(KDCheckpointHeader)) == false ||
+			memcmp(header.magic, KD_CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 || header.version != KD_CHECKPOINT_VERSION || header.node_count == 0) {
+		printf("Error: %s is not a kd-tree checkpoint\n", filename);
+		return false;
+	}
+
+	//Throw away the current kd-tree and mesh
+	free_kd_tree();
+
+	if(global_mesh_data->LoadFromBinaryFile(&binary_mesh_file, true) == false)
+		return false;
+
+	int ret = true;
+
+	vector<unsigned int> local_indices;
+	ret = read_checkpoint_list(p, end, header.triangle_count, local_indices);
+
+	for(unsigned int i=1; ret == true && i<local_indices.size(); i++) {
+		Triangle* tri = global_mesh_data->GetTriangle(i);
+		if(tri != NULL)
+			tri->SetLocalIndex(local_indices[i]);
+	}
+
+	//Rebuild the nodes, the parents always come before their children
+	if(kd_leaf_nodes == NULL)
+		kd_leaf_nodes = new vector<TriangleComplex*>;
+
+	kd_leaf_nodes->clear();
+
+	vector<TriangleComplex*> nodes;
+
+	for(unsigned int i=0; ret == true && i<header.node_count; i++) {
+		KDCheckpointNode node;
+		if(read_checkpoint_data(p, end, &node, sizeof(KDCheckpointNode)) == false) {
+			ret = false;
+			break;
+		}
+
+		TriangleComplex* tc = this;
+
+		if(i == 0) {
+			if(node.parent != -1) {
+				ret = false;
+				break;
+			}
+
+			if(kd_prism != NULL)
+				delete kd_prism;
+			kd_prism = NULL;
+		}
+		else {
+			if(node.parent < 0 || node.parent >= int(i) || node.child_slot < 0 || node.child_slot > 1 || nodes[node.parent]->kd_child[node.child_slot] != NULL) {
+				ret = false;
+				break;
+			}
+
+			TriangleComplex* tc_parent = nodes[node.parent];
+
+			tc = new TriangleComplex(global_mesh_data);
+			tc_parent->kd_child[node.child_slot] = tc;
+
+			tc->SetKDParent(tc_parent);
+			tc->SetKDTreePrisms(kd_tree_prisms);
+		}
+
+		nodes.push_back(tc);
+
+		tc->SetKDLeafNodes(kd_leaf_nodes);
+		tc->SetKDSplittingDimension(node.splitting_dimension);
+		tc->SetIncompleteListsComputed(node.incomplete_lists_computed);
+
+		if(node.has_prism) {
+			Prism* prism = new Prism;
+			prism->SetMinMax(Vector2d(node.prism_min[0], node.prism_min[1]), Vector2d(node.prism_max[0], node.prism_max[1]));
+
+			tc->SetKDPrism(prism);
+		}
+
+		ret = read_checkpoint_list(p, end, node.vertex_count, tc->vertex_list);
+
+		if(ret == true) ret = read_checkpoint_list(p, end, node.triangle_count, tc->triangle_list);
+		if(ret == true) ret = read_checkpoint_list(p, end, node.incomplete_count, tc->incomplete_vertices);
+
+		if(ret == true) {
+			tc->incomplete_vertices_angles.resize(node.incomplete_count);
+
+			if(node.incomplete_count > 0)
+				ret = read_checkpoint_data(p, end, &tc->incomplete_vertices_angles[0], sizeof(double) * node.incomplete_count);
+		}
+
+		if(ret == true) ret = read_checkpoint_list(p, end, node.bridge_count, tc->kd_bridge_triangles);
+	}
+
+	//The leaf nodes
+	vector<unsigned int> leaf_ids;
+	if(ret == true)
+		ret = read_checkpoint_list(p, end, header.leaf_count, leaf_ids);
+
+	for(unsigned int i=0; ret == true && i<leaf_ids.size(); i++) {
+		if(leaf_ids[i] >= nodes.size()) {
+			ret = false;
+			break;
+		}
+
+		kd_leaf_nodes->push_back(nodes[leaf_ids[i]]);
+	}
+
+	if(ret == false) {
+		printf("Error: the checkpoint %s is truncated or corrupt\n", filename);
+
+		free_kd_tree();
+		kd_leaf_nodes->clear();
+
+		return false;
+	}
+
+	level = header.level;
+	return true;
+}
+
+
+//Debugging functions
+/*int TriangleComplex::write_svg(const char* filename, double w, double h) {
+	//Simple error check
+	//if(global_vertex_list->size() <= 1)
+	//	return false;
+
+	//Open the file for writing
+	FILE* handle = fopen(filename, "w");
+	if(!handle)
+		return false;
+
+	//Write a background rectangle
+	fprintf(handle, "<svg viewBox=\"0 0 %f %f\" version=\"1.1\">\n", w, h);
+	fprintf(handle, "<rect x=\"%f\" y=\"%f\" width=\"%f\" height=\"%f\" fill=\"white\"/>\n", 0.0, 0.0, w, h);
+
+	//Write all the triangle/vertex data
+	if(write_svg(handle, w, h, true) == false) {
+		fclose(handle);
+		return false;
+	}
+
+	//Close the file and return
+	fprintf(handle, "</svg>\n");
+	fclose(handle);
+	return true;
+}*/
+
+/*int TriangleComplex::write_svg(FILE* handle, double w, double h, int draw_verts) {
+	//Write the triangles/edges
+	//for(unsigned int i=0; i<triangle_list->size(); i++)
+	//	(*triangle_list)[i]->write_svg(handle, w, h);
+	for(unsigned int i=0; i<GetTriangleCount(); i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri != NULL)
+			tri->write_svg(handle, w, h);
+	}
+
+	//Write the vertices
+	if(draw_verts == true) {
+		for(unsigned int i=0; i<global_mesh_data->GetVertexCount(); i++) {
+		//for(unsigned int i=0; i<global_vertex_list->size(); i++) {
+			Vector2d* pt = global_mesh_data->GetVertex(i);
+			if(pt == NULL)
+				continue;
+
+			//double cx = (*global_vertex_list)[i]->x;
+			//double cy = (*global_vertex_list)[i]->y;
+			double cx = pt->x;
+			double cy = pt->y;
+			double r = 1.0;
+
+			fprintf(handle, "<circle cx=\"%f\" cy=\"%f\" r=\"%f\" fill=\"blue\"/>\n", cx, h-cy, r);
+		}
+	}
+
+	//Write the kd-tree prism
+	if(kd_prism != NULL)
+		kd_prism->write_svg(handle, w, h);
+
+	//If there are kd-children have them write their own triangle/vertex data
+	if(kd_child[0] != NULL) kd_child[0]->write_svg(handle, w, h, false);
+	if(kd_child[1] != NULL) kd_child[1]->write_svg(handle, w, h, false);
+
+	return true;
+}*/
+
+/*int TriangleComplex::generate_random_vertex_list(int num, double xmin, double xmax) {
+	for(int i=0; i<num; i++) {
+		Vector2d* new_vertex = new Vector2d;
+		new_vertex->set(get_rand(xmin, xmax), get_rand(xmin, xmax));
+
+		unsigned int vindex = global_mesh_data->AppendVertex(new_vertex);
+		AppendVertexIndex(vindex);
+		//global_vertex_list->push_back(new_vector);
+		//AppendVertexIndex(i+1);
+	}
+
+	return true;
+}*/
+
+//Internal use functions
+int TriangleComplex::initialize() {
+	vertex_list.clear();
+	triangle_list.clear();
+
+	//triangle_list = new TriangleList;
+	//triangle_list->clear();
+
+	//Clear some lists
+	incomplete_vertices.clear();
+	incomplete_vertices_angles.clear();
+
+	incomplete_lists_computed = false;
+
+	delaunay_flip_count = 0;
 
 	//Initialize the kd tree data
 	kd_parent = NULL;
@@ -1429,6 +1799,8 @@ int TriangleComplex::initialize() {
 
 	kd_bridge_triangles.clear();
 
+	mesh_stream_writer = NULL;
+
 	return true;
 }
 
@@ -1492,7 +1864,7 @@ int TriangleComplex::basic_triangle_mesher() {
 		return false;
 	}
 
-	time_t start_time = clock();
+	double start_time = MesherProfiler::GetWallTime();
 
 	//Counts the number of loops
 	int count = 0;
@@ -1658,8 +2030,10 @@ int TriangleComplex::basic_triangle_mesher() {
 
 	printf("incomplete vertices left over: %u\n", incomplete_vertices.size());
 
-	time_t end_time = clock();
-	printf("Time spent in basic triangle mesher = %fs\n", double(end_time - start_time) / double(CLOCKS_PER_SEC));
+	double elapsed_time = MesherProfiler::GetWallTime() - start_time;
+	MesherProfiler::AddPhaseTime("basic_triangle_mesher", elapsed_time);
+
+	printf("Time spent in basic triangle mesher = %fs\n", elapsed_time);
 
 	printf("Triangle count: %u\n", GetTriangleCount());
 	return true;
@@ -1772,7 +2146,7 @@ int TriangleComplex::compute_incomplete_vertices() {
 		return true;
 
 	//Keep track of the time spent in this function
-	time_t start_time = clock();
+	double start_time = MesherProfiler::GetWallTime();
 
 	//Clear the lists
 	incomplete_vertices.clear();
@@ -1831,8 +2205,10 @@ int TriangleComplex::compute_incomplete_vertices() {
 		}
 	}
 
-	clock_t end_time = clock();
-	printf("Time spent computing incomplete vertices/edges = %fs\n", double(end_time - start_time) / double(CLOCKS_PER_SEC));
+	double elapsed_time = MesherProfiler::GetWallTime() - start_time;
+	MesherProfiler::AddPhaseTime("compute_incomplete_vertices", elapsed_time);
+
+	printf("Time spent computing incomplete vertices/edges = %fs\n", elapsed_time);
 
 	return true;
 }
@@ -1876,333 +2252,514 @@ int TriangleComplex::is_vertex_complete(unsigned int vindex, TriangleList adjace
 }
 
 int TriangleComplex::basic_delaunay_flipper() {
+	return basic_delaunay_flipper(DELAUNAY_MAXIMUM_PASS_COUNT);
+}
+
+int TriangleComplex::basic_delaunay_flipper(unsigned int maximum_pass_count) {
+	delaunay_flip_count = 0;
+
 	//If there are less than two triangles there are no flips to perform
 	if(GetTriangleCount() < 2)
 		return true;
 
-	int flip_count = 0;
-	int maximum_flip_count = 100;
-	for(int iter=0; iter<maximum_flip_count; iter++) {
-		//Assert that there is no delaunay flip performed this run
-		int flip_performed = false;
-		//printf("iter: %d\n", iter);
-
-		for(unsigned int i=0; i<GetTriangleCount(); i++) {
-			Triangle* tri = GetTriangle(i);
-
-			//Skip bridge triangles for flipping
-			if(tri == NULL || IsBridgeTriangleIndex(tri->GetLocalIndex()) == true)
-				continue;
-
-			//Go through each adjacent triangle of tri
-			for(int k=0; k<3; k++) {
-				Triangle* adj_tri = tri->GetAdjacentTriangle(k);
+	double start_time = MesherProfiler::GetWallTime();
 
-				//Skip bridge triangles for flipping
-				if(adj_tri == NULL || IsBridgeTriangleIndex(adj_tri->GetLocalIndex()) == true)
-					continue;
-				
-				//Perform a flip if the delaunay condition fails
-				if(tri->TestDelaunay(k) == false) {
-					tri->PerformDelaunayFlip(k);
-					flip_performed = true;
-				}
-			}
-		}
+	//Flag the bridge triangles and the queued triangle slots by global triangle index
+	unsigned int global_triangle_count = global_mesh_data->GetTriangleCount();
 
-		//Stop if we've converged to a delaunay triangulation
-		if(flip_performed == false)
-			break;
+	vector<char> is_bridge(global_triangle_count, false);
+	for(unsigned int i=0; i<kd_bridge_triangles.size(); i++) {
+		if(kd_bridge_triangles[i] < global_triangle_count)
+			is_bridge[kd_bridge_triangles[i]] = true;
 	}
 
-	return true;
-}
-
-//The most basic stretched grid method
-int TriangleComplex::basic_stretched_grid_method(unsigned int iterations, double alpha) {
-	//These are used by the SGM algorithm and are pre-calculated here
-	vector<unsigned int> vertex_triangle_count;
-	vector<bool> vertex_clamped;
-	vector<double> vertex_angles;
+	vector<char> is_local(global_triangle_count, false);
+	for(unsigned int i=0; i<GetTriangleCount(); i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri != NULL)
+			is_local[tri->GetTriangleIndex()] = true;
+	}
 
-	double average_edge_length = 0.0;
-	double total_edge_count = 0.0;
+	//Triangles streamed out of memory are final, their neighbours point to the sealed triangle instead
+	Triangle* sealed_triangle = MeshStreamWriter::GetSealedTriangle();
 
-	/*vertex_triangle_count.resize(global_vertex_list->size(), 0);
-	vertex_clamped.resize(global_vertex_list->size(), true);
-	vertex_angles.resize(global_vertex_list->size(), 0.0);*/
-	vertex_triangle_count.resize(global_mesh_data->GetVertexCount(), 0);
-	vertex_clamped.resize(global_mesh_data->GetVertexCount(), true);
-	vertex_angles.resize(global_mesh_data->GetVertexCount(), 0.0);
+	vector<char> is_queued(3*global_triangle_count, false);
+	queue< pair<Triangle*, int> > edge_queue;
 
+	//Every edge starts in the queue once, an edge between two triangles of this complex from the one with the
+	//smaller index
 	for(unsigned int i=0; i<GetTriangleCount(); i++) {
 		Triangle* tri = GetTriangle(i);
-		if(tri == NULL)
+
+		//Skip bridge triangles for flipping
+		if(tri == NULL || is_bridge[tri->GetTriangleIndex()] == true)
 			continue;
 
-		for(int j=0; j<3; j++) {
-			unsigned int vj_index = tri->GetVertexIndex(j);
+		for(int k=0; k<3; k++) {
+			Triangle* adj_tri = tri->GetAdjacentTriangle(k);
 
-			double vj_angle = 0.0;
-			if(tri->GetVertexAngle(j, vj_angle) == true) {
-				vertex_triangle_count[vj_index]++;
-				vertex_angles[vj_index] += vj_angle;
-			}
+			if(adj_tri == NULL || adj_tri == sealed_triangle)
+				continue;
+
+			unsigned int adj_tindex = adj_tri->GetTriangleIndex();
+			if(is_local[adj_tindex] == true && is_bridge[adj_tindex] == false && adj_tindex < tri->GetTriangleIndex())
+				continue;
+
+			is_queued[3*tri->GetTriangleIndex() + k] = true;
+			edge_queue.push(make_pair(tri, k));
 		}
 	}
 
-	for(unsigned int i=0; i<GetVertexCount(); i++) {
-		unsigned int vindex = GetVertexIndex(i);
-
-		if(vertex_angles[vindex] < 6.28318)
-			continue;
+	unsigned long test_count = 0;
+	unsigned long maximum_test_count = 3*(unsigned long)(GetTriangleCount()) * maximum_pass_count;
 
-		if(vertex_triangle_count[vindex] == 0)
-			continue;
+	while(edge_queue.empty() == false && test_count < maximum_test_count) {
+		Triangle* tri = edge_queue.front().first;
+		int k = edge_queue.front().second;
+		edge_queue.pop();
 
-		vertex_clamped[vindex] = false;
-	}
+		is_queued[3*tri->GetTriangleIndex() + k] = false;
+		test_count++;
 
-	for(unsigned int i=0; i<GetTriangleCount(); i++) {
-		Triangle* tri = GetTriangle(i);
-		if(tri == NULL)
+		//Skip bridge triangles for flipping
+		Triangle* adj_tri = tri->GetAdjacentTriangle(k);
+		if(adj_tri == NULL || adj_tri == sealed_triangle || is_bridge[adj_tri->GetTriangleIndex()] == true)
 			continue;
 
-		for(int j=0; j<3; j++) {
-			unsigned int vj_index = tri->GetVertexIndex(j);
-
-			Vector2d* vj = tri->GetVertex(j);
-			if(vj == NULL)
-				continue;
+		//Perform a flip if the delaunay condition fails
+		if(tri->TestDelaunay(k) == true || tri->PerformDelaunayFlip(k) == false)
+			continue;
 
-			Vector2d* v1 = NULL;
-			Vector2d* v2 = NULL;
+		delaunay_flip_count++;
 
-			Triangle* adj1 = NULL;
-			Triangle* adj2 = NULL;
+		//Queue the outer edges of the two triangles, every slot but the one holding the new diagonal
+		Triangle* flipped[2] = {tri, adj_tri};
+		for(int j=0; j<2; j++) {
+			for(int slot=0; slot<3; slot++) {
+				if(flipped[j]->GetAdjacentTriangle(slot) == flipped[1-j])
+					continue;
 
-			if(tri->GetAdjacentVerticesTriangles(j, v1, v2, adj1, adj2) != false) {
-				if(adj2 == NULL) {
-					average_edge_length += vj->distance(*v1) * 0.5;
-					total_edge_count += 0.5;
-				}
-				else {
-					average_edge_length += vj->distance(*v1) * 0.25;
-					total_edge_count += 0.25;
-				}
+				unsigned int queue_index = 3*flipped[j]->GetTriangleIndex() + slot;
 
-				if(adj1 == NULL) {
-					average_edge_length += vj->distance(*v2) * 0.5;
-					total_edge_count += 0.5;
-				}
-				else {
-					average_edge_length += vj->distance(*v2) * 0.25;
-					total_edge_count += 0.25;
+				if(is_queued[queue_index] == false) {
+					is_queued[queue_index] = true;
+					edge_queue.push(make_pair(flipped[j], slot));
 				}
 			}
 		}
 	}
-	average_edge_length /= total_edge_count;
-	printf("Averaged edge length: %f\n", average_edge_length);
-	printf("Total edge count: %f\n", total_edge_count);
 
-	//Run the stretched grid method
-	for(int iter=0; iter<iterations; iter++) {
-		vector<Vector2d> vertex_adjustments;
-		vertex_adjustments.resize(global_mesh_data->GetVertexCount(), Vector2d(0, 0));
-
-		for(unsigned int i=0; i<GetTriangleCount(); i++) {
-			Triangle* tri = GetTriangle(i);
-			if(tri == NULL)
-				continue;
+	if(edge_queue.empty() == false)
+		printf("Delaunay flipper stopped after %lu edge tests with %u edges left to test\n", test_count, (unsigned int) edge_queue.size());
 
-			for(int j=0; j<3; j++) {
-				unsigned int vj_index = tri->GetVertexIndex(j);
+	printf("Flipped %u edges\n", delaunay_flip_count);
 
-				Vector2d* vj = tri->GetVertex(j);
-				if(vj == NULL)
-					continue;
+	MesherProfiler::AddPhaseTime("basic_delaunay_flipper", MesherProfiler::GetWallTime() - start_time);
 
-				if(vertex_clamped[vj_index] == false) {
-					Vector2d* v1 = NULL;
-					Vector2d* v2 = NULL;
+	return true;
+}
 
-					Triangle* adj1 = NULL;
-					Triangle* adj2 = NULL;
-					if(tri->GetAdjacentVerticesTriangles(j, v1, v2, adj1, adj2) != false) {
-						//vertex_adjustments[vj_index] += (*v1 - *vj)*0.5;
-						//vertex_adjustments[vj_index] += (*v2 - *vj)*0.5;
+int TriangleComplex::parallel_delaunay_flipper(unsigned int maximum_pass_count) {
+	delaunay_flip_count = 0;
 
-						/*double v1_dist = vj->distance(*v1);
-						double v2_dist = vj->distance(*v2);
+	long triangle_count = triangle_list.size();
+	if(triangle_count < 2)
+		return true;
 
-						double v1_factor = (v1_dist - average_edge_length) / v1_dist;
-						double v2_factor = (v2_dist - average_edge_length) / v2_dist;*/
+	double start_time = MesherProfiler::GetWallTime();
 
-						if(adj2 == NULL)
-							vertex_adjustments[vj_index] += (*v1 - *vj) * 0.5;
+	//Only the triangles of this complex that aren't bridges are flipped
+	unsigned int global_triangle_count = global_mesh_data->GetTriangleCount();
 
-						else
-							vertex_adjustments[vj_index] += (*v1 - *vj) * 0.25;
+	vector<char> is_flippable(global_triangle_count, false);
+	for(long i=0; i<triangle_count; i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri != NULL)
+			is_flippable[tri->GetTriangleIndex()] = true;
+	}
 
-						if(adj1 == NULL)
-							vertex_adjustments[vj_index] += (*v2 - *vj) * 0.5;
+	for(unsigned int i=0; i<kd_bridge_triangles.size(); i++) {
+		if(kd_bridge_triangles[i] < global_triangle_count)
+			is_flippable[kd_bridge_triangles[i]] = false;
+	}
 
-						else
-							vertex_adjustments[vj_index] += (*v2 - *vj) * 0.25;
+	//Every illegal edge is found from the triangle holding its id
+	vector<unsigned int> candidates;
 
+	#pragma omp parallel
+	{
+		vector<unsigned int> thread_candidates;
 
-						/*double dist2 = vj->distance2(*v1);
-						if(dist2 < alpha) dist2 = alpha;
-						vertex_adjustments[vj_index] += (*vj - *v1)*0.5/dist2;
+		#pragma omp for schedule(static)
+		for(long i=0; i<triangle_count; i++) {
+			Triangle* tri = GetTriangle(i);
+			if(tri == NULL)
+				continue;
 
-						dist2 = vj->distance2(*v2);
-						if(dist2 < alpha) dist2 = alpha;
-						vertex_adjustments[vj_index] += (*vj - *v2)*0.5/dist2;*/
-					}
-				}
+			for(int k=0; k<3; k++) {
+				unsigned int edge = find_illegal_edge(tri, k, is_flippable);
+				if(edge == 3*tri->GetTriangleIndex() + k)
+					thread_candidates.push_back(edge);
 			}
 		}
 
-		/*#pragma omp parallel for
-		for(unsigned int i=0; i<global_vertex_list->size(); i++) {
-			Vector2d* vi = GetGlobalVertex(i);
-			if(vi == NULL)
-				continue;
+		#pragma omp critical
+		candidates.insert(candidates.end(), thread_candidates.begin(), thread_candidates.end());
+	}
 
-			for(unsigned int j=i+1; j<global_vertex_list->size(); j++) {
-				Vector2d* vj = GetGlobalVertex(j);
-				if(vj == NULL)
-					continue;
+	unsigned long test_count = 3*(unsigned long)(triangle_count);
+	unsigned long maximum_test_count = 3*(unsigned long)(triangle_count) * maximum_pass_count;
 
-				double dist2 = vi->distance2(*vj);
-				if(dist2 < alpha) dist2 = alpha;
+	//The highest priority of the edges that would change each triangle
+	vector<uint64_t> reservations(global_triangle_count, 0);
+	vector<char> is_flipped(global_triangle_count, false);
 
-				vertex_adjustments[i] -= (*vi - *vj)/dist2;
-			}
-		}*/
+	unsigned int round = 0;
+	while(candidates.empty() == false && test_count < maximum_test_count) {
+		long candidate_count = candidates.size();
 
-		for(unsigned int i=0; i<global_mesh_data->GetVertexCount(); i++) {
-			if(vertex_clamped[i] == false) {
-				Vector2d* v = GetGlobalVertex(i);
-				if(v == NULL)
-					continue;
+		//The triangles are kept so they can be cleared after the flips have changed the neighbours
+		vector<unsigned int> flip_tindices(6*candidate_count, 0);
 
-				//vertex_adjustments[i] /= double(vertex_triangle_count[i]);
-				(*v) = (*v) + (vertex_adjustments[i] * (alpha/vertex_triangle_count[i]));
+		#pragma omp parallel for schedule(static)
+		for(long i=0; i<candidate_count; i++) {
+			Triangle* flip_triangles[6];
+			get_flip_triangles(candidates[i], flip_triangles);
+
+			uint64_t priority = compute_flip_priority(candidates[i], round);
+
+			for(int j=0; j<6; j++) {
+				if(flip_triangles[j] == NULL)
+					continue;
+
+				unsigned int tindex = flip_triangles[j]->GetTriangleIndex();
+				flip_tindices[6*i+j] = tindex;
+
+				//Keep the highest priority
+				uint64_t current = reservations[tindex];
+				while(current < priority) {
+					uint64_t previous = __sync_val_compare_and_swap(&reservations[tindex], current, priority);
+					if(previous == current)
+						break;
+
+					current = previous;
+				}
+			}
+		}
+
+		//Flip the edges that hold all of their triangles
+		long flip_count = 0;
+
+		#pragma omp parallel for schedule(static) reduction(+:flip_count)
+		for(long i=0; i<candidate_count; i++) {
+			uint64_t priority = compute_flip_priority(candidates[i], round);
+
+			int is_independent = true;
+			for(int j=0; j<6 && is_independent == true; j++) {
+				if(flip_tindices[6*i+j] != 0 && reservations[flip_tindices[6*i+j]] != priority)
+					is_independent = false;
+			}
+
+			if(is_independent == false)
+				continue;
+
+			Triangle* tri = global_mesh_data->GetTriangle(candidates[i] / 3);
+			Triangle* adj_tri = tri->GetAdjacentTriangle(candidates[i] % 3);
+
+			if(tri->PerformDelaunayFlip(candidates[i] % 3) == false)
+				continue;
+
+			//Cache the new circumcircles here, while no other thread looks at these two triangles
+			Vector2d center;
+			double radius;
+
+			tri->GetCircumcircle(center, radius);
+			adj_tri->GetCircumcircle(center, radius);
+
+			is_flipped[tri->GetTriangleIndex()] = true;
+			is_flipped[adj_tri->GetTriangleIndex()] = true;
+
+			flip_count++;
+		}
+
+		delaunay_flip_count += flip_count;
+
+		//Test the edges of the flipped triangles, the edges that lost are still illegal if neither triangle flipped
+		vector<unsigned int> next_candidates;
+		long next_test_count = 0;
+
+		#pragma omp parallel reduction(+:next_test_count)
+		{
+			vector<unsigned int> thread_candidates;
+
+			#pragma omp for schedule(static)
+			for(long i=0; i<candidate_count; i++) {
+				unsigned int tindices[2] = {flip_tindices[6*i], flip_tindices[6*i+1]};
+
+				if(is_flipped[tindices[0]] == false && is_flipped[tindices[1]] == false) {
+					thread_candidates.push_back(candidates[i]);
+					continue;
+				}
+
+				//Only the flip that owned both triangles tests them
+				if(reservations[tindices[0]] != compute_flip_priority(candidates[i], round) || is_flipped[tindices[0]] == false)
+					continue;
+
+				for(int j=0; j<2; j++) {
+					Triangle* tri = global_mesh_data->GetTriangle(tindices[j]);
+
+					for(int k=0; k<3; k++) {
+						unsigned int edge = find_illegal_edge(tri, k, is_flippable);
+						if(edge != 0)
+							thread_candidates.push_back(edge);
+					}
+
+					next_test_count += 3;
+				}
 			}
+
+			#pragma omp critical
+			next_candidates.insert(next_candidates.end(), thread_candidates.begin(), thread_candidates.end());
+		}
+
+		test_count += next_test_count;
+
+		//Clear the reservations and flags of this round
+		#pragma omp parallel for schedule(static)
+		for(long i=0; i<6*candidate_count; i++) {
+			reservations[flip_tindices[i]] = 0;
+			is_flipped[flip_tindices[i]] = false;
 		}
+
+		//Two flipped triangles can share an illegal edge
+		sort(next_candidates.begin(), next_candidates.end());
+		next_candidates.erase(unique(next_candidates.begin(), next_candidates.end()), next_candidates.end());
+
+		candidates.swap(next_candidates);
+		round++;
 	}
 
-	printf("DONE WITH STRETCHED GRID!\n");
+	if(candidates.empty() == false)
+		printf("Delaunay flipper stopped after %u rounds with %u edges left to flip\n", round, (unsigned int) candidates.size());
+
+	printf("Flipped %u edges in %u rounds\n", delaunay_flip_count, round);
+
+	MesherProfiler::AddPhaseTime("parallel_delaunay_flipper", MesherProfiler::GetWallTime() - start_time);
+
 	return true;
 }
 
-//The force based stretched grid method
-int TriangleComplex::force_stretched_grid_method(int iterations, double dt) {
-	//First collect all the edge information
-	vector<Edge*> edge_list;
-	double average_edge_length = 0.0;
+unsigned int TriangleComplex::find_illegal_edge(Triangle* tri, int opposing_vertex, vector<char>& is_flippable) {
+	Triangle* adj_tri = tri->GetAdjacentTriangle(opposing_vertex);
+	if(adj_tri == NULL || adj_tri->GetTriangleIndex() >= is_flippable.size())
+		return 0;
 
-	if(GetEdges(edge_list) == false)
+	if(is_flippable[tri->GetTriangleIndex()] == false || is_flippable[adj_tri->GetTriangleIndex()] == false)
+		return 0;
+
+	if(tri->TestDelaunay(opposing_vertex) == true)
+		return 0;
+
+	if(tri->GetTriangleIndex() < adj_tri->GetTriangleIndex())
+		return 3*tri->GetTriangleIndex() + opposing_vertex;
+
+	for(int i=0; i<3; i++) {
+		if(adj_tri->GetAdjacentTriangle(i) == tri)
+			return 3*adj_tri->GetTriangleIndex() + i;
+	}
+
+	return 0;
+}
+
+int TriangleComplex::get_flip_triangles(unsigned int edge, Triangle* flip_triangles[6]) {
+	for(int i=0; i<6; i++)
+		flip_triangles[i] = NULL;
+
+	Triangle* tri = global_mesh_data->GetTriangle(edge / 3);
+	if(tri == NULL)
 		return false;
 
-	if(ComputeAverageEdgeLength(average_edge_length, edge_list) == false)
+	Triangle* adj_tri = tri->GetAdjacentTriangle(edge % 3);
+	if(adj_tri == NULL)
 		return false;
 
-	//Next create some data that will be used by the algorithm
-	vector<int> use_vertex;
-	vector<double> vertex_angle;
-	vector<unsigned int> vertex_triangle_count;
+	flip_triangles[0] = tri;
+	flip_triangles[1] = adj_tri;
+
+	//A tangled mesh can link the same triangles more than once, so the count is checked
+	int count = 2;
+	for(int i=0; i<3 && count<6; i++) {
+		if(tri->GetAdjacentTriangle(i) != adj_tri && tri->GetAdjacentTriangle(i) != NULL)
+			flip_triangles[count++] = tri->GetAdjacentTriangle(i);
+	}
+
+	for(int i=0; i<3 && count<6; i++) {
+		if(adj_tri->GetAdjacentTriangle(i) != tri && adj_tri->GetAdjacentTriangle(i) != NULL)
+			flip_triangles[count++] = adj_tri->GetAdjacentTriangle(i);
+	}
 
-	vector<Vector2d> vertex_velocity;
-	vector<Vector2d> vertex_force;
+	return true;
+}
 
-	//unsigned int iterations = 100;
-	//double dt = 0.01;
+uint64_t TriangleComplex::compute_flip_priority(unsigned int edge, unsigned int round) {
+	//A 32 bit integer hash of the edge and round
+	uint32_t h = edge * 2654435761u + round * 40503u;
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
 
-	//Resize some lists
-	use_vertex.resize(global_mesh_data->GetVertexCount(), false);
-	vertex_angle.resize(global_mesh_data->GetVertexCount(), 0.0);
-	vertex_triangle_count.resize(global_mesh_data->GetVertexCount(), 0);
+	return (uint64_t(h) << 32) | uint64_t(edge);
+}
 
-	vertex_velocity.resize(global_mesh_data->GetVertexCount(), Vector2d(0,0));
-	vertex_force.resize(global_mesh_data->GetVertexCount(), Vector2d(0,0));
+//Restore the Delaunay condition over the edges of some new triangles
+// + the stack holds a triangle and the vertex across from the edge to test, a flip pushes the four edges
+//   around the two flipped triangles, so the work only spreads as far as the flips do
+int TriangleComplex::local_delaunay_flipper(vector<Triangle*>& triangles) {
+	vector< pair<Triangle*, unsigned int> > flip_stack;
 
-	//Do some calculations to see which vertices to actually use
-	for(unsigned int i=0; i<GetTriangleCount(); i++) {
-		Triangle* tri = GetTriangle(i);
-		if(tri == NULL)
+	for(unsigned int i=0; i<triangles.size(); i++) {
+		for(int j=0; j<3; j++)
+			flip_stack.push_back(make_pair(triangles[i], triangles[i]->GetVertexIndex(j)));
+	}
+
+	while(flip_stack.empty() == false) {
+		Triangle* tri = flip_stack.back().first;
+		unsigned int vindex = flip_stack.back().second;
+		flip_stack.pop_back();
+
+		//An earlier flip may have moved the vertex out of this triangle
+		int opposing_vertex = -1;
+		for(int i=0; i<3; i++) {
+			if(tri->GetVertexIndex(i) == vindex)
+				opposing_vertex = i;
+		}
+
+		if(opposing_vertex < 0)
 			continue;
 
-		for(int j=0; j<3; j++) {
-			unsigned int vj_index = tri->GetVertexIndex(j);
+		//Skip bridge triangles for flipping
+		Triangle* adj_tri = tri->GetAdjacentTriangle(opposing_vertex);
+		if(adj_tri == NULL || IsBridgeTriangleIndex(tri->GetTriangleIndex()) == true || IsBridgeTriangleIndex(adj_tri->GetTriangleIndex()) == true)
+			continue;
+
+		if(tri->TestDelaunay(opposing_vertex) == true || tri->PerformDelaunayFlip(opposing_vertex) == false)
+			continue;
 
-			double vj_angle = 0.0;
-			if(tri->GetVertexAngle(j, vj_angle) == true) {
-				vertex_triangle_count[vj_index]++;
-				vertex_angle[vj_index] += vj_angle;
+		//The outer edges of the two triangles are across from the ends of the new diagonal
+		for(int i=0; i<3; i++) {
+			unsigned int diagonal_vindex = tri->GetVertexIndex(i);
+			if(adj_tri->IsVertex(diagonal_vindex) == true) {
+				flip_stack.push_back(make_pair(tri, diagonal_vindex));
+				flip_stack.push_back(make_pair(adj_tri, diagonal_vindex));
 			}
 		}
 	}
 
-	for(unsigned int i=0; i<GetVertexCount(); i++) {
-		unsigned int vindex = GetVertexIndex(i);
+	return true;
+}
 
-		if(vertex_angle[vindex] < 6.28318)
-			continue;
+//Swap one or two triangles for the triangles they were split into
+int TriangleComplex::replace_triangles(Triangle* tri, Triangle* adj_tri, vector<Triangle*>& new_triangles) {
+	vector<unsigned int> free_tindices;
+	free_tindices.push_back(tri->GetTriangleIndex());
 
-		if(vertex_triangle_count[vindex] == 0)
-			continue;
+	if(adj_tri != NULL)
+		free_tindices.push_back(adj_tri->GetTriangleIndex());
+
+	//Nothing points to the old triangles any more, so they don't have to be searched for
+	for(unsigned int i=0; i<free_tindices.size(); i++)
+		global_mesh_data->ReleaseTriangle(free_tindices[i]);
 
-		use_vertex[vindex] = true;
+	for(unsigned int i=0; i<new_triangles.size(); i++) {
+		if(i < free_tindices.size())
+			SetTriangle(free_tindices[i], new_triangles[i]);
+		else
+			AppendTriangle(new_triangles[i]);
 	}
 
-	//Run the actual stretched grid algorithm
-	for(unsigned int iter=0; iter<iterations; iter++) {
-		//Reset the vertex forces
-		for(unsigned int i=0; i<vertex_force.size(); i++) {
-			vertex_force[i].x = 0.0;
-			vertex_force[i].y = 0.0;
-		}
+	return true;
+}
 
-		//Calculate the force on each vertex with the edge list
-		for(unsigned int i=0; i<edge_list.size(); i++) {
-			unsigned int v0_index = edge_list[i]->GetVertexIndex(0);
-			unsigned int v1_index = edge_list[i]->GetVertexIndex(1);
+//The most basic stretched grid method
+int TriangleComplex::basic_stretched_grid_method(unsigned int iterations, double alpha) {
+	double start_time = MesherProfiler::GetWallTime();
 
-			Vector2d* v0 = edge_list[i]->GetVertex(0);
-			Vector2d* v1 = edge_list[i]->GetVertex(1);
+	LaplacianSmoother laplacian_smoother(global_mesh_data);
+	if(laplacian_smoother.Build(triangle_list, vertex_list, alpha) == false)
+		return false;
 
-			if(v0 == NULL || v1 == NULL)
-				continue;
+	if(laplacian_smoother.Smooth(iterations) == false)
+		return false;
 
-			double length = edge_list[i]->ComputeLength();
-			Vector2d rhat = (*v1 - *v0).normalize();
+	//The vertices have moved under the cached circumcircles
+	long triangle_count = triangle_list.size();
 
-			double dl = (length - average_edge_length);
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<triangle_count; i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri != NULL)
+			tri->ResetCircumcircle();
+	}
 
-			vertex_force[v0_index] += (rhat * dl);
-			vertex_force[v1_index] -= (rhat * dl);
-		}
+	MesherProfiler::AddPhaseTime("laplacian_smooth", MesherProfiler::GetWallTime() - start_time);
 
-		//Update velocity and position
-		for(unsigned int i=0; i<GetVertexCount(); i++) {
-			unsigned int vindex = GetVertexIndex(i);
-			Vector2d* pt = GetVertex(i);
+	printf("DONE WITH STRETCHED GRID!\n");
+	return true;
+}
 
-			if(use_vertex[vindex] == true && pt != NULL) {
-				vertex_velocity[vindex] += (vertex_force[vindex] * dt);
-				*pt = *pt + (vertex_velocity[vindex] * dt);
-			}
+//The force based stretched grid method
+int TriangleComplex::force_stretched_grid_method(unsigned int iterations, double dt, double damping, double tolerance) {
+	double start_time = MesherProfiler::GetWallTime();
+
+	ForceSmoother force_smoother(global_mesh_data);
+	if(force_smoother.Build(triangle_list, vertex_list) == false)
+		return false;
+
+	if(force_smoother.Smooth(iterations, dt, damping, tolerance) == false)
+		return false;
+
+	//The vertices have moved under the cached circumcircles
+	long triangle_count = triangle_list.size();
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<triangle_count; i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri != NULL)
+			tri->ResetCircumcircle();
+	}
+
+	MesherProfiler::AddPhaseTime("force_smooth", MesherProfiler::GetWallTime() - start_time);
+
+	printf("DONE WITH STRETCHED GRID! %u of %u iterations\n", force_smoother.GetIterationCount(), iterations);
+	return true;
+}
+
+//Sort a list of edges and delete the edges that are in it more than once
+int TriangleComplex::sort_edge_list(vector<Edge*>& edge_list) {
+	sort(edge_list.begin(), edge_list.end(), compare_edges);
+
+	//The copies of an edge are next to each other now, keep the first one
+	unsigned int count = 0;
+	for(unsigned int i=0; i<edge_list.size(); i++) {
+		if(count > 0 && (*edge_list[count-1]) == (*edge_list[i])) {
+			delete edge_list[i];
+			continue;
 		}
+
+		edge_list[count++] = edge_list[i];
 	}
 
+	edge_list.resize(count);
 
-	printf("DONE WITH STRETCHED GRID!\n");
 	return true;
 }
 
+bool TriangleComplex::compare_edges(Edge* e1, Edge* e2) {
+	return (*e1) < (*e2);
+}
+
 int TriangleComplex::basic_mesh_cleaner() {
 	vector<unsigned int> triangles_to_delete;
 
@@ -2215,7 +2772,7 @@ int TriangleComplex::basic_mesh_cleaner() {
 			double angle = 0.0;
 			if(tri->GetVertexAngle(j, angle) != false && angle > 3.141592/2.0) {
 				if(tri->GetAdjacentTriangleCount() < 3) {
-					triangles_to_delete.push_back(i);
+					triangles_to_delete.push_back(GetTriangleIndex(i));
 					break;
 				}
 			}
@@ -2287,38 +2844,13 @@ int TriangleComplex::split_obtuse_edges(double desired_edge_length, unsigned int
 			if(tri->SubdivideAlongEdge(j, split_count, new_triangles, new_vindices, average_new_edge_length) == true) {
 				Triangle* adj_tri = tri->GetAdjacentTriangle(j);
 
-				printf("Deleting some old triangles\n");
-				if(adj_tri != NULL) {
-					unsigned int adj_tindex;
-					for(unsigned int tindex = 0; tindex<GetTriangleCount(); tindex++) {
-						if(GetTriangle(tindex) == adj_tri) {
-							adj_tindex = tindex;
-							break;
-						}
-					}
-
-					printf("adj_tindex: %u\n", adj_tindex);
-					if(adj_tindex > i) {
-						DeleteTriangle(adj_tindex);
-						DeleteTriangle(i);
-					}
-					else {
-						DeleteTriangle(i);
-						DeleteTriangle(adj_tindex);
-					}
-				}
-				else
-					DeleteTriangle(i);
-				printf("Deletion successful\n");
-
-				//Append the new vertex indices and triangles to the final lists
+				//Append the new vertex indices to this complex, and replace the two triangles with the new ones
 				for(unsigned int k=0; k<new_vindices.size(); k++)
 					AppendVertexIndex(new_vindices[k]);
 					//final_new_vindices.push_back(new_vindices[k]);
 
-				for(unsigned int k=0; k<new_triangles.size(); k++)
-					AppendTriangle(new_triangles[k]);
-					//final_new_triangles.push_back(new_triangles[k]);
+				replace_triangles(tri, adj_tri, new_triangles);
+				local_delaunay_flipper(new_triangles);
 
 				printf("ASDF\n");
 				split_triangle = true;
@@ -2366,11 +2898,586 @@ int TriangleComplex::split_obtuse_edges(double desired_edge_length, unsigned int
 
 //Barycentric subdivide triangles to achieve a desired edge length
 int TriangleComplex::barycentric_subdivion(double desired_cell_edge_length, double& average_edge_length) {
+	if(desired_cell_edge_length < EFF_ZERO)
+		return false;
+
+	//Every level halves the edges
+	while(average_edge_length > desired_cell_edge_length) {
+		if(uniform_refine_level(NULL) == false)
+			return false;
+
+		average_edge_length *= 0.5;
+	}
 
 	return true;
 }
 
+//One level of 1-to-4 refinement, of every triangle or of the ones in a prism
+int TriangleComplex::uniform_refine_level(Prism* prism) {
+	long triangle_count = triangle_list.size();
+	if(triangle_count == 0)
+		return false;
+
+	//The local indices of the neighbours of every triangle, -1 on the boundary
+	vector<int> local_indices(global_mesh_data->GetTriangleCount(), -1);
+	for(long i=0; i<triangle_count; i++)
+		local_indices[triangle_list[i]] = i;
+
+	vector<int> adjacent(3*triangle_count, -1);
+	int connected = true;
+
+	#pragma omp parallel for schedule(static) reduction(&&:connected)
+	for(long i=0; i<triangle_count; i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++) {
+			Triangle* adj_tri = tri->GetAdjacentTriangle(j);
+			if(adj_tri == NULL)
+				continue;
+
+			adjacent[3*i+j] = local_indices[adj_tri->GetTriangleIndex()];
+			connected = connected && (adjacent[3*i+j] >= 0);
+		}
+	}
+
+	if(connected == false) {
+		printf("Error: uniform refinement needs every neighbouring triangle in the complex\n");
+		return false;
+	}
+
+	//The triangles split 1-to-4, all of them without a prism
+	vector<char> red(triangle_count, 0);
+
+	for(long i=0; i<triangle_count; i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		if(prism == NULL) {
+			red[i] = true;
+			continue;
+		}
+
+		Vector2d centroid = (*tri->GetVertex(0) + *tri->GetVertex(1) + *tri->GetVertex(2)) / 3.0;
+		red[i] = prism->TestPointInside(centroid, false);
+
+		for(int j=0; j<3 && red[i] == false; j++)
+			red[i] = prism->TestPointInside(*tri->GetVertex(j), false);
+	}
+
+	//A neighbour with two split edges can't be split in two, so it is split 1-to-4 too, until no more are
+	if(prism != NULL) {
+		vector<long> red_stack;
+		for(long i=0; i<triangle_count; i++) {
+			if(red[i] == true)
+				red_stack.push_back(i);
+		}
+
+		while(red_stack.empty() == false) {
+			long i = red_stack.back();
+			red_stack.pop_back();
+
+			for(int j=0; j<3; j++) {
+				int k = adjacent[3*i+j];
+				if(k < 0 || red[k] == true)
+					continue;
+
+				int split_count = 0;
+				for(int l=0; l<3; l++) {
+					if(adjacent[3*k+l] >= 0 && red[adjacent[3*k+l]] == true)
+						split_count++;
+				}
+
+				if(split_count >= 2) {
+					red[k] = true;
+					red_stack.push_back(k);
+				}
+			}
+		}
+	}
+
+	//An edge is split if either of its triangles is red, the one with the lower local index makes the midpoint
+	vector<unsigned int> midpoint_offsets(triangle_count+1, 0);
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<triangle_count; i++) {
+		for(int j=0; j<3; j++) {
+			int k = adjacent[3*i+j];
+			if((red[i] == true || (k >= 0 && red[k] == true)) && (k < 0 || i < k))
+				midpoint_offsets[i+1]++;
+		}
+	}
+
+	for(long i=0; i<triangle_count; i++)
+		midpoint_offsets[i+1] += midpoint_offsets[i];
+
+	unsigned int midpoint_count = midpoint_offsets[triangle_count];
+	if(midpoint_count == 0)
+		return true;
+
+	unsigned int first_vindex = 0;
+	Vector2d* midpoints = global_mesh_data->AllocateVertexBlock(midpoint_count, first_vindex);
+
+	vector<unsigned int> edge_midpoints(3*triangle_count, 0);
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<triangle_count; i++) {
+		Triangle* tri = GetTriangle(i);
+		unsigned int offset = midpoint_offsets[i];
+
+		for(int j=0; j<3; j++) {
+			int k = adjacent[3*i+j];
+			if((red[i] == true || (k >= 0 && red[k] == true)) && (k < 0 || i < k)) {
+				midpoints[offset] = (*tri->GetVertex((j+1)%3) + *tri->GetVertex((j+2)%3)) * 0.5;
+				edge_midpoints[3*i+j] = first_vindex + offset;
+				offset++;
+			}
+		}
+	}
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<triangle_count; i++) {
+		for(int j=0; j<3; j++) {
+			int k = adjacent[3*i+j];
+			if(k < 0 || k > i || (red[i] == false && red[k] == false))
+				continue;
+
+			for(int l=0; l<3; l++) {
+				if(adjacent[3*k+l] == i)
+					edge_midpoints[3*i+j] = edge_midpoints[3*k+l];
+			}
+		}
+	}
+
+	AppendVertexIndices(first_vindex, midpoint_count);
+
+	//Red triangles become four, green ones two and the rest stay as they are
+	// + the first child takes over the slot of its parent, the others go to new slots
+	vector<unsigned int> child_offsets(triangle_count+1, 0);
+
+	for(long i=0; i<triangle_count; i++) {
+		unsigned int extra_count = 0;
+		if(red[i] == true)
+			extra_count = 3;
+
+		else {
+			for(int j=0; j<3; j++) {
+				if(edge_midpoints[3*i+j] != 0)
+					extra_count = 1;
+			}
+		}
+
+		child_offsets[i+1] = child_offsets[i] + extra_count;
+	}
+
+	unsigned int first_tindex = global_mesh_data->GetTriangleCount();
+	unsigned int extra_triangle_count = child_offsets[triangle_count];
+
+	global_mesh_data->ResizeTriangleList(first_tindex + extra_triangle_count);
+	triangle_list.resize(triangle_count + extra_triangle_count);
+
+	vector<Triangle*> children(4*triangle_count, (Triangle*) NULL);
+
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<triangle_count; i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		unsigned int v[3];
+		unsigned int m[3];
+
+		for(int j=0; j<3; j++) {
+			v[j] = tri->GetVertexIndex(j);
+			m[j] = edge_midpoints[3*i+j];
+		}
+
+		//Triangles with no split edges are kept
+		unsigned int child_vertices[4][3];
+		int child_count = 0;
+
+		if(red[i] == true) {
+			//A corner triangle at every vertex, and the middle one
+			for(int j=0; j<3; j++) {
+				child_vertices[j][0] = v[j];
+				child_vertices[j][1] = m[(j+2)%3];
+				child_vertices[j][2] = m[(j+1)%3];
+			}
+
+			child_vertices[3][0] = m[0];
+			child_vertices[3][1] = m[1];
+			child_vertices[3][2] = m[2];
+
+			child_count = 4;
+		}
+
+		else {
+			//Split the triangle from the midpoint of its split edge to the opposite vertex
+			for(int j=0; j<3; j++) {
+				if(m[j] == 0)
+					continue;
+
+				child_vertices[0][0] = v[j];
+				child_vertices[0][1] = v[(j+1)%3];
+				child_vertices[0][2] = m[j];
+
+				child_vertices[1][0] = v[j];
+				child_vertices[1][1] = m[j];
+				child_vertices[1][2] = v[(j+2)%3];
+
+				child_count = 2;
+			}
+		}
+
+		if(child_count == 0) {
+			children[4*i] = tri;
+			continue;
+		}
+
+		for(int j=0; j<child_count; j++) {
+			Triangle* child = new Triangle(global_mesh_data->GetGlobalVertexList());
+			for(int k=0; k<3; k++)
+				child->SetVertex(k, child_vertices[j][k]);
+
+			children[4*i+j] = child;
+
+			if(j == 0)
+				global_mesh_data->SetTriangle(triangle_list[i], child);
+
+			else {
+				unsigned int offset = child_offsets[i] + j - 1;
+
+				global_mesh_data->SetTriangle(first_tindex + offset, child);
+				triangle_list[triangle_count + offset] = first_tindex + offset;
+			}
+		}
+
+		delete tri;
+	}
+
+	//Connect every child to the sibling or the child of a neighbour that shares each of its edges
+	#pragma omp parallel for schedule(static)
+	for(long i=0; i<triangle_count; i++) {
+		for(int c=0; c<4; c++) {
+			Triangle* child = children[4*i+c];
+			if(child == NULL)
+				continue;
+
+			for(int e=0; e<3; e++) {
+				unsigned int v1 = child->GetVertexIndex((e+1)%3);
+				unsigned int v2 = child->GetVertexIndex((e+2)%3);
+
+				Triangle* adj_tri = NULL;
+
+				for(int j=-1; j<3 && adj_tri == NULL; j++) {
+					int k = (j < 0 ? i : adjacent[3*i+j]);
+					if(k < 0)
+						continue;
+
+					for(int l=0; l<4; l++) {
+						Triangle* candidate = children[4*k+l];
+
+						if(candidate != NULL && candidate != child && candidate->IsVertex(v1) && candidate->IsVertex(v2)) {
+							adj_tri = candidate;
+							break;
+						}
+					}
+				}
+
+				child->SetAdjacentTriangle(e, adj_tri);
+			}
+		}
+	}
+
+	unsigned int red_count = 0;
+	for(long i=0; i<triangle_count; i++) {
+		if(red[i] == true)
+			red_count++;
+	}
+
+	printf("Split %u triangles 1-to-4 and %u in two, added %u vertices\n", red_count, extra_triangle_count - 3*red_count, midpoint_count);
+	return true;
+}
+
 //Initialize the kd-tree prism based on the vertex list
+//Mesh the leaf nodes and combine them level by level until only the top node is left
+// + a checkpoint is saved at the start of every checkpoint_interval levels
+int TriangleComplex::run_kd_tree_levels(unsigned int level, const char* checkpoint_filename, unsigned int checkpoint_interval) {
+	int use_checkpoints = (checkpoint_filename != NULL && checkpoint_filename[0] != '\0' && checkpoint_interval > 0);
+	unsigned int first_level = level;
+
+	while(kd_leaf_nodes->size() > 1) {
+		//The first level is either cheap to redo or was just loaded from the checkpoint
+		if(use_checkpoints == true && level > first_level && level % checkpoint_interval == 0) {
+			if(SaveKDCheckpoint(checkpoint_filename, level) == false)
+				printf("Warning: could not save the checkpoint %s\n", checkpoint_filename);
+		}
+
+		//Mesh all the leaf nodes
+		double start_time = MesherProfiler::GetWallTime();
+
+		#pragma omp parallel for
+		for(int i=0; i<kd_leaf_nodes->size(); i++) {
+			printf("Starting to mesh leaf node %u\n", i);
+			(*kd_leaf_nodes)[i]->RunTriangleMesher();
+
+			if(mesh_stream_writer != NULL)
+				(*kd_leaf_nodes)[i]->stream_final_triangles(mesh_stream_writer);
+
+			printf("Done meshing leaf node %u\n\n", i);
+		}
+
+		MesherProfiler::AddPhaseTime("mesh_kd_leaf_nodes", MesherProfiler::GetWallTime() - start_time);
+
+		//Combine sibling leaf-nodes
+		vector<TriangleComplex*> new_kd_leaf_nodes;
+		new_kd_leaf_nodes.clear();
+
+		printf("Starting with %u kd leaf nodes\n", kd_leaf_nodes->size());
+		while(kd_leaf_nodes->size() > 1) {
+			TriangleComplex* tc_parent = (*kd_leaf_nodes)[0]->GetKDParent();
+
+			//Safety check
+			if(tc_parent == NULL) {
+				printf("OH NOES\n");
+				return false;
+			}
+
+			//A child can already have been combined into a new leaf node during this pass
+			TriangleComplex* tc_children[2] = {tc_parent->kd_child[0], tc_parent->kd_child[1]};
+
+			//Combine the children to create a new leaf node
+			// + This will delete the children from kd_leaf_nodes
+			if(tc_parent->CombineChildren() == false) {
+				printf("No children!!\n");
+				new_kd_leaf_nodes.push_back((*kd_leaf_nodes)[0]);
+				kd_leaf_nodes->erase(kd_leaf_nodes->begin());
+			}
+			else {
+				//So make sure the deleted children don't carry over to the next level
+				for(unsigned int i=0; i<new_kd_leaf_nodes.size(); i++) {
+					if(new_kd_leaf_nodes[i] == tc_children[0] || new_kd_leaf_nodes[i] == tc_children[1]) {
+						new_kd_leaf_nodes.erase(new_kd_leaf_nodes.begin() + i);
+						i--;
+					}
+				}
+
+				new_kd_leaf_nodes.push_back(tc_parent);
+			}
+		}
+
+		*kd_leaf_nodes = new_kd_leaf_nodes;
+		printf("KD LEAF NODE COUNT: %u\n", kd_leaf_nodes->size());
+
+		level++;
+	}
+
+	CombineChildren();
+
+	if(basic_triangle_mesher() == false)
+		return false;
+
+	if(basic_delaunay_flipper() == false)
+		return false;
+
+	//Reset the local indices of all triangles
+	unsigned int index = 1;
+	for(unsigned int i=0; i<GetTriangleCount(); i++) {
+		Triangle* tri = GetTriangle(i);
+
+		if(tri != NULL)
+			tri->SetLocalIndex(index++);
+	}
+
+	return true;
+}
+
+//Write out and free the triangles of this complex that can never change again
+// + a triangle is final once it has three neighbours, passes the Delaunay test with each of them and its circumcircle
+//   lies strictly inside the kd prism: no vertex from outside this complex can then ever fall inside it
+// + only final triangles whose neighbours are all final are freed, the rest stay as a sealed band around the working mesh
+int TriangleComplex::stream_final_triangles(MeshStreamWriter* mesh_stream_writer) {
+	if(kd_prism == NULL || mesh_stream_writer == NULL)
+		return false;
+
+	Triangle* sealed_triangle = MeshStreamWriter::GetSealedTriangle();
+
+	Vector2d min = kd_prism->GetMin();
+	Vector2d max = kd_prism->GetMax();
+
+	//Find the final triangles
+	vector<unsigned int> final_tindices;
+
+	for(unsigned int i=0; i<GetTriangleCount(); i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri == NULL || tri->GetAdjacentTriangleCount() < 3 || IsBridgeTriangleIndex(GetTriangleIndex(i)) == true)
+			continue;
+
+		int is_final = true;
+		for(int k=0; k<3; k++) {
+			if(tri->GetAdjacentTriangle(k) != sealed_triangle && tri->TestDelaunay(k) == false) {
+				is_final = false;
+				break;
+			}
+		}
+
+		Vector2d center;
+		double radius = 0.0;
+
+		if(is_final == false || tri->GetCircumcircle(center, radius) == false)
+			continue;
+
+		//Leave a little room for round-off on the prism walls
+		radius *= (1.0 + 1e-9);
+
+		if(center.x - radius > min.x && center.x + radius < max.x && center.y - radius > min.y && center.y + radius < max.y)
+			final_tindices.push_back(GetTriangleIndex(i));
+	}
+
+	sort(final_tindices.begin(), final_tindices.end());
+
+	//Only the ones surrounded by final triangles can go
+	vector<unsigned int> release_tindices;
+
+	for(unsigned int i=0; i<final_tindices.size(); i++) {
+		Triangle* tri = GetGlobalTriangle(final_tindices[i]);
+
+		int surrounded = true;
+		for(int k=0; k<3; k++) {
+			Triangle* adj_tri = tri->GetAdjacentTriangle(k);
+
+			if(adj_tri != sealed_triangle && binary_search(final_tindices.begin(), final_tindices.end(), adj_tri->GetTriangleIndex()) == false) {
+				surrounded = false;
+				break;
+			}
+		}
+
+		if(surrounded == true)
+			release_tindices.push_back(final_tindices[i]);
+	}
+
+	if(release_tindices.empty() == true)
+		return true;
+
+	//The writer and the global triangle list are shared by the leaf nodes being meshed in parallel
+	#pragma omp critical
+	{
+		for(unsigned int i=0; i<release_tindices.size(); i++)
+			mesh_stream_writer->WriteTriangle(GetGlobalTriangle(release_tindices[i]));
+
+		//Seal the links from the triangles that stay behind
+		for(unsigned int i=0; i<release_tindices.size(); i++) {
+			Triangle* tri = GetGlobalTriangle(release_tindices[i]);
+
+			for(int k=0; k<3; k++) {
+				Triangle* adj_tri = tri->GetAdjacentTriangle(k);
+				if(adj_tri == sealed_triangle || binary_search(release_tindices.begin(), release_tindices.end(), adj_tri->GetTriangleIndex()) == true)
+					continue;
+
+				for(int j=0; j<3; j++) {
+					if(adj_tri->GetAdjacentTriangle(j) == tri) {
+						mesh_stream_writer->SealLink(adj_tri, j, release_tindices[i]);
+						break;
+					}
+				}
+			}
+		}
+
+		for(unsigned int i=0; i<release_tindices.size(); i++)
+			global_mesh_data->ReleaseTriangle(release_tindices[i]);
+	}
+
+	//Drop the freed triangles from this complex
+	unsigned int count = 0;
+	for(unsigned int i=0; i<triangle_list.size(); i++) {
+		if(binary_search(release_tindices.begin(), release_tindices.end(), triangle_list[i]) == false)
+			triangle_list[count++] = triangle_list[i];
+	}
+	triangle_list.resize(count);
+
+	//Vertices that no longer touch a triangle in memory are walled in by the sealed band, and don't need to be
+	//checked by the mesher again, but the incomplete ones are kept for the ancestors to finish
+	vector<unsigned int> kept_vindices = incomplete_vertices;
+
+	for(unsigned int i=0; i<GetTriangleCount(); i++) {
+		Triangle* tri = GetTriangle(i);
+		if(tri == NULL)
+			continue;
+
+		for(int j=0; j<3; j++)
+			kept_vindices.push_back(tri->GetVertexIndex(j));
+	}
+
+	sort(kept_vindices.begin(), kept_vindices.end());
+
+	count = 0;
+	for(unsigned int i=0; i<vertex_list.size(); i++) {
+		if(binary_search(kept_vindices.begin(), kept_vindices.end(), vertex_list[i]) == true)
+			vertex_list[count++] = vertex_list[i];
+	}
+	vertex_list.resize(count);
+
+	return true;
+}
+
+//Number the kd nodes in pre-order, along with the id of each node's parent
+int TriangleComplex::collect_kd_nodes(vector<TriangleComplex*>& nodes, vector<int>& parents, int parent_id) {
+	int id = nodes.size();
+
+	nodes.push_back(this);
+	parents.push_back(parent_id);
+
+	for(int i=0; i<2; i++) {
+		if(kd_child[i] != NULL)
+			kd_child[i]->collect_kd_nodes(nodes, parents, id);
+	}
+
+	return true;
+}
+
+//Delete every node below this one
+int TriangleComplex::free_kd_tree() {
+	for(int i=0; i<2; i++) {
+		if(kd_child[i] == NULL)
+			continue;
+
+		kd_child[i]->free_kd_tree();
+
+		delete kd_child[i];
+		kd_child[i] = NULL;
+	}
+
+	return true;
+}
+
+//Checkpoint file helpers
+int TriangleComplex::write_checkpoint_list(FILE* handle, const vector<unsigned int>& list) {
+	if(list.empty() == true)
+		return true;
+
+	return (fwrite(&list[0], sizeof(unsigned int), list.size(), handle) == list.size());
+}
+
+int TriangleComplex::read_checkpoint_list(const char*& p, const char* end, unsigned int count, vector<unsigned int>& list) {
+	list.resize(count);
+	if(count == 0)
+		return true;
+
+	return read_checkpoint_data(p, end, &list[0], sizeof(unsigned int) * size_t(count));
+}
+
+int TriangleComplex::read_checkpoint_data(const char*& p, const char* end, void* data, size_t size) {
+	if(size_t(end - p) < size)
+		return false;
+
+	memcpy(data, p, size);
+	p += size;
+
+	return true;
+}
+
 int TriangleComplex::compute_kd_prism() {
 	//Safety check
 	if(GetVertexCount() == 0)
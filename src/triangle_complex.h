@@ -4,6 +4,7 @@
 
 #include <string>
 #include <vector>
+#include <queue>
 #include <algorithm>
 using namespace std;
 
@@ -20,6 +21,20 @@ using namespace std;
 
 //Mesh data code
 #include "global_mesh_data.h"
+#include "point_cloud_file.h"
+#include "kd_checkpoint.h"
+#include "mesh_stream_writer.h"
+
+//Refinement code
+#include "delaunay_refiner.h"
+#include "mesh_coarsener.h"
+
+//Smoothing code
+#include "laplacian_smoother.h"
+#include "force_smoother.h"
+
+//Profiling code
+#include "mesher_profiler.h"
 
 #include <omp.h>
 
@@ -28,6 +43,12 @@ using namespace std;
 
 #define MAXIMUM_MESH_SIZE	500
 
+//The Delaunay flipper gives up after testing this many times as many edges as a full sweep over the triangles would
+#define DELAUNAY_MAXIMUM_PASS_COUNT	100
+
+//Complexes with fewer triangles than this are flipped by one thread
+#define PARALLEL_FLIPPER_MIN_TRIANGLES	10000
+
 class TriangleComplex {
 public:
 	TriangleComplex();
@@ -62,6 +83,9 @@ public:
 	int SetTriangleIndex(unsigned int triangle, unsigned int tindex);
 	int AppendTriangleIndex(unsigned int tindex);
 
+	//Append a run of consecutive global indices
+	int AppendTriangleIndices(unsigned int first_tindex, unsigned int count);
+
 	int AppendAllTriangleIndices();
 
 	int SetTriangle(unsigned int tindex, Triangle* tri);
@@ -82,6 +106,9 @@ public:
 	int SetVertexIndex(unsigned int vertex, unsigned int vindex);
 	int AppendVertexIndex(unsigned int vindex);
 
+	//Append a run of consecutive global indices
+	int AppendVertexIndices(unsigned int first_vindex, unsigned int count);
+
 	int AppendAllVertexIndices();
 
 	int RemoveVertex(unsigned int vertex);
@@ -92,6 +119,9 @@ public:
 	int GenerateUniformGrid(double xmin, double xmax, double ymin, double ymax, unsigned int xcount, unsigned int ycount);
 	int GenerateHexGrid(double xmin, double xmax, double ymin, double ymax, unsigned int xcount, unsigned int ycount);
 
+	//Load a large point cloud straight into one vertex block
+	int LoadPointsFromFile(const char* filename, int point_format);
+
 	//These have to do with the meshing process
 	vector<unsigned int> GetIncompleteVertices();
 	vector<double> GetIncompleteVerticesAngles();
@@ -103,7 +133,22 @@ public:
 	///////////////////////
 
 	int RunTriangleMesher();
+	int RunTriangleMesher(const char* checkpoint_filename, unsigned int checkpoint_interval);
+	//Flip the mesh back to Delaunay, after vertices have been moved or triangles added
+	// + the cached circumcircles are recomputed first, and large complexes are flipped in parallel
 	int RunDelaunayFlips();
+	int RunDelaunayFlips(unsigned int maximum_pass_count);
+
+	//The number of edges flipped by the last Delaunay flipper run
+	unsigned int GetDelaunayFlipCount();
+
+	//Pick a kd-tree meshing run back up from a checkpoint
+	int ResumeTriangleMesher(const char* checkpoint_filename, unsigned int checkpoint_interval);
+
+	//Stream triangles out as soon as they are final during kd-tree meshing, and free them
+	// + set on the top node before running the mesher, NULL turns streaming off
+	// + after a streamed run only the triangles along the last seams are left in memory
+	int SetMeshStreamWriter(MeshStreamWriter* mesh_stream_writer);
 
 	int BasicTriangleMesher();
 
@@ -112,8 +157,36 @@ public:
 
 	int StretchedGridMethod(unsigned int iterations, double alpha);
 
+	//Force based smoothing with a time step of alpha, see ForceSmoother
+	// + stops early once no vertex moves more than tolerance times the average edge length in a step, 0 turns it off
+	int StretchedGridMethod(unsigned int iterations, double alpha, double damping, double tolerance);
+
+	//Laplacian smoothing of the interior vertices, see LaplacianSmoother
+	int LaplacianStretchedGridMethod(unsigned int iterations, double alpha);
+
 	int AdjustCellEdgeLength(double desired_edge_length);
 
+	//Refine the mesh until no triangle has an angle under minimum_angle (in degrees) or is bigger than an
+	//equilateral triangle with the desired edge length, 0 turns either criterion off
+	// + one strip of the mesh per thread is refined at a time, see DelaunayRefiner::RefinePartitioned
+	int QualityRefine(double desired_edge_length, double minimum_angle);
+
+	//The same, with a desired edge length that changes over the mesh, see DelaunayRefiner::SetSizingFunction
+	int QualityRefine(double desired_edge_length, double minimum_angle, SizingFunction* sizing_function);
+
+	//Split every triangle 1-to-4 through its edge midpoints, levels times
+	// + with a prism only the triangles with a vertex or their centroid inside it are split 1-to-4, their
+	//   neighbours are split in two to keep the mesh conforming, or in four if two of their edges were split
+	int UniformRefine(unsigned int levels, Prism* prism);
+
+	//Split every triangle 1-to-4 until the average edge length is down to the desired edge length
+	int UniformRefine(double desired_edge_length);
+
+	//Collapse edges shorter than the desired edge length, shortest first, until none are left that can go or
+	//the mesh is down to the target triangle count, 0 turns either limit off
+	// + see MeshCoarsener for which collapses are allowed
+	int CoarsenMesh(double desired_edge_length, unsigned int target_triangle_count);
+
 	/////////////////////////////
 	// Mesh Geometry functions //
 	/////////////////////////////
@@ -163,6 +236,14 @@ public:
 	int AppendBridgeTriangleIndex(unsigned int local_index);
 	int IsBridgeTriangleIndex(unsigned int local_index);
 
+	//Write the whole kd-tree and the global mesh to a checkpoint file
+	// + the file is written next to the old one and renamed over it, so a crash never leaves a partial checkpoint
+	int SaveKDCheckpoint(const char* filename, unsigned int level);
+
+	//Rebuild the kd-tree and the global mesh from a checkpoint file
+	// + this has to be called on the top node, and replaces any mesh and kd-tree it had
+	int LoadKDCheckpoint(const char* filename, unsigned int& level);
+
 	/////////////////////////
 	// Debugging functions //
 	/////////////////////////
@@ -190,13 +271,48 @@ private:
 	int is_vertex_complete(unsigned int vindex, TriangleList adjacent_triangles);
 
 	//The most basic delaunay flipper
+	// + the suspect edges go through a queue, every edge starts in it once, and a flip only queues the four outer
+	//   edges of its two triangles, so the work is proportional to the number of flips
+	// + an edge is queued as a triangle slot, flagged so it is never in the queue twice
 	int basic_delaunay_flipper();
+	int basic_delaunay_flipper(unsigned int maximum_pass_count);
+
+	//Delaunay flipper for meshes with many illegal edges at once, like after smoothing
+	// + every round picks an independent set of the illegal edges by random priority: an edge is flipped if it has the
+	//   highest priority on its two triangles and their four neighbours, so the flips of a round never touch the same
+	//   triangle and run in parallel
+	// + the next round only tests the edges of the flipped triangles, the edges that lost are kept as they are
+	// + the circumcircles have to be cached already, so the tests from many threads only read them
+	int parallel_delaunay_flipper(unsigned int maximum_pass_count);
+
+	//The edge id of a triangle slot if the edge can be flipped and fails the Delaunay test, 0 otherwise
+	// + an edge id is 3 times the smaller of the two triangle indices plus the slot of the edge in that triangle
+	unsigned int find_illegal_edge(Triangle* tri, int opposing_vertex, vector<char>& is_flippable);
+
+	//The triangles a flip of an edge changes, the two triangles of the edge first, then their neighbours or NULL
+	int get_flip_triangles(unsigned int edge, Triangle* flip_triangles[6]);
+
+	//A pseudo-random priority for an edge that changes every round, the edge id keeps it unique
+	static uint64_t compute_flip_priority(unsigned int edge, unsigned int round);
+
+	//Restore the Delaunay condition over the edges of some new triangles
+	// + a flip only exposes the outer edges of the two triangles it makes, so the work stays local to what changed
+	int local_delaunay_flipper(vector<Triangle*>& triangles);
+
+	//Swap one or two triangles for the triangles they were split into
+	// + the new triangles take over the global slots of the old ones first, the rest are appended
+	// + the old triangles have to be unlinked from their neighbours already, as the subdivisions do
+	int replace_triangles(Triangle* tri, Triangle* adj_tri, vector<Triangle*>& new_triangles);
 
 	//The most basic stretched grid method
 	int basic_stretched_grid_method(unsigned int iterations, double alpha);
 
-	//The force based stretched grid method
-	int force_stretched_grid_method(int iterations, double dt);
+	//The force based stretched grid method, see ForceSmoother
+	int force_stretched_grid_method(unsigned int iterations, double dt, double damping, double tolerance);
+
+	//Sort a list of edges and delete the edges that are in it more than once
+	int sort_edge_list(vector<Edge*>& edge_list);
+	static bool compare_edges(Edge* e1, Edge* e2);
 
 	//Cleans up the mesh to remove extra triangles
 	int basic_mesh_cleaner();
@@ -210,8 +326,31 @@ private:
 	int split_obtuse_edges(double desired_edge_length, unsigned int& edge_count, double& average_edge_length);
 
 	//Barycentric subdivide triangles to achieve a desired edge length
+	// + every level splits all the triangles 1-to-4 and halves the average edge length
 	int barycentric_subdivion(double desired_cell_edge_length, double& average_edge_length);
 
+	//One level of 1-to-4 refinement, of every triangle or of the ones in a prism
+	// + the complex has to hold every triangle its triangles are connected to, as the top complex does
+	int uniform_refine_level(Prism* prism);
+
+	//Mesh the leaf nodes and combine them level by level until only the top node is left
+	// + a checkpoint is saved at the start of every checkpoint_interval levels
+	int run_kd_tree_levels(unsigned int level, const char* checkpoint_filename, unsigned int checkpoint_interval);
+
+	//Write out and free the triangles of this complex that can never change again
+	int stream_final_triangles(MeshStreamWriter* mesh_stream_writer);
+
+	//Number the kd nodes in pre-order, along with the id of each node's parent
+	int collect_kd_nodes(vector<TriangleComplex*>& nodes, vector<int>& parents, int parent_id);
+
+	//Delete every node below this one
+	int free_kd_tree();
+
+	//Checkpoint file helpers
+	static int write_checkpoint_list(FILE* handle, const vector<unsigned int>& list);
+	static int read_checkpoint_list(const char*& p, const char* end, unsigned int count, vector<unsigned int>& list);
+	static int read_checkpoint_data(const char*& p, const char* end, void* data, size_t size);
+
 	//Initialize the kd-tree prism based on the vertex list
 	int compute_kd_prism();
 
@@ -245,6 +384,9 @@ private:
 
 	int incomplete_lists_computed;
 
+	//Flips made by the last Delaunay flipper run
+	unsigned int delaunay_flip_count;
+
 	/////////////////////////////
 	// K-d tree structure data //
 	/////////////////////////////
@@ -259,6 +401,9 @@ private:
 	int kd_splitting_dimension;
 
 	vector<unsigned int> kd_bridge_triangles;
+
+	//Where final triangles are streamed to, only used on the top node
+	MeshStreamWriter* mesh_stream_writer;
 };
 
 #endif
@@ -5,13 +5,32 @@ TriangleMesher::TriangleMesher() {
 	mesher_command_stack.clear();
 
 	mesher_command_fail_behaviour = TriangleMesher::QUIT_ON_FAILURE;
+	mesher_command_execution_mode = TriangleMesher::SEQUENTIAL_EXECUTION;
+
+	//Profiling
+	command_filename = "";
+	profile_report_filename = "";
 
 	//The mesh and a complex for the mesher to operate on
 	global_mesh_data = new GlobalMeshData;
 	triangle_complex = new TriangleComplex(global_mesh_data);
+
+	//Background exports
+	async_exports.clear();
+
+	current_snapshot = NULL;
+
+	pthread_mutex_init(&async_export_mutex, NULL);
+	pthread_mutex_init(&snapshot_mutex, NULL);
 }
 
 TriangleMesher::~TriangleMesher() {
+	//The exports can't outlive their commands
+	WaitForAsyncExports();
+
+	pthread_mutex_destroy(&async_export_mutex);
+	pthread_mutex_destroy(&snapshot_mutex);
+
 	delete triangle_complex;
 	triangle_complex = NULL;
 }
@@ -30,12 +49,37 @@ int TriangleMesher::LoadCommandsFromFile(const char* filename) {
 
 	XML_TreeNode* head_node = xml_document->GetHeadNode();
 
+	//The profile report goes next to the command file unless the command list says otherwise
+	command_filename = filename;
+	profile_report_filename = command_filename + ".profile.json";
+
 	vector<XML_TreeNode*> mesh_command_lists;
 	head_node->GetTreeNodesOfTagName("commandlist", mesh_command_lists);
 
 	for(unsigned int i=0; i<mesh_command_lists.size(); i++) {
 		XML_TreeNode* mesh_command_list = mesh_command_lists[i];
 
+		//<commandlist execution="concurrent"> lets independent commands overlap
+		XML_Tag* mesh_command_list_tag = mesh_command_list->GetStartTag();
+		if(mesh_command_list_tag != NULL) {
+			string execution_str = mesh_command_list_tag->GetAttributeValue("execution");
+
+			if(strcmp(execution_str.c_str(), "concurrent") == 0)
+				SetExecutionMode(TriangleMesher::CONCURRENT_EXECUTION);
+
+			else if(strcmp(execution_str.c_str(), "sequential") == 0)
+				SetExecutionMode(TriangleMesher::SEQUENTIAL_EXECUTION);
+
+			//<commandlist profile="no"> or <commandlist profile="report.json">
+			string profile_str = mesh_command_list_tag->GetAttributeValue("profile");
+
+			if(strcmp(profile_str.c_str(), "no") == 0)
+				SetProfileReport("");
+
+			else if(strcmp(profile_str.c_str(), "yes") != 0 && profile_str != "")
+				SetProfileReport(profile_str.c_str());
+		}
+
 		vector<XML_Tag*> mesh_command_tags;
 		mesh_command_list->GetOpenCloseTags(mesh_command_tags);
 
@@ -94,6 +138,29 @@ int TriangleMesher::ClearMesherCommands() {
 	return true;
 }
 
+//Put the mesher back the way it was constructed, so it can run another command file
+int TriangleMesher::Reset() {
+	WaitForAsyncExports();
+	ClearMesherCommands();
+
+	mesher_command_fail_behaviour = TriangleMesher::QUIT_ON_FAILURE;
+	mesher_command_execution_mode = TriangleMesher::SEQUENTIAL_EXECUTION;
+
+	//Profiling
+	mesher_profiler.Clear();
+
+	command_filename = "";
+	profile_report_filename = "";
+
+	//The mesh and a complex for the mesher to operate on
+	delete triangle_complex;
+
+	global_mesh_data->FreeAllData();
+	triangle_complex = new TriangleComplex(global_mesh_data);
+
+	return true;
+}
+
 //This lets you choose whether to stop/continue if one command fails
 int TriangleMesher::SetFailBehaviour(int mesher_command_fail_behaviour) {
 	this->mesher_command_fail_behaviour = mesher_command_fail_behaviour;
@@ -101,6 +168,14 @@ int TriangleMesher::SetFailBehaviour(int mesher_command_fail_behaviour) {
 	return true;
 }
 
+//This lets you choose whether the commands run strictly in order, or whether commands that don't
+//depend on each other (like several exports of the same mesh) run at the same time
+int TriangleMesher::SetExecutionMode(int mesher_command_execution_mode) {
+	this->mesher_command_execution_mode = mesher_command_execution_mode;
+
+	return true;
+}
+
 //Once all the commands have been run, their results are populated
 int TriangleMesher::GetMesherCommandResult(unsigned int index) {
 	if(index >= GetMesherCommandCount() || GetMesherCommand(index) == NULL)
@@ -109,30 +184,131 @@ int TriangleMesher::GetMesherCommandResult(unsigned int index) {
 	return GetMesherCommand(index)->mesher_command_result;
 }
 
+//Write a json profile of every command to this file after RunMesherCommands, an empty name turns it off
+int TriangleMesher::SetProfileReport(const char* filename) {
+	profile_report_filename = filename;
+	return true;
+}
+
+//The profiles of the last RunMesherCommands
+MesherProfiler* TriangleMesher::GetMesherProfiler() {
+	return &mesher_profiler;
+}
+
+//Predict the element counts, memory and run time of every command without running any of them
+int TriangleMesher::EstimateMesherCommands(MesherCostModel* cost_model, vector<CommandEstimate>& estimates) {
+	//The commands start from whatever mesh is already loaded
+	double vertex_count = 0;
+	for(unsigned int i=1; i<global_mesh_data->GetVertexCount(); i++) {
+		if(global_mesh_data->GetVertex(i) != NULL)
+			vertex_count++;
+	}
+
+	double triangle_count = 0;
+	for(unsigned int i=1; i<global_mesh_data->GetTriangleCount(); i++) {
+		if(global_mesh_data->GetTriangle(i) != NULL)
+			triangle_count++;
+	}
+
+	return cost_model->EstimateCommands(mesher_command_stack, vertex_count, triangle_count, estimates);
+}
+
+//Fit a cost model to the profiles of the last RunMesherCommands
+int TriangleMesher::CalibrateCostModel(MesherCostModel* cost_model) {
+	return cost_model->Calibrate(&mesher_profiler, mesher_command_stack);
+}
+
 //This actually runs all of the mesher commands you set
 int TriangleMesher::RunMesherCommands() {
-	for(unsigned int i=0; i<GetMesherCommandCount(); i++) {
-		MesherCommand* mc = GetMesherCommand(i);
+	int ret = true;
 
-		if(mc != NULL) {
-			printf("\nRunning command %u\n", i);
-			mc->print();
-			printf("\n");
+	mesher_profiler.Clear();
+	double start_time = MesherProfiler::GetWallTime();
 
-			int ret = RunMesherCommand(mc);
+	if(mesher_command_execution_mode == TriangleMesher::CONCURRENT_EXECUTION)
+		ret = run_concurrent_mesher_commands();
 
-			if(ret == false && mesher_command_fail_behaviour == TriangleMesher::QUIT_ON_FAILURE)
-				return false;
+	else {
+		for(unsigned int i=0; i<GetMesherCommandCount(); i++) {
+			MesherCommand* mc = GetMesherCommand(i);
+
+			if(mc != NULL) {
+				printf("\nRunning command %u\n", i);
+				mc->print();
+				printf("\n");
+
+				if(RunMesherCommand(mc) == false && mesher_command_fail_behaviour == TriangleMesher::QUIT_ON_FAILURE) {
+					ret = false;
+					break;
+				}
+			}
 		}
 	}
 
-	return true;
+	//Every background export is done before returning, a failed one counts like any other failed command
+	if(WaitForAsyncExports() == false && mesher_command_fail_behaviour == TriangleMesher::QUIT_ON_FAILURE)
+		ret = false;
+
+	if(profile_report_filename != "") {
+		//The async exports only have their results now
+		for(unsigned int i=0; i<mesher_profiler.GetCommandProfileCount(); i++) {
+			CommandProfile* profile = mesher_profiler.GetCommandProfile(i);
+
+			if(profile->command_index < GetMesherCommandCount())
+				profile->result = GetMesherCommandResult(profile->command_index);
+		}
+
+		if(mesher_profiler.WriteReport(profile_report_filename.c_str(), command_filename.c_str(), MesherProfiler::GetWallTime() - start_time) == true)
+			printf("Wrote the profile report %s\n", profile_report_filename.c_str());
+	}
+
+	return ret;
 }
 
 //Run a mesher command
 int TriangleMesher::RunMesherCommand(MesherCommand* mc) {
+	unsigned int command_index = 0;
+	while(command_index < GetMesherCommandCount() && GetMesherCommand(command_index) != mc)
+		command_index++;
+
+	int is_async_export = (mc->async_export == true && (mc->command_type == MesherCommand::SAVE_MESH_TO_FILE || mc->command_type == MesherCommand::WRITE_SVG));
+
+	CommandProfile profile;
+	mesher_profiler.BeginCommand(profile, command_index, mc->GetCommandName(), is_async_export, mc->GetMeshAccess(), global_mesh_data);
+
+	int ret = run_mesher_command(mc);
+
+	mesher_profiler.EndCommand(profile, mc->mesher_command_result, global_mesh_data);
+
+	return ret;
+}
+
+//Run a mesher command without profiling it
+int TriangleMesher::run_mesher_command(MesherCommand* mc) {
 	int ret = false;
 
+	int is_async_export = (mc->async_export == true && (mc->command_type == MesherCommand::SAVE_MESH_TO_FILE || mc->command_type == MesherCommand::WRITE_SVG));
+	int async_export_started = false;
+
+	//Background exports that share a file with this command have to finish first
+	wait_for_async_exports(mc);
+
+	if(is_async_export == true)
+		async_export_started = start_async_export(mc);
+
+	//The snapshot is out of date once the mesh changes
+	else if(mc->GetMeshAccess() == MesherCommand::WRITE_MESH_ACCESS)
+		release_snapshot();
+
+	if(is_async_export == true) {
+		if(async_export_started == false) {
+			mc->mesher_command_result = MesherCommand::FAILURE_RESULT;
+			return false;
+		}
+
+		return true;
+	}
+
 	//Figure out which command to execute and run it
 	if(mc->command_type == MesherCommand::GENERATE_RANDOM_GRID)
 		ret = GenerateRandomGrid(mc->xmin, mc->xmax, mc->ymin, mc->ymax, mc->vertex_count);
@@ -143,17 +319,23 @@ int TriangleMesher::RunMesherCommand(MesherCommand* mc) {
 	else if(mc->command_type == MesherCommand::GENERATE_HEX_GRID)
 		ret = GenerateHexGrid(mc->xmin, mc->xmax, mc->ymin, mc->ymax, mc->xcount, mc->ycount);
 
+	else if(mc->command_type == MesherCommand::LOAD_POINTS_FROM_FILE)
+		ret = LoadPointsFromFile(mc->filename, mc->point_format);
+
 	else if(mc->command_type == MesherCommand::RUN_TRIANGLE_MESHER)
-		ret = RunTriangleMesher(mc->use_kd_tree);
+		ret = RunTriangleMesher(mc->use_kd_tree, mc->checkpoint_filename, mc->checkpoint_interval, mc->stream_filename);
+
+	else if(mc->command_type == MesherCommand::RESUME_TRIANGLE_MESHER)
+		ret = ResumeTriangleMesher(mc->checkpoint_filename, mc->checkpoint_interval);
 
 	else if(mc->command_type == MesherCommand::LOAD_MESH_FROM_FILE)
-		ret = LoadMeshFromFile(mc->filename, mc->load_save_triangles);
+		ret = LoadMeshFromFile(mc->filename, mc->load_save_triangles, mc->file_format);
 
 	else if(mc->command_type == MesherCommand::SAVE_MESH_TO_FILE)
-		ret = SaveMeshToFile(mc->filename, mc->load_save_triangles);
+		ret = SaveMeshToFile(mc->filename, mc->load_save_triangles, mc->file_format, mc->quantization_bits);
 
 	else if(mc->command_type == MesherCommand::WRITE_SVG)
-		ret = WriteSVG(mc->svg_filename, mc->svg_width, mc->svg_height);
+		ret = WriteSVG(mc->svg_filename, mc->svg_width, mc->svg_height, (mc->svg_use_viewport ? &mc->svg_viewport : NULL), mc->svg_merge_subpixel, mc->svg_draw_vertices, mc->svg_max_elements);
 
 	else if(mc->command_type == MesherCommand::SUBDIVIDE_TRIANGLE)
 		ret = SubdivideTriangle(mc->subdivide_vindex, mc->subdivide_triangle_local_index);
@@ -164,11 +346,24 @@ int TriangleMesher::RunMesherCommand(MesherCommand* mc) {
 	else if(mc->command_type == MesherCommand::BASIC_TRIANGLE_MESHER)
 		ret = BasicTriangleMesher();
 
+	else if(mc->command_type == MesherCommand::BASIC_DELAUNAY_FLIPPER)
+		ret = BasicDelaunayFlipper(mc->delaunay_max_iterations);
+
 	else if(mc->command_type == MesherCommand::STRETCHED_GRID)
-		ret = StretchedGrid(mc->stretched_grid_iterations, mc->stretched_grid_alpha);
+		ret = StretchedGrid(mc->stretched_grid_iterations, mc->stretched_grid_alpha, mc->stretched_grid_method, mc->stretched_grid_damping, mc->stretched_grid_tolerance);
 
 	else if(mc->command_type == MesherCommand::REFINE_MESH)
-		ret = RefineMesh(mc->desired_edge_length);
+		ret = refine_mesh(mc);
+
+	else if(mc->command_type == MesherCommand::UNIFORM_REFINE) {
+		if(mc->desired_edge_length > 0)
+			ret = UniformRefine(mc->desired_edge_length);
+		else
+			ret = UniformRefine(mc->uniform_refine_levels, (mc->uniform_refine_use_prism ? &mc->uniform_refine_prism : NULL));
+	}
+
+	else if(mc->command_type == MesherCommand::COARSEN_MESH)
+		ret = CoarsenMesh(mc->desired_edge_length, mc->coarsen_triangle_count);
 
 	else if(mc->command_type == MesherCommand::DO_NOTHING)
 		ret = true;
@@ -188,6 +383,15 @@ int TriangleMesher::RunMesherCommand(MesherCommand* mc) {
 	return true;
 }
 
+//Wait for the background exports to finish and fill in their results
+// + returns false if any of them failed
+int TriangleMesher::WaitForAsyncExports() {
+	int ret = wait_for_async_exports(NULL);
+	release_snapshot();
+
+	return ret;
+}
+
 
 //Debugging function
 int TriangleMesher::PrintMesherCommands() {
@@ -231,14 +435,70 @@ int TriangleMesher::GenerateHexGrid(double xmin, double xmax, double ymin, doubl
 	return true;
 }
 
+int TriangleMesher::LoadPointsFromFile(const char* filename, int point_format) {
+	int ret = triangle_complex->LoadPointsFromFile(filename, point_format);
+
+	return ret;
+}
+
 int TriangleMesher::RunTriangleMesher(int UseKdTree) {
 	int ret = triangle_complex->RunTriangleMesher();
 
 	return ret;
 }
 
+int TriangleMesher::RunTriangleMesher(int UseKdTree, const char* checkpoint_filename, unsigned int checkpoint_interval) {
+	//No checkpoints without a file to put them in
+	if(checkpoint_filename == NULL || strcmp(checkpoint_filename, "") == 0)
+		return RunTriangleMesher(UseKdTree);
+
+	int ret = triangle_complex->RunTriangleMesher(checkpoint_filename, checkpoint_interval);
+
+	return ret;
+}
+
+int TriangleMesher::RunTriangleMesher(int UseKdTree, const char* checkpoint_filename, unsigned int checkpoint_interval, const char* stream_filename) {
+	if(stream_filename == NULL || strcmp(stream_filename, "") == 0)
+		return RunTriangleMesher(UseKdTree, checkpoint_filename, checkpoint_interval);
+
+	//A checkpoint can't bring back the triangles that were already streamed out
+	if(checkpoint_filename != NULL && strcmp(checkpoint_filename, "") != 0) {
+		printf("Error: a streamed mesher run can't be checkpointed\n");
+		return false;
+	}
+
+	MeshStreamWriter mesh_stream_writer;
+	if(mesh_stream_writer.Open(stream_filename, global_mesh_data) == false)
+		return false;
+
+	triangle_complex->SetMeshStreamWriter(&mesh_stream_writer);
+	int ret = triangle_complex->RunTriangleMesher();
+	triangle_complex->SetMeshStreamWriter(NULL);
+
+	//The triangles left in memory finish off the file
+	if(mesh_stream_writer.Close() == false)
+		ret = false;
+
+	return ret;
+}
+
+int TriangleMesher::ResumeTriangleMesher(const char* checkpoint_filename, unsigned int checkpoint_interval) {
+	if(strcmp(checkpoint_filename, "") == 0) {
+		printf("Error: ResumeTriangleMesher needs a checkpoint file\n");
+		return false;
+	}
+
+	int ret = triangle_complex->ResumeTriangleMesher(checkpoint_filename, checkpoint_interval);
+
+	return ret;
+}
+
 int TriangleMesher::LoadMeshFromFile(const char* filename, int load_triangles) {
-	if(global_mesh_data->LoadFromFile(filename, load_triangles) == false)
+	return LoadMeshFromFile(filename, load_triangles, GlobalMeshData::UNKNOWN_FILE_FORMAT);
+}
+
+int TriangleMesher::LoadMeshFromFile(const char* filename, int load_triangles, int file_format) {
+	if(global_mesh_data->LoadFromFile(filename, load_triangles, file_format) == false)
 		return false;
 
 	if(triangle_complex->AppendAllGlobalMeshData() == false)
@@ -248,19 +508,38 @@ int TriangleMesher::LoadMeshFromFile(const char* filename, int load_triangles) {
 }
 
 int TriangleMesher::SaveMeshToFile(const char* filename, int save_triangles) {
-	int ret = global_mesh_data->SaveToFile(filename, save_triangles);
+	return SaveMeshToFile(filename, save_triangles, GlobalMeshData::UNKNOWN_FILE_FORMAT);
+}
+
+int TriangleMesher::SaveMeshToFile(const char* filename, int save_triangles, int file_format) {
+	int ret = global_mesh_data->SaveToFile(filename, save_triangles, file_format);
 
 	return ret;
 }
 
+int TriangleMesher::SaveMeshToFile(const char* filename, int save_triangles, int file_format, unsigned int quantization_bits) {
+	return save_mesh(global_mesh_data, filename, save_triangles, file_format, quantization_bits);
+}
+
+//Write the mesh in the binary mesh layout to an open stream
+int TriangleMesher::SaveMeshToBinaryStream(FILE* handle, int save_triangles) {
+	return global_mesh_data->SaveToBinaryStream(handle, save_triangles);
+}
+
 int TriangleMesher::WriteSVG(const char* filename, double svg_width, double svg_height) {
 	int ret = global_mesh_data->WriteSVG(filename, svg_width, svg_height);
 
 	return ret;
 }
 
+int TriangleMesher::WriteSVG(const char* filename, double svg_width, double svg_height, Prism* viewport, int merge_subpixel, int draw_vertices, unsigned int max_elements) {
+	return write_svg(global_mesh_data, filename, svg_width, svg_height, viewport, merge_subpixel, draw_vertices, max_elements);
+}
+
 int TriangleMesher::AppendVertex(Vector2d vertex) {
-	return true;
+	unsigned int vindex = global_mesh_data->AppendVertex(new Vector2d(vertex.x, vertex.y));
+
+	return triangle_complex->AppendVertexIndex(vindex);
 }
 
 int TriangleMesher::SubdivideTriangle(unsigned int vindex, unsigned int triangle_local_index) {
@@ -282,7 +561,9 @@ int TriangleMesher::BasicTriangleMesher() {
 }
 
 int TriangleMesher::BasicDelaunayFlipper(unsigned int delaunay_max_iterations) {
-	return true;
+	int ret = triangle_complex->RunDelaunayFlips(delaunay_max_iterations);
+
+	return ret;
 }
 
 int TriangleMesher::StretchedGrid(unsigned int iterations, double alpha) {
@@ -291,12 +572,124 @@ int TriangleMesher::StretchedGrid(unsigned int iterations, double alpha) {
 	return ret;
 }
 
+int TriangleMesher::StretchedGrid(unsigned int iterations, double alpha, int stretched_grid_method) {
+	return StretchedGrid(iterations, alpha, stretched_grid_method, 0.0, 0.0);
+}
+
+int TriangleMesher::StretchedGrid(unsigned int iterations, double alpha, int stretched_grid_method, double damping, double tolerance) {
+	if(stretched_grid_method == MesherCommand::LAPLACIAN_STRETCHED_GRID_METHOD) {
+		int ret = triangle_complex->LaplacianStretchedGridMethod(iterations, alpha);
+
+		return ret;
+	}
+
+	int ret = triangle_complex->StretchedGridMethod(iterations, alpha, damping, tolerance);
+
+	return ret;
+}
+
 int TriangleMesher::RefineMesh(double desired_edge_length) {
 	int ret = triangle_complex->AdjustCellEdgeLength(desired_edge_length);
 
 	return ret;
 }
 
+int TriangleMesher::RefineMesh(double desired_edge_length, int refine_method, double minimum_angle) {
+	return RefineMesh(desired_edge_length, refine_method, minimum_angle, NULL);
+}
+
+//Refine to a desired edge length that changes over the mesh
+int TriangleMesher::RefineMesh(double desired_edge_length, int refine_method, double minimum_angle, SizingFunction* sizing_function) {
+	if(refine_method == MesherCommand::OBTUSE_REFINE_METHOD) {
+		if(sizing_function != NULL)
+			printf("Warning: the obtuse refine method ignores the sizing function\n");
+
+		return RefineMesh(desired_edge_length);
+	}
+
+	int ret = triangle_complex->QualityRefine(desired_edge_length, minimum_angle, sizing_function);
+
+	return ret;
+}
+
+int TriangleMesher::UniformRefine(unsigned int levels, Prism* prism) {
+	int ret = triangle_complex->UniformRefine(levels, prism);
+
+	return ret;
+}
+
+int TriangleMesher::UniformRefine(double desired_edge_length) {
+	int ret = triangle_complex->UniformRefine(desired_edge_length);
+
+	return ret;
+}
+
+int TriangleMesher::CoarsenMesh(double desired_edge_length, unsigned int target_triangle_count) {
+	int ret = triangle_complex->CoarsenMesh(desired_edge_length, target_triangle_count);
+
+	return ret;
+}
+
+////////////////////////
+// Bulk data transfer //
+////////////////////////
+
+//Add many vertices in one pass, copied from separate x and y arrays or from one interleaved xy array
+unsigned int TriangleMesher::AppendVertices(const double* x, const double* y, unsigned int count) {
+	unsigned int first_vindex = global_mesh_data->AppendVertices(x, y, count);
+	if(first_vindex != 0)
+		triangle_complex->AppendVertexIndices(first_vindex, count);
+
+	return first_vindex;
+}
+
+unsigned int TriangleMesher::AppendVertices(const double* xy, unsigned int count) {
+	unsigned int first_vindex = global_mesh_data->AppendVertices(xy, count);
+	if(first_vindex != 0)
+		triangle_complex->AppendVertexIndices(first_vindex, count);
+
+	return first_vindex;
+}
+
+//Use an interleaved xy array for the vertices without copying it
+unsigned int TriangleMesher::AdoptVertices(double* xy, unsigned int count) {
+	unsigned int first_vindex = global_mesh_data->AdoptVertices(xy, count);
+	if(first_vindex != 0)
+		triangle_complex->AppendVertexIndices(first_vindex, count);
+
+	return first_vindex;
+}
+
+//Add count triangles from 3*count global vertex indices, connecting the ones that share an edge
+unsigned int TriangleMesher::AppendTriangles(const uint32_t* vertex_indices, unsigned int count) {
+	unsigned int first_tindex = global_mesh_data->AppendTriangles(vertex_indices, count);
+	if(first_tindex != 0)
+		triangle_complex->AppendTriangleIndices(first_tindex, count);
+
+	return first_tindex;
+}
+
+//The mesh in slot order
+unsigned int TriangleMesher::GetVertexSlotCount() {
+	return global_mesh_data->GetVertexCount();
+}
+
+unsigned int TriangleMesher::GetTriangleSlotCount() {
+	return global_mesh_data->GetTriangleCount();
+}
+
+int TriangleMesher::ExportVertices(double* xy) {
+	return global_mesh_data->ExportVertices(xy);
+}
+
+int TriangleMesher::ExportVertices(double* x, double* y) {
+	return global_mesh_data->ExportVertices(x, y);
+}
+
+int TriangleMesher::ExportTriangles(uint32_t* vertex_indices, uint32_t* neighbours) {
+	return global_mesh_data->ExportTriangles(vertex_indices, neighbours);
+}
+
 /////////////////////
 // Data management //
 /////////////////////
@@ -304,3 +697,272 @@ int TriangleMesher::RefineMesh(double desired_edge_length) {
 TriangleComplex* TriangleMesher::GetTriangleComplex() {
 	return triangle_complex;
 }
+
+////////////////////////////
+// Internal use functions //
+////////////////////////////
+
+//Refine with the options of a command, loading its sizing function sources first
+int TriangleMesher::refine_mesh(MesherCommand* mc) {
+	SizingFunction sizing_function;
+
+	if(strcmp(mc->sizing_grid_filename, "") != 0 && sizing_function.LoadGridFile(mc->sizing_grid_filename) == false)
+		return false;
+
+	if(strcmp(mc->sizing_sources_filename, "") != 0 && sizing_function.LoadPointSourceFile(mc->sizing_sources_filename) == false)
+		return false;
+
+	if(strcmp(mc->sizing_mesh_filename, "") != 0 && sizing_function.LoadBackgroundMesh(mc->sizing_mesh_filename) == false)
+		return false;
+
+	if(sizing_function.IsEmpty() == true)
+		return RefineMesh(mc->desired_edge_length, mc->refine_method, mc->refine_minimum_angle);
+
+	return RefineMesh(mc->desired_edge_length, mc->refine_method, mc->refine_minimum_angle, &sizing_function);
+}
+
+//Run the commands in waves, every command in a wave only depends on commands in earlier waves
+// + a command goes in the wave after the last earlier command it conflicts with, so the commands that
+//   touch the same data still run in their original order and the results match a sequential run
+// + on QUIT_ON_FAILURE the waves after a failure don't run, but the rest of its own wave may already have
+int TriangleMesher::run_concurrent_mesher_commands() {
+	unsigned int command_count = GetMesherCommandCount();
+
+	vector<unsigned int> command_wave(command_count, 0);
+	unsigned int wave_count = 0;
+
+	for(unsigned int i=0; i<command_count; i++) {
+		MesherCommand* mc = GetMesherCommand(i);
+		if(mc == NULL)
+			continue;
+
+		for(unsigned int j=0; j<i; j++) {
+			MesherCommand* mc_j = GetMesherCommand(j);
+
+			if(mc_j != NULL && command_wave[j] >= command_wave[i] && mc->ConflictsWith(mc_j) == true)
+				command_wave[i] = command_wave[j] + 1;
+		}
+
+		if(command_wave[i] + 1 > wave_count)
+			wave_count = command_wave[i] + 1;
+	}
+
+	for(unsigned int wave=0; wave<wave_count; wave++) {
+		vector<unsigned int> wave_commands;
+
+		for(unsigned int i=0; i<command_count; i++) {
+			if(GetMesherCommand(i) != NULL && command_wave[i] == wave)
+				wave_commands.push_back(i);
+		}
+
+		//The commands are printed up front so their descriptions don't get mixed up
+		for(unsigned int i=0; i<wave_commands.size(); i++) {
+			printf("\nRunning command %u", wave_commands[i]);
+			if(wave_commands.size() > 1)
+				printf(" (%u at the same time)", (unsigned int) wave_commands.size());
+			printf("\n");
+
+			GetMesherCommand(wave_commands[i])->print();
+			printf("\n");
+		}
+
+		int wave_failed = false;
+
+		#pragma omp parallel for schedule(dynamic, 1) if(wave_commands.size() > 1)
+		for(int i=0; i<int(wave_commands.size()); i++) {
+			if(RunMesherCommand(GetMesherCommand(wave_commands[i])) == false) {
+				#pragma omp critical
+				wave_failed = true;
+			}
+		}
+
+		if(wave_failed == true && mesher_command_fail_behaviour == TriangleMesher::QUIT_ON_FAILURE)
+			return false;
+	}
+
+	return true;
+}
+
+//Start a save or svg export in the background
+// + the exports started between two changes to the mesh share one snapshot of it, the first of them pays for a
+//   deep copy of the mesh
+int TriangleMesher::start_async_export(MesherCommand* mc) {
+	pthread_mutex_lock(&async_export_mutex);
+
+	MeshSnapshot* snapshot = current_snapshot;
+	if(snapshot != NULL) {
+		pthread_mutex_lock(&snapshot_mutex);
+		snapshot->reference_count++;
+		pthread_mutex_unlock(&snapshot_mutex);
+	}
+
+	pthread_mutex_unlock(&async_export_mutex);
+
+	//Copy the mesh without holding the lock, it only has to be shared once it is done
+	if(snapshot == NULL) {
+		double start_time = MesherProfiler::GetWallTime();
+
+		snapshot = new MeshSnapshot;
+		snapshot->global_mesh_data = new GlobalMeshData;
+		snapshot->reference_count = 1;
+
+		snapshot->global_mesh_data->CopyFrom(global_mesh_data);
+
+		double elapsed_time = MesherProfiler::GetWallTime() - start_time;
+		MesherProfiler::AddPhaseTime("mesh_snapshot", elapsed_time);
+
+		printf("Time spent taking a mesh snapshot: %fs\n", elapsed_time);
+
+		//Later exports share it, unless another export of the same mesh got there first
+		pthread_mutex_lock(&async_export_mutex);
+
+		if(current_snapshot == NULL) {
+			snapshot->reference_count++;
+			current_snapshot = snapshot;
+		}
+
+		pthread_mutex_unlock(&async_export_mutex);
+	}
+
+	AsyncExport* async_export = new AsyncExport;
+	async_export->mc = mc;
+	async_export->snapshot = snapshot;
+	async_export->snapshot_mutex = &snapshot_mutex;
+	async_export->result = false;
+
+	if(pthread_create(&async_export->thread, NULL, run_async_export, async_export) != 0) {
+		printf("Error: could not start a background export\n");
+
+		release_snapshot(async_export->snapshot, async_export->snapshot_mutex);
+		delete async_export;
+
+		return false;
+	}
+
+	pthread_mutex_lock(&async_export_mutex);
+	async_exports.push_back(async_export);
+	pthread_mutex_unlock(&async_export_mutex);
+
+	return true;
+}
+
+//Wait for the background exports that share a file with a command, or all of them if it is NULL
+int TriangleMesher::wait_for_async_exports(MesherCommand* mc) {
+	//Take the exports to wait for out of the list, then join them without holding the lock
+	vector<AsyncExport*> finished_exports;
+
+	pthread_mutex_lock(&async_export_mutex);
+
+	for(unsigned int i=0; i<async_exports.size(); i++) {
+		if(mc != NULL && mc->FileConflictsWith(async_exports[i]->mc) == false)
+			continue;
+
+		finished_exports.push_back(async_exports[i]);
+
+		async_exports.erase(async_exports.begin() + i);
+		i--;
+	}
+
+	pthread_mutex_unlock(&async_export_mutex);
+
+	int ret = true;
+
+	for(unsigned int i=0; i<finished_exports.size(); i++) {
+		AsyncExport* async_export = finished_exports[i];
+
+		pthread_join(async_export->thread, NULL);
+
+		if(async_export->result == false) {
+			async_export->mc->mesher_command_result = MesherCommand::FAILURE_RESULT;
+			ret = false;
+		}
+		else
+			async_export->mc->mesher_command_result = MesherCommand::SUCCESS_RESULT;
+
+		delete async_export;
+	}
+
+	return ret;
+}
+
+//Drop a reference to a snapshot, the last one frees it
+int TriangleMesher::release_snapshot() {
+	pthread_mutex_lock(&async_export_mutex);
+
+	MeshSnapshot* snapshot = current_snapshot;
+	current_snapshot = NULL;
+
+	pthread_mutex_unlock(&async_export_mutex);
+
+	if(snapshot != NULL)
+		release_snapshot(snapshot, &snapshot_mutex);
+
+	return true;
+}
+
+int TriangleMesher::release_snapshot(MeshSnapshot* snapshot, pthread_mutex_t* snapshot_mutex) {
+	pthread_mutex_lock(snapshot_mutex);
+	snapshot->reference_count--;
+	int last_reference = (snapshot->reference_count == 0);
+	pthread_mutex_unlock(snapshot_mutex);
+
+	if(last_reference == true) {
+		delete snapshot->global_mesh_data;
+		delete snapshot;
+	}
+
+	return true;
+}
+
+void* TriangleMesher::run_async_export(void* data) {
+	AsyncExport* async_export = (AsyncExport*) data;
+
+	MesherCommand* mc = async_export->mc;
+	GlobalMeshData* snapshot_mesh_data = async_export->snapshot->global_mesh_data;
+
+	if(mc->command_type == MesherCommand::SAVE_MESH_TO_FILE)
+		async_export->result = save_mesh(snapshot_mesh_data, mc->filename, mc->load_save_triangles, mc->file_format, mc->quantization_bits);
+
+	else if(mc->command_type == MesherCommand::WRITE_SVG)
+		async_export->result = write_svg(snapshot_mesh_data, mc->svg_filename, mc->svg_width, mc->svg_height, (mc->svg_use_viewport ? &mc->svg_viewport : NULL), mc->svg_merge_subpixel, mc->svg_draw_vertices, mc->svg_max_elements);
+
+	//The snapshot can go as soon as the last export using it is done
+	release_snapshot(async_export->snapshot, async_export->snapshot_mutex);
+	async_export->snapshot = NULL;
+
+	return NULL;
+}
+
+//The exports, on any copy of the mesh
+int TriangleMesher::save_mesh(GlobalMeshData* global_mesh_data, const char* filename, int save_triangles, int file_format, unsigned int quantization_bits) {
+	if(file_format == GlobalMeshData::UNKNOWN_FILE_FORMAT)
+		file_format = GlobalMeshData::GetFileFormat(filename);
+
+	//Only compressed files can be quantized
+	if(file_format == GlobalMeshData::COMPRESSED_FILE_FORMAT)
+		return global_mesh_data->SaveToCompressedFile(filename, save_triangles, quantization_bits);
+
+	return global_mesh_data->SaveToFile(filename, save_triangles, file_format);
+}
+
+int TriangleMesher::write_svg(GlobalMeshData* global_mesh_data, const char* filename, double svg_width, double svg_height, Prism* viewport, int merge_subpixel, int draw_vertices, unsigned int max_elements) {
+	SVGWriter svg_writer;
+
+	if(svg_writer.SetSize(svg_width, svg_height) == false) {
+		printf("Error: the svg size must be positive\n");
+		return false;
+	}
+
+	if(viewport != NULL && svg_writer.SetViewport(*viewport) == false) {
+		printf("Error: the svg viewport is empty\n");
+		return false;
+	}
+
+	svg_writer.SetMergeSubpixelTriangles(merge_subpixel);
+	svg_writer.SetDrawVertices(draw_vertices);
+	svg_writer.SetElementBudget(max_elements);
+
+	int ret = svg_writer.Write(filename, global_mesh_data);
+
+	return ret;
+}
@@ -7,6 +7,8 @@
 #include <algorithm>
 using namespace std;
 
+#include <pthread.h>
+
 //XML i/o code
 #include "SimpleXML/src/xml_document.h"
 
@@ -15,13 +17,33 @@ using namespace std;
 #include "vector2d.h"
 #include "triangle_complex.h"
 #include "mesher_command.h"
+#include "mesher_profiler.h"
+#include "mesher_cost_model.h"
 
 //Mesh data code
 #include "global_mesh_data.h"
+#include "svg_writer.h"
 
 #ifndef TRIANGLE_MESHER
 #define TRIANGLE_MESHER
 
+//A copy of the mesh, shared by the background exports started between two changes to the mesh
+struct MeshSnapshot {
+	GlobalMeshData* global_mesh_data;
+	unsigned int reference_count;
+};
+
+//A save or svg export running in the background on a snapshot
+struct AsyncExport {
+	pthread_t thread;
+
+	MesherCommand* mc;
+	MeshSnapshot* snapshot;
+	pthread_mutex_t* snapshot_mutex;
+
+	int result;
+};
+
 class TriangleMesher {
 public:
 	TriangleMesher();
@@ -42,6 +64,10 @@ public:
 
 	int ClearMesherCommands();
 
+	//Put the mesher back the way it was constructed, so it can run another command file
+	// + the mesh lists keep their capacity, so a mesher reused for many small jobs stops reallocating them
+	int Reset();
+
 	//This lets you choose whether to stop/continue if one command fails
 	int SetFailBehaviour(int mesher_command_fail_behaviour);
 	enum {
@@ -49,15 +75,41 @@ public:
 		CONTINUE_ON_FAILURE
 	};
 
+	//This lets you choose whether the commands run strictly in order, or whether commands that don't
+	//depend on each other (like several exports of the same mesh) run at the same time
+	int SetExecutionMode(int mesher_command_execution_mode);
+	enum {
+		SEQUENTIAL_EXECUTION=0,
+		CONCURRENT_EXECUTION
+	};
+
 	//Once all the commands have been run, their results are populated
 	int GetMesherCommandResult(unsigned int index);
 
+	//Write a json profile of every command to this file after RunMesherCommands, an empty name turns it off
+	// + LoadCommandsFromFile defaults it to <command file>.profile.json, <commandlist profile="no|filename"> overrides that
+	int SetProfileReport(const char* filename);
+
+	//The profiles of the last RunMesherCommands
+	MesherProfiler* GetMesherProfiler();
+
+	//Predict the element counts, memory and run time of every command without running any of them
+	int EstimateMesherCommands(MesherCostModel* cost_model, vector<CommandEstimate>& estimates);
+
+	//Fit a cost model to the profiles of the last RunMesherCommands
+	int CalibrateCostModel(MesherCostModel* cost_model);
+
 	//This actually runs all of the mesher commands you set
 	int RunMesherCommands();
 
 	//Run a mesher command
+	// + async saves and svg exports only get started here, their results are filled in once they are waited for
 	int RunMesherCommand(MesherCommand* mc);
 
+	//Wait for the background exports to finish and fill in their results
+	// + returns false if any of them failed
+	int WaitForAsyncExports();
+
 	//Debugging function
 	int PrintMesherCommands();
 
@@ -69,12 +121,30 @@ public:
 	int GenerateUniformGrid(double xmin, double xmax, double ymin, double ymax, unsigned int xcount, unsigned int ycount);
 	int GenerateHexGrid(double xmin, double xmax, double ymin, double ymax, unsigned int xcount, unsigned int ycount);
 
+	int LoadPointsFromFile(const char* filename, int point_format);
+
 	int RunTriangleMesher(int UseKdTree);
+	int RunTriangleMesher(int UseKdTree, const char* checkpoint_filename, unsigned int checkpoint_interval);
+
+	//Write the mesh to an xml file while it is being built, freeing triangles as soon as they are final
+	// + only the triangles along the last kd seams are left in memory afterwards
+	int RunTriangleMesher(int UseKdTree, const char* checkpoint_filename, unsigned int checkpoint_interval, const char* stream_filename);
+
+	//Pick a kd-tree meshing run back up from a checkpoint file written by RunTriangleMesher
+	int ResumeTriangleMesher(const char* checkpoint_filename, unsigned int checkpoint_interval);
 
 	int LoadMeshFromFile(const char* filename, int load_triangles);
+	int LoadMeshFromFile(const char* filename, int load_triangles, int file_format);
+
 	int SaveMeshToFile(const char* filename, int save_triangles);
+	int SaveMeshToFile(const char* filename, int save_triangles, int file_format);
+	int SaveMeshToFile(const char* filename, int save_triangles, int file_format, unsigned int quantization_bits);
+
+	//Write the mesh in the binary mesh layout to an open stream
+	int SaveMeshToBinaryStream(FILE* handle, int save_triangles);
 
 	int WriteSVG(const char* filename, double svg_width, double svg_height);
+	int WriteSVG(const char* filename, double svg_width, double svg_height, Prism* viewport, int merge_subpixel, int draw_vertices, unsigned int max_elements);
 
 	int AppendVertex(Vector2d vertex);
 
@@ -85,8 +155,46 @@ public:
 	int BasicDelaunayFlipper(unsigned int delaunay_max_iterations);
 
 	int StretchedGrid(unsigned int iterations, double alpha);
+	int StretchedGrid(unsigned int iterations, double alpha, int stretched_grid_method);
+	int StretchedGrid(unsigned int iterations, double alpha, int stretched_grid_method, double damping, double tolerance);
 
 	int RefineMesh(double desired_edge_length);
+	int RefineMesh(double desired_edge_length, int refine_method, double minimum_angle);
+
+	//Refine to a desired edge length that changes over the mesh, the sizing function is only used by the quality method
+	int RefineMesh(double desired_edge_length, int refine_method, double minimum_angle, SizingFunction* sizing_function);
+
+	int UniformRefine(unsigned int levels, Prism* prism);
+	int UniformRefine(double desired_edge_length);
+
+	//Collapse short edges, see TriangleComplex::CoarsenMesh
+	int CoarsenMesh(double desired_edge_length, unsigned int target_triangle_count);
+
+	////////////////////////
+	// Bulk data transfer //
+	////////////////////////
+
+	//Add many vertices in one pass, copied from separate x and y arrays or from one interleaved xy array
+	// + returns the global index of the first vertex, or 0 if nothing was added
+	unsigned int AppendVertices(const double* x, const double* y, unsigned int count);
+	unsigned int AppendVertices(const double* xy, unsigned int count);
+
+	//Use an interleaved xy array for the vertices without copying it, it has to outlive the mesher's use of it
+	unsigned int AdoptVertices(double* xy, unsigned int count);
+
+	//Add count triangles from 3*count global vertex indices, connecting the ones that share an edge
+	// + returns the global index of the first triangle, or 0 if nothing was added
+	unsigned int AppendTriangles(const uint32_t* vertex_indices, unsigned int count);
+
+	//The mesh in slot order, the arrays are sized from the slot counts (slot 0 is always empty)
+	// + 2 doubles per vertex slot, NaN for empty slots
+	// + 3 vertex indices and 3 neighbour indices per triangle slot, 0 for empty slots and missing neighbours
+	unsigned int GetVertexSlotCount();
+	unsigned int GetTriangleSlotCount();
+
+	int ExportVertices(double* xy);
+	int ExportVertices(double* x, double* y);
+	int ExportTriangles(uint32_t* vertex_indices, uint32_t* neighbours);
 
 	/////////////////////
 	// Data management //
@@ -95,14 +203,59 @@ public:
 	TriangleComplex* GetTriangleComplex();
 
 private:
+	////////////////////////////
+	// Internal use functions //
+	////////////////////////////
+
+	//Run a mesher command without profiling it
+	int run_mesher_command(MesherCommand* mc);
+
+	//Refine with the options of a command, loading its sizing function sources first
+	int refine_mesh(MesherCommand* mc);
+
+	//Run the commands in waves, every command in a wave only depends on commands in earlier waves
+	int run_concurrent_mesher_commands();
+
+	//Start a save or svg export in the background
+	int start_async_export(MesherCommand* mc);
+
+	//Wait for the background exports that share a file with a command, or all of them if it is NULL
+	int wait_for_async_exports(MesherCommand* mc);
+
+	//Drop a reference to a snapshot, the last one frees it
+	int release_snapshot();
+	static int release_snapshot(MeshSnapshot* snapshot, pthread_mutex_t* snapshot_mutex);
+
+	static void* run_async_export(void* data);
+
+	//The exports, on any copy of the mesh
+	static int save_mesh(GlobalMeshData* global_mesh_data, const char* filename, int save_triangles, int file_format, unsigned int quantization_bits);
+	static int write_svg(GlobalMeshData* global_mesh_data, const char* filename, double svg_width, double svg_height, Prism* viewport, int merge_subpixel, int draw_vertices, unsigned int max_elements);
+
 	//Data regarding the mesher command stack
 	vector<MesherCommand*> mesher_command_stack;
 
 	int mesher_command_fail_behaviour;
+	int mesher_command_execution_mode;
+
+	//Profiling
+	MesherProfiler mesher_profiler;
+
+	string command_filename;
+	string profile_report_filename;
 
 	//The mesh and a complex for the mesher to operate on
 	GlobalMeshData* global_mesh_data;
 	TriangleComplex* triangle_complex;
+
+	//The exports running in the background, and the snapshot new ones can share until the mesh changes
+	// + async_export_mutex guards both, only while they change, the joins and snapshot copies happen outside it
+	vector<AsyncExport*> async_exports;
+
+	MeshSnapshot* current_snapshot;
+
+	pthread_mutex_t async_export_mutex;
+	pthread_mutex_t snapshot_mutex;
 };
 
 #endif
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+using namespace std;
+
+#include <omp.h>
+
+#include "../src/mesher_batch.h"
+
+//Two batch jobs running at the same time must each report the cpu time of their own thread, not of the process
+// + each job should come to about half of the cpu time of the batch, a process wide measure gives each of them
+//   nearly all of it
+
+#define JOB_COUNT			2
+#define JOB_VERTEX_COUNT	20000
+
+//A job may take at most this fraction of the cpu time of the whole batch
+#define MAX_JOB_CPU_FRACTION	0.75
+
+int write_job(const char* filename) {
+	FILE* handle = fopen(filename, "w");
+	if(handle == NULL) {
+		printf("Error: could not write %s\n", filename);
+		return false;
+	}
+
+	fprintf(handle, "<?xml version=\"1.0\"?>\n");
+	fprintf(handle, "<commandlist>\n");
+	fprintf(handle, "\t<GenerateRandomGrid xmin=\"0\" xmax=\"1\" ymin=\"0\" ymax=\"1\" vertex_count=\"%u\"/>\n", JOB_VERTEX_COUNT);
+	fprintf(handle, "\t<TriangleMesher/>\n");
+	fprintf(handle, "</commandlist>\n");
+
+	fclose(handle);
+	return true;
+}
+
+//Add up the cpu times of the commands in a profile report, returns false if any of them is a process total
+int read_job_cpu_time(const char* filename, double& cpu_time) {
+	cpu_time = 0;
+
+	FILE* handle = fopen(filename, "r");
+	if(handle == NULL) {
+		printf("Error: could not read %s\n", filename);
+		return false;
+	}
+
+	string report;
+	char buffer[4096];
+	size_t count = 0;
+	while((count = fread(buffer, 1, sizeof(buffer), handle)) > 0)
+		report.append(buffer, count);
+
+	fclose(handle);
+
+	if(report.find("\"process_cpu_time\"") != string::npos) {
+		printf("Error: %s has commands measured over the whole process\n", filename);
+		return false;
+	}
+
+	const char* key = "\"cpu_time\": ";
+	unsigned int command_count = 0;
+
+	for(size_t pos = report.find(key); pos != string::npos; pos = report.find(key, pos+1)) {
+		cpu_time += atof(report.c_str() + pos + strlen(key));
+		command_count++;
+	}
+
+	if(command_count == 0) {
+		printf("Error: %s has no cpu times\n", filename);
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv) {
+	srand(0);
+	omp_set_num_threads(JOB_COUNT);
+
+	MesherBatch mesher_batch;
+	char filenames[JOB_COUNT][100];
+
+	for(int i=0; i<JOB_COUNT; i++) {
+		sprintf(filenames[i], "test_batch_profile_%d.xml", i);
+		if(write_job(filenames[i]) == false)
+			return 1;
+
+		mesher_batch.AppendJob(filenames[i]);
+	}
+
+	double start_cpu_time = MesherProfiler::GetProcessCPUTime();
+
+	if(mesher_batch.RunJobs() == false) {
+		printf("Error: the batch failed\n");
+		return 1;
+	}
+
+	double total_cpu_time = MesherProfiler::GetProcessCPUTime() - start_cpu_time;
+
+	int ret = true;
+	for(int i=0; i<JOB_COUNT; i++) {
+		string report_filename = string(filenames[i]) + ".profile.json";
+
+		double job_cpu_time = 0;
+		if(read_job_cpu_time(report_filename.c_str(), job_cpu_time) == false)
+			ret = false;
+
+		else if(job_cpu_time > MAX_JOB_CPU_FRACTION * total_cpu_time) {
+			printf("Error: job %d reported %fs of cpu time, the whole batch took %fs\n", i, job_cpu_time, total_cpu_time);
+			ret = false;
+		}
+
+		else
+			printf("Job %d: %fs of %fs cpu time\n", i, job_cpu_time, total_cpu_time);
+
+		remove(filenames[i]);
+		remove(report_filename.c_str());
+	}
+
+	printf(ret == true ? "PASSED\n" : "FAILED\n");
+	return (ret == true ? 0 : 1);
+}
@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <new>
+using namespace std;
+
+#include "../src/global_mesh_data.h"
+
+//Loading a binary mesh file has to copy the vertices into one block, not allocate them one at a time, and a file
+//with bad indices has to leave the mesh that was loaded before it alone
+
+#define TEST_VERTEX_COUNT		100000
+
+//A load may make at most this many allocations, far fewer than one per vertex
+#define MAX_LOAD_ALLOCATIONS	1000
+
+//Dynamic exception specifications are gone from newer standards
+#if __cplusplus >= 201103L
+#define THROW_BAD_ALLOC
+#define THROW_NOTHING		noexcept
+#else
+#define THROW_BAD_ALLOC		throw(std::bad_alloc)
+#define THROW_NOTHING		throw()
+#endif
+
+//Count the allocations made while counting is on
+static int count_allocations = false;
+static long allocation_count = 0;
+
+__attribute__((noinline)) void* operator new(size_t size) THROW_BAD_ALLOC {
+	if(count_allocations == true)
+		__sync_fetch_and_add(&allocation_count, 1);
+
+	void* p = malloc(size > 0 ? size : 1);
+	if(p == NULL)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void* operator new[](size_t size) THROW_BAD_ALLOC {
+	return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void* p) THROW_NOTHING {
+	free(p);
+}
+
+void operator delete[](void* p) THROW_NOTHING {
+	free(p);
+}
+
+int main(int argc, char** argv) {
+	const char* filename = "test_binary_mesh_load.tmb";
+
+	//Write a mesh of random vertices
+	GlobalMeshData* saved_mesh = new GlobalMeshData;
+
+	srand(0);
+	for(unsigned int i=0; i<TEST_VERTEX_COUNT; i++)
+		saved_mesh->AppendVertex(new Vector2d(rand() / double(RAND_MAX), rand() / double(RAND_MAX)));
+
+	if(saved_mesh->SaveToFile(filename, false) == false) {
+		printf("Error: could not write %s\n", filename);
+		return 1;
+	}
+
+	//Load it back, counting the allocations
+	GlobalMeshData* loaded_mesh = new GlobalMeshData;
+
+	count_allocations = true;
+	int ret = loaded_mesh->LoadFromFile(filename, false);
+	count_allocations = false;
+
+	remove(filename);
+
+	if(ret == false) {
+		printf("Error: could not load %s\n", filename);
+		return 1;
+	}
+
+	if(loaded_mesh->GetVertexCount() != saved_mesh->GetVertexCount()) {
+		printf("Error: loaded %u vertex slots, saved %u\n", loaded_mesh->GetVertexCount(), saved_mesh->GetVertexCount());
+		ret = false;
+	}
+
+	for(unsigned int i=1; ret == true && i<saved_mesh->GetVertexCount(); i++) {
+		Vector2d* saved = saved_mesh->GetVertex(i);
+		Vector2d* loaded = loaded_mesh->GetVertex(i);
+
+		if(loaded == NULL || loaded->x != saved->x || loaded->y != saved->y) {
+			printf("Error: vertex %u wasn't loaded back\n", i);
+			ret = false;
+		}
+	}
+
+	if(allocation_count > MAX_LOAD_ALLOCATIONS) {
+		printf("Error: loading %u vertices made %ld allocations\n", TEST_VERTEX_COUNT, allocation_count);
+		ret = false;
+	}
+	else
+		printf("Loading %u vertices made %ld allocations\n", TEST_VERTEX_COUNT, allocation_count);
+
+	//Write a single triangle, then point its last vertex past the end of the vertex block
+	GlobalMeshData* bad_mesh = new GlobalMeshData;
+
+	bad_mesh->AppendVertex(new Vector2d(0.0, 0.0));
+	bad_mesh->AppendVertex(new Vector2d(1.0, 0.0));
+	bad_mesh->AppendVertex(new Vector2d(0.0, 1.0));
+
+	uint32_t triangle_vertices[3] = {1, 2, 3};
+	bad_mesh->AppendTriangles(triangle_vertices, 1);
+
+	int corrupted = false;
+	if(bad_mesh->SaveToFile(filename, true) == true) {
+		FILE* handle = fopen(filename, "r+b");
+
+		BinaryMeshHeader header;
+		if(handle != NULL && fread(&header, sizeof(BinaryMeshHeader), 1, handle) == 1) {
+			uint32_t bad_vindex = header.vertex_count;
+
+			corrupted = (fseek(handle, long(header.vertex_index_offset + 5 * sizeof(uint32_t)), SEEK_SET) == 0 &&
+					fwrite(&bad_vindex, sizeof(uint32_t), 1, handle) == 1);
+		}
+
+		if(handle != NULL)
+			fclose(handle);
+	}
+
+	if(corrupted == false) {
+		printf("Error: could not write the corrupted file %s\n", filename);
+		ret = false;
+	}
+
+	else if(loaded_mesh->LoadFromFile(filename, true) == true) {
+		printf("Error: a triangle with a missing vertex was loaded\n");
+		ret = false;
+	}
+
+	else if(loaded_mesh->GetVertexCount() != saved_mesh->GetVertexCount() || loaded_mesh->GetTriangleCount() > 1 ||
+			loaded_mesh->GetVertex(TEST_VERTEX_COUNT) == NULL) {
+		printf("Error: the failed load left %u vertex slots and %u triangle slots behind\n", loaded_mesh->GetVertexCount(), loaded_mesh->GetTriangleCount());
+		ret = false;
+	}
+
+	remove(filename);
+
+	delete saved_mesh;
+	delete loaded_mesh;
+	delete bad_mesh;
+
+	printf(ret == true ? "PASSED\n" : "FAILED\n");
+	return (ret == true ? 0 : 1);
+}